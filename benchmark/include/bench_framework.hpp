@@ -45,6 +45,8 @@ class test_case
     std::size_t threads() const { return threads_; }
     std::size_t iterations() const { return iterations_; }
     mapnik::parameters const& params() const { return params_; }
+    // input bytes processed per iteration, reported as throughput when non-zero
+    virtual std::size_t bytes_per_iteration() const { return 0; }
     virtual bool validate() const = 0;
     virtual bool operator()() const = 0;
 };
@@ -256,7 +258,7 @@ int run(T const& test_runner, std::string const& name)
         }
         std::snprintf(msg,
                       sizeof(msg),
-                      " %*.0f%s iters %6.0f milliseconds %*.0f%s i/t/s\n",
+                      " %*.0f%s iters %6.0f milliseconds %*.0f%s i/t/s",
                       itersf.w,
                       itersf.v,
                       itersf.u,
@@ -265,6 +267,15 @@ int run(T const& test_runner, std::string const& name)
                       ips.v,
                       ips.u);
         std::clog << msg;
+        if (auto bytes = test_runner.bytes_per_iteration())
+        {
+            std::snprintf(msg,
+                          sizeof(msg),
+                          " %8.1f MB/t/s",
+                          bytes * total_iters / seconds<double>(elapsed_nonzero).count() / 1e6);
+            std::clog << msg;
+        }
+        std::clog << "\n";
         return 0;
     }
     catch (std::exception const& ex)
@@ -0,0 +1,100 @@
+#include "bench_framework.hpp"
+#include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/dot_rasterizer.hpp>
+#include <mapnik/image.hpp>
+
+#include "agg_color_rgba.h"
+#include "agg_ellipse.h"
+#include "agg_pixfmt_rgba.h"
+#include "agg_rendering_buffer.h"
+#include "agg_renderer_base.h"
+#include "agg_renderer_scanline.h"
+#include "agg_scanline_u.h"
+
+#include <random>
+#include <vector>
+
+// Draws a cloud of small dots, as dot-symbolizer does for GPS traces.
+class test : public benchmark::test_case
+{
+  public:
+    enum mode_e { ellipses, stamps, density };
+
+  private:
+    mode_e mode_;
+    double radius_;
+    std::vector<mapnik::dot_rasterizer::point_type> points_;
+
+  public:
+    test(mapnik::parameters const& params, mode_e mode, double radius)
+        : test_case(params)
+        , mode_(mode)
+        , radius_(radius)
+    {
+        std::default_random_engine engine(42);
+        std::normal_distribution<double> position(512, 160);
+        for (int i = 0; i < 200000; ++i)
+        {
+            points_.emplace_back(position(engine), position(engine));
+        }
+    }
+
+    bool validate() const { return true; }
+
+    bool operator()() const
+    {
+        mapnik::image_rgba8 canvas(1024, 1024);
+        mapnik::image_gray32f counts(1024, 1024);
+        mapnik::color fill(200, 30, 60, 120);
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            switch (mode_)
+            {
+                case ellipses:
+                    render_ellipses(canvas, fill);
+                    break;
+                case stamps:
+                    mapnik::dot_rasterizer(radius_, radius_).blend(canvas, fill, 1.0, mapnik::src_over, points_);
+                    break;
+                case density:
+                    mapnik::dot_rasterizer(radius_, radius_).accumulate(counts, points_);
+                    break;
+            }
+        }
+        return true;
+    }
+
+  private:
+    // what dot-symbolizer draws with marker-rasterizer="full"
+    void render_ellipses(mapnik::image_rgba8& canvas, mapnik::color const& fill) const
+    {
+        using blender_type = agg::comp_op_adaptor_rgba_pre<agg::rgba8, agg::order_rgba>;
+        using pixfmt_type = agg::pixfmt_custom_blend_rgba<blender_type, agg::rendering_buffer>;
+        using renderer_base = agg::renderer_base<pixfmt_type>;
+        agg::rendering_buffer buf(canvas.bytes(), canvas.width(), canvas.height(), canvas.row_size());
+        pixfmt_type pixf(buf);
+        pixf.comp_op(agg::comp_op_src_over);
+        renderer_base renb(pixf);
+        agg::renderer_scanline_aa_solid<renderer_base> ren(renb);
+        ren.color(agg::rgba8_pre(fill.red(), fill.green(), fill.blue(), fill.alpha()));
+        mapnik::rasterizer ras;
+        agg::scanline_u8 sl;
+        agg::ellipse el(0, 0, radius_, radius_);
+        for (auto const& pt : points_)
+        {
+            el.init(pt.x, pt.y, radius_, radius_, el.num_steps());
+            ras.add_path(el);
+            agg::render_scanlines(ras, sl, ren);
+        }
+    }
+};
+
+int main(int argc, char** argv)
+{
+    return benchmark::sequencer(argc, argv)
+      .run<test>("dots as agg ellipses", test::ellipses, 2.0)
+      .run<test>("dots as stamps", test::stamps, 2.0)
+      .run<test>("single pixel dots", test::stamps, 0.5)
+      .run<test>("dot density", test::density, 2.0)
+      .done();
+}
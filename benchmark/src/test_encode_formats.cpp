@@ -0,0 +1,59 @@
+#include "bench_framework.hpp"
+#include <mapnik/image_reader.hpp>
+#include <mapnik/image_util.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <memory>
+
+class test : public benchmark::test_case
+{
+    std::shared_ptr<mapnik::image_rgba8> im_;
+    std::vector<std::string> formats_;
+    int encode_threads_;
+
+  public:
+    test(mapnik::parameters const& params)
+        : test_case(params)
+        , encode_threads_(static_cast<int>(*params.get<mapnik::value_integer>("encode_threads", 0)))
+    {
+        std::string formats = *params.get<std::string>("formats", "png8,png32,jpeg85");
+        boost::algorithm::split(formats_, formats, boost::algorithm::is_any_of(","));
+        std::string filename("./benchmark/data/multicolor.png");
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(filename, "png"));
+        if (!reader.get())
+        {
+            throw mapnik::image_reader_exception("Failed to load: " + filename);
+        }
+        mapnik::image_rgba8 tile(reader->width(), reader->height());
+        reader->read(0, 0, tile);
+        auto size = static_cast<std::size_t>(*params.get<mapnik::value_integer>("size", 256));
+        im_ = std::make_shared<mapnik::image_rgba8>(size, size);
+        for (std::size_t y = 0; y < size; ++y)
+        {
+            for (std::size_t x = 0; x < size; ++x)
+            {
+                (*im_)(x, y) = tile(x % tile.width(), y % tile.height());
+            }
+        }
+    }
+    bool validate() const
+    {
+        auto encoded = mapnik::save_to_strings(*im_, formats_, encode_threads_);
+        for (std::size_t i = 0; i < formats_.size(); ++i)
+        {
+            if (encoded[i] != mapnik::save_to_string(*im_, formats_[i]))
+                return false;
+        }
+        return true;
+    }
+    bool operator()() const
+    {
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            auto encoded = mapnik::save_to_strings(*im_, formats_, encode_threads_);
+        }
+        return true;
+    }
+};
+
+BENCHMARK(test, "encoding multicolor to several formats")
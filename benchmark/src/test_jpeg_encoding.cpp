@@ -0,0 +1,52 @@
+#include "bench_framework.hpp"
+#include <mapnik/image_reader.hpp>
+#include <mapnik/image_util.hpp>
+#include <memory>
+
+class test : public benchmark::test_case
+{
+    std::shared_ptr<mapnik::image_rgba8> im_;
+    std::string format_;
+
+  public:
+    test(mapnik::parameters const& params)
+        : test_case(params)
+        , format_(*params.get<std::string>("format", "jpeg85"))
+    {
+        std::string filename("./benchmark/data/multicolor.png");
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(filename, "png"));
+        if (!reader.get())
+        {
+            throw mapnik::image_reader_exception("Failed to load: " + filename);
+        }
+        mapnik::image_rgba8 tile(reader->width(), reader->height());
+        reader->read(0, 0, tile);
+        // the tile repeated up to the size, 256 or 1024 for instance
+        auto size = static_cast<std::size_t>(*params.get<mapnik::value_integer>("size", 256));
+        im_ = std::make_shared<mapnik::image_rgba8>(size, size);
+        for (std::size_t y = 0; y < size; ++y)
+        {
+            for (std::size_t x = 0; x < size; ++x)
+            {
+                (*im_)(x, y) = tile(x % tile.width(), y % tile.height());
+            }
+        }
+    }
+    bool validate() const
+    {
+        // encoding again reuses the compressor of the thread
+        return mapnik::save_to_string(*im_, format_) == mapnik::save_to_string(*im_, format_);
+    }
+    bool operator()() const
+    {
+        std::string out;
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            out.clear();
+            out = mapnik::save_to_string(*im_, format_);
+        }
+        return true;
+    }
+};
+
+BENCHMARK(test, "encoding multicolor jpeg")
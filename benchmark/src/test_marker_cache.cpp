@@ -4,9 +4,10 @@
 class test : public benchmark::test_case
 {
     std::vector<std::string> images_;
+    bool update_cache_;
 
   public:
-    test(mapnik::parameters const& params)
+    test(mapnik::parameters const& params, bool update_cache)
         : test_case(params)
         , images_{"./test/data/images/dummy.jpg",
                   "./test/data/images/dummy.jpeg",
@@ -20,6 +21,7 @@ class test : public benchmark::test_case
                   "./test/data/svg/point_sm.svg",
                   "./test/data/svg/point.svg",
                   "./test/data/svg/airfield-12.svg"}
+        , update_cache_(update_cache)
     {}
     bool validate() const { return true; }
     bool operator()() const
@@ -29,7 +31,7 @@ class test : public benchmark::test_case
         {
             for (auto filename : images_)
             {
-                auto marker = mapnik::marker_cache::instance().find(filename, true);
+                auto marker = mapnik::marker_cache::instance().find(filename, update_cache_);
             }
             ++count;
         }
@@ -37,4 +39,12 @@ class test : public benchmark::test_case
     }
 };
 
-BENCHMARK(test, "marker cache")
\ No newline at end of file
+// With --threads N the cached lookups show whether concurrent renderers
+// contend on the cache, the uncached loads are serialized by design.
+int main(int argc, char** argv)
+{
+    return benchmark::sequencer(argc, argv)
+      .run<test>("marker cache", true)
+      .run<test>("marker cache (no update)", false)
+      .done();
+}
@@ -4,11 +4,13 @@
 class test : public benchmark::test_case
 {
     mapnik::image_rgba8 im_;
+    std::string format_;
 
   public:
     test(mapnik::parameters const& params)
         : test_case(params)
         , im_(256, 256)
+        , format_(*params.get<std::string>("format", "png8:m=h:z=1"))
     {}
     bool validate() const { return true; }
     bool operator()() const
@@ -17,7 +19,7 @@ class test : public benchmark::test_case
         for (std::size_t i = 0; i < iterations_; ++i)
         {
             out.clear();
-            out = mapnik::save_to_string(im_, "png8:m=h:z=1");
+            out = mapnik::save_to_string(im_, format_);
         }
         return true;
     }
@@ -1,5 +1,6 @@
 #include "bench_framework.hpp"
 #include <mapnik/quad_tree.hpp>
+#include <mapnik/label_collision_detector.hpp>
 #include <random>
 
 using quad_tree_type = mapnik::quad_tree<std::size_t>;
@@ -49,4 +50,79 @@ class test : public benchmark::test_case
     }
 };
 
-BENCHMARK(test, "quad_tree creation")
+// simulates line labels: a run of glyph boxes which is either placed as a whole or rejected
+template<typename Detector>
+class test_labels : public benchmark::test_case
+{
+    std::vector<std::vector<mapnik::box2d<double>>> labels_;
+
+  public:
+    test_labels(mapnik::parameters const& params)
+        : test_case(params)
+    {
+        std::default_random_engine engine(0);
+        std::uniform_real_distribution<double> position(-128, 2176);
+        std::uniform_int_distribution<int> glyphs(3, 16);
+        std::size_t num_labels = *params.get<mapnik::value_integer>("labels", 20000);
+        labels_.reserve(num_labels);
+        for (std::size_t i = 0; i < num_labels; ++i)
+        {
+            double x = position(engine);
+            double y = position(engine);
+            std::vector<mapnik::box2d<double>> boxes;
+            for (int g = glyphs(engine); g > 0; --g)
+            {
+                boxes.emplace_back(x, y, x + 7, y + 12);
+                x += 7;
+                y += 1;
+            }
+            labels_.push_back(std::move(boxes));
+        }
+    }
+
+    bool validate() const { return true; }
+
+    bool place(mapnik::label_collision_detector3& detector, std::vector<mapnik::box2d<double>> const& boxes) const
+    {
+        for (auto const& box : boxes)
+        {
+            if (!detector.has_placement(box))
+                return false;
+        }
+        for (auto const& box : boxes)
+        {
+            detector.insert(box);
+        }
+        return true;
+    }
+
+    bool place(mapnik::label_collision_detector4& detector, std::vector<mapnik::box2d<double>> const& boxes) const
+    {
+        return detector.try_insert(boxes, 0.0, mapnik::label_collision_detector4::no_text, 0.0);
+    }
+
+    bool operator()() const
+    {
+        std::size_t placed = 0;
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            Detector detector(mapnik::box2d<double>(-128, -128, 2176, 2176));
+            for (auto const& boxes : labels_)
+            {
+                if (place(detector, boxes))
+                    ++placed;
+            }
+        }
+        return placed > 0;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    mapnik::setup();
+    return benchmark::sequencer(argc, argv)
+      .run<test>("quad_tree creation")
+      .run<test_labels<mapnik::label_collision_detector3>>("label placement (quad_tree)")
+      .run<test_labels<mapnik::label_collision_detector4>>("label placement (grid)")
+      .done();
+}
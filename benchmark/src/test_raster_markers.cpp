@@ -0,0 +1,118 @@
+#include "bench_framework.hpp"
+#include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/agg_render_marker.hpp>
+#include <mapnik/image.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Draws the same raster marker at tens of thousands of point placements.
+class test : public benchmark::test_case
+{
+  public:
+    enum mode_e { blend_from, single, instanced };
+
+  private:
+    using blender_type = agg::comp_op_adaptor_rgba_pre<agg::rgba8, agg::order_rgba>;
+    using pixfmt_type = agg::pixfmt_custom_blend_rgba<blender_type, agg::rendering_buffer>;
+    using renderer_base = agg::renderer_base<pixfmt_type>;
+
+    mode_e mode_;
+    mapnik::image_rgba8 icon_;
+    std::vector<agg::trans_affine> placements_;
+
+    // antialiased disc with a one pixel dark outline, premultiplied
+    static mapnik::image_rgba8 make_icon(int size)
+    {
+        mapnik::image_rgba8 icon(size, size);
+        double r = 0.5 * size - 1.0;
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                double d = std::hypot(x + 0.5 - 0.5 * size, y + 0.5 - 0.5 * size);
+                double a = std::min(1.0, std::max(0.0, r - d + 0.5));
+                unsigned shade = d > r - 1.5 ? 40 : 220;
+                unsigned alpha = static_cast<unsigned>(a * 255 + 0.5);
+                unsigned v = shade * alpha / 255;
+                icon(x, y) = v | (v << 8) | ((v / 2) << 16) | (alpha << 24);
+            }
+        }
+        icon.set_premultiplied(true);
+        return icon;
+    }
+
+  public:
+    test(mapnik::parameters const& params, mode_e mode)
+        : test_case(params)
+        , mode_(mode)
+        , icon_(make_icon(24))
+    {
+        std::default_random_engine engine(42);
+        std::uniform_real_distribution<double> position(-12, 1036);
+        for (int i = 0; i < 20000; ++i)
+        {
+            // centered on the placement, as markers are
+            placements_.push_back(agg::trans_affine_translation(position(engine) - 12, position(engine) - 12));
+        }
+    }
+
+    bool validate() const
+    {
+        mapnik::image_rgba8 expected(1024, 1024);
+        mapnik::image_rgba8 actual(1024, 1024);
+        render(expected, blend_from);
+        render(actual, mode_);
+        return std::memcmp(expected.bytes(), actual.bytes(), expected.size()) == 0;
+    }
+
+    bool operator()() const
+    {
+        mapnik::image_rgba8 canvas(1024, 1024);
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            render(canvas, mode_);
+        }
+        return true;
+    }
+
+  private:
+    void render(mapnik::image_rgba8& canvas, mode_e mode) const
+    {
+        agg::rendering_buffer buf(canvas.bytes(), canvas.width(), canvas.height(), canvas.row_size());
+        pixfmt_type pixf(buf);
+        pixf.comp_op(agg::comp_op_src_over);
+        renderer_base renb(pixf);
+        mapnik::rasterizer ras;
+        switch (mode)
+        {
+            case blend_from:
+                // what translated markers were drawn with before
+                for (auto const& tr : placements_)
+                {
+                    mapnik::detail::blend_from(renb, icon_, static_cast<int>(tr.tx), static_cast<int>(tr.ty), 255);
+                }
+                break;
+            case single:
+                for (auto const& tr : placements_)
+                {
+                    mapnik::render_raster_marker(renb, ras, icon_, tr, 1.0, 1.0f, false);
+                }
+                break;
+            case instanced:
+                mapnik::render_raster_markers(renb, ras, icon_, placements_, 1.0, 1.0f, false);
+                break;
+        }
+    }
+};
+
+int main(int argc, char** argv)
+{
+    return benchmark::sequencer(argc, argv)
+      .run<test>("raster markers agg blend_from", test::blend_from)
+      .run<test>("raster markers one at a time", test::single)
+      .run<test>("raster markers as instances", test::instanced)
+      .done();
+}
@@ -0,0 +1,88 @@
+#include "bench_framework.hpp"
+#include <mapnik/marker.hpp>
+#include <mapnik/svg/svg_parser.hpp>
+#include <mapnik/svg/svg_converter.hpp>
+#include <mapnik/svg/svg_path_adapter.hpp>
+#include <mapnik/util/file_io.hpp>
+#include <mapnik/util/fs.hpp>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+class test : public benchmark::test_case
+{
+    std::vector<std::string> svgs_;
+    std::size_t bytes_;
+
+  public:
+    test(mapnik::parameters const& params)
+        : test_case(params)
+        , bytes_(0)
+    {
+        std::string dir = *params.get<std::string>("dir", "./test/data/svg");
+        for (auto const& filename : mapnik::util::list_directory(dir))
+        {
+            if (!boost::iends_with(filename, ".svg"))
+                continue;
+            mapnik::util::file file(filename);
+            if (!file || file.size() == 0)
+                continue;
+            auto data = file.data();
+            if (!data)
+                continue;
+            svgs_.emplace_back(data.get(), file.size());
+            bytes_ += file.size();
+        }
+    }
+
+    std::size_t bytes_per_iteration() const { return bytes_; }
+
+    bool validate() const
+    {
+        if (svgs_.empty())
+            return false;
+        for (auto const& svg : svgs_)
+        {
+            if (parse(svg) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    bool operator()() const
+    {
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            for (auto const& svg : svgs_)
+            {
+                count += parse(svg);
+            }
+        }
+        return count > 0;
+    }
+
+  private:
+    // returns the number of vertices, an svg which fails to parse counts as none
+    static std::size_t parse(std::string const& svg)
+    {
+        using namespace mapnik::svg;
+        mapnik::svg_path_ptr marker_path(std::make_shared<mapnik::svg_storage_type>());
+        vertex_stl_adapter<svg_path_storage> stl_storage(marker_path->source());
+        svg_path_adapter svg_path(stl_storage);
+        svg_converter_type converter(svg_path, marker_path->attributes());
+        svg_parser parser(converter, false);
+        try
+        {
+            parser.parse_from_string(svg);
+        }
+        catch (std::exception const&)
+        {
+            return 0;
+        }
+        return marker_path->source().size();
+    }
+};
+
+// Parses every svg below --dir (./test/data/svg by default) from memory,
+// throughput is reported in MB of svg source per thread and second.
+BENCHMARK(test, "svg parsing")
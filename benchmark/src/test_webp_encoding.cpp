@@ -0,0 +1,42 @@
+#include "bench_framework.hpp"
+#include <mapnik/image_reader.hpp>
+#include <mapnik/image_util.hpp>
+#include <memory>
+
+class test : public benchmark::test_case
+{
+    std::shared_ptr<mapnik::image_rgba8> im_;
+    std::string format_;
+
+  public:
+    test(mapnik::parameters const& params)
+        : test_case(params)
+        , format_(*params.get<std::string>("format", "webp:method=4"))
+    {
+        std::string filename("./benchmark/data/multicolor.png");
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(filename, "png"));
+        if (!reader.get())
+        {
+            throw mapnik::image_reader_exception("Failed to load: " + filename);
+        }
+        im_ = std::make_shared<mapnik::image_rgba8>(reader->width(), reader->height());
+        reader->read(0, 0, *im_);
+    }
+    bool validate() const
+    {
+        // encoding again reuses the buffers of the thread
+        return mapnik::save_to_string(*im_, format_) == mapnik::save_to_string(*im_, format_);
+    }
+    bool operator()() const
+    {
+        std::string out;
+        for (std::size_t i = 0; i < iterations_; ++i)
+        {
+            out.clear();
+            out = mapnik::save_to_string(*im_, format_);
+        }
+        return true;
+    }
+};
+
+BENCHMARK(test, "encoding multicolor webp")
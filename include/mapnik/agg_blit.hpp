@@ -0,0 +1,202 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_AGG_BLIT_HPP
+#define MAPNIK_AGG_BLIT_HPP
+
+#include <mapnik/image.hpp>
+#include <mapnik/util/const_rendering_buffer.hpp>
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore_agg.hpp>
+#include "agg_basics.h"
+#include "agg_pixfmt_rgba.h"
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace mapnik {
+
+namespace detail {
+
+// Blends `len` premultiplied rgba pixels over `dst`, with the same result as
+// agg::comp_op_rgba_src_over. Transparent source pixels leave the destination
+// unchanged and are skipped, opaque ones at full cover are copied.
+inline void blend_src_over(std::uint8_t* dst, std::uint8_t const* src, unsigned len, unsigned cover)
+{
+    for (; len > 0; --len, dst += 4, src += 4)
+    {
+        std::uint32_t pixel;
+        std::memcpy(&pixel, src, 4);
+        if (pixel == 0)
+            continue;
+        unsigned sr = src[0];
+        unsigned sg = src[1];
+        unsigned sb = src[2];
+        unsigned sa = src[3];
+        if (cover < 255)
+        {
+            sr = (sr * cover + 255) >> 8;
+            sg = (sg * cover + 255) >> 8;
+            sb = (sb * cover + 255) >> 8;
+            sa = (sa * cover + 255) >> 8;
+        }
+        else if (sa == 255)
+        {
+            std::memcpy(dst, src, 4);
+            continue;
+        }
+        unsigned s1a = 255 - sa;
+        dst[0] = static_cast<std::uint8_t>(sr + ((dst[0] * s1a + 255) >> 8));
+        dst[1] = static_cast<std::uint8_t>(sg + ((dst[1] * s1a + 255) >> 8));
+        dst[2] = static_cast<std::uint8_t>(sb + ((dst[2] * s1a + 255) >> 8));
+        dst[3] = static_cast<std::uint8_t>(sa + ((dst[3] * s1a + 255) >> 8));
+    }
+}
+
+template<typename RendererBase>
+void blend_from(RendererBase& renb, image_rgba8 const& src, int x, int y, agg::cover_type cover)
+{
+    using const_rendering_buffer = util::rendering_buffer<image_rgba8>;
+    using pixfmt_pre = agg::pixfmt_alpha_blend_rgba<agg::blender_rgba32_pre, const_rendering_buffer, agg::pixel32_type>;
+    const_rendering_buffer src_buffer(src);
+    pixfmt_pre pixf(src_buffer);
+    renb.blend_from(pixf, 0, x, y, cover);
+}
+
+} // namespace detail
+
+// Blends the premultiplied `src` with its top left corner at (x, y) into the
+// buffer of `renb`, a renderer_base over pixfmt_custom_blend_rgba, clipped to
+// its clip box. Source over is blended inline, other composite operations go
+// through renderer_base::blend_from. Both give the same result.
+template<typename RendererBase>
+void blit_rgba8(RendererBase& renb, image_rgba8 const& src, int x, int y, agg::cover_type cover)
+{
+    if (renb.ren().comp_op() != agg::comp_op_src_over)
+    {
+        detail::blend_from(renb, src, x, y, cover);
+        return;
+    }
+    int x0 = std::max(x, renb.xmin());
+    int y0 = std::max(y, renb.ymin());
+    int x1 = std::min(x + static_cast<int>(src.width()), renb.xmax() + 1);
+    int y1 = std::min(y + static_cast<int>(src.height()), renb.ymax() + 1);
+    if (x0 >= x1 || y0 >= y1 || cover == 0)
+        return;
+    for (int row = y0; row < y1; ++row)
+    {
+        auto const* src_row = reinterpret_cast<std::uint8_t const*>(src.get_row(row - y, x0 - x));
+        detail::blend_src_over(renb.ren().pix_ptr(x0, row), src_row, x1 - x0, cover);
+    }
+}
+
+// Blends `src` at each of `positions`, top left corners with x and y members,
+// in order. The same as calling blit_rgba8 for each of them, but the source is
+// scanned once for its runs of transparent, translucent and opaque pixels:
+// every instance skips the transparent runs and copies the opaque ones.
+template<typename RendererBase, typename Positions>
+void blit_rgba8_instances(RendererBase& renb, image_rgba8 const& src, Positions const& positions, agg::cover_type cover)
+{
+    if (positions.size() < 2 || renb.ren().comp_op() != agg::comp_op_src_over)
+    {
+        for (auto const& pos : positions)
+        {
+            blit_rgba8(renb, src, pos.x, pos.y, cover);
+        }
+        return;
+    }
+    if (cover == 0)
+        return;
+
+    struct run
+    {
+        int x0;
+        int x1;
+        bool opaque;
+    };
+    int width = static_cast<int>(src.width());
+    int height = static_cast<int>(src.height());
+    std::vector<run> runs;
+    std::vector<std::size_t> row_runs(height + 1, 0);
+    for (int row = 0; row < height; ++row)
+    {
+        auto const* pixels = src.get_row(row);
+        auto const* alpha = reinterpret_cast<std::uint8_t const*>(pixels) + 3;
+        int x = 0;
+        while (x < width)
+        {
+            if (pixels[x] == 0)
+            {
+                ++x;
+                continue;
+            }
+            bool opaque = alpha[4 * x] == 255;
+            int start = x;
+            while (x < width && pixels[x] != 0 && (alpha[4 * x] == 255) == opaque)
+                ++x;
+            runs.push_back({start, x, opaque});
+        }
+        row_runs[row + 1] = runs.size();
+    }
+
+    for (auto const& pos : positions)
+    {
+        int x = pos.x;
+        int y = pos.y;
+        int x0 = std::max(x, renb.xmin()) - x;
+        int x1 = std::min(x + width, renb.xmax() + 1) - x;
+        int y0 = std::max(y, renb.ymin()) - y;
+        int y1 = std::min(y + height, renb.ymax() + 1) - y;
+        if (x0 >= x1 || y0 >= y1)
+            continue;
+        for (int row = y0; row < y1; ++row)
+        {
+            for (std::size_t i = row_runs[row]; i < row_runs[row + 1]; ++i)
+            {
+                int begin = std::max(runs[i].x0, x0);
+                int end = std::min(runs[i].x1, x1);
+                if (begin >= end)
+                    continue;
+                auto const* src_pixels = reinterpret_cast<std::uint8_t const*>(src.get_row(row, begin));
+                std::uint8_t* dst_pixels = renb.ren().pix_ptr(x + begin, y + row);
+                if (runs[i].opaque && cover == 255)
+                {
+                    std::memcpy(dst_pixels, src_pixels, 4 * (end - begin));
+                }
+                else
+                {
+                    detail::blend_src_over(dst_pixels, src_pixels, end - begin, cover);
+                }
+            }
+        }
+    }
+}
+
+} // namespace mapnik
+
+#endif // MAPNIK_AGG_BLIT_HPP
@@ -23,13 +23,17 @@
 #ifndef MAPNIK_AGG_RENDER_MARKER_HPP
 #define MAPNIK_AGG_RENDER_MARKER_HPP
 
+#include <mapnik/agg_blit.hpp>
+#include <mapnik/agg_helpers.hpp>
 #include <mapnik/color.hpp>
 #include <mapnik/feature.hpp>
 #include <mapnik/geom_util.hpp>
+#include <mapnik/marker_sprite_cache.hpp>
 #include <mapnik/svg/svg_path_attributes.hpp>
 #include <mapnik/svg/svg_converter.hpp>
 #include <mapnik/vertex_converters.hpp>
 #include <mapnik/geometry/box2d.hpp>
+#include <mapnik/geometry/point.hpp>
 #include <mapnik/safe_cast.hpp>
 #include <mapnik/util/const_rendering_buffer.hpp>
 
@@ -76,6 +80,96 @@ void render_vector_marker(SvgRenderer& svg_renderer,
     }
 }
 
+// Draws a vector marker by blending its cached sprite, see
+// marker_sprite_cache. Draws the sprite first if needed. Returns false when
+// the marker is too large for a sprite, it should be drawn with
+// render_vector_marker then.
+template<typename RasterizerType, typename SvgRenderer, typename RendererBaseType>
+bool render_vector_marker_sprite(SvgRenderer& svg_renderer,
+                                 RendererBaseType& renb,
+                                 svg_path_ptr const& marker,
+                                 marker_sprite_style const& style,
+                                 box2d<double> const& bbox,
+                                 svg_attribute_type const& attrs,
+                                 agg::trans_affine const& tr,
+                                 double opacity,
+                                 double gamma,
+                                 gamma_method_enum gamma_method,
+                                 bool snap_to_pixels)
+{
+    using pixfmt_type = typename RendererBaseType::pixfmt_type;
+    using const_rendering_buffer = util::rendering_buffer<image_rgba8>;
+    using pixfmt_pre = agg::pixfmt_alpha_blend_rgba<agg::blender_rgba32_pre, const_rendering_buffer, agg::pixel32_type>;
+
+    marker_sprite_cache& cache = marker_sprite_cache::instance();
+    int x, y;
+    marker_sprite_cache::key k =
+      marker_sprite_cache::make_key(marker, style, bbox, tr, opacity, gamma, gamma_method, snap_to_pixels, x, y);
+    std::shared_ptr<marker_sprite const> sprite = cache.find(k);
+    if (!sprite)
+    {
+        agg::trans_affine sprite_tr = marker_sprite_cache::sprite_transform(k, bbox);
+        // strokes, joins and caps reach beyond the bounding box
+        double stroke = 0.0;
+        for (auto const& attr : attrs)
+        {
+            if (attr.visibility_flag && (attr.stroke_flag || attr.stroke_gradient.get_gradient_type() != NO_GRADIENT))
+            {
+                stroke =
+                  std::max(stroke, attr.stroke_width * attr.transform.scale() * std::max(attr.miter_limit, 2.0));
+            }
+        }
+        box2d<double> extent = bbox * sprite_tr;
+        double pad = 2.0 + 0.5 * stroke * sprite_tr.scale();
+        int x0 = static_cast<int>(std::floor(extent.minx() - pad));
+        int y0 = static_cast<int>(std::floor(extent.miny() - pad));
+        int width = static_cast<int>(std::ceil(extent.maxx() + pad)) - x0;
+        int height = static_cast<int>(std::ceil(extent.maxy() + pad)) - y0;
+        if (width > marker_sprite_cache::max_sprite_size || height > marker_sprite_cache::max_sprite_size)
+        {
+            return false;
+        }
+        image_rgba8 image(width, height);
+        agg::rendering_buffer buf(image.bytes(), image.width(), image.height(), image.row_size());
+        pixfmt_type pixf(buf);
+        pixf.comp_op(agg::comp_op_src_over);
+        RendererBaseType sprite_renb(pixf);
+        RasterizerType ras;
+        RasterizerType* ras_ptr = &ras;
+        set_gamma_method(ras_ptr, gamma, gamma_method);
+        ras.clip_box(0, 0, width, height);
+        agg::scanline_u8 sl;
+        sprite_tr *= agg::trans_affine_translation(-x0, -y0);
+        svg_renderer.render(ras, sl, sprite_renb, sprite_tr, opacity, bbox);
+        sprite = cache.insert(k, marker, image, x0, y0);
+    }
+    if (sprite->image.width() > 0)
+    {
+        const_rendering_buffer src_buffer(sprite->image);
+        pixfmt_pre pixf_sprite(src_buffer);
+        renb.blend_from(pixf_sprite, 0, x + sprite->x, y + sprite->y, 255);
+    }
+    return true;
+}
+
+// Raster markers with this transform are blended pixel for pixel, without
+// resampling.
+inline bool raster_marker_translation_only(agg::trans_affine const& tr, float scale_factor)
+{
+    return std::fabs(1.0 - scale_factor) < 0.001 && (std::fabs(1.0 - tr.sx) < agg::affine_epsilon) &&
+           (std::fabs(0.0 - tr.shy) < agg::affine_epsilon) && (std::fabs(0.0 - tr.shx) < agg::affine_epsilon) &&
+           (std::fabs(1.0 - tr.sy) < agg::affine_epsilon);
+}
+
+inline geometry::point<int> raster_marker_position(agg::trans_affine const& tr, bool snap_to_pixels)
+{
+    if (snap_to_pixels)
+    {
+        return {static_cast<int>(std::floor(tr.tx + .5)), static_cast<int>(std::floor(tr.ty + .5))};
+    }
+    return {static_cast<int>(tr.tx), static_cast<int>(tr.ty)};
+}
+
 template<typename RendererType, typename RasterizerType>
 void render_raster_marker(RendererType renb,
                           RasterizerType& ras,
@@ -92,24 +186,10 @@ void render_raster_marker(RendererType renb,
     agg::scanline_u8 sl;
     double width = src.width();
     double height = src.height();
-    if (std::fabs(1.0 - scale_factor) < 0.001 && (std::fabs(1.0 - tr.sx) < agg::affine_epsilon) &&
-        (std::fabs(0.0 - tr.shy) < agg::affine_epsilon) && (std::fabs(0.0 - tr.shx) < agg::affine_epsilon) &&
-        (std::fabs(1.0 - tr.sy) < agg::affine_epsilon))
+    if (raster_marker_translation_only(tr, scale_factor))
     {
-        const_rendering_buffer src_buffer(src);
-        pixfmt_pre pixf_mask(src_buffer);
-        if (snap_to_pixels)
-        {
-            renb.blend_from(pixf_mask,
-                            0,
-                            static_cast<int>(std::floor(tr.tx + .5)),
-                            static_cast<int>(std::floor(tr.ty + .5)),
-                            unsigned(255 * opacity));
-        }
-        else
-        {
-            renb.blend_from(pixf_mask, 0, static_cast<int>(tr.tx), static_cast<int>(tr.ty), unsigned(255 * opacity));
-        }
+        geometry::point<int> pos = raster_marker_position(tr, snap_to_pixels);
+        blit_rgba8(renb, src, pos.x, pos.y, unsigned(255 * opacity));
     }
     else
     {
@@ -156,6 +236,35 @@ void render_raster_marker(RendererType renb,
     }
 }
 
+// Draws the same raster marker with each of the transforms, in order. When all
+// of them are translations the marker is blended as instances of the image,
+// see blit_rgba8_instances.
+template<typename RendererType, typename RasterizerType>
+void render_raster_markers(RendererType renb,
+                           RasterizerType& ras,
+                           image_rgba8 const& src,
+                           std::vector<agg::trans_affine> const& trs,
+                           double opacity,
+                           float scale_factor,
+                           bool snap_to_pixels)
+{
+    std::vector<geometry::point<int>> positions;
+    positions.reserve(trs.size());
+    for (auto const& tr : trs)
+    {
+        if (!raster_marker_translation_only(tr, scale_factor))
+        {
+            for (auto const& marker_tr : trs)
+            {
+                render_raster_marker(renb, ras, src, marker_tr, opacity, scale_factor, snap_to_pixels);
+            }
+            return;
+        }
+        positions.push_back(raster_marker_position(tr, snap_to_pixels));
+    }
+    blit_rgba8_instances(renb, src, positions, unsigned(255 * opacity));
+}
+
 } // namespace mapnik
 
 #endif // MAPNIK_AGG_RENDER_MARKER_HPP
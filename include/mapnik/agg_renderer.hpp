@@ -35,6 +35,7 @@
 #include <mapnik/request.hpp>
 #include <mapnik/symbolizer_enumerations.hpp>
 #include <mapnik/renderer_common.hpp>
+#include <mapnik/renderer_common/label_placement_queue.hpp>
 #include <mapnik/image_util.hpp>
 // stl
 #include <memory>
@@ -57,6 +58,7 @@ struct marker;
 class proj_transform;
 struct rasterizer;
 struct rgba8_t;
+class text_symbolizer_helper;
 template<typename T>
 class image;
 } // namespace mapnik
@@ -85,6 +87,7 @@ class buffer_stack
         {
             --position_;
             mapnik::fill(*position_, 0); // fill with transparent colour
+            position_->painted(false);
         }
         return *position_;
     }
@@ -171,7 +174,10 @@ class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T0>
     }
 
     void painted(bool painted);
-    bool painted();
+    // Whether any rule of a style matched a feature, including styles drawn
+    // on an intermediate buffer. Callers can skip encoding images nothing was
+    // rendered on, see also solid_image_cache.
+    bool painted() const;
 
     inline eAttributeCollectionPolicy attribute_collection_policy() const { return DEFAULT; }
 
@@ -186,6 +192,7 @@ class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T0>
     void draw_geo_extent(box2d<double> const& extent, mapnik::color const& color);
 
   private:
+    Map const& m_;
     std::stack<std::reference_wrapper<buffer_type>> buffers_;
     buffer_stack<buffer_type> internal_buffers_;
     std::unique_ptr<buffer_type> inflated_buffer_;
@@ -193,11 +200,40 @@ class MAPNIK_DECL agg_renderer : public feature_style_processor<agg_renderer<T0>
     gamma_method_enum gamma_method_;
     double gamma_;
     renderer_common common_;
+    label_placement_queue label_queue_;
     void setup(Map const& m, buffer_type& pixmap);
+    void render_label(text_symbolizer const& sym,
+                      mapnik::feature_impl& feature,
+                      proj_transform const& prj_trans,
+                      box2d<double> const& clip_box);
+    void render_label(shield_symbolizer const& sym,
+                      mapnik::feature_impl& feature,
+                      proj_transform const& prj_trans,
+                      box2d<double> const& clip_box);
+    void render_label(text_symbolizer const& sym,
+                      mapnik::feature_impl& feature,
+                      text_symbolizer_helper const& helper);
+    void render_label(shield_symbolizer const& sym,
+                      mapnik::feature_impl& feature,
+                      text_symbolizer_helper const& helper);
+    void render_queued_labels();
 };
 
 extern template class MAPNIK_DECL agg_renderer<image<rgba8_t>>;
 
+class image_row_writer;
+
+// Renders the map in horizontal bands of band_height rows, at least 16, from
+// top to bottom, and writes each of them to writer before rendering the next,
+// so only a band is ever in memory. Every band queries the layers for its own
+// extent and places its own labels, like a metatile: a buffer-size on the map
+// lets features and labels crossing bands be drawn on both sides. The writer
+// has the size of the map and is finished at the end.
+MAPNIK_DECL void render_in_bands(Map const& map,
+                                 image_row_writer& writer,
+                                 unsigned band_height,
+                                 double scale_factor = 1.0);
+
 } // namespace mapnik
 
 #endif // MAPNIK_AGG_RENDERER_HPP
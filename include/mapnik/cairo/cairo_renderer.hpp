@@ -32,6 +32,7 @@
 #include <mapnik/rule.hpp> // for all symbolizers
 #include <mapnik/cairo/cairo_context.hpp>
 #include <mapnik/renderer_common.hpp>
+#include <mapnik/renderer_common/label_placement_queue.hpp>
 
 // stl
 #include <memory>
@@ -134,7 +135,17 @@ class MAPNIK_DECL cairo_renderer : public feature_style_processor<cairo_renderer
     renderer_common common_;
     cairo_face_manager face_manager_;
     bool style_level_compositing_;
+    label_placement_queue label_queue_;
     void setup(Map const& m);
+    void render_label(text_symbolizer const& sym,
+                      mapnik::feature_impl& feature,
+                      proj_transform const& prj_trans,
+                      box2d<double> const& clip_box);
+    void render_label(shield_symbolizer const& sym,
+                      mapnik::feature_impl& feature,
+                      proj_transform const& prj_trans,
+                      box2d<double> const& clip_box);
+    void render_queued_labels();
 };
 
 extern template class MAPNIK_DECL cairo_renderer<cairo_ptr>;
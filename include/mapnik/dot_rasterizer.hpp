@@ -0,0 +1,99 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_DOT_RASTERIZER_HPP
+#define MAPNIK_DOT_RASTERIZER_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/color.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/image_compositing.hpp>
+#include <mapnik/geometry.hpp>
+
+// stl
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace mapnik {
+
+class proj_transform;
+class view_transform;
+
+// Draws many dots of the same size at once, for point clouds rendered with
+// dot-symbolizer marker-rasterizer="sprite". The antialiased coverage of the
+// ellipse is rasterized once for each quarter pixel position of its center and
+// then stamped at every point. Dots no larger than a pixel are drawn as single
+// pixels covered by the area of the ellipse.
+class MAPNIK_DECL dot_rasterizer
+{
+  public:
+    using point_type = geometry::point<double>;
+
+    // rx and ry are the radii in pixels.
+    dot_rasterizer(double rx, double ry);
+
+    double rx() const { return rx_; }
+    double ry() const { return ry_; }
+
+    // Blends fill at the given opacity with the composite operation at each
+    // point, in screen coordinates, of the premultiplied image.
+    void blend(image_rgba8& image,
+               color const& fill,
+               double opacity,
+               composite_mode_e comp_op,
+               std::vector<point_type> const& points) const;
+
+    // Adds the coverage of a dot, from 0 to weight, at each point to density.
+    // Colorize the result with a raster colorizer, for instance.
+    void accumulate(image_gray32f& density, std::vector<point_type> const& points, float weight = 1.0f) const;
+
+    // Appends the vertices of geom to points in screen coordinates. All of
+    // them are reprojected in one batch.
+    static void append_points(geometry::geometry<double> const& geom,
+                              proj_transform const& prj_trans,
+                              view_transform const& tr,
+                              std::vector<point_type>& points);
+
+  private:
+    struct stamp
+    {
+        // offset of the top left corner from the pixel of the dot center
+        int x;
+        int y;
+        int width;
+        int height;
+        std::vector<std::uint8_t> cover;
+    };
+
+    template<typename Op>
+    void apply(int width, int height, std::vector<point_type> const& points, Op op) const;
+
+    double rx_;
+    double ry_;
+    std::array<stamp, 16> stamps_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_DOT_RASTERIZER_HPP
@@ -35,6 +35,7 @@
 #include <mapnik/image_compositing.hpp> // for composite_mode_e
 #include <mapnik/pixel_position.hpp>
 #include <mapnik/renderer_common.hpp>
+#include <mapnik/renderer_common/label_placement_queue.hpp>
 
 // stl
 #include <memory>
@@ -79,7 +80,7 @@ class MAPNIK_DECL grid_renderer : public feature_style_processor<grid_renderer<T
     void end_map_processing(Map const& map);
     void start_layer_processing(layer const& lay, box2d<double> const& query_extent);
     void end_layer_processing(layer const& lay);
-    void start_style_processing(feature_type_style const& /*st*/) {}
+    void start_style_processing(feature_type_style const& st);
     void end_style_processing(feature_type_style const& /*st*/) {}
     void render_marker(mapnik::feature_impl const& feature,
                        pixel_position const& pos,
@@ -117,10 +118,21 @@ class MAPNIK_DECL grid_renderer : public feature_style_processor<grid_renderer<T
     inline attributes const& variables() const { return common_.vars_; }
 
   private:
+    Map const& m_;
     buffer_type& pixmap_;
     const std::unique_ptr<grid_rasterizer> ras_ptr;
     renderer_common common_;
+    label_placement_queue label_queue_;
     void setup(Map const& m);
+    void render_label(text_symbolizer const& sym,
+                      mapnik::feature_impl& feature,
+                      proj_transform const& prj_trans,
+                      box2d<double> const& clip_box);
+    void render_label(shield_symbolizer const& sym,
+                      mapnik::feature_impl& feature,
+                      proj_transform const& prj_trans,
+                      box2d<double> const& clip_box);
+    void render_queued_labels();
 };
 } // namespace mapnik
 
@@ -30,6 +30,8 @@
 
 // stl
 #include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <set>
 #include <cmath>
@@ -49,6 +51,123 @@ struct RGBAPolicy
     }
 };
 
+// Open addressing map from packed rgba colors to small values.
+template<typename V>
+class color_table
+{
+    struct entry
+    {
+        std::uint32_t color;
+        V value;
+        bool used;
+    };
+
+  public:
+    color_table()
+        : entries_(1024, entry{0, V(), false})
+        , size_(0)
+        , shift_(22)
+    {}
+
+    std::size_t size() const { return size_; }
+
+    V const* find(std::uint32_t color) const
+    {
+        std::size_t mask = entries_.size() - 1;
+        for (std::size_t i = slot(color);; i = (i + 1) & mask)
+        {
+            entry const& e = entries_[i];
+            if (!e.used)
+                return nullptr;
+            if (e.color == color)
+                return &e.value;
+        }
+    }
+
+    // The value of color, inserted with init when missing.
+    V& get(std::uint32_t color, V init = V())
+    {
+        std::size_t mask = entries_.size() - 1;
+        for (std::size_t i = slot(color);; i = (i + 1) & mask)
+        {
+            entry& e = entries_[i];
+            if (e.used && e.color == color)
+                return e.value;
+            if (!e.used)
+            {
+                if (2 * (size_ + 1) > entries_.size())
+                {
+                    grow();
+                    return get(color, init);
+                }
+                ++size_;
+                e = entry{color, init, true};
+                return e.value;
+            }
+        }
+    }
+
+    void insert(std::uint32_t color, V value) { get(color) = value; }
+
+    // Calls f(color, value) for every color, in no particular order.
+    template<typename F>
+    void for_each(F f) const
+    {
+        for (entry const& e : entries_)
+        {
+            if (e.used)
+                f(e.color, e.value);
+        }
+    }
+
+  private:
+    std::size_t slot(std::uint32_t color) const { return (color * 2654435761u) >> shift_; }
+
+    void grow()
+    {
+        std::vector<entry> old(entries_.size() * 2, entry{0, V(), false});
+        old.swap(entries_);
+        size_ = 0;
+        --shift_;
+        for (entry const& e : old)
+        {
+            if (e.used)
+                get(e.color, e.value);
+        }
+    }
+
+    std::vector<entry> entries_;
+    std::size_t size_;
+    unsigned shift_;
+};
+
+// Number of pixels of every distinct color of an image, to insert each color
+// into a hextree once rather than every pixel.
+class color_histogram : public color_table<unsigned>
+{
+  public:
+    template<typename Image>
+    void add(Image const& image)
+    {
+        for (unsigned y = 0; y < image.height(); ++y)
+        {
+            typename Image::pixel_type const* row = image.get_row(y);
+            unsigned x = 0;
+            while (x < image.width())
+            {
+                // runs of a color are common in rendered maps
+                unsigned val = row[x];
+                unsigned run = 1;
+                while (++x < image.width() && row[x] == val)
+                {
+                    ++run;
+                }
+                get(val) += run;
+            }
+        }
+    }
+};
+
 template<typename T, typename InsertPolicy = RGBAPolicy>
 class hextree : private util::noncopyable
 {
@@ -64,23 +183,12 @@ class hextree : private util::noncopyable
             , reduce_cost(0.0)
             , children_count(0)
         {
-            std::fill(children_, children_ + 16, nullptr);
-        }
-
-        ~node()
-        {
-            for (unsigned i = 0; i < 16; ++i)
-            {
-                if (children_[i] != 0)
-                {
-                    delete children_[i];
-                    children_[i] = 0;
-                }
-            }
+            std::fill(children_, children_ + 16, 0u);
         }
 
         bool is_leaf() const { return (children_count == 0); }
-        node* children_[16];
+        // numbers of the child nodes, 0 for none (the root is nobody's child)
+        unsigned children_[16];
         // sum of values for computing mean value using count or pixel_count
         double reds;
         double greens;
@@ -113,13 +221,17 @@ class hextree : private util::noncopyable
     unsigned colors_;
     // flag indicating existance of invisible pixels (a < InsertPolicy::MIN_ALPHA)
     bool has_holes_;
-    const std::unique_ptr<node> root_;
+    // nodes are allocated in blocks, the root first, so that the tree is
+    // freed at once and does not move while it grows
+    static const unsigned NODE_BLOCK_BITS = 10;
+    std::vector<std::unique_ptr<node[]>> node_blocks_;
+    unsigned node_count_;
     // working palette for quantization, sorted on mean(r,g,b,a) for easier searching NN
     std::vector<rgba> sorted_pal_;
     // index remaping of sorted_pal_ indexes to indexes of returned image palette
     std::vector<unsigned> pal_remap_;
-    // rgba hashtable for quantization
-    mutable rgba_hash_table color_hashmap_;
+    // index in sorted_pal_ of every color quantized so far
+    mutable color_table<std::uint8_t> color_hashmap_;
     // gamma correction to prioritize dark colors (>1.0)
     double gamma_;
     // look up table for gamma correction
@@ -135,19 +247,13 @@ class hextree : private util::noncopyable
         : max_colors_(max_colors)
         , colors_(0)
         , has_holes_(false)
-        , root_(new node())
-        ,
-#ifdef USE_DENSE_HASH_MAP
-        // TODO - test for any benefit to initializing at a larger size
-        color_hashmap_()
-        ,
-#endif
-        trans_mode_(FULL_TRANSPARENCY)
+        , node_blocks_()
+        , node_count_(0)
+        , color_hashmap_()
+        , trans_mode_(FULL_TRANSPARENCY)
     {
         setGamma(g);
-#ifdef USE_DENSE_HASH_MAP
-        color_hashmap_.set_empty_key(0);
-#endif
+        new_node();
     }
 
     ~hextree() {}
@@ -190,27 +296,35 @@ class hextree : private util::noncopyable
         }
     }
 
-    void insert(T const& data)
+    void insert(T const& data) { insert(data, 1); }
+
+    // Inserts count pixels of the same color at once, see color_histogram.
+    void insert(T const& data, unsigned count)
     {
         std::uint8_t a = preprocessAlpha(data.a);
         unsigned level = 0;
-        node* cur_node = root_.get();
+        node* cur_node = root();
         if (a < InsertPolicy::MIN_ALPHA)
         {
             has_holes_ = true;
             return;
         }
+        double r = gammaLUT_[data.r] * count;
+        double g = gammaLUT_[data.g] * count;
+        double b = gammaLUT_[data.b] * count;
+        double alpha = double(a) * count;
         while (true)
         {
-            cur_node->pixel_count++;
-            cur_node->reds += gammaLUT_[data.r];
-            cur_node->greens += gammaLUT_[data.g];
-            cur_node->blues += gammaLUT_[data.b];
-            cur_node->alphas += a;
+            bool empty = cur_node->pixel_count == 0;
+            cur_node->pixel_count += count;
+            cur_node->reds += r;
+            cur_node->greens += g;
+            cur_node->blues += b;
+            cur_node->alphas += alpha;
 
             if (level == InsertPolicy::MAX_LEVELS)
             {
-                if (cur_node->pixel_count == 1)
+                if (empty)
                 {
                     ++colors_;
                 }
@@ -221,9 +335,9 @@ class hextree : private util::noncopyable
             if (cur_node->children_[idx] == 0)
             {
                 cur_node->children_count++;
-                cur_node->children_[idx] = new node();
+                cur_node->children_[idx] = new_node();
             }
-            cur_node = cur_node->children_[idx];
+            cur_node = child(cur_node, idx);
             ++level;
         }
     }
@@ -242,8 +356,8 @@ class hextree : private util::noncopyable
             return pal_remap_[has_holes_ ? 1 : 0];
         }
 
-        rgba_hash_table::iterator it = color_hashmap_.find(val);
-        if (it == color_hashmap_.end())
+        std::uint8_t const* cached = color_hashmap_.find(val);
+        if (cached == nullptr)
         {
             rgba c(val);
             int dr, dg, db, da;
@@ -300,11 +414,11 @@ class hextree : private util::noncopyable
                 }
             }
             // put found index in hash map
-            color_hashmap_[val] = ind;
+            color_hashmap_.insert(val, static_cast<std::uint8_t>(ind));
         }
         else
         {
-            ind = it->second;
+            ind = *cached;
         }
 
         return pal_remap_[ind];
@@ -321,7 +435,7 @@ class hextree : private util::noncopyable
         assign_node_colors();
 
         sorted_pal_.reserve(colors_);
-        create_palette_rek(sorted_pal_, root_.get());
+        create_palette_rek(sorted_pal_, root());
 
         // sort palette for binary searching in quantization
         std::sort(sorted_pal_.begin(), sorted_pal_.end(), rgba::mean_sort_cmp());
@@ -348,8 +462,24 @@ class hextree : private util::noncopyable
     }
 
   private:
+    node* get_node(unsigned n) const
+    {
+        return &node_blocks_[n >> NODE_BLOCK_BITS][n & ((1u << NODE_BLOCK_BITS) - 1)];
+    }
+
+    node* root() const { return get_node(0); }
+    node* child(node const* n, unsigned idx) const { return get_node(n->children_[idx]); }
+
+    unsigned new_node()
+    {
+        if ((node_count_ & ((1u << NODE_BLOCK_BITS) - 1)) == 0)
+        {
+            node_blocks_.emplace_back(new node[1u << NODE_BLOCK_BITS]);
+        }
+        return node_count_++;
+    }
 
-    void print_tree(node* r, int d = 0, int id = 0) const
+    void print_tree(node const* r, int d = 0, int id = 0) const
     {
         for (int i = 0; i < d; i++)
         {
@@ -383,14 +513,14 @@ class hextree : private util::noncopyable
         {
             if (r->children_[idx] != 0)
             {
-                print_tree(r->children_[idx], d + 1, idx);
+                print_tree(child(r, idx), d + 1, idx);
             }
         }
     }
 
     // traverse tree and search for nodes with count!=0, that represent single color.
     // clip extreme alfa values
-    void create_palette_rek(std::vector<rgba>& palette, node* itr) const
+    void create_palette_rek(std::vector<rgba>& palette, node const* itr) const
     {
         if (itr->count != 0)
         {
@@ -404,12 +534,14 @@ class hextree : private util::noncopyable
                                    static_cast<std::uint8_t>(round(gamma(itr->greens / count, gamma_))),
                                    static_cast<std::uint8_t>(round(gamma(itr->blues / count, gamma_))),
                                    a));
+            // the subtree is represented by this color
+            return;
         }
         for (unsigned idx = 0; idx < 16; ++idx)
         {
             if (itr->children_[idx] != 0)
             {
-                create_palette_rek(palette, itr->children_[idx]);
+                create_palette_rek(palette, child(itr, idx));
             }
         }
     }
@@ -434,35 +566,37 @@ class hextree : private util::noncopyable
             if (r->children_[idx] != 0)
             {
                 double dr, dg, db, da;
-                compute_cost(r->children_[idx]);
+                node* c = child(r, idx);
+                compute_cost(c);
                 // include childrens penalty
-                r->reduce_cost += r->children_[idx]->reduce_cost;
+                r->reduce_cost += c->reduce_cost;
                 // difference between mean value and subtree mean value
-                dr = r->children_[idx]->reds / r->children_[idx]->pixel_count - mean_r;
-                dg = r->children_[idx]->greens / r->children_[idx]->pixel_count - mean_g;
-                db = r->children_[idx]->blues / r->children_[idx]->pixel_count - mean_b;
-                da = r->children_[idx]->alphas / r->children_[idx]->pixel_count - mean_a;
+                dr = c->reds / c->pixel_count - mean_r;
+                dg = c->greens / c->pixel_count - mean_g;
+                db = c->blues / c->pixel_count - mean_b;
+                da = c->alphas / c->pixel_count - mean_a;
                 // penalty_x = d_x^2 * pixel_count * mean_alfa/255, where x=r,g,b,a
                 // mean_alpha/255 because more opaque color = more noticable differences
-                r->reduce_cost += (dr * dr + dg * dg + db * db + da * da) * r->children_[idx]->alphas / 255;
+                r->reduce_cost += (dr * dr + dg * dg + db * db + da * da) * c->alphas / 255;
             }
         }
     }
 
-    // starting from root_, unfold nodes with biggest penalty
+    // starting from the root, unfold nodes with biggest penalty
     // until all available colors are assigned to processed nodes
     void assign_node_colors()
     {
-        compute_cost(root_.get());
+        node* root = this->root();
+        compute_cost(root);
 
         int tries = 0;
 
-        // at the begining, single color assigned to root_
+        // at the begining, single color assigned to the root
         colors_ = 1;
-        root_->count = root_->pixel_count;
+        root->count = root->pixel_count;
 
         std::set<node*, node_rev_cmp> colored_leaves_heap;
-        colored_leaves_heap.insert(root_.get());
+        colored_leaves_heap.insert(root);
         while ((!colored_leaves_heap.empty() && (colors_ < max_colors_) && (tries < 16)))
         {
             // select worst node to remove it from palette and replace with children
@@ -484,7 +618,7 @@ class hextree : private util::noncopyable
                 {
                     if (cur_node->children_[idx] != 0)
                     {
-                        node* n = cur_node->children_[idx];
+                        node* n = child(cur_node, idx);
                         n->count = n->pixel_count;
                         colored_leaves_heap.insert(n);
                         colors_++;
@@ -39,6 +39,7 @@ MAPNIK_DISABLE_WARNING_POP
 // stl
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace mapnik {
 
@@ -59,13 +60,44 @@ class image_reader_exception : public std::exception
 
 struct MAPNIK_DECL image_reader : private util::noncopyable
 {
+    struct window
+    {
+        unsigned x;
+        unsigned y;
+        unsigned width;
+        unsigned height;
+    };
+
     virtual unsigned width() const = 0;
     virtual unsigned height() const = 0;
     virtual bool has_alpha() const = 0;
     virtual boost::optional<box2d<double>> bounding_box() const = 0;
     virtual void read(unsigned x, unsigned y, image_rgba8& image) = 0;
     virtual image_any read(unsigned x, unsigned y, unsigned width, unsigned height) = 0;
+    // Factor, 1, 2, 4 or 8, by which read_scaled can shrink a window of width
+    // by height pixels and keep at least target_width by target_height of them.
+    // jpeg and webp shrink while decoding, the other formats return 1.
+    virtual unsigned
+      scale_denominator(unsigned width, unsigned height, unsigned target_width, unsigned target_height) const;
+    // Reads the window of width by height pixels at x, y shrunk by a
+    // scale_denominator, into ceil(width / denominator) by
+    // ceil(height / denominator) pixels.
+    virtual image_any read_scaled(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator);
+    // The part of the image, in its pixels, covered by what read_scaled
+    // returns for the window: the window grown to whole pixels of the shrunk
+    // image, as jpeg decodes past the right and bottom edges. webp stretches
+    // the last pixels over what is left of the image there instead.
+    virtual box2d<double>
+      scaled_window(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator) const;
+    // Reads several windows, as read(x, y, width, height) does each of them.
+    // The png reader decodes the rows they cover once.
+    virtual std::vector<image_any> read_windows(std::vector<window> const& windows);
     virtual ~image_reader() {}
+
+  protected:
+    // The largest of 2, 4 and 8 that keeps the target size, or 1.
+    static unsigned
+      power_of_two_denominator(unsigned width, unsigned height, unsigned target_width, unsigned target_height);
 };
 
 template<typename... Args>
@@ -78,6 +110,11 @@ MAPNIK_DECL image_reader* get_image_reader(std::string const& file, std::string
 MAPNIK_DECL image_reader* get_image_reader(std::string const& file);
 MAPNIK_DECL image_reader* get_image_reader(char const* data, size_t size);
 
+// Bytes of decoded rows a png reader keeps for its next read, 64MB by
+// default. Readers use the value set when they are created.
+MAPNIK_DECL std::size_t png_reader_cache_size();
+MAPNIK_DECL void set_png_reader_cache_size(std::size_t bytes);
+
 } // namespace mapnik
 
 #endif // MAPNIK_IMAGE_READER_HPP
@@ -0,0 +1,78 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+#ifndef MAPNIK_IMAGE_ROW_WRITER_HPP
+#define MAPNIK_IMAGE_ROW_WRITER_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/image_view.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace mapnik {
+
+// Encodes an rgba8 image handed over a few rows at a time, from top to
+// bottom, so that the whole image never has to be in memory. Rows are
+// expected with demultiplied alpha, as renderers leave them.
+class MAPNIK_DECL image_row_writer : private util::noncopyable
+{
+  public:
+    image_row_writer(unsigned width, unsigned height);
+    virtual ~image_row_writer();
+
+    unsigned width() const { return width_; }
+    unsigned height() const { return height_; }
+    unsigned rows_written() const { return rows_written_; }
+
+    // Appends the rows of the view below the rows written so far.
+    void write(image_view_rgba8 const& rows);
+
+    // Ends the file once all rows are written.
+    void finish();
+
+  protected:
+    virtual void write_rows(image_view_rgba8 const& rows) = 0;
+    virtual void finish_image() = 0;
+
+  private:
+    unsigned width_;
+    unsigned height_;
+    unsigned rows_written_;
+    bool finished_;
+};
+
+// A writer of an image of the given size and type to the stream. The type
+// takes the options of save_to_stream for png24/png32, tiff and jpeg. Paletted
+// png and webp need all of the pixels up front and are not supported.
+MAPNIK_DECL std::unique_ptr<image_row_writer>
+  create_image_row_writer(std::ostream& stream, std::string const& type, unsigned width, unsigned height);
+
+} // namespace mapnik
+
+#endif // MAPNIK_IMAGE_ROW_WRITER_HPP
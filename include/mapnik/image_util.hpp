@@ -38,6 +38,7 @@ MAPNIK_DISABLE_WARNING_POP
 // stl
 #include <string>
 #include <exception>
+#include <vector>
 
 namespace mapnik {
 
@@ -86,6 +87,14 @@ MAPNIK_DECL std::string save_to_string(T const& image, std::string const& type);
 template<typename T>
 MAPNIK_DECL std::string save_to_string(T const& image, std::string const& type, rgba_palette const& palette);
 
+// Encodes the image to each of the types, as save_to_string does, for tiles
+// served in several formats. The image is checked for a single color once and
+// the types are encoded on up to threads threads, 0 means one per hardware
+// thread.
+template<typename T>
+MAPNIK_DECL std::vector<std::string>
+  save_to_strings(T const& image, std::vector<std::string> const& types, int threads = 0);
+
 template<typename T>
 MAPNIK_DECL void
   save_to_stream(T const& image, std::ostream& stream, std::string const& type, rgba_palette const& palette);
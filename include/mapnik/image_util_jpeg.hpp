@@ -26,13 +26,36 @@
 #include <mapnik/config.hpp>
 
 // stl
+#include <memory>
 #include <string>
 #include <iostream>
 
 namespace mapnik {
+class image_row_writer;
+
+struct jpeg_options
+{
+    jpeg_options()
+        : quality(85)
+        , optimize(false)
+        , progressive(false)
+    {}
+
+    int quality;
+    // Huffman tables computed for the image, a few percent smaller
+    bool optimize;
+    // scans of increasing detail, see jpeg_simple_progression
+    bool progressive;
+};
+
 namespace detail {
 MAPNIK_DECL int parse_jpeg_quality(std::string const& params);
-}
+// jpeg85:optimize:progressive, or with =true/=false
+MAPNIK_DECL jpeg_options parse_jpeg_options(std::string const& params);
+// t is the lower case type
+std::unique_ptr<image_row_writer>
+  create_jpeg_row_writer(std::ostream& stream, std::string const& t, unsigned width, unsigned height);
+} // namespace detail
 struct jpeg_saver
 {
     jpeg_saver(std::ostream&, std::string const&);
@@ -26,11 +26,20 @@
 #include <mapnik/palette.hpp>
 
 // stl
+#include <memory>
 #include <string>
 #include <iostream>
 
 namespace mapnik {
 
+class image_row_writer;
+
+namespace detail {
+// t is the lower case type
+std::unique_ptr<image_row_writer>
+  create_png_row_writer(std::ostream& stream, std::string const& t, unsigned width, unsigned height);
+} // namespace detail
+
 struct png_saver_pal
 {
     png_saver_pal(std::ostream&, std::string const&, rgba_palette const&);
@@ -24,11 +24,20 @@
 #define MAPNIK_IMAGE_UTIL_TIFF_HPP
 
 // stl
+#include <memory>
 #include <string>
 #include <iostream>
 
 namespace mapnik {
 
+class image_row_writer;
+
+namespace detail {
+// t is the lower case type
+std::unique_ptr<image_row_writer>
+  create_tiff_row_writer(std::ostream& stream, std::string const& t, unsigned width, unsigned height);
+} // namespace detail
+
 struct tiff_saver
 {
     tiff_saver(std::ostream&, std::string const&);
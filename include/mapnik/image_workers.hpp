@@ -20,27 +20,26 @@
  *
  *****************************************************************************/
 
-#ifndef MAPNIK_SVG_PATH_GRAMMAR_X3_HPP
-#define MAPNIK_SVG_PATH_GRAMMAR_X3_HPP
+#ifndef MAPNIK_IMAGE_WORKERS_HPP
+#define MAPNIK_IMAGE_WORKERS_HPP
 
-#include <mapnik/svg/svg_grammar_config_x3.hpp>
+#include <mapnik/config.hpp>
 
-namespace mapnik {
-namespace svg {
-namespace grammar {
-
-namespace x3 = boost::spirit::x3;
+// stl
+#include <cstddef>
+#include <functional>
 
-using svg_path_grammar_type = x3::rule<class svg_path_rule_tag>;
-using svg_points_grammar_type = x3::rule<class svg_points_rule_tag>;
-
-svg_path_grammar_type const svg_path = "SVG Path";
-svg_points_grammar_type const svg_points = "SVG_Points";
+namespace mapnik {
+namespace detail {
 
-BOOST_SPIRIT_DECLARE(svg_path_grammar_type, svg_points_grammar_type);
+// Runs work on the calling thread and on up to helpers threads of a pool kept
+// for the lifetime of the process, shared by the encoders of save_to_strings
+// and the png bands. work must not throw and must return once nothing is left
+// to do: copies which haven't started by the time the one of the calling
+// thread returns are not run, so work may itself run workers.
+MAPNIK_DECL void run_image_workers(std::size_t helpers, std::function<void()> const& work);
 
-} // namespace grammar
-} // namespace svg
+} // namespace detail
 } // namespace mapnik
 
-#endif // MAPNIK_SVG_PATH_GRAMMAR_X3_HPP
+#endif // MAPNIK_IMAGE_WORKERS_HPP
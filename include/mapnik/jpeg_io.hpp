@@ -25,9 +25,17 @@
 
 #if defined(HAVE_JPEG)
 
-#include <new>
-#include <ostream>
+// mapnik
+#include <mapnik/image_util.hpp>
+#include <mapnik/image_util_jpeg.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <cstddef>
 #include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
 
 extern "C" {
 #include <jpeglib.h>
@@ -74,59 +82,192 @@ inline void term_destination(j_compress_ptr cinfo)
     dest->out->flush();
 }
 
-} // namespace jpeg_detail
+// Writes the compressed data of cinfo to out.
+inline void set_stream_dest(j_compress_ptr cinfo, std::ostream* out)
+{
+    cinfo->dest = (struct jpeg_destination_mgr*)(*cinfo->mem->alloc_small)((j_common_ptr)cinfo,
+                                                                          JPOOL_PERMANENT,
+                                                                          sizeof(dest_mgr));
+    dest_mgr* dest = reinterpret_cast<dest_mgr*>(cinfo->dest);
+    dest->pub.init_destination = init_destination;
+    dest->pub.empty_output_buffer = empty_output_buffer;
+    dest->pub.term_destination = term_destination;
+    dest->out = out;
+}
 
-namespace mapnik {
+inline void on_error(j_common_ptr cinfo)
+{
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, buffer);
+    throw mapnik::image_writer_exception(std::string("JPEG Writer: libjpeg could not write image: ") + buffer);
+}
 
-template<typename T1, typename T2>
-void save_as_jpeg(T1& file, int quality, T2 const& image)
+// Sets the input color space for rgba8 pixels. libjpeg-turbo reads them as
+// they are and skips the alpha byte, plain libjpeg gets rows of RGB.
+inline void set_rgba8_input(j_compress_ptr cinfo)
 {
-    struct jpeg_compress_struct cinfo;
-    struct jpeg_error_mgr jerr;
+#if defined(JCS_EXTENSIONS)
+    cinfo->input_components = 4;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    cinfo->in_color_space = JCS_EXT_XBGR;
+#else
+    cinfo->in_color_space = JCS_EXT_RGBX;
+#endif
+#else
+    cinfo->input_components = 3;
+    cinfo->in_color_space = JCS_RGB;
+#endif
+}
 
-    int width = static_cast<int>(image.width());
-    int height = static_cast<int>(image.height());
-
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_compress(&cinfo);
-
-    cinfo.dest = (struct jpeg_destination_mgr*)(*cinfo.mem->alloc_small)((j_common_ptr)&cinfo,
-                                                                         JPOOL_PERMANENT,
-                                                                         sizeof(jpeg_detail::dest_mgr));
-    jpeg_detail::dest_mgr* dest = reinterpret_cast<jpeg_detail::dest_mgr*>(cinfo.dest);
-    dest->pub.init_destination = jpeg_detail::init_destination;
-    dest->pub.empty_output_buffer = jpeg_detail::empty_output_buffer;
-    dest->pub.term_destination = jpeg_detail::term_destination;
-    dest->out = &file;
-
-    // jpeg_stdio_dest(&cinfo, fp);
-    cinfo.image_width = width;
-    cinfo.image_height = height;
-    cinfo.input_components = 3;
-    cinfo.in_color_space = JCS_RGB;
-    jpeg_set_defaults(&cinfo);
-    jpeg_set_quality(&cinfo, quality, boolean(1));
-    jpeg_start_compress(&cinfo, boolean(1));
-    JSAMPROW row_pointer[1];
-    JSAMPLE* row = reinterpret_cast<JSAMPLE*>(::operator new(sizeof(JSAMPLE) * width * 3));
-    while (cinfo.next_scanline < cinfo.image_height)
+// Call after the size and the input color space are set.
+inline void set_options(j_compress_ptr cinfo, mapnik::jpeg_options const& opts)
+{
+    jpeg_set_defaults(cinfo);
+    jpeg_set_quality(cinfo, opts.quality, boolean(1));
+    cinfo->optimize_coding = boolean(opts.optimize);
+    if (opts.progressive)
     {
-        const unsigned* imageRow = image.get_row(cinfo.next_scanline);
-        int index = 0;
-        for (int i = 0; i < width; ++i)
+        jpeg_simple_progression(cinfo);
+    }
+}
+
+// Writes the rows of an rgba8 image or view. rgb is scratch space for the
+// rows converted for plain libjpeg.
+template<typename T>
+void write_rgba8_rows(j_compress_ptr cinfo, T const& image, std::vector<JSAMPLE>& rgb)
+{
+    std::size_t height = image.height();
+#if defined(JCS_EXTENSIONS)
+    (void)rgb;
+    JSAMPROW rows[16];
+    std::size_t y = 0;
+    while (y < height)
+    {
+        JDIMENSION count = 0;
+        for (; count < 16 && y + count < height; ++count)
+        {
+            rows[count] = const_cast<JSAMPROW>(reinterpret_cast<JSAMPLE const*>(image.get_row(y + count)));
+        }
+        JDIMENSION written = jpeg_write_scanlines(cinfo, rows, count);
+        if (written == 0)
         {
-            row[index++] = (imageRow[i]) & 0xff;
-            row[index++] = (imageRow[i] >> 8) & 0xff;
-            row[index++] = (imageRow[i] >> 16) & 0xff;
+            throw mapnik::image_writer_exception("JPEG Writer: failed to write to stream");
         }
-        row_pointer[0] = &row[0];
-        (void)jpeg_write_scanlines(&cinfo, row_pointer, 1);
+        y += written;
     }
-    ::operator delete(row);
+#else
+    std::size_t width = image.width();
+    rgb.resize(width * 3);
+    JSAMPROW row_pointer[1] = {rgb.data()};
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        auto const* pixels = image.get_row(y);
+        JSAMPLE* out = rgb.data();
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            *out++ = pixels[x] & 0xff;
+            *out++ = (pixels[x] >> 8) & 0xff;
+            *out++ = (pixels[x] >> 16) & 0xff;
+        }
+        if (jpeg_write_scanlines(cinfo, row_pointer, 1) == 0)
+        {
+            throw mapnik::image_writer_exception("JPEG Writer: failed to write to stream");
+        }
+    }
+#endif
+}
 
-    jpeg_finish_compress(&cinfo);
-    jpeg_destroy_compress(&cinfo);
+// A compressor kept by each thread for the images it saves. libjpeg holds on
+// to its tables and memory pools from one image to the next, so only the
+// per image buffers are allocated again.
+struct compressor : private mapnik::util::noncopyable
+{
+    compressor()
+    {
+        cinfo.err = jpeg_std_error(&jerr);
+        jerr.error_exit = on_error;
+        jpeg_create_compress(&cinfo);
+        dest.pub.init_destination = init_destination;
+        dest.pub.empty_output_buffer = empty_output_buffer;
+        dest.pub.term_destination = term_destination;
+        dest.out = nullptr;
+        dest.buffer = nullptr;
+        cinfo.dest = &dest.pub;
+        cinfo.input_components = 3;
+        cinfo.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+        for (int i = 0; i < 2; ++i)
+        {
+            dc_tables[i] = *cinfo.dc_huff_tbl_ptrs[i];
+            ac_tables[i] = *cinfo.ac_huff_tbl_ptrs[i];
+        }
+    }
+
+    ~compressor() { jpeg_destroy_compress(&cinfo); }
+
+    void set_options(mapnik::jpeg_options const& opts)
+    {
+        jpeg_detail::set_options(&cinfo, opts);
+        // jpeg_set_defaults keeps the Huffman tables that are already
+        // allocated, optimize_coding overwrites them
+        for (int i = 0; i < 2; ++i)
+        {
+            *cinfo.dc_huff_tbl_ptrs[i] = dc_tables[i];
+            *cinfo.ac_huff_tbl_ptrs[i] = ac_tables[i];
+        }
+    }
+
+    static compressor& get()
+    {
+        static thread_local compressor instance;
+        return instance;
+    }
+
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    dest_mgr dest;
+    std::vector<JSAMPLE> rgb;
+    JHUFF_TBL dc_tables[2];
+    JHUFF_TBL ac_tables[2];
+};
+
+} // namespace jpeg_detail
+
+namespace mapnik {
+
+template<typename T1, typename T2>
+void save_as_jpeg(T1& file, jpeg_options const& opts, T2 const& image)
+{
+    jpeg_detail::compressor& c = jpeg_detail::compressor::get();
+    c.dest.out = &file;
+    c.cinfo.image_width = static_cast<JDIMENSION>(image.width());
+    c.cinfo.image_height = static_cast<JDIMENSION>(image.height());
+    jpeg_detail::set_rgba8_input(&c.cinfo);
+    try
+    {
+        c.set_options(opts);
+        jpeg_start_compress(&c.cinfo, boolean(1));
+        jpeg_detail::write_rgba8_rows(&c.cinfo, image, c.rgb);
+        jpeg_finish_compress(&c.cinfo);
+    }
+    catch (...)
+    {
+        // back to the idle state for the next image
+        jpeg_abort_compress(&c.cinfo);
+        c.dest.out = nullptr;
+        throw;
+    }
+    c.dest.out = nullptr;
+}
+
+template<typename T1, typename T2>
+void save_as_jpeg(T1& file, int quality, T2 const& image)
+{
+    jpeg_options opts;
+    opts.quality = quality;
+    save_as_jpeg(file, opts, image);
 }
+
 } // namespace mapnik
 
 #endif
@@ -35,6 +35,11 @@ MAPNIK_DISABLE_WARNING_PUSH
 MAPNIK_DISABLE_WARNING_POP
 
 // stl
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
 #include <vector>
 
 namespace mapnik {
@@ -120,128 +125,304 @@ class label_collision_detector3 : util::noncopyable
     void clear() { tree_.clear(); }
 };
 
-// quad tree based label collision detector so labels dont appear within a given distance
+// uniform grid based label collision detector so labels dont appear within a given distance
+//
+// Boxes are kept in flat (structure of arrays) storage and bucketed into a grid
+// sized from the detector extent. Label texts used for repeat-distance checks are
+// interned once per render, so each stored box only carries a small integer id.
 class label_collision_detector4 : util::noncopyable
 {
   public:
-    struct label
-    {
-        label(box2d<double> const& b)
-            : box(b)
-            , text()
-        {}
-        label(box2d<double> const& b, mapnik::value_unicode_string const& t)
-            : box(b)
-            , text(t)
-        {}
-
-        box2d<double> box;
-        mapnik::value_unicode_string text;
-    };
+    // interned label text, 0 is reserved for labels without text
+    using text_id = std::uint32_t;
+    enum : text_id { no_text = 0 };
 
   private:
-    using tree_t = quad_tree<label>;
-    tree_t tree_;
-
-  public:
-    using query_iterator = tree_t::query_iterator;
-
-    explicit label_collision_detector4(box2d<double> const& _extent)
-        : tree_(_extent)
-    {}
+    // aim for cells of roughly this many pixels, bounded by max_grid_size per axis
+    static constexpr double target_cell_size = 64.0;
+    static constexpr unsigned max_grid_size = 128;
 
-    bool has_placement(box2d<double> const& box)
+    struct text_hasher
     {
-        tree_t::query_iterator tree_itr = tree_.query_in_box(box);
-        tree_t::query_iterator tree_end = tree_.query_end();
-
-        for (; tree_itr != tree_end; ++tree_itr)
+        std::size_t operator()(value_unicode_string const& text) const
         {
-            if (tree_itr->get().box.intersects(box))
-                return false;
+            return static_cast<std::size_t>(text.hashCode());
         }
+    };
 
-        return true;
+    using cell_type = std::vector<std::uint32_t>;
+    using text_map = std::unordered_map<value_unicode_string, text_id, text_hasher>;
+
+    box2d<double> extent_;
+    unsigned cols_;
+    unsigned rows_;
+    double inv_cell_width_;
+    double inv_cell_height_;
+    std::vector<cell_type> cells_;
+    std::vector<double> minx_;
+    std::vector<double> miny_;
+    std::vector<double> maxx_;
+    std::vector<double> maxy_;
+    std::vector<text_id> text_;
+    text_map texts_;
+    std::vector<std::uint32_t> nearby_;
+
+    static unsigned grid_size(double length)
+    {
+        double size = std::ceil(length / target_cell_size);
+        if (!(size > 1.0))
+            return 1;
+        return size < max_grid_size ? static_cast<unsigned>(size) : max_grid_size;
     }
 
-    bool has_placement(box2d<double> const& box, double margin)
+    static unsigned cell_index(double value, double origin, double inv_cell_size, unsigned size)
     {
-        box2d<double> const& margin_box =
-          (margin > 0
-             ? box2d<double>(box.minx() - margin, box.miny() - margin, box.maxx() + margin, box.maxy() + margin)
-             : box);
+        double index = (value - origin) * inv_cell_size;
+        if (!(index > 0.0))
+            return 0;
+        if (index >= size - 1)
+            return size - 1;
+        return static_cast<unsigned>(index);
+    }
 
-        tree_t::query_iterator tree_itr = tree_.query_in_box(margin_box);
-        tree_t::query_iterator tree_end = tree_.query_end();
+    bool intersects(std::uint32_t id, box2d<double> const& box) const
+    {
+        return !(minx_[id] > box.maxx() || maxx_[id] < box.minx() || miny_[id] > box.maxy() || maxy_[id] < box.miny());
+    }
 
-        for (; tree_itr != tree_end; ++tree_itr)
+    // Calls pred for every stored box sharing a grid cell with query and returns
+    // true as soon as pred does. Boxes spanning several cells may be visited more than once.
+    template<typename Pred>
+    bool any_of(box2d<double> const& query, Pred pred) const
+    {
+        if (minx_.empty())
+            return false;
+        unsigned x0 = cell_index(query.minx(), extent_.minx(), inv_cell_width_, cols_);
+        unsigned x1 = cell_index(query.maxx(), extent_.minx(), inv_cell_width_, cols_);
+        unsigned y0 = cell_index(query.miny(), extent_.miny(), inv_cell_height_, rows_);
+        unsigned y1 = cell_index(query.maxy(), extent_.miny(), inv_cell_height_, rows_);
+        for (unsigned y = y0; y <= y1; ++y)
         {
-            if (tree_itr->get().box.intersects(margin_box))
+            for (unsigned x = x0; x <= x1; ++x)
             {
-                return false;
+                for (std::uint32_t id : cells_[y * cols_ + x])
+                {
+                    if (pred(id))
+                        return true;
+                }
             }
         }
-        return true;
+        return false;
     }
 
-    bool has_placement(box2d<double> const& box,
-                       double margin,
-                       mapnik::value_unicode_string const& text,
-                       double repeat_distance)
+    static box2d<double> pad(box2d<double> const& box, double margin)
+    {
+        return margin > 0
+                 ? box2d<double>(box.minx() - margin, box.miny() - margin, box.maxx() + margin, box.maxy() + margin)
+                 : box;
+    }
+
+  public:
+
+    explicit label_collision_detector4(box2d<double> const& _extent)
+        : extent_(_extent)
+        , cols_(grid_size(_extent.width()))
+        , rows_(grid_size(_extent.height()))
+        , inv_cell_width_(_extent.width() > 0 ? cols_ / _extent.width() : 0.0)
+        , inv_cell_height_(_extent.height() > 0 ? rows_ / _extent.height() : 0.0)
+        , cells_(cols_ * rows_)
+    {}
+
+    // Returns the id of an already interned text or no_text.
+    text_id find_text(value_unicode_string const& text) const
+    {
+        if (text.length() == 0)
+            return no_text;
+        auto itr = texts_.find(text);
+        return itr != texts_.end() ? itr->second : no_text;
+    }
+
+    // Returns the id of text, interning it on first use.
+    text_id intern(value_unicode_string const& text)
+    {
+        if (text.length() == 0)
+            return no_text;
+        return texts_.emplace(text, static_cast<text_id>(texts_.size() + 1)).first->second;
+    }
+
+    bool has_placement(box2d<double> const& box) const
+    {
+        return !any_of(box, [&](std::uint32_t id) { return intersects(id, box); });
+    }
+
+    bool has_placement(box2d<double> const& box, double margin) const
+    {
+        box2d<double> const margin_box = pad(box, margin);
+        return !any_of(margin_box, [&](std::uint32_t id) { return intersects(id, margin_box); });
+    }
+
+    bool has_placement(box2d<double> const& box, double margin, text_id text, double repeat_distance) const
     {
         // Don't bother with any of the repeat checking unless the repeat distance is greater than the margin
-        if (repeat_distance <= margin)
+        if (text == no_text || repeat_distance <= margin)
         {
             return has_placement(box, margin);
         }
 
-        box2d<double> repeat_box(box.minx() - repeat_distance,
-                                 box.miny() - repeat_distance,
-                                 box.maxx() + repeat_distance,
-                                 box.maxy() + repeat_distance);
+        box2d<double> const repeat_box = pad(box, repeat_distance);
+        box2d<double> const margin_box = pad(box, margin);
 
-        box2d<double> const& margin_box =
-          (margin > 0
-             ? box2d<double>(box.minx() - margin, box.miny() - margin, box.maxx() + margin, box.maxy() + margin)
-             : box);
+        return !any_of(repeat_box, [&](std::uint32_t id) {
+            return intersects(id, margin_box) || (text_[id] == text && intersects(id, repeat_box));
+        });
+    }
 
-        tree_t::query_iterator tree_itr = tree_.query_in_box(repeat_box);
-        tree_t::query_iterator tree_end = tree_.query_end();
+    bool has_placement(box2d<double> const& box,
+                       double margin,
+                       mapnik::value_unicode_string const& text,
+                       double repeat_distance) const
+    {
+        // a text which was never inserted can't violate the repeat distance
+        return has_placement(box, margin, find_text(text), repeat_distance);
+    }
 
-        for (; tree_itr != tree_end; ++tree_itr)
+    // Checks all boxes of a candidate placement (e.g. every glyph of a line label).
+    template<typename Boxes>
+    bool has_placements(Boxes const& boxes, double margin, text_id text, double repeat_distance) const
+    {
+        for (box2d<double> const& box : boxes)
         {
-            if (tree_itr->get().box.intersects(margin_box) ||
-                (text == tree_itr->get().text && tree_itr->get().box.intersects(repeat_box)))
-            {
+            if (!has_placement(box, margin, text, repeat_distance))
                 return false;
+        }
+        return true;
+    }
+
+    void insert(box2d<double> const& box, text_id text = no_text)
+    {
+        if (!extent_.intersects(box))
+            return;
+        auto id = static_cast<std::uint32_t>(minx_.size());
+        minx_.push_back(box.minx());
+        miny_.push_back(box.miny());
+        maxx_.push_back(box.maxx());
+        maxy_.push_back(box.maxy());
+        text_.push_back(text);
+        unsigned x0 = cell_index(box.minx(), extent_.minx(), inv_cell_width_, cols_);
+        unsigned x1 = cell_index(box.maxx(), extent_.minx(), inv_cell_width_, cols_);
+        unsigned y0 = cell_index(box.miny(), extent_.miny(), inv_cell_height_, rows_);
+        unsigned y1 = cell_index(box.maxy(), extent_.miny(), inv_cell_height_, rows_);
+        for (unsigned y = y0; y <= y1; ++y)
+        {
+            for (unsigned x = x0; x <= x1; ++x)
+            {
+                cells_[y * cols_ + x].push_back(id);
             }
         }
+    }
+
+    void insert(box2d<double> const& box, mapnik::value_unicode_string const& text) { insert(box, intern(text)); }
+
+    // Inserts all boxes of an accepted placement.
+    template<typename Boxes>
+    void insert(Boxes const& boxes, text_id text)
+    {
+        for (box2d<double> const& box : boxes)
+        {
+            insert(box, text);
+        }
+    }
 
+    // Checks all boxes of a candidate placement and inserts them if none collides.
+    template<typename Boxes>
+    bool try_insert(Boxes const& boxes, double margin, text_id text, double repeat_distance)
+    {
+        if (!has_placements(boxes, margin, text, repeat_distance))
+            return false;
+        insert(boxes, text);
         return true;
     }
 
-    void insert(box2d<double> const& box)
+    // Places a run of independent candidates (e.g. markers along a line) in order,
+    // each checked against the stored boxes including the ones placed before it by
+    // this call. Stops at the first box which is not wholly inside the extent (with
+    // avoid_edges) or which collides (unless allow_overlap) and returns the number
+    // of boxes placed. Placed boxes are only stored when insert_placed is set.
+    template<typename Iterator>
+    std::size_t place_each(Iterator first, Iterator last, bool avoid_edges, bool allow_overlap, bool insert_placed)
+    {
+        if (avoid_edges)
+        {
+            // the extent test doesn't depend on earlier placements, cut the run first
+            last = std::find_if(first, last, [&](box2d<double> const& box) { return !extent_.contains(box); });
+        }
+        std::size_t count = 0;
+        for (; first != last; ++first, ++count)
+        {
+            box2d<double> const& box = *first;
+            if (!allow_overlap && !has_placement(box))
+                break;
+            if (insert_placed)
+                insert(box);
+        }
+        return count;
+    }
+
+    // Returns the index of the first of several alternative boxes which is wholly
+    // inside the extent (with avoid_edges) and collides with nothing (unless
+    // allow_overlap), or the number of boxes if none is. The stored boxes around
+    // all alternatives are looked up once and then tested against each in turn.
+    template<typename Iterator>
+    std::size_t find_placement(Iterator first, Iterator last, bool avoid_edges, bool allow_overlap)
     {
-        if (tree_.extent().intersects(box))
+        nearby_.clear();
+        if (!allow_overlap && first != last)
+        {
+            box2d<double> bounds(*first);
+            for (Iterator itr = std::next(first); itr != last; ++itr)
+            {
+                bounds.expand_to_include(*itr);
+            }
+            any_of(bounds, [&](std::uint32_t id) {
+                if (intersects(id, bounds))
+                    nearby_.push_back(id);
+                return false;
+            });
+        }
+        std::size_t index = 0;
+        for (; first != last; ++first, ++index)
         {
-            tree_.insert(label(box), box);
+            box2d<double> const& box = *first;
+            if (avoid_edges && !extent_.contains(box))
+                continue;
+            if (std::none_of(nearby_.begin(), nearby_.end(), [&](std::uint32_t id) { return intersects(id, box); }))
+                break;
         }
+        return index;
     }
 
-    void insert(box2d<double> const& box, mapnik::value_unicode_string const& text)
+    void clear()
     {
-        if (tree_.extent().intersects(box))
+        for (auto& cell : cells_)
         {
-            tree_.insert(label(box, text), box);
+            cell.clear();
         }
+        minx_.clear();
+        miny_.clear();
+        maxx_.clear();
+        maxy_.clear();
+        text_.clear();
+        texts_.clear();
     }
 
-    void clear() { tree_.clear(); }
+    box2d<double> const& extent() const { return extent_; }
 
-    box2d<double> const& extent() const { return tree_.extent(); }
+    std::size_t size() const { return minx_.size(); }
 
-    query_iterator begin() { return tree_.query_in_box(extent()); }
-    query_iterator end() { return tree_.query_end(); }
+    box2d<double> box(std::size_t index) const
+    {
+        return box2d<double>(minx_[index], miny_[index], maxx_[index], maxy_[index]);
+    }
 };
 } // namespace mapnik
 
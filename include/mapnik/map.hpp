@@ -51,6 +51,7 @@ using featureset_ptr = std::shared_ptr<Featureset>;
 class feature_type_style;
 class view_transform;
 class layer;
+class text_layout_pool;
 
 class MAPNIK_DECL Map : boost::equality_comparable<Map>
 {
@@ -99,6 +100,10 @@ class MAPNIK_DECL Map : boost::equality_comparable<Map>
     boost::optional<std::string> font_directory_;
     freetype_engine::font_file_mapping_type font_file_mapping_;
     freetype_engine::font_memory_cache_type font_memory_cache_;
+    // not copied, see get_text_layout_pool
+    mutable std::shared_ptr<text_layout_pool> text_layout_pool_;
+    // shared by copies, see pin_marker
+    std::map<std::string, std::shared_ptr<void const>> marker_pins_;
 
   public:
     using const_style_iterator = std::map<std::string, feature_type_style>::const_iterator;
@@ -479,6 +484,23 @@ class MAPNIK_DECL Map : boost::equality_comparable<Map>
 
     freetype_engine::font_memory_cache_type& get_font_memory_cache() { return font_memory_cache_; }
 
+    /*!
+     * @brief Get the threads laying out the text of prioritized labels,
+     * see the text-layout-threads parameter. They are created on first use
+     * with fonts from this map and kept across renders until the fonts of the
+     * map change.
+     * @param num_threads The number of threads, including the rendering thread.
+     */
+    std::shared_ptr<text_layout_pool> get_text_layout_pool(std::size_t num_threads) const;
+
+    /*!
+     * @brief Keep the marker cached under key from being evicted while this
+     * map or a copy of it exists. Maps loaded from XML pin the files their
+     * symbolizers and background image name.
+     * @param key The file or URI of the marker.
+     */
+    void pin_marker(std::string const& key);
+
   private:
     friend void swap(Map& rhs, Map& lhs);
     void fixAspectRatio();
@@ -28,9 +28,14 @@
 #include <mapnik/config.hpp>
 #include <mapnik/util/noncopyable.hpp>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
 #include <unordered_map>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace mapnik {
 
@@ -41,22 +46,117 @@ class MAPNIK_DECL marker_cache : public singleton<marker_cache, CreateUsingNew>,
 {
     friend class CreateUsingNew<marker_cache>;
 
+    struct entry;
+    using marker_map = std::unordered_map<std::string, std::shared_ptr<entry const>>;
+    // Markers which may be evicted, oldest first. Markers found since the
+    // last sweep get a second chance at the back.
+    using marker_ring = std::list<marker_map::value_type const*>;
+
+    struct entry
+    {
+        entry(std::shared_ptr<marker const> const& mark, std::size_t bytes, bool registered)
+            : mark_(mark)
+            , bytes_(bytes)
+            , registered_(registered)
+            , found_(false)
+        {}
+
+        std::shared_ptr<marker const> mark_;
+        std::size_t bytes_;
+        // added by insert() or from an icon pack, never evicted
+        bool registered_;
+        // found since the last sweep
+        mutable std::atomic<bool> found_;
+        // only used with mutex_ held
+        mutable marker_ring::iterator ring_pos_;
+    };
+    struct local_markers;
+    struct pin_table;
+
   private:
     marker_cache();
     ~marker_cache();
     bool insert_marker(std::string const& key, marker&& path);
-    std::unordered_map<std::string, std::shared_ptr<mapnik::marker const>> marker_cache_;
+    std::shared_ptr<marker const> publish(std::string const& key, std::shared_ptr<marker const> const& mark);
+    void replace(std::string const& key, std::shared_ptr<marker const> const& mark);
+    // The following are called with mutex_ held.
+    void add(std::string const& key, std::shared_ptr<marker const> const& mark, bool registered);
+    marker_map::iterator drop(marker_map::iterator itr);
+    void evict();
+    void shrink();
+    // Loaded markers, guarded by mutex_. Threads also keep the entries they
+    // found in a map of their own, which they drop once generation_ changes:
+    // writers bump it whenever a cached marker is replaced or removed.
+    marker_map markers_;
+    marker_ring ring_;
+    std::atomic<std::size_t> generation_;
+    std::size_t bytes_;
+    std::size_t capacity_;
+    // shared with the handles returned by pin_until_released, which may
+    // outlive the cache
+    std::shared_ptr<pin_table> pins_;
+    // threads which found markers, they count their own hits
+    std::vector<local_markers const*> locals_;
+    // hits of threads which exited
+    std::size_t hits_;
+    std::size_t misses_;
+    std::size_t evictions_;
     bool insert_svg(std::string const& name, std::string const& svg_string);
-    std::unordered_map<std::string, std::string> svg_cache_;
+    // built-in shape:// markers, parsed once
+    std::unordered_map<std::string, std::shared_ptr<marker const>> svg_cache_;
 
   public:
+    struct statistics
+    {
+        std::size_t hits;      // markers found in the cache
+        std::size_t misses;    // markers loaded, or failed to load
+        std::size_t evictions; // markers dropped to stay within the capacity
+        std::size_t size;      // markers cached
+        std::size_t bytes;     // estimated memory of the cached markers
+        std::size_t capacity;
+    };
+
     std::string known_svg_prefix_;
     std::string known_image_prefix_;
     inline bool is_uri(std::string const& path) { return is_svg_uri(path) || is_image_uri(path); }
     bool is_svg_uri(std::string const& path);
     bool is_image_uri(std::string const& path);
+    // data:[<media type>][;base64],<data> holding an SVG document or an image
+    bool is_data_uri(std::string const& path);
     std::shared_ptr<marker const> find(std::string const& key, bool update_cache = false, bool strict = false);
+    // Parses an SVG document or an encoded image (PNG, JPEG, ...) from size
+    // bytes owned by the caller and caches the marker under key, replacing a
+    // marker cached under the same key. The bytes are only read during the
+    // call. Returns a null marker, and caches nothing, if they can't be parsed.
+    std::shared_ptr<marker const>
+      insert(std::string const& key, char const* data, std::size_t size, bool strict = false);
+    // Drops the marker cached under key, renderers still holding it keep it
+    // alive. Returns whether there was one.
+    bool remove(std::string const& key);
+    // Adds all icons of a precompiled icon pack (see svg/svg_icon_pack.hpp)
+    // under the names they were written with, keeping markers already loaded
+    // under the same name. Returns the number of icons added.
+    std::size_t load_icon_pack(std::string const& filename);
     void clear();
+
+    // Once the estimated memory of the cached markers (pixels, vertices and
+    // attributes) exceeds capacity bytes, markers are dropped oldest first
+    // until they take 7/8 of it, skipping those found since the last time.
+    // Markers of built-in and pinned keys are never dropped, nor are markers
+    // registered with insert() or from icon packs. Renderers holding a dropped
+    // marker keep it alive, and it is loaded again when next found.
+    void set_capacity(std::size_t bytes);
+    std::size_t capacity();
+    // Pins the marker cached, or later loaded, under key until unpin() was
+    // called as many times.
+    void pin(std::string const& key);
+    bool unpin(std::string const& key);
+    // Pins key until the returned handle and all its copies are destroyed.
+    // Maps loaded from XML hold the pins of the markers they use (see
+    // Map::pin_marker), so they are not reloaded for every tile.
+    std::shared_ptr<void const> pin_until_released(std::string const& key);
+    bool is_pinned(std::string const& key);
+    statistics stats();
 };
 
 } // namespace mapnik
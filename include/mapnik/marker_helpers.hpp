@@ -46,6 +46,7 @@ MAPNIK_DISABLE_WARNING_POP
 
 // stl
 #include <memory>
+#include <vector>
 
 namespace mapnik {
 
@@ -90,6 +91,15 @@ struct vector_markers_dispatch : util::noncopyable
         }
     }
 
+    // Allows renderers to draw the placements from cached bitmaps of the
+    // marker, see marker_rasterizer_enum. The stock marker and its explicit
+    // style identify the bitmaps.
+    void set_sprite_source(svg_path_ptr const& marker, marker_sprite_style const& style)
+    {
+        params_.sprite_marker = marker;
+        params_.sprite_style = style;
+    }
+
   protected:
     static agg::trans_affine recenter(svg_path_ptr const& src)
     {
@@ -130,12 +140,18 @@ struct raster_markers_dispatch : util::noncopyable
                                                                detector_,
                                                                params_.placement_params);
         double x, y, angle = .0;
+        placements_.clear();
         while (placement_finder.get_point(x, y, angle, params_.ignore_placement))
         {
             agg::trans_affine matrix = params_.placement_params.tr;
             matrix.rotate(angle);
             matrix.translate(x, y);
-            renderer_context_.render_marker(src_, params_, matrix);
+            placements_.push_back(matrix);
+        }
+        // handed over together so that renderers can blend them as instances
+        if (!placements_.empty())
+        {
+            renderer_context_.render_markers(src_, params_, placements_);
         }
     }
 
@@ -144,6 +160,7 @@ struct raster_markers_dispatch : util::noncopyable
     markers_renderer_context& renderer_context_;
     image_rgba8 const& src_;
     Detector& detector_;
+    std::vector<agg::trans_affine> placements_;
 };
 
 void build_ellipse(symbolizer_base const& sym,
@@ -158,6 +175,10 @@ bool push_explicit_style(svg_attribute_type const& src,
                          feature_impl& feature,
                          attributes const& vars);
 
+// The symbolizer properties which change what a vector marker looks like
+// apart from its transform: the explicit style and the ellipse size.
+marker_sprite_style explicit_marker_style(symbolizer_base const& sym, feature_impl& feature, attributes const& vars);
+
 void setup_transform_scaling(agg::trans_affine& tr,
                              double svg_width,
                              double svg_height,
@@ -0,0 +1,206 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_MARKER_SPRITE_CACHE_HPP
+#define MAPNIK_MARKER_SPRITE_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/color.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/marker.hpp>
+#include <mapnik/symbolizer_enumerations.hpp>
+#include <mapnik/util/singleton.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore_agg.hpp>
+#include "agg_trans_affine.h"
+MAPNIK_DISABLE_WARNING_POP
+
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <boost/optional.hpp>
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+namespace mapnik {
+
+// Premultiplied bitmap of a vector marker drawn at one transform.
+struct marker_sprite
+{
+    image_rgba8 image;
+    // Position of the top left corner relative to the pixel the marker origin falls into.
+    int x;
+    int y;
+};
+
+// Symbolizer properties which change what a vector marker looks like apart
+// from its transform: the explicit style and the size of ellipses.
+struct marker_sprite_style
+{
+    boost::optional<color> fill;
+    boost::optional<double> fill_opacity;
+    boost::optional<color> stroke;
+    boost::optional<double> stroke_width;
+    boost::optional<double> stroke_opacity;
+    boost::optional<double> width;
+    boost::optional<double> height;
+
+    bool operator==(marker_sprite_style const& rhs) const
+    {
+        return fill == rhs.fill && fill_opacity == rhs.fill_opacity && stroke == rhs.stroke &&
+               stroke_width == rhs.stroke_width && stroke_opacity == rhs.stroke_opacity && width == rhs.width &&
+               height == rhs.height;
+    }
+};
+
+// Bitmaps of vector markers shared by all renderers. Markers symbolizers with
+// marker-rasterizer="sprite" draw repeated placements of an icon by blending
+// its sprite instead of rasterizing the SVG paths every time. The linear part
+// of transforms is quantized so that it moves the marker outline by at most
+// 1/16 pixel, the position of the marker in steps of 1/4 pixel.
+class MAPNIK_DECL marker_sprite_cache : public singleton<marker_sprite_cache, CreateStatic>,
+                                        private util::noncopyable
+{
+    friend class CreateStatic<marker_sprite_cache>;
+
+  public:
+    // Largest sprite edge in pixels, larger markers are rasterized directly.
+    enum : int { max_sprite_size = 512 };
+
+    struct key
+    {
+        svg_storage_type const* marker;
+        marker_sprite_style style;
+        // sx, shy, shx, sy in quantization steps
+        std::array<std::int64_t, 4> linear;
+        // subpixel offset of the marker origin in quarter pixels
+        int dx;
+        int dy;
+        double opacity;
+        double gamma;
+        gamma_method_enum gamma_method;
+
+        bool operator==(key const& rhs) const
+        {
+            return marker == rhs.marker && style == rhs.style && linear == rhs.linear && dx == rhs.dx &&
+                   dy == rhs.dy && opacity == rhs.opacity && gamma == rhs.gamma && gamma_method == rhs.gamma_method;
+        }
+    };
+
+    // Splits the transform of a placement into the pixel (x, y) the marker
+    // origin falls into and the key of the sprite to blend there. style is
+    // the explicit_marker_style of the symbolizer.
+    static key make_key(svg_path_ptr const& marker,
+                        marker_sprite_style const& style,
+                        box2d<double> const& bbox,
+                        agg::trans_affine const& tr,
+                        double opacity,
+                        double gamma,
+                        gamma_method_enum gamma_method,
+                        bool snap_to_pixels,
+                        int& x,
+                        int& y);
+
+    // The quantized transform a sprite is drawn with, relative to the pixel
+    // the marker origin falls into.
+    static agg::trans_affine sprite_transform(key const& k, box2d<double> const& bbox);
+
+    // Doesn't lock for sprites the calling thread found before.
+    std::shared_ptr<marker_sprite const> find(key const& k) const;
+
+    // Crops image to its painted pixels and caches it, dropping the oldest
+    // sprites when the cache is full. x and y are the position of the image
+    // as in marker_sprite. Keeps the marker alive while its sprites are cached.
+    std::shared_ptr<marker_sprite const>
+      insert(key const& k, svg_path_ptr const& marker, image_rgba8 const& image, int x, int y);
+
+    std::size_t size() const;
+    void clear();
+
+  private:
+    marker_sprite_cache();
+
+    struct key_hash
+    {
+        std::size_t operator()(key const& k) const
+        {
+            std::size_t seed = std::hash<void const*>()(k.marker);
+            auto combine = [&seed](std::size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+            auto combine_color = [&combine](boost::optional<color> const& c) {
+                combine(c ? c->rgba() : 0);
+                combine(c ? 1 + c->get_premultiplied() : 0);
+            };
+            auto combine_double = [&combine](boost::optional<double> const& d) {
+                combine(d ? std::hash<double>()(*d) : 0);
+                combine(d ? 1 : 0);
+            };
+            combine_color(k.style.fill);
+            combine_double(k.style.fill_opacity);
+            combine_color(k.style.stroke);
+            combine_double(k.style.stroke_width);
+            combine_double(k.style.stroke_opacity);
+            combine_double(k.style.width);
+            combine_double(k.style.height);
+            for (auto value : k.linear)
+            {
+                combine(std::hash<std::int64_t>()(value));
+            }
+            combine(std::hash<int>()(k.dx * 4 + k.dy));
+            combine(std::hash<double>()(k.opacity));
+            combine(std::hash<double>()(k.gamma));
+            return seed;
+        }
+    };
+
+    struct entry
+    {
+        svg_path_ptr marker;
+        std::shared_ptr<marker_sprite const> sprite;
+    };
+
+    using sprite_map = std::unordered_map<key, entry, key_hash>;
+
+    // Guarded by mutex_. Threads also keep the entries they found in a map of
+    // their own, which they drop once generation_ changes: it is bumped
+    // whenever sprites are dropped.
+    sprite_map sprites_;
+    std::atomic<std::size_t> generation_;
+    std::deque<key> order_;
+    std::size_t bytes_;
+    std::size_t capacity_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_MARKER_SPRITE_CACHE_HPP
@@ -29,6 +29,13 @@
 #include <mapnik/tolerance_iterator.hpp>
 #include <mapnik/geometry/geometry_types.hpp>
 
+// stl
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 namespace mapnik {
 
 template<typename Locator, typename Detector>
@@ -41,13 +48,24 @@ class markers_line_placement : public markers_point_placement<Locator, Detector>
     markers_line_placement(Locator& locator, Detector& detector, markers_placement_params const& params)
         : point_placement(locator, detector, params)
         , first_point_(true)
+        , batched_(false)
         , spacing_(0.0)
         , spacing_offset_(NAN)
         , marker_width_((params.size * params.tr).width())
+        , move_(0.0)
         , path_(locator)
+        , next_(0)
+        , placed_(0)
+        , run_end_(0)
     {
         spacing_ = params.spacing < 1 ? 100 : params.spacing;
         spacing_offset_ = params.spacing_offset;
+        box2d<double> const& size = params.size;
+        corners_ = {{size.minx(), size.miny(), size.maxx(), size.miny(), size.maxx(), size.maxy(), size.minx(), size.maxy()}};
+        for (std::size_t i = 0; i < corners_.size(); i += 2)
+        {
+            params.tr.transform(&corners_[i], &corners_[i + 1]);
+        }
     }
 
     void rewind()
@@ -56,6 +74,12 @@ class markers_line_placement : public markers_point_placement<Locator, Detector>
         first_point_ = true;
     }
 
+    // Once the first marker is placed, the positions of the rest of the subpath
+    // are collected and their boxes computed in one go. Runs of them are then
+    // handed to the detector in a single call, which places them in path order and
+    // stops at the first one rejected. Only for those the nearby alternatives
+    // within max_error are generated, again checked with one call. The result is
+    // the same as checking one position after the other.
     bool get_point(double& x, double& y, double& angle, bool ignore_placement)
     {
         if (this->done_)
@@ -68,8 +92,6 @@ class markers_line_placement : public markers_point_placement<Locator, Detector>
             return point_placement::get_point(x, y, angle, ignore_placement);
         }
 
-        double move = spacing_;
-
         if (first_point_)
         {
             if (!path_.next_subpath())
@@ -78,33 +100,65 @@ class markers_line_placement : public markers_point_placement<Locator, Detector>
                 return false;
             }
             first_point_ = false;
-            move = std::isnan(spacing_offset_) ? spacing_ / 2.0 : spacing_offset_;
+            batched_ = false;
+            // until something is placed the path is walked by the initial offset
+            move_ = std::isnan(spacing_offset_) ? spacing_ / 2.0 : spacing_offset_;
         }
 
-        while (path_.forward(move))
+        if (!batched_)
         {
-            tolerance_iterator tolerance_offset(spacing_ * this->params_.max_error, 0.0);
-            while (tolerance_offset.next())
+            while (path_.forward(move_))
             {
-                vertex_cache::scoped_state state(path_);
-                if (path_.move(tolerance_offset.get()) &&
-                    (path_.linear_position() + marker_width_ / 2.0) < path_.length())
+                if (place_near(x, y, angle, ignore_placement, false))
                 {
-                    pixel_position pos = path_.current_position();
-                    x = pos.x;
-                    y = pos.y;
-                    angle = path_.current_segment_angle();
-                    if (!this->set_direction(angle))
+                    move_ = spacing_;
+                    // with nothing to check markers are simply placed as they come
+                    if (this->params_.avoid_edges || !this->params_.allow_overlap)
                     {
-                        continue;
-                    }
-                    if (!this->push_to_detector(x, y, angle, ignore_placement))
-                    {
-                        continue;
+                        collect_candidates();
+                        batched_ = true;
                     }
                     return true;
                 }
             }
+            this->done_ = true;
+            return false;
+        }
+
+        while (next_ < candidates_.size())
+        {
+            std::size_t index = next_++;
+            if (index >= placed_)
+            {
+                if (index >= run_end_)
+                {
+                    // positions without a valid box end a run
+                    auto itr = std::find_if(candidates_.begin() + index, candidates_.end(), [](candidate const& c) {
+                        return !c.valid;
+                    });
+                    run_end_ = static_cast<std::size_t>(itr - candidates_.begin());
+                }
+                placed_ = index + this->detector_.place_each(boxes_.begin() + index,
+                                                             boxes_.begin() + run_end_,
+                                                             this->params_.avoid_edges,
+                                                             this->params_.allow_overlap,
+                                                             !ignore_placement);
+            }
+            if (index < placed_)
+            {
+                candidate const& c = candidates_[index];
+                x = c.x;
+                y = c.y;
+                angle = c.angle;
+                return true;
+            }
+            // the detector resumes after this position
+            placed_ = next_;
+            path_.restore_state(candidates_[index].state);
+            if (place_near(x, y, angle, ignore_placement, true))
+            {
+                return true;
+            }
         }
 
         this->done_ = true;
@@ -113,11 +167,132 @@ class markers_line_placement : public markers_point_placement<Locator, Detector>
     }
 
   private:
+    struct candidate
+    {
+        vertex_cache::state state;
+        double x;
+        double y;
+        double angle;
+        bool valid;
+    };
+
     bool first_point_;
+    bool batched_;
     double spacing_;
     double spacing_offset_;
     double marker_width_;
+    double move_;
     vertex_cache path_;
+    // corners of the marker box around its anchor, before rotation
+    std::array<double, 8> corners_;
+    std::vector<candidate> candidates_;
+    std::vector<box2d<double>> boxes_;
+    std::vector<candidate> alternatives_;
+    std::vector<box2d<double>> alternative_boxes_;
+    std::size_t next_;
+    std::size_t placed_;
+    std::size_t run_end_;
+
+    // Walks the rest of the current subpath and records the preferred position at
+    // every spacing step together with the box the marker would cover there.
+    void collect_candidates()
+    {
+        candidates_.clear();
+        boxes_.clear();
+        next_ = 0;
+        placed_ = 0;
+        run_end_ = 0;
+        std::size_t steps = static_cast<std::size_t>((path_.length() - path_.linear_position()) / spacing_) + 1;
+        candidates_.reserve(steps);
+        boxes_.reserve(steps);
+        while (path_.forward(spacing_))
+        {
+            candidate c;
+            c.state = path_.save_state();
+            // moving by zero doesn't change the position, no need to restore it
+            c.valid = locate(0.0, c);
+            boxes_.push_back(c.valid ? marker_box(c) : box2d<double>());
+            candidates_.push_back(c);
+        }
+    }
+
+    // Tries the positions around the current one, nearest first, and places the
+    // first which fits. skip_preferred leaves out the current position itself.
+    // The alternatives are generated up front and checked with one detector call.
+    bool place_near(double& x, double& y, double& angle, bool ignore_placement, bool skip_preferred)
+    {
+        alternatives_.clear();
+        alternative_boxes_.clear();
+        tolerance_iterator tolerance_offset(spacing_ * this->params_.max_error, 0.0);
+        if (skip_preferred)
+        {
+            tolerance_offset.next();
+        }
+        // with nothing to check the first valid position is placed
+        bool const check = this->params_.avoid_edges || !this->params_.allow_overlap;
+        while ((check || alternatives_.empty()) && tolerance_offset.next())
+        {
+            vertex_cache::scoped_state state(path_);
+            candidate c;
+            if (locate(tolerance_offset.get(), c))
+            {
+                alternatives_.push_back(c);
+                alternative_boxes_.push_back(marker_box(c));
+            }
+        }
+        std::size_t index = this->detector_.find_placement(alternative_boxes_.begin(),
+                                                           alternative_boxes_.end(),
+                                                           this->params_.avoid_edges,
+                                                           this->params_.allow_overlap);
+        if (index == alternatives_.size())
+        {
+            return false;
+        }
+        if (!ignore_placement)
+        {
+            this->detector_.insert(alternative_boxes_[index]);
+        }
+        x = alternatives_[index].x;
+        y = alternatives_[index].y;
+        angle = alternatives_[index].angle;
+        return true;
+    }
+
+    // Moves by offset and fills in the marker position there. Returns false if the
+    // marker would run over the end of the path or doesn't fit the direction.
+    bool locate(double offset, candidate& c)
+    {
+        if (!path_.move(offset) || (path_.linear_position() + marker_width_ / 2.0) >= path_.length())
+        {
+            return false;
+        }
+        pixel_position pos = path_.current_position();
+        c.x = pos.x;
+        c.y = pos.y;
+        c.angle = path_.current_segment_angle();
+        return this->set_direction(c.angle);
+    }
+
+    // Same box as perform_transform(), from the marker corners transformed once.
+    box2d<double> marker_box(candidate const& c) const
+    {
+        double cos_a = std::cos(c.angle);
+        double sin_a = std::sin(c.angle);
+        double minx = std::numeric_limits<double>::max();
+        double miny = minx;
+        double maxx = std::numeric_limits<double>::lowest();
+        double maxy = maxx;
+        for (std::size_t i = 0; i < corners_.size(); i += 2)
+        {
+            double px = corners_[i] * cos_a - corners_[i + 1] * sin_a;
+            double py = corners_[i] * sin_a + corners_[i + 1] * cos_a;
+            minx = std::min(minx, px);
+            miny = std::min(miny, py);
+            maxx = std::max(maxx, px);
+            maxy = std::max(maxy, py);
+        }
+        return box2d<double>(minx + c.x, miny + c.y, maxx + c.x, maxy + c.y);
+    }
 };
 
 } // namespace mapnik
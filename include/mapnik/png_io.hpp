@@ -28,6 +28,8 @@
 #include <mapnik/octree.hpp>
 #include <mapnik/hextree.hpp>
 #include <mapnik/image.hpp>
+#include <mapnik/image_workers.hpp>
+#include <mapnik/util/noncopyable.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -42,6 +44,26 @@ extern "C" {
 #include <set>
 MAPNIK_DISABLE_WARNING_POP
 
+// SSE2 is always available on x86-64, so unlike SSE_MATH this is not opt-in
+#if defined(__SSE2__)
+#include <mapnik/sse.hpp>
+#endif
+
+// stl
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef MAPNIK_THREADSAFE
+#include <thread>
+#endif
+
 #define MAX_OCTREE_LEVELS 4
 
 namespace mapnik {
@@ -56,6 +78,8 @@ struct png_options
     double gamma;
     bool paletted;
     bool use_hextree;
+    // threads compressing the image data, 0 means one per hardware thread
+    int threads;
 
     png_options()
         : colors(256)
@@ -66,6 +90,7 @@ struct png_options
         , gamma(-1)
         , paletted(true)
         , use_hextree(true)
+        , threads(1)
     {}
 };
 
@@ -83,6 +108,474 @@ void flush_data(png_structp png_ptr)
     out->flush();
 }
 
+namespace detail {
+
+// The sum of the filtered bytes taken as signed magnitudes, the cost libpng
+// minimizes when picking a filter.
+inline std::uint64_t png_filter_cost(std::uint8_t const* data, std::size_t size)
+{
+    std::uint64_t cost = 0;
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    __m128i const zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_min_epu8(v, _mm_sub_epi8(zero, v)), zero));
+    }
+    m128_int total;
+    total.v = sum;
+    cost = static_cast<std::uint64_t>(total.u32[0]) + total.u32[2];
+#endif
+    for (; i < size; ++i)
+    {
+        cost += data[i] < 128 ? data[i] : 256 - data[i];
+    }
+    return cost;
+}
+
+inline std::uint8_t png_paeth_predictor(int a, int b, int c)
+{
+    int pa = std::abs(b - c);
+    int pb = std::abs(a - c);
+    int pc = std::abs(a + b - 2 * c);
+    return static_cast<std::uint8_t>((pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c));
+}
+
+// Filters bytes [begin, row_bytes) of row with the PNG filter type (1 sub,
+// 2 up, 3 average, 4 paeth), begin >= bpp. Unlike when decoding, every
+// predictor only reads unfiltered bytes, so the bytes are independent.
+inline void png_filter_span(int type,
+                            std::uint8_t const* row,
+                            std::uint8_t const* prev,
+                            std::size_t begin,
+                            std::size_t row_bytes,
+                            unsigned bpp,
+                            std::uint8_t* out)
+{
+    std::size_t i = begin;
+#if defined(__SSE2__)
+    __m128i const one = _mm_set1_epi8(1);
+    __m128i const zero = _mm_setzero_si128();
+    for (; i + 16 <= row_bytes; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + i));
+        __m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + i - bpp));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(prev + i));
+        __m128i predictor;
+        if (type == 1)
+        {
+            predictor = a;
+        }
+        else if (type == 2)
+        {
+            predictor = b;
+        }
+        else if (type == 3)
+        {
+            // _mm_avg_epu8 rounds up
+            predictor = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        }
+        else
+        {
+            __m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(prev + i - bpp));
+            __m128i half[2];
+            for (int h = 0; h < 2; ++h)
+            {
+                __m128i a16 = h == 0 ? _mm_unpacklo_epi8(a, zero) : _mm_unpackhi_epi8(a, zero);
+                __m128i b16 = h == 0 ? _mm_unpacklo_epi8(b, zero) : _mm_unpackhi_epi8(b, zero);
+                __m128i c16 = h == 0 ? _mm_unpacklo_epi8(c, zero) : _mm_unpackhi_epi8(c, zero);
+                __m128i pa = _mm_sub_epi16(b16, c16);
+                __m128i pb = _mm_sub_epi16(a16, c16);
+                __m128i pc = _mm_add_epi16(pa, pb);
+                pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+                pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+                pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+                __m128i not_a = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+                __m128i use_c = _mm_cmpgt_epi16(pb, pc);
+                __m128i b_or_c = _mm_or_si128(_mm_and_si128(use_c, c16), _mm_andnot_si128(use_c, b16));
+                half[h] = _mm_or_si128(_mm_and_si128(not_a, b_or_c), _mm_andnot_si128(not_a, a16));
+            }
+            predictor = _mm_packus_epi16(half[0], half[1]);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sub_epi8(x, predictor));
+    }
+#endif
+    switch (type)
+    {
+        case 1:
+            for (; i < row_bytes; ++i)
+                out[i] = static_cast<std::uint8_t>(row[i] - row[i - bpp]);
+            break;
+        case 2:
+            for (; i < row_bytes; ++i)
+                out[i] = static_cast<std::uint8_t>(row[i] - prev[i]);
+            break;
+        case 3:
+            for (; i < row_bytes; ++i)
+                out[i] = static_cast<std::uint8_t>(row[i] - ((row[i - bpp] + prev[i]) >> 1));
+            break;
+        default:
+            for (; i < row_bytes; ++i)
+                out[i] = static_cast<std::uint8_t>(row[i] - png_paeth_predictor(row[i - bpp], prev[i], prev[i - bpp]));
+    }
+}
+
+// Applies the PNG filter type (0 none, 1 sub, 2 up, 3 average, 4 paeth) to
+// row. prev is the previous unfiltered row, all zeros for the first one.
+inline void png_filter_row(int type,
+                           std::uint8_t const* row,
+                           std::uint8_t const* prev,
+                           std::size_t row_bytes,
+                           unsigned bpp,
+                           std::uint8_t* out)
+{
+    // the first pixel has no left neighbours
+    std::size_t head = std::min<std::size_t>(bpp, row_bytes);
+    switch (type)
+    {
+        case 1:
+            std::copy_n(row, head, out);
+            break;
+        case 2:
+        case 4:
+            for (std::size_t i = 0; i < head; ++i)
+                out[i] = static_cast<std::uint8_t>(row[i] - prev[i]);
+            break;
+        case 3:
+            for (std::size_t i = 0; i < head; ++i)
+                out[i] = static_cast<std::uint8_t>(row[i] - (prev[i] >> 1));
+            break;
+        default:
+            std::copy_n(row, row_bytes, out);
+            return;
+    }
+    png_filter_span(type, row, prev, head, row_bytes, bpp, out);
+}
+
+// Writes the filter type byte and the filtered row to out. Of several allowed
+// filters the one with the smallest cost is used, as libpng does. scratch
+// holds row_bytes.
+inline void png_filter_row_adaptive(int filters,
+                                    std::uint8_t const* row,
+                                    std::uint8_t const* prev,
+                                    std::size_t row_bytes,
+                                    unsigned bpp,
+                                    std::uint8_t* out,
+                                    std::uint8_t* scratch)
+{
+    filters &= PNG_ALL_FILTERS;
+    if (filters == 0)
+    {
+        filters = PNG_FILTER_NONE;
+    }
+    int best = -1;
+    if ((filters & (filters - 1)) == 0)
+    {
+        // a single filter, nothing to pick
+        best = 0;
+        while (!(filters & (PNG_FILTER_NONE << best)))
+            ++best;
+        png_filter_row(best, row, prev, row_bytes, bpp, out + 1);
+        out[0] = static_cast<std::uint8_t>(best);
+        return;
+    }
+    std::uint64_t best_cost = 0;
+    std::uint8_t* best_data = out + 1;
+    std::uint8_t* candidate = scratch;
+    for (int type = 0; type < 5; ++type)
+    {
+        if (!(filters & (PNG_FILTER_NONE << type)))
+            continue;
+        std::uint8_t* target = best < 0 ? best_data : candidate;
+        png_filter_row(type, row, prev, row_bytes, bpp, target);
+        std::uint64_t cost = png_filter_cost(target, row_bytes);
+        if (best < 0 || cost < best_cost)
+        {
+            if (best >= 0)
+                std::swap(best_data, candidate);
+            best = type;
+            best_cost = cost;
+        }
+    }
+    if (best_data != out + 1)
+    {
+        std::copy_n(best_data, row_bytes, out + 1);
+    }
+    out[0] = static_cast<std::uint8_t>(best);
+}
+
+// Whether the rows are filtered and compressed by png_write_rows rather than
+// by libpng, which picks filters slowly.
+inline bool png_filter_in_mapnik(png_options const& opts)
+{
+    return opts.threads != 1 || (opts.filters & PNG_ALL_FILTERS & ~PNG_FILTER_NONE) != 0;
+}
+
+// Filters rows one after another and deflates them into one zlib stream,
+// written as IDAT chunks of up to 64k. Used for images compressed as a single
+// band and by the png row writer, so both write the same bytes.
+class png_row_deflater : private util::noncopyable
+{
+  public:
+    png_row_deflater(png_structp png_ptr, std::size_t row_bytes, unsigned bpp, png_options const& opts)
+        : png_ptr_(png_ptr)
+        , row_bytes_(row_bytes)
+        , bpp_(bpp)
+        , filters_(opts.filters)
+        , prev_(row_bytes, 0)
+        , filtered_(row_bytes + 1)
+        , scratch_(row_bytes)
+        , out_(65536)
+    {
+        std::memset(&strm_, 0, sizeof(strm_));
+        if (deflateInit2(&strm_, opts.compression, Z_DEFLATED, 15, 8, opts.strategy) != Z_OK)
+        {
+            throw std::runtime_error("png: failed to initialize zlib");
+        }
+        strm_.next_out = out_.data();
+        strm_.avail_out = static_cast<uInt>(out_.size());
+    }
+
+    ~png_row_deflater() { deflateEnd(&strm_); }
+
+    // row is in the pixel format of the file, row_bytes long.
+    void write(std::uint8_t const* row)
+    {
+        png_filter_row_adaptive(filters_, row, prev_.data(), row_bytes_, bpp_, filtered_.data(), scratch_.data());
+        std::copy_n(row, row_bytes_, prev_.data());
+        deflate_chunks(filtered_.data(), filtered_.size(), Z_NO_FLUSH);
+    }
+
+    // Ends the zlib stream and writes the IEND chunk.
+    void finish()
+    {
+        deflate_chunks(nullptr, 0, Z_FINISH);
+        png_write_chunk(png_ptr_, reinterpret_cast<png_const_bytep>("IEND"), nullptr, 0);
+    }
+
+  private:
+    void deflate_chunks(std::uint8_t const* data, std::size_t size, int flush)
+    {
+        strm_.next_in = const_cast<Bytef*>(data);
+        strm_.avail_in = static_cast<uInt>(size);
+        for (;;)
+        {
+            int ret = deflate(&strm_, flush);
+            if (ret == Z_STREAM_ERROR)
+            {
+                throw std::runtime_error("png: deflate failed");
+            }
+            bool end = ret == Z_STREAM_END;
+            std::size_t written = out_.size() - strm_.avail_out;
+            if (strm_.avail_out == 0 || (end && written > 0))
+            {
+                png_write_chunk(png_ptr_, reinterpret_cast<png_const_bytep>("IDAT"), out_.data(), written);
+                strm_.next_out = out_.data();
+                strm_.avail_out = static_cast<uInt>(out_.size());
+            }
+            if (end || (flush != Z_FINISH && strm_.avail_in == 0 && strm_.avail_out > 0))
+                break;
+        }
+    }
+
+    png_structp png_ptr_;
+    std::size_t row_bytes_;
+    unsigned bpp_;
+    int filters_;
+    std::vector<std::uint8_t> prev_;
+    std::vector<std::uint8_t> filtered_;
+    std::vector<std::uint8_t> scratch_;
+    std::vector<std::uint8_t> out_;
+    z_stream strm_;
+};
+
+struct png_band
+{
+    unsigned y0;
+    unsigned y1;
+    std::vector<std::uint8_t> data; // raw deflate
+    uLong adler;
+    std::size_t size; // of the filtered rows
+};
+
+// Filters and deflates the rows of band on its own, ending with a sync flush
+// so the bands can be concatenated, or with the final block for the last one.
+// Like pigz, the filtered rows before the band prime the dictionary. Rows are
+// filtered and compressed in batches of about 32k.
+template<typename GetRow>
+void png_deflate_band(GetRow const& get_row,
+                      std::size_t row_bytes,
+                      unsigned bpp,
+                      bool last,
+                      png_options const& opts,
+                      png_band& band)
+{
+    std::size_t const line = row_bytes + 1;
+    std::size_t const window = 32768;
+    unsigned const batch_rows = static_cast<unsigned>((window + line - 1) / line);
+    unsigned y0 = band.y0 - std::min(band.y0, batch_rows);
+    std::vector<std::uint8_t> filtered(std::min<std::size_t>(batch_rows, band.y1 - y0) * line);
+    std::vector<std::uint8_t> rows(row_bytes * 2, 0);
+    std::vector<std::uint8_t> scratch(row_bytes);
+    std::uint8_t* buffers[2] = {rows.data(), rows.data() + row_bytes};
+    std::uint8_t const* prev = y0 > 0 ? get_row(y0 - 1, buffers[(y0 - 1) & 1]) : buffers[1];
+    auto filter_rows = [&](unsigned begin, unsigned end) {
+        for (unsigned y = begin; y < end; ++y)
+        {
+            std::uint8_t const* row = get_row(y, buffers[y & 1]);
+            png_filter_row_adaptive(opts.filters,
+                                    row,
+                                    prev,
+                                    row_bytes,
+                                    bpp,
+                                    &filtered[(y - begin) * line],
+                                    scratch.data());
+            prev = row;
+        }
+        return (end - begin) * line;
+    };
+
+    z_stream strm;
+    std::memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, opts.compression, Z_DEFLATED, -15, 8, opts.strategy) != Z_OK)
+    {
+        throw std::runtime_error("png: failed to initialize zlib");
+    }
+    if (y0 < band.y0)
+    {
+        std::size_t size = filter_rows(y0, band.y0);
+        std::size_t used = std::min(size, window);
+        deflateSetDictionary(&strm, &filtered[size - used], static_cast<uInt>(used));
+    }
+    band.size = (band.y1 - band.y0) * line;
+    band.adler = adler32(0L, Z_NULL, 0);
+    band.data.resize(deflateBound(&strm, band.size) + 16);
+    std::size_t written = 0;
+    for (unsigned y = band.y0;;)
+    {
+        unsigned end = std::min(band.y1, y + batch_rows);
+        std::size_t size = filter_rows(y, end);
+        y = end;
+        band.adler = adler32(band.adler, filtered.data(), static_cast<uInt>(size));
+        strm.next_in = filtered.data();
+        strm.avail_in = static_cast<uInt>(size);
+        int flush = y < band.y1 ? Z_NO_FLUSH : (last ? Z_FINISH : Z_SYNC_FLUSH);
+        for (;;)
+        {
+            strm.next_out = band.data.data() + written;
+            strm.avail_out = static_cast<uInt>(band.data.size() - written);
+            int ret = deflate(&strm, flush);
+            written = band.data.size() - strm.avail_out;
+            if (ret == Z_STREAM_ERROR)
+            {
+                deflateEnd(&strm);
+                throw std::runtime_error("png: deflate failed");
+            }
+            if (flush == Z_FINISH ? ret == Z_STREAM_END : (strm.avail_in == 0 && strm.avail_out > 0))
+                break;
+            band.data.resize(band.data.size() * 2);
+        }
+        if (y >= band.y1)
+            break;
+    }
+    deflateEnd(&strm);
+    band.data.resize(written);
+}
+
+// Writes the image data as IDAT chunks, and the IEND chunk, after
+// png_write_info. Bands of rows are filtered and compressed on up to
+// opts.threads threads, get_row(y, buffer) returns row y in the pixel format
+// of the file, either in place or copied to buffer (row_bytes).
+template<typename GetRow>
+void png_write_rows(png_structp png_ptr,
+                    unsigned height,
+                    std::size_t row_bytes,
+                    unsigned bpp,
+                    GetRow const& get_row,
+                    png_options const& opts)
+{
+    // at least 128k of rows per band so they compress about as well as one stream
+    std::size_t const line = row_bytes + 1;
+    unsigned num_threads = opts.threads > 0 ? static_cast<unsigned>(opts.threads) : 1;
+#ifdef MAPNIK_THREADSAFE
+    if (opts.threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+#endif
+    unsigned rows_per_band =
+      std::max((height + num_threads - 1) / num_threads, static_cast<unsigned>((131072 + line - 1) / line));
+    if (rows_per_band >= height)
+    {
+        std::vector<std::uint8_t> buffer(row_bytes);
+        png_row_deflater deflater(png_ptr, row_bytes, bpp, opts);
+        for (unsigned y = 0; y < height; ++y)
+        {
+            deflater.write(get_row(y, buffer.data()));
+        }
+        deflater.finish();
+        return;
+    }
+    std::vector<png_band> bands;
+    for (unsigned y = 0; y < height || bands.empty(); y += rows_per_band)
+    {
+        png_band band;
+        band.y0 = y;
+        band.y1 = std::min(height, y + rows_per_band);
+        bands.push_back(std::move(band));
+    }
+
+    std::atomic<std::size_t> next(0);
+    auto work = [&](std::exception_ptr& error) {
+        try
+        {
+            std::size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) < bands.size())
+            {
+                png_deflate_band(get_row, row_bytes, bpp, i + 1 == bands.size(), opts, bands[i]);
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+            next.store(bands.size(), std::memory_order_relaxed);
+        }
+    };
+    std::size_t num_workers = std::min<std::size_t>(num_threads, bands.size()) - 1;
+    std::vector<std::exception_ptr> errors(num_workers + 1);
+    std::atomic<std::size_t> slot(0);
+    run_image_workers(num_workers, [&] { work(errors[slot.fetch_add(1, std::memory_order_relaxed)]); });
+    for (auto const& error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    // zlib header for a 32k window with the level hint, and the checksum of
+    // all bands at the end
+    int level = opts.compression == Z_DEFAULT_COMPRESSION ? 6 : opts.compression;
+    unsigned header = (0x78 << 8) | ((level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6);
+    header += 31 - header % 31;
+    std::uint8_t const zlib_header[2] = {static_cast<std::uint8_t>(header >> 8), static_cast<std::uint8_t>(header)};
+    uLong adler = adler32(0L, Z_NULL, 0);
+    for (auto const& band : bands)
+    {
+        adler = adler32_combine(adler, band.adler, static_cast<z_off_t>(band.size));
+    }
+    bands.front().data.insert(bands.front().data.begin(), zlib_header, zlib_header + 2);
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        bands.back().data.push_back(static_cast<std::uint8_t>(adler >> shift));
+    }
+    for (auto const& band : bands)
+    {
+        png_write_chunk(png_ptr, reinterpret_cast<png_const_bytep>("IDAT"), band.data.data(), band.data.size());
+    }
+    png_write_chunk(png_ptr, reinterpret_cast<png_const_bytep>("IEND"), nullptr, 0);
+}
+
+} // namespace detail
+
 template<typename T1, typename T2>
 void save_as_png(T1& file, T2 const& image, png_options const& opts)
 
@@ -133,6 +626,33 @@ void save_as_png(T1& file, T2 const& image, png_options const& opts)
     {
         row_pointers[i] = const_cast<png_bytep>(reinterpret_cast<const unsigned char*>(image.get_row(i)));
     }
+    if (detail::png_filter_in_mapnik(opts))
+    {
+        png_write_info(png_ptr, info_ptr);
+        bool rgb = opts.trans_mode == 0;
+        auto get_row = [&](unsigned y, std::uint8_t* buffer) {
+            auto const* row = reinterpret_cast<std::uint8_t const*>(image.get_row(y));
+            if (!rgb)
+                return row;
+            for (unsigned x = 0; x < image.width(); ++x)
+            {
+                std::copy_n(row + 4 * x, 3, buffer + 3 * x);
+            }
+            return static_cast<std::uint8_t const*>(buffer);
+        };
+        unsigned bpp = rgb ? 3 : 4;
+        try
+        {
+            detail::png_write_rows(png_ptr, image.height(), image.width() * bpp, bpp, get_row, opts);
+        }
+        catch (...)
+        {
+            png_destroy_write_struct(&png_ptr, &info_ptr);
+            throw;
+        }
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        return;
+    }
     png_set_rows(png_ptr, info_ptr, row_pointers.get());
     png_write_png(png_ptr,
                   info_ptr,
@@ -335,6 +855,21 @@ void save_as_png(T& file,
     }
 
     png_write_info(png_ptr, info_ptr);
+    if (detail::png_filter_in_mapnik(opts))
+    {
+        auto get_row = [&](unsigned y, std::uint8_t*) { return image.get_row(y); };
+        try
+        {
+            detail::png_write_rows(png_ptr, height, (width * color_depth + 7) / 8, 1, get_row, opts);
+        }
+        catch (...)
+        {
+            png_destroy_write_struct(&png_ptr, &info_ptr);
+            throw;
+        }
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        return;
+    }
     for (unsigned i = 0; i < height; ++i)
     {
         png_write_row(png_ptr, const_cast<png_bytep>(image.get_row(i)));
@@ -591,7 +1126,8 @@ void save_as_png8(T1& file,
             mapnik::image_gray8::pixel_type* row_out = reduced_image.get_row(y);
             for (unsigned x = 0; x < width; ++x)
             {
-                row_out[x] = tree.quantize(row[x]);
+                // runs of a color map to the same index
+                row_out[x] = (x > 0 && row[x] == row[x - 1]) ? row_out[x - 1] : tree.quantize(row[x]);
             }
         }
         save_as_png(file, palette, reduced_image, width, height, 8, alpha_table, opts);
@@ -618,12 +1154,11 @@ void save_as_png8(T1& file,
             std::uint8_t index = 0;
             for (unsigned x = 0; x < width; ++x)
             {
-                index = tree.quantize(row[x]);
-                if (x % 2 == 0)
+                if (x == 0 || row[x] != row[x - 1])
                 {
-                    index = index << 4;
+                    index = tree.quantize(row[x]);
                 }
-                row_out[x >> 1] |= index;
+                row_out[x >> 1] |= (x % 2 == 0) ? index << 4 : index;
             }
         }
         save_as_png(file, palette, reduced_image, width, height, 4, alpha_table, opts);
@@ -649,15 +1184,11 @@ void save_as_png8_hex(T1& file, T2 const& image, png_options const& opts)
             tree.setGamma(opts.gamma);
         }
 
-        for (unsigned y = 0; y < height; ++y)
-        {
-            typename T2::pixel_type const* row = image.get_row(y);
-            for (unsigned x = 0; x < width; ++x)
-            {
-                unsigned val = row[x];
-                tree.insert(mapnik::rgba(U2RED(val), U2GREEN(val), U2BLUE(val), U2ALPHA(val)));
-            }
-        }
+        color_histogram histogram;
+        histogram.add(image);
+        histogram.for_each([&tree](unsigned val, unsigned count) {
+            tree.insert(mapnik::rgba(U2RED(val), U2GREEN(val), U2BLUE(val), U2ALPHA(val)), count);
+        });
 
         // transparency values per palette index
         std::vector<mapnik::rgba> rgba_palette;
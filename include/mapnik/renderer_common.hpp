@@ -34,7 +34,9 @@
 namespace mapnik {
 class label_collision_detector4;
 class Map;
+class render_thunk_cache;
 class request;
+class vertex_cache_store;
 //  class attributes;
 } // namespace mapnik
 
@@ -80,6 +82,10 @@ struct renderer_common : private util::noncopyable
     box2d<double> query_extent_;
     view_transform t_;
     detector_ptr detector_;
+    // measured label paths shared by the text and shield symbolizers of a render
+    std::shared_ptr<vertex_cache_store> vertex_caches_;
+    // laid out members of the group symbolizers of a render
+    std::shared_ptr<render_thunk_cache> render_thunks_;
 
   protected:
     // it's desirable to keep this class implicitly noncopyable to prevent
@@ -0,0 +1,146 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_RENDERER_COMMON_LABEL_PLACEMENT_QUEUE_HPP
+#define MAPNIK_RENDERER_COMMON_LABEL_PLACEMENT_QUEUE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/symbolizer_base.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace mapnik {
+
+class proj_transform;
+class Map;
+class layer;
+class feature_type_style;
+
+// Text and shield symbolizers with a `priority` are not placed while their
+// layer is rendered. Instead they are collected here and placed once all
+// layers were processed, highest priority first, so that important labels
+// win the space regardless of layer and data order. Candidates with equal
+// priority keep the order in which they were queued.
+//
+// Only styles drawn straight onto the map queue their labels: labels of
+// styles or layers with a comp-op, an opacity or image filters are placed
+// with them and composited like the rest of the style. Queued labels are
+// placed before a layer that clears the label cache or blends with what was
+// drawn before it other than by src-over.
+
+struct label_placement_candidate
+{
+    double priority;
+    // text_symbolizer or shield_symbolizer owned by the map styles
+    symbolizer_base const* sym;
+    bool shield;
+    feature_ptr feature;
+    // proj_transform instances are owned by proj_transform_cache
+    proj_transform const* prj_trans;
+    box2d<double> clip_box;
+};
+
+class MAPNIK_DECL label_placement_queue : util::noncopyable
+{
+  public:
+    label_placement_queue()
+        : candidates_()
+        , layer_composited_(false)
+        , active_(false)
+    {}
+
+    // Called at the start of every layer, returns whether the queued labels
+    // have to be placed before the layer is rendered.
+    bool start_layer(Map const& map, layer const& lay);
+
+    // Called at the start of every style of the layer.
+    void start_style(feature_type_style const& st);
+
+    // Whether the style being rendered queues its prioritized labels.
+    bool active() const { return active_; }
+
+    template<typename Symbolizer>
+    void push(double priority,
+              Symbolizer const& sym,
+              feature_impl const& feature,
+              proj_transform const& prj_trans,
+              box2d<double> const& clip_box)
+    {
+        // features are recycled by some datasources, so keep our own copy
+        feature_ptr copy = std::make_shared<feature_impl>(feature.context(), feature.id());
+        copy->set_data(feature.get_data());
+        copy->set_geometry_copy(feature.get_geometry());
+        candidates_.push_back(label_placement_candidate{priority,
+                                                        &sym,
+                                                        std::is_same<Symbolizer, shield_symbolizer>::value,
+                                                        std::move(copy),
+                                                        &prj_trans,
+                                                        clip_box});
+    }
+
+    bool empty() const { return candidates_.empty(); }
+
+    std::size_t size() const { return candidates_.size(); }
+
+    // Puts the candidates in placement order.
+    void sort()
+    {
+        std::stable_sort(candidates_.begin(),
+                         candidates_.end(),
+                         [](label_placement_candidate const& lhs, label_placement_candidate const& rhs) {
+                             return lhs.priority > rhs.priority;
+                         });
+    }
+
+    std::vector<label_placement_candidate>::const_iterator begin() const { return candidates_.begin(); }
+    std::vector<label_placement_candidate>::const_iterator end() const { return candidates_.end(); }
+
+    void clear() { candidates_.clear(); }
+
+    // Calls f for every queued candidate in placement order and empties the queue.
+    template<typename F>
+    void flush(F&& f)
+    {
+        sort();
+        for (auto const& candidate : candidates_)
+        {
+            f(candidate);
+        }
+        clear();
+    }
+
+  private:
+    std::vector<label_placement_candidate> candidates_;
+    bool layer_composited_;
+    bool active_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_RENDERER_COMMON_LABEL_PLACEMENT_QUEUE_HPP
@@ -24,10 +24,15 @@
 #define MAPNIK_RENDERER_COMMON_RENDER_MARKERS_SYMBOLIZER_HPP
 
 #include <mapnik/marker.hpp>
+#include <mapnik/marker_sprite_cache.hpp>
 #include <mapnik/markers_placement.hpp>
 #include <mapnik/renderer_common.hpp>
 #include <mapnik/symbolizer_base.hpp>
 
+// stl
+#include <string>
+#include <vector>
+
 namespace mapnik {
 
 struct markers_dispatch_params
@@ -40,6 +45,10 @@ struct markers_dispatch_params
     bool snap_to_pixels;
     double scale_factor;
     value_double opacity;
+    marker_rasterizer_enum rasterizer;
+    // set by vector_markers_dispatch::set_sprite_source
+    svg_path_ptr sprite_marker;
+    marker_sprite_style sprite_style;
 
     markers_dispatch_params(box2d<double> const& size,
                             agg::trans_affine const& tr,
@@ -61,6 +70,17 @@ struct markers_renderer_context : util::noncopyable
                                svg_attribute_type const& attrs,
                                markers_dispatch_params const& params,
                                agg::trans_affine const& marker_tr) = 0;
+
+    // Draws the placements of a raster marker on one geometry, in order.
+    virtual void render_markers(image_rgba8 const& src,
+                                markers_dispatch_params const& params,
+                                std::vector<agg::trans_affine> const& marker_trs)
+    {
+        for (auto const& marker_tr : marker_trs)
+        {
+            render_marker(src, params, marker_tr);
+        }
+    }
 };
 
 MAPNIK_DECL
@@ -71,6 +91,17 @@ void render_markers_symbolizer(markers_symbolizer const& sym,
                                box2d<double> const& clip_box,
                                markers_renderer_context& renderer_context);
 
+// Renders mark, already found in the marker cache under filename.
+MAPNIK_DECL
+void render_markers_symbolizer(markers_symbolizer const& sym,
+                               mapnik::feature_impl& feature,
+                               proj_transform const& prj_trans,
+                               renderer_common const& common,
+                               box2d<double> const& clip_box,
+                               std::string const& filename,
+                               marker const& mark,
+                               markers_renderer_context& renderer_context);
+
 } // namespace mapnik
 
 #endif // MAPNIK_RENDERER_COMMON_RENDER_MARKERS_SYMBOLIZER_HPP
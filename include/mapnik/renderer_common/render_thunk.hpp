@@ -35,6 +35,10 @@
 // agg
 #include <agg_trans_affine.h>
 
+// stl
+#include <memory>
+#include <vector>
+
 namespace mapnik {
 
 // Thunk for rendering a particular instance of a point - this
@@ -68,17 +72,21 @@ struct vector_marker_render_thunk : util::movable
 struct raster_marker_render_thunk : util::movable
 {
     image_rgba8 const& src_;
+    // keeps src_ alive if the marker cache drops the marker
+    std::shared_ptr<marker const> marker_;
     agg::trans_affine tr_;
     double opacity_;
     composite_mode_e comp_op_;
     bool snap_to_pixels_;
 
     raster_marker_render_thunk(image_rgba8 const& src,
+                               std::shared_ptr<marker const> const& mark,
                                agg::trans_affine const& marker_trans,
                                double opacity,
                                composite_mode_e comp_op,
                                bool snap_to_pixels)
         : src_(src)
+        , marker_(mark)
         , tr_(marker_trans)
         , opacity_(opacity)
         , comp_op_(comp_op)
@@ -88,21 +96,19 @@ struct raster_marker_render_thunk : util::movable
 
 struct text_render_thunk : util::movable
 {
-    using helper_ptr = std::unique_ptr<text_symbolizer_helper>;
-    // helper is stored here in order
-    // to keep in scope the text rendering structures
-    helper_ptr helper_;
-    placements_list const& placements_;
+    placements_list placements_;
+    // the glyphs of the placements point into these
+    std::vector<text_layout_ptr> layouts_;
     double opacity_;
     composite_mode_e comp_op_;
     halo_rasterizer_enum halo_rasterizer_;
 
-    text_render_thunk(helper_ptr&& helper,
+    text_render_thunk(text_symbolizer_helper& helper,
                       double opacity,
                       composite_mode_e comp_op,
                       halo_rasterizer_enum halo_rasterizer)
-        : helper_(std::move(helper))
-        , placements_(helper_->get())
+        : placements_(helper.release_placements())
+        , layouts_(helper.layouts())
         , opacity_(opacity)
         , comp_op_(comp_op)
         , halo_rasterizer_(halo_rasterizer)
@@ -113,7 +119,7 @@ struct text_render_thunk : util::movable
 // via a static visitor later.
 
 using render_thunk = util::variant<vector_marker_render_thunk, raster_marker_render_thunk, text_render_thunk>;
-using render_thunk_list = std::list<render_thunk>;
+using render_thunk_list = std::vector<render_thunk>;
 
 } // namespace mapnik
 
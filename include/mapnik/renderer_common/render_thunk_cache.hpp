@@ -0,0 +1,100 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_RENDERER_COMMON_RENDER_THUNK_CACHE_HPP
+#define MAPNIK_RENDERER_COMMON_RENDER_THUNK_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/renderer_common/render_thunk.hpp>
+#include <mapnik/util/noncopyable.hpp>
+#include <mapnik/value.hpp>
+
+// stl
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace mapnik {
+
+struct group_rule;
+
+// Laid out members of group symbolizers, shared by all group symbolizers of a
+// render. A member is laid out once for its group rule and the values of the
+// columns the rules read, then reused by every feature with the same values,
+// as route shields repeated along roads are. The members of a feature share the
+// collision detector of a virtual renderer, which the extractor empties after
+// every symbolizer, so layouts don't depend on what was placed before them and
+// reusing one places nothing.
+class MAPNIK_DECL render_thunk_cache : private util::noncopyable
+{
+  public:
+    struct key
+    {
+        group_rule const* rule;
+        value_integer index;
+        box2d<double> clipping_extent;
+        // in the order of the column names
+        std::vector<value> values;
+
+        bool operator==(key const& rhs) const;
+    };
+
+    struct layout
+    {
+        box2d<double> bounds;
+        render_thunk_list thunks;
+        // the sub feature the thunks were extracted from
+        feature_ptr feature;
+    };
+
+    // Layouts are dropped at the start of a group symbolizer once there are
+    // more than capacity of them, with 0 they are only kept for one feature.
+    // Set by the group-layout-cache-size map parameter.
+    explicit render_thunk_cache(std::size_t capacity = 4096);
+
+    layout const* find(key const& k) const;
+
+    // An empty layout for k, valid until the cache is cleared.
+    layout& insert(key&& k);
+
+    std::size_t size() const { return layouts_.size(); }
+    std::size_t capacity() const { return capacity_; }
+    void clear();
+
+  private:
+    struct key_hash
+    {
+        std::size_t operator()(key const& k) const;
+    };
+
+    std::unordered_map<key, layout*, key_hash> index_;
+    std::deque<layout> layouts_;
+    std::size_t capacity_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_RENDERER_COMMON_RENDER_THUNK_CACHE_HPP
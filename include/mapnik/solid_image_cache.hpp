@@ -0,0 +1,109 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+#ifndef MAPNIK_SOLID_IMAGE_CACHE_HPP
+#define MAPNIK_SOLID_IMAGE_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/util/singleton.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace mapnik {
+
+// Encoded rgba8 images of a single color, shared by save_to_stream and
+// save_to_string. Ocean and empty tiles are written from here instead of
+// being encoded again for every request. The check for a single color stops
+// at the first pixel that differs, within the first row for most tiles.
+class MAPNIK_DECL solid_image_cache : public singleton<solid_image_cache, CreateStatic>,
+                                      private util::noncopyable
+{
+    friend class CreateStatic<solid_image_cache>;
+
+  public:
+    struct key
+    {
+        std::uint32_t color;
+        // encoders may write premultiplied images differently, tiff does
+        bool premultiplied;
+        std::size_t width;
+        std::size_t height;
+        // lower case format string with its options, e.g. "png8:z=1"
+        std::string format;
+
+        bool operator==(key const& rhs) const
+        {
+            return color == rhs.color && premultiplied == rhs.premultiplied && width == rhs.width &&
+                   height == rhs.height && format == rhs.format;
+        }
+    };
+
+    std::shared_ptr<std::string const> find(key const& k) const;
+
+    // Caches an encoded image, dropping the oldest ones when more than
+    // capacity are cached.
+    std::shared_ptr<std::string const> insert(key const& k, std::string&& encoded);
+
+    // Number of encoded images kept, 256 by default. 0 disables the cache.
+    // capacity() doesn't lock, it is read for every image saved.
+    void set_capacity(std::size_t capacity);
+    std::size_t capacity() const;
+    std::size_t size() const;
+    void clear();
+
+  private:
+    solid_image_cache();
+
+    struct key_hash
+    {
+        std::size_t operator()(key const& k) const
+        {
+            std::size_t seed = std::hash<std::uint32_t>()(k.color);
+            auto combine = [&seed](std::size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+            combine(std::hash<bool>()(k.premultiplied));
+            combine(std::hash<std::size_t>()(k.width));
+            combine(std::hash<std::size_t>()(k.height));
+            combine(std::hash<std::string>()(k.format));
+            return seed;
+        }
+    };
+
+    void shrink();
+
+    std::unordered_map<key, std::shared_ptr<std::string const>, key_hash> images_;
+    std::deque<key> order_;
+    std::atomic<std::size_t> capacity_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_SOLID_IMAGE_CACHE_HPP
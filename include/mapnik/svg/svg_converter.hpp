@@ -228,13 +228,13 @@ class svg_converter : util::noncopyable
         attr.fill_flag = true;
     }
 
-    void add_fill_gradient(mapnik::gradient const& grad)
+    void add_fill_gradient(gradient_ref const& grad)
     {
         path_attributes& attr = cur_attr();
         attr.fill_gradient = grad;
     }
 
-    void add_stroke_gradient(mapnik::gradient const& grad)
+    void add_stroke_gradient(gradient_ref const& grad)
     {
         path_attributes& attr = cur_attr();
         attr.stroke_gradient = grad;
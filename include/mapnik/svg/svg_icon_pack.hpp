@@ -0,0 +1,84 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+#ifndef MAPNIK_SVG_ICON_PACK_HPP
+#define MAPNIK_SVG_ICON_PACK_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/marker.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mapnik {
+namespace svg {
+
+using icon_pack_entry = std::pair<std::string, svg_path_ptr>;
+
+// Collects parsed SVGs and serializes them into a single icon pack.
+// Gradients and path attributes are stored once and referenced by index
+// from every path using them, the float vertices of all icons are stored
+// in one block which readers use in place.
+class MAPNIK_DECL icon_pack_writer : private util::noncopyable
+{
+  public:
+    icon_pack_writer();
+    void add(std::string const& name, svg_storage_type const& icon);
+    std::size_t size() const { return icon_count_; }
+    std::string data() const;
+    void save(std::string const& filename) const;
+
+  private:
+    std::uint32_t add_gradient(gradient const& grad);
+    std::uint32_t add_attributes(path_attributes const& attr);
+
+    std::string gradients_;
+    std::string attributes_;
+    std::string icons_;
+    std::unordered_map<std::string, std::uint32_t> gradient_ids_;
+    std::unordered_map<std::string, std::uint32_t> attribute_ids_;
+    std::vector<vertex_f> vertices_;
+    std::uint32_t icon_count_;
+};
+
+// Reads an icon pack written by icon_pack_writer. The vertices of the icons
+// are views into `data`, which is kept alive by `owner`. Throws
+// std::runtime_error if the pack is malformed.
+MAPNIK_DECL std::vector<icon_pack_entry> read_icon_pack(char const* data,
+                                                        std::size_t size,
+                                                        std::shared_ptr<void const> owner);
+
+// Reads an icon pack from a file, memory mapped if supported.
+MAPNIK_DECL std::vector<icon_pack_entry> read_icon_pack(std::string const& filename);
+
+} // namespace svg
+} // namespace mapnik
+
+#endif // MAPNIK_SVG_ICON_PACK_HPP
@@ -101,12 +101,14 @@ class MAPNIK_DECL svg_parser : private util::noncopyable
     error_handler& err_handler();
     void parse(std::string const& filename);
     void parse_from_string(std::string const& svg);
+    // svg document of size bytes, not necessarily null terminated
+    void parse_from_buffer(char const* data, std::size_t size);
     svg_converter_type& path_;
     bool is_defs_;
     bool strict_;
     bool ignore_;
     bool css_style_;
-    std::map<std::string, gradient> gradient_map_;
+    std::map<std::string, gradient_ref> gradient_map_;
     std::map<std::string, boost::property_tree::detail::rapidxml::xml_node<char> const*> node_cache_;
     mapnik::css_data css_data_;
     boost::optional<viewbox> vbox_{};
@@ -38,6 +38,8 @@ MAPNIK_DISABLE_WARNING_POP
 
 // stl
 #include <cmath>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace mapnik {
@@ -869,7 +871,7 @@ class vertex_stl_adapter : util::noncopyable
         vertices_[v2] = t;
     }
 
-    unsigned last_command() const { return vertices_.size() ? vertices_[vertices_.size() - 1].cmd : path_cmd_stop; }
+    unsigned last_command() const { return vertices_.size() ? cvertices()[vertices_.size() - 1].cmd : path_cmd_stop; }
 
     unsigned last_vertex(double* x, double* y) const
     {
@@ -891,27 +893,138 @@ class vertex_stl_adapter : util::noncopyable
         return vertex(safe_cast<unsigned>(vertices_.size() - 2), x, y);
     }
 
-    double last_x() const { return vertices_.size() ? vertices_[vertices_.size() - 1].x : 0.0; }
+    double last_x() const { return vertices_.size() ? cvertices()[vertices_.size() - 1].x : 0.0; }
 
-    double last_y() const { return vertices_.size() ? vertices_[vertices_.size() - 1].y : 0.0; }
+    double last_y() const { return vertices_.size() ? cvertices()[vertices_.size() - 1].y : 0.0; }
 
     std::size_t total_vertices() const { return vertices_.size(); }
 
     unsigned vertex(unsigned idx, double* x, double* y) const
     {
-        const vertex_type& v = vertices_[idx];
+        const vertex_type& v = cvertices()[idx];
         *x = v.x;
         *y = v.y;
         return v.cmd;
     }
 
-    unsigned command(unsigned idx) const { return vertices_[idx].cmd; }
+    unsigned command(unsigned idx) const { return cvertices()[idx].cmd; }
 
   private:
+    // reading must not go through the mutable accessors of the container
+    Container const& cvertices() const { return vertices_; }
+
     Container& vertices_;
 };
 
-using svg_path_storage = std::vector<vertex_d>;
+// Vertices of a parsed SVG. Coordinates are stored as floats, which is plenty
+// for icon sized user units and halves the memory of double vertices.
+// The storage either owns its vertices or is a read only view into a block
+// kept alive by `owner` (e.g. a memory mapped icon pack). Modifying a view
+// copies the vertices first.
+class vertex_storage
+{
+  public:
+    using value_type = vertex_f;
+
+    vertex_storage()
+        : data_(nullptr)
+        , size_(0)
+    {}
+
+    vertex_storage(value_type const* data, std::size_t size, std::shared_ptr<void const> owner)
+        : data_(data)
+        , size_(size)
+        , owner_(std::move(owner))
+    {}
+
+    vertex_storage(vertex_storage const& other)
+        : vertices_(other.vertices_)
+        , data_(other.data_)
+        , size_(other.size_)
+        , owner_(other.owner_)
+    {
+        if (!owner_)
+            sync();
+    }
+
+    vertex_storage(vertex_storage&& other)
+        : vertices_(std::move(other.vertices_))
+        , data_(other.data_)
+        , size_(other.size_)
+        , owner_(std::move(other.owner_))
+    {
+        other.sync();
+    }
+
+    vertex_storage& operator=(vertex_storage rhs)
+    {
+        std::swap(vertices_, rhs.vertices_);
+        std::swap(data_, rhs.data_);
+        std::swap(size_, rhs.size_);
+        std::swap(owner_, rhs.owner_);
+        return *this;
+    }
+
+    void push_back(value_type const& v)
+    {
+        detach();
+        vertices_.push_back(v);
+        sync();
+    }
+
+    value_type& operator[](std::size_t idx)
+    {
+        detach();
+        return vertices_[idx];
+    }
+
+    value_type const& operator[](std::size_t idx) const { return data_[idx]; }
+
+    value_type const* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool is_view() const { return owner_ != nullptr; }
+
+    void reserve(std::size_t size)
+    {
+        detach();
+        vertices_.reserve(size);
+        sync();
+    }
+
+    void shrink_to_fit()
+    {
+        if (!owner_)
+        {
+            vertices_.shrink_to_fit();
+            sync();
+        }
+    }
+
+  private:
+    void detach()
+    {
+        if (owner_)
+        {
+            vertices_.assign(data_, data_ + size_);
+            owner_.reset();
+            sync();
+        }
+    }
+
+    void sync()
+    {
+        data_ = vertices_.data();
+        size_ = vertices_.size();
+    }
+
+    std::vector<value_type> vertices_;
+    value_type const* data_;
+    std::size_t size_;
+    std::shared_ptr<void const> owner_;
+};
+
+using svg_path_storage = vertex_storage;
 
 using svg_path_adapter = path_adapter<vertex_stl_adapter<svg_path_storage>>;
 
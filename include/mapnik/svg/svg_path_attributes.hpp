@@ -35,13 +35,66 @@ MAPNIK_DISABLE_WARNING_PUSH
 #include "agg_trans_affine.h"
 MAPNIK_DISABLE_WARNING_POP
 
+// stl
+#include <memory>
+
 namespace mapnik {
 namespace svg {
 
+// Immutable gradient shared by all paths, and all copies of their
+// attributes, which reference it. Mirrors the read only interface of
+// mapnik::gradient so renderers can use it in place of one.
+class gradient_ref
+{
+  public:
+    gradient_ref()
+        : ptr_(none())
+    {}
+
+    gradient_ref(gradient const& grad)
+        : ptr_(std::make_shared<gradient const>(grad))
+    {}
+
+    explicit gradient_ref(std::shared_ptr<gradient const> ptr)
+        : ptr_(ptr ? std::move(ptr) : none())
+    {}
+
+    operator gradient const&() const { return *ptr_; }
+    gradient const& get() const { return *ptr_; }
+    std::shared_ptr<gradient const> const& ptr() const { return ptr_; }
+
+    bool operator==(gradient_ref const& other) const { return ptr_ == other.ptr_ || *ptr_ == *other.ptr_; }
+    bool operator!=(gradient_ref const& other) const { return !(*this == other); }
+
+    gradient_e get_gradient_type() const { return ptr_->get_gradient_type(); }
+    agg::trans_affine const& get_transform() const { return ptr_->get_transform(); }
+    gradient_unit_e get_units() const { return ptr_->get_units(); }
+    bool has_stop() const { return ptr_->has_stop(); }
+    stop_array const& get_stop_array() const { return ptr_->get_stop_array(); }
+    void get_control_points(double& x1, double& y1, double& x2, double& y2, double& r) const
+    {
+        ptr_->get_control_points(x1, y1, x2, y2, r);
+    }
+    void get_control_points(double& x1, double& y1, double& x2, double& y2) const
+    {
+        ptr_->get_control_points(x1, y1, x2, y2);
+    }
+
+  private:
+    // paths without a gradient all share one empty gradient
+    static std::shared_ptr<gradient const> const& none()
+    {
+        static std::shared_ptr<gradient const> const empty = std::make_shared<gradient const>();
+        return empty;
+    }
+
+    std::shared_ptr<gradient const> ptr_;
+};
+
 struct path_attributes
 {
-    mapnik::gradient fill_gradient;
-    mapnik::gradient stroke_gradient;
+    gradient_ref fill_gradient;
+    gradient_ref stroke_gradient;
     agg::trans_affine transform;
     double opacity;
     double fill_opacity;
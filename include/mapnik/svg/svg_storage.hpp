@@ -49,6 +49,10 @@ class svg_storage : util::noncopyable
         return attributes_;
     }
 
+    VertexSource const& source() const { return source_; }
+
+    AttributeSource const& attributes() const { return attributes_; }
+
     void set_bounding_box(box2d<double> const& b) { bounding_box_ = b; }
 
     void set_bounding_box(double x0, double y0, double x1, double y1) { bounding_box_.init(x0, y0, x1, y1); }
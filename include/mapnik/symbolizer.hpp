@@ -96,7 +96,8 @@ enum class property_types : std::uint8_t {
     target_font_feature_settings,
     target_line_pattern,
     target_smooth_algorithm,
-    target_scaling_method
+    target_scaling_method,
+    target_marker_rasterizer
 };
 
 template<typename T>
@@ -175,6 +176,7 @@ ENUM_FROM_STRING(marker_multi_policy_e, marker_multi_policy_enum)
 ENUM_FROM_STRING(debug_symbolizer_mode_e, debug_symbolizer_mode_enum)
 ENUM_FROM_STRING(pattern_alignment_e, pattern_alignment_enum)
 ENUM_FROM_STRING(halo_rasterizer_e, halo_rasterizer_enum)
+ENUM_FROM_STRING(marker_rasterizer_e, marker_rasterizer_enum)
 ENUM_FROM_STRING(label_placement_e, label_placement_enum)
 ENUM_FROM_STRING(vertical_alignment_e, vertical_alignment_enum)
 ENUM_FROM_STRING(horizontal_alignment_e, horizontal_alignment_enum)
@@ -318,6 +318,13 @@ struct symbolizer_default<halo_rasterizer_enum, keys::halo_rasterizer>
     static halo_rasterizer_enum value() { return halo_rasterizer_enum::HALO_RASTERIZER_FULL; }
 };
 
+// marker-rasterizer
+template<>
+struct symbolizer_default<marker_rasterizer_enum, keys::marker_rasterizer>
+{
+    static marker_rasterizer_enum value() { return marker_rasterizer_enum::MARKER_RASTERIZER_FULL; }
+};
+
 // text-placements
 
 // placement (point-placement-type FIXME)
@@ -40,9 +40,21 @@ enum class line_rasterizer_enum : std::uint8_t {
 };
 DEFINE_ENUM(line_rasterizer_e, line_rasterizer_enum);
 
-enum class halo_rasterizer_enum : std::uint8_t { HALO_RASTERIZER_FULL, HALO_RASTERIZER_FAST, halo_rasterizer_enum_MAX };
+enum class halo_rasterizer_enum : std::uint8_t {
+    HALO_RASTERIZER_FULL,
+    HALO_RASTERIZER_FAST,
+    HALO_RASTERIZER_SDF, // thresholds cached glyph distance fields, see glyph_sdf_atlas
+    halo_rasterizer_enum_MAX
+};
 DEFINE_ENUM(halo_rasterizer_e, halo_rasterizer_enum);
 
+enum class marker_rasterizer_enum : std::uint8_t {
+    MARKER_RASTERIZER_FULL,
+    MARKER_RASTERIZER_SPRITE, // blends cached bitmaps of vector markers, see marker_sprite_cache
+    marker_rasterizer_enum_MAX
+};
+DEFINE_ENUM(marker_rasterizer_e, marker_rasterizer_enum);
+
 enum class point_placement_enum : std::uint8_t {
     CENTROID_POINT_PLACEMENT,
     INTERIOR_POINT_PLACEMENT,
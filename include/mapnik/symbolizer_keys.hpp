@@ -95,6 +95,8 @@ enum class keys : std::uint8_t {
     ff_settings,
     extend,
     line_pattern,
+    priority,
+    marker_rasterizer,
     MAX_SYMBOLIZER_KEY
 };
 
@@ -49,12 +49,18 @@ namespace mapnik {
 class MAPNIK_DECL font_face : util::noncopyable
 {
   public:
-    font_face(FT_Face face);
+    font_face(FT_Face face, std::string const& file_name);
 
     std::string family_name() const { return std::string(face_->family_name); }
 
     std::string style_name() const { return std::string(face_->style_name); }
 
+    // The font file and the index of the face in it identify a face across
+    // font managers.
+    std::string const& file_name() const { return file_name_; }
+
+    long face_index() const { return face_->face_index; }
+
     FT_Face get_face() const { return face_; }
 
     bool set_character_sizes(double size);
@@ -70,6 +76,7 @@ class MAPNIK_DECL font_face : util::noncopyable
     bool init_color_font();
 
     FT_Face face_;
+    std::string file_name_;
     const bool color_font_;
 };
 using face_ptr = std::shared_ptr<font_face>;
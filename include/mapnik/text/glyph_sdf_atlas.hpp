@@ -0,0 +1,131 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_TEXT_GLYPH_SDF_ATLAS_HPP
+#define MAPNIK_TEXT_GLYPH_SDF_ATLAS_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/util/singleton.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mapnik {
+
+class font_face;
+
+// Signed distance field of a glyph outline: the distance of every texel
+// center to the outline, negative inside the glyph. Distances are measured in
+// pixels of the size the field was generated at.
+struct MAPNIK_DECL glyph_sdf
+{
+    // Pixel size of the em square the field was generated at.
+    double size;
+    unsigned width;
+    unsigned height;
+    // Position of the top left corner of the field relative to the glyph origin, y pointing up.
+    int left;
+    int top;
+    std::vector<float> data;
+
+    // Bilinearly interpolated distance at texel coordinates, x right and y down
+    // from the top left corner. Outside the field the distance keeps growing.
+    double distance(double x, double y) const;
+};
+
+// Distance fields of glyph outlines, generated once per font file, face index,
+// glyph and size class and shared by all renderers. Fill and halos of any radius up to
+// max_distance() are rasterized from a field by thresholding it, which is much
+// cheaper than stroking the outline for every label.
+class MAPNIK_DECL glyph_sdf_atlas : public singleton<glyph_sdf_atlas, CreateStatic>,
+                                    private util::noncopyable
+{
+    friend class CreateStatic<glyph_sdf_atlas>;
+
+  public:
+    // Size the field for text of the given size is generated at. Size classes
+    // are a factor of sqrt(2) apart.
+    static double size_class(double size);
+    // The largest distance from the outline, in pixels at the given text size,
+    // which the field of that size class represents.
+    static double max_distance(double size);
+
+    // Returns the field of a glyph at the size class of size, generating it on
+    // first use. Returns nullptr for color and bitmap-only faces.
+    std::shared_ptr<glyph_sdf const> get(font_face& face, unsigned glyph_index, double size);
+
+    // Number of fields kept, 16384 by default. The oldest fields are dropped
+    // first, renderers keep the ones they use alive.
+    void set_capacity(std::size_t capacity);
+    std::size_t capacity() const;
+    std::size_t size() const;
+    void clear();
+
+  private:
+    glyph_sdf_atlas();
+
+    struct key
+    {
+        // index of the font file in files_
+        std::size_t file;
+        long face_index;
+        unsigned glyph_index;
+        int size_class;
+        bool operator==(key const& rhs) const
+        {
+            return file == rhs.file && face_index == rhs.face_index && glyph_index == rhs.glyph_index &&
+                   size_class == rhs.size_class;
+        }
+    };
+
+    struct key_hash
+    {
+        std::size_t operator()(key const& k) const
+        {
+            std::size_t seed = std::hash<std::size_t>()(k.file);
+            seed ^= std::hash<long>()(k.face_index) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<unsigned>()(k.glyph_index) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= std::hash<int>()(k.size_class) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+
+    void shrink();
+
+    // font files seen so far, so that keys don't hold their names
+    std::unordered_map<std::string, std::size_t> files_;
+    std::unordered_map<key, std::shared_ptr<glyph_sdf const>, key_hash> fields_;
+    std::deque<key> order_;
+    std::size_t capacity_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_TEXT_GLYPH_SDF_ATLAS_HPP
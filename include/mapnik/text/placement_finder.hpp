@@ -24,6 +24,7 @@
 
 // mapnik
 #include <mapnik/geometry/box2d.hpp>
+#include <mapnik/label_collision_detector.hpp>
 #include <mapnik/pixel_position.hpp>
 #include <mapnik/text/text_layout.hpp>
 #include <mapnik/text/glyph_positions.hpp>
@@ -32,7 +33,6 @@
 
 namespace mapnik {
 
-class label_collision_detector4;
 using DetectorType = label_collision_detector4;
 
 class feature_impl;
@@ -56,10 +56,27 @@ class placement_finder : util::noncopyable
     // Iterate over the given path, placing line-following labels or point labels with respect to label_spacing.
     template<typename T>
     bool find_line_placements(T& path, bool points);
+    // Same for an already measured path.
+    bool find_line_placements(vertex_cache& pp, bool points);
     // Try next position alternative from placement_info.
     bool next_position();
+    // next_position() split in two steps: prepare_position() evaluates the next alternative and
+    // layout_position() shapes its text. layout_position() touches neither the feature nor the
+    // collision detector, so it may run on a worker thread with a face_manager of its own.
+    bool prepare_position();
+    void layout_position(face_manager_freetype& font_manager);
+    void layout_position() { layout_position(font_manager_); }
 
     placements_list const& placements() const { return placements_; }
+    // Hands over the placements found so far.
+    placements_list release_placements()
+    {
+        placements_list placements;
+        placements.swap(placements_);
+        return placements;
+    }
+    // Every layout prepared so far, the glyphs of the placements point into them.
+    std::vector<text_layout_ptr> const& layouts() const { return processed_layouts_; }
 
     void
       set_marker(marker_info_ptr m, box2d<double> box, bool marker_unlocked, pixel_position const& marker_displacement);
@@ -71,7 +88,9 @@ class placement_finder : util::noncopyable
     // Adjusts user defined spacing to place an integer number of labels.
     double get_spacing(double path_length, double layout_width) const;
     // Checks for collision.
-    bool collision(box2d<double> const& box, const value_unicode_string& repeat_key, bool line_placement) const;
+    bool collision(box2d<double> const& box, DetectorType::text_id repeat_key, bool line_placement) const;
+    // Looks up repeat_key_ for the current layouts in the collision detector.
+    void intern_repeat_key();
     // Adds marker to glyph_positions and to collision detector. Returns false if there is a collision.
     bool add_marker(glyph_positions_ptr& glyphs, pixel_position const& pos, std::vector<box2d<double>>& bboxes) const;
     // Maps upright==auto, left-only and right-only to left,right to simplify processing.
@@ -84,6 +103,8 @@ class placement_finder : util::noncopyable
     text_placement_info const& info_;
     evaluated_text_properties_ptr text_props_;
     layout_container layouts_;
+    // interned layouts_.text() for repeat distance checks
+    DetectorType::text_id repeat_key_;
 
     double scale_factor_;
     face_manager_freetype& font_manager_;
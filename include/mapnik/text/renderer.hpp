@@ -127,6 +127,10 @@ class agg_text_renderer : public text_renderer
   private:
     pixmap_type& pixmap_;
 
+    // Renders halos and text from glyph_sdf_atlas fields. Returns false without
+    // rendering anything if a glyph has no field or its halo is too wide for it.
+    bool render_sdf(glyph_positions const& positions);
+
     template<std::size_t PixelWidth>
     void render_halo(unsigned char* buffer,
                      unsigned width,
@@ -30,11 +30,17 @@
 #include <mapnik/text/glyph_positions.hpp>
 #include <mapnik/text/text_properties.hpp>
 
+// stl
+#include <map>
+#include <memory>
+
 namespace mapnik {
 
 class feature_impl;
 class proj_transform;
 class view_transform;
+class vertex_cache;
+class vertex_cache_store;
 struct symbolizer_base;
 
 template<typename T>
@@ -140,7 +146,8 @@ class text_symbolizer_helper : public base_symbolizer_helper
                            FaceManagerT& font_manager,
                            DetectorT& detector,
                            box2d<double> const& query_extent,
-                           agg::trans_affine const&);
+                           agg::trans_affine const&,
+                           bool defer_layout = false);
 
     template<typename FaceManagerT, typename DetectorT>
     text_symbolizer_helper(shield_symbolizer const& sym,
@@ -154,10 +161,28 @@ class text_symbolizer_helper : public base_symbolizer_helper
                            FaceManagerT& font_manager,
                            DetectorT& detector,
                            box2d<double> const& query_extent,
-                           agg::trans_affine const&);
+                           agg::trans_affine const&,
+                           bool defer_layout = false);
 
     // Return all placements.
     placements_list const& get() const;
+    // Hands over the placements get() returns, they stay valid as long as
+    // layouts() do and may outlive the helper.
+    placements_list release_placements()
+    {
+        get();
+        return finder_.release_placements();
+    }
+    // Layouts the glyphs of the placements point into.
+    std::vector<text_layout_ptr> const& layouts() const { return finder_.layouts(); }
+
+    // Shapes the text of a helper constructed with defer_layout, otherwise get() does it. Helpers
+    // may be laid out concurrently as long as each thread passes a face_manager of its own.
+    void layout(face_manager_freetype& font_manager) const;
+    bool layout_pending() const { return layout_pending_; }
+
+    // Lets line placements reuse the paths measured by other helpers of the same render.
+    void set_vertex_cache_store(vertex_cache_store* store) { vertex_cache_store_ = store; }
 
   protected:
     void init_converters();
@@ -166,11 +191,23 @@ class text_symbolizer_helper : public base_symbolizer_helper
     void initialize_grid_points() const;
     bool next_point_placement() const;
     bool next_line_placement() const;
+    // Converted and measured path of a line or polygon geometry, nullptr for points.
+    vertex_cache* line_vertex_cache(geometry_cref const& geom) const;
+    // Prepares the first placement alternative, laying it out unless defer_layout is set.
+    void init_position(bool defer_layout) const;
+    // Drops points which can't get a label before any text layout is done.
+    void discard_blocked_points(label_collision_detector4 const& detector) const;
 
     mutable placement_finder finder_;
 
     placement_finder_adapter<placement_finder> adapter_;
     mutable vertex_converter_type converter_;
+    agg::trans_affine const& affine_trans_;
+    // Measured paths by source geometry, reused by every placement alternative.
+    mutable std::map<void const*, std::shared_ptr<vertex_cache>> vertex_caches_;
+    vertex_cache_store* vertex_cache_store_ = nullptr;
+    // The first placement alternative has been prepared but not laid out yet.
+    mutable bool layout_pending_ = false;
     // ShieldSymbolizer only
     void init_marker() const;
 };
@@ -80,6 +80,10 @@ class text_layout
     // Processes the text into a list of glyphs, performing RTL/LTR handling, shaping and line breaking.
     void layout();
 
+    // Selects the fonts used by layout(). Layouts built on one thread may be shaped on another one, but
+    // a face_manager (and its FreeType faces) must never be used by two threads at the same time.
+    inline void set_font_manager(face_manager_freetype& font_manager) { font_manager_ = &font_manager; }
+
     // Clear all data stored in this object. The object's state is the same as directly after construction.
     void clear();
 
@@ -110,7 +114,7 @@ class text_layout
     void add_child(text_layout_ptr const& child_layout);
 
     inline text_layout_vector const& get_child_layouts() const { return child_layout_list_; }
-    inline face_manager_freetype& get_font_manager() const { return font_manager_; }
+    inline face_manager_freetype& get_font_manager() const { return *font_manager_; }
     inline double get_scale_factor() const { return scale_factor_; }
     inline text_symbolizer_properties const& get_default_text_properties() const { return properties_; }
     inline text_layout_properties const& get_layout_properties() const { return layout_properties_; }
@@ -134,7 +138,7 @@ class text_layout
     void init_auto_alignment();
 
     // input
-    face_manager_freetype& font_manager_;
+    face_manager_freetype* font_manager_;
     double scale_factor_;
 
     // processing
@@ -197,6 +201,8 @@ class layout_container
     void clear();
 
     void layout();
+    // Same as layout() but shapes all layouts with the given fonts.
+    void layout(face_manager_freetype& font_manager);
 
     inline size_t size() const { return layouts_.size(); }
     inline bool empty() const { return layouts_.empty(); }
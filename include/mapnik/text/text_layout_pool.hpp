@@ -0,0 +1,74 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_TEXT_LAYOUT_POOL_HPP
+#define MAPNIK_TEXT_LAYOUT_POOL_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mapnik {
+
+class text_symbolizer_helper;
+
+// Lays out the text of many labels at once. Itemizing, shaping and line
+// breaking only depend on the feature being labelled, so the helpers are
+// constructed with defer_layout, laid out here in parallel and placed one
+// after another afterwards. FreeType faces and the face caches must not be
+// shared between threads, so each worker thread owns its fonts. The threads
+// and their fonts are kept for the lifetime of the pool, see
+// Map::get_text_layout_pool.
+class MAPNIK_DECL text_layout_pool : private util::noncopyable
+{
+  public:
+    // num_threads includes the calling thread, 0 means one per hardware thread.
+    // Without MAPNIK_THREADSAFE all layouts are done by the calling thread.
+    text_layout_pool(freetype_engine::font_file_mapping_type const& font_file_mapping,
+                     freetype_engine::font_memory_cache_type const& font_cache,
+                     std::size_t num_threads = 0);
+    ~text_layout_pool();
+
+    std::size_t num_threads() const;
+
+    // Lays out all pending helpers. The calling thread takes part using
+    // font_manager. The resulting glyphs reference the fonts of the workers,
+    // so keep the returned lock until the placements are rendered. The pool
+    // serves one render at a time: while it is taken the helpers are laid out
+    // by the calling thread alone and the returned lock owns nothing.
+    std::unique_lock<std::mutex> layout(std::vector<text_symbolizer_helper const*> const& helpers,
+                                        face_manager_freetype& font_manager);
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_TEXT_LAYOUT_POOL_HPP
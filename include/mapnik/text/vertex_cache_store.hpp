@@ -0,0 +1,123 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_TEXT_VERTEX_CACHE_STORE_HPP
+#define MAPNIK_TEXT_VERTEX_CACHE_STORE_HPP
+
+// mapnik
+#include <mapnik/vertex_cache.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mapnik {
+
+class proj_transform;
+
+// Keeps the measured paths (segment lengths and distances) of line label
+// geometries during a render, so that text and shield symbolizers on the same
+// road or river convert and measure its geometry only once.
+class vertex_cache_store : util::noncopyable
+{
+  public:
+    // Everything a converted label path depends on: the source vertices and
+    // the arguments of the vertex converters. The vertices are compared in
+    // full, so geometries whose hashes collide never share a path.
+    struct key
+    {
+        // geometry type, then the size of each ring followed by its coordinates
+        std::vector<double> vertices;
+        proj_transform const* prj_trans;
+        std::array<double, 18> args;
+
+        bool operator==(key const& rhs) const
+        {
+            return prj_trans == rhs.prj_trans && args == rhs.args && vertices == rhs.vertices;
+        }
+    };
+
+    explicit vertex_cache_store(std::size_t capacity = 1024)
+        : capacity_(capacity)
+    {}
+
+    std::shared_ptr<vertex_cache> find(key const& k) const
+    {
+        auto itr = caches_.find(k);
+        return itr != caches_.end() ? itr->second : nullptr;
+    }
+
+    // Adds a path, dropping the oldest one when the store is full.
+    void insert(key const& k, std::shared_ptr<vertex_cache> const& cache)
+    {
+        if (capacity_ == 0 || !caches_.emplace(k, cache).second)
+            return;
+        order_.push_back(k);
+        if (order_.size() > capacity_)
+        {
+            caches_.erase(order_.front());
+            order_.pop_front();
+        }
+    }
+
+    void clear()
+    {
+        caches_.clear();
+        order_.clear();
+    }
+
+    std::size_t size() const { return caches_.size(); }
+
+  private:
+    struct key_hash
+    {
+        std::size_t operator()(key const& k) const
+        {
+            std::size_t seed = std::hash<void const*>()(k.prj_trans);
+            for (double arg : k.args)
+            {
+                seed ^= std::hash<double>()(arg) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+            for (double v : k.vertices)
+            {
+                seed ^= std::hash<double>()(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+            return seed;
+        }
+    };
+
+    std::unordered_map<key, std::shared_ptr<vertex_cache>, key_hash> caches_;
+    std::deque<key> order_;
+    std::size_t capacity_;
+};
+
+using vertex_cache_store_ptr = std::shared_ptr<vertex_cache_store>;
+
+} // namespace mapnik
+
+#endif // MAPNIK_TEXT_VERTEX_CACHE_STORE_HPP
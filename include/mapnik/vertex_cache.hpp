@@ -49,13 +49,16 @@ class MAPNIK_DECL vertex_cache : util::noncopyable
 {
     struct segment
     {
-        segment(double x, double y, double _length)
+        segment(double x, double y, double _length, double _distance)
             : pos(x, y)
             , length(_length)
+            , distance(_distance)
         {}
         pixel_position
           pos; // Last point of this segment, first point is implicitly defined by the previous segement in this vector
         double length;
+        // Distance of pos from the start of the subpath, used to find segments by binary search.
+        double distance;
     };
 
     // The first segment always has the length 0 and just defines the starting point.
@@ -69,8 +72,8 @@ class MAPNIK_DECL vertex_cache : util::noncopyable
         {
             if (len == 0. && !vector.empty())
                 return; // Don't add zero length segments
-            vector.emplace_back(x, y, len);
             length += len;
+            vector.emplace_back(x, y, len, length);
         }
         using iterator = std::vector<segment>::iterator;
         std::vector<segment> vector;
@@ -164,6 +167,9 @@ class MAPNIK_DECL vertex_cache : util::noncopyable
 
   private:
     void rewind_subpath();
+    // Makes the segment containing the given distance from the start of the subpath current
+    // and converts distance to the position in that segment. Returns false if it is outside the subpath.
+    bool seek_segment(double& distance);
     bool next_segment();
     bool previous_segment();
     void find_line_circle_intersection(double cx,
@@ -38,8 +38,10 @@ MAPNIK_DISABLE_WARNING_POP
 
 // stl
 #include <algorithm>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace mapnik {
 
@@ -53,69 +55,68 @@ int webp_stream_write(const uint8_t* data, size_t data_size, const WebPPicture*
 
 std::string MAPNIK_DECL webp_encoding_error(WebPEncodingError error);
 
-template<typename T2>
-inline int import_image(T2 const& im_in, WebPPicture& pic, bool alpha)
+namespace detail {
+
+inline int import_rgba(std::uint8_t const* rgba, int stride, WebPPicture& pic, bool alpha)
 {
-    image<typename T2::pixel> const& data = im_in.data();
-    std::size_t width = im_in.width();
-    std::size_t height = im_in.height();
-    std::size_t stride = sizeof(typename T2::pixel_type) * width;
-    if (data.width() == width && data.height() == height)
-    {
-        if (alpha)
-        {
-            return WebPPictureImportRGBA(&pic, data.bytes(), static_cast<int>(stride));
-        }
-        else
-        {
 #if (WEBP_ENCODER_ABI_VERSION >> 8) >= 1
-            return WebPPictureImportRGBX(&pic, data.bytes(), static_cast<int>(stride));
-#else
-            return WebPPictureImportRGBA(&pic, data.bytes(), static_cast<int>(stride));
-#endif
-        }
+    if (!alpha)
+    {
+        return WebPPictureImportRGBX(&pic, rgba, stride);
     }
-    else
+#endif
+    return WebPPictureImportRGBA(&pic, rgba, stride);
+}
+
+// ARGB pixels of the pictures encoded by this thread, kept between calls
+// unless they take more than 16MB.
+inline std::vector<std::uint32_t>& webp_argb_buffer()
+{
+    static thread_local std::vector<std::uint32_t> buffer;
+    return buffer;
+}
+
+// Points pic at the pixels of image converted to ARGB in buffer, which
+// libwebp does not free.
+template<typename T>
+void import_argb(T const& image, WebPPicture& pic, bool alpha, std::vector<std::uint32_t>& buffer)
+{
+    std::size_t const width = image.width();
+    std::size_t const height = image.height();
+    buffer.resize(width * height);
+    std::uint32_t const alpha_mask = alpha ? 0 : 0xff000000;
+    for (std::size_t y = 0; y < height; ++y)
     {
-        // need to copy: https://github.com/mapnik/mapnik/issues/2024
-        image_rgba8 im(width, height);
-        for (unsigned y = 0; y < height; ++y)
-        {
-            typename T2::pixel_type const* row_from = im_in.get_row(y);
-            image_rgba8::pixel_type* row_to = im.get_row(y);
-            std::copy(row_from, row_from + width, row_to);
-        }
-        if (alpha)
-        {
-            return WebPPictureImportRGBA(&pic, im.bytes(), static_cast<int>(stride));
-        }
-        else
+        typename T::pixel_type const* row = image.get_row(y);
+        std::uint32_t* out = &buffer[y * width];
+        for (std::size_t x = 0; x < width; ++x)
         {
-#if (WEBP_ENCODER_ABI_VERSION >> 8) >= 1
-            return WebPPictureImportRGBX(&pic, im.bytes(), static_cast<int>(stride));
-#else
-            return WebPPictureImportRGBA(&pic, im.bytes(), static_cast<int>(stride));
-#endif
+            std::uint32_t const rgba = row[x];
+            out[x] = (rgba & 0xff00ff00) | ((rgba & 0xff) << 16) | ((rgba >> 16) & 0xff) | alpha_mask;
         }
     }
+    pic.use_argb = 1;
+    pic.argb = buffer.data();
+    pic.argb_stride = static_cast<int>(width);
+}
+
+} // namespace detail
+
+// Rows of a view are as far apart as those of the image it looks into, so
+// they are imported in place.
+template<typename T2>
+inline int import_image(T2 const& im_in, WebPPicture& pic, bool alpha)
+{
+    return detail::import_rgba(reinterpret_cast<std::uint8_t const*>(im_in.get_row(0)),
+                               static_cast<int>(im_in.data().row_size()),
+                               pic,
+                               alpha);
 }
 
 template<>
 inline int import_image(image_rgba8 const& im, WebPPicture& pic, bool alpha)
 {
-    std::size_t stride = sizeof(image_rgba8::pixel_type) * im.width();
-    if (alpha)
-    {
-        return WebPPictureImportRGBA(&pic, im.bytes(), static_cast<int>(stride));
-    }
-    else
-    {
-#if (WEBP_ENCODER_ABI_VERSION >> 8) >= 1
-        return WebPPictureImportRGBX(&pic, im.bytes(), static_cast<int>(stride));
-#else
-        return WebPPictureImportRGBA(&pic, im.bytes(), static_cast<int>(stride));
-#endif
-    }
+    return detail::import_rgba(im.bytes(), static_cast<int>(im.row_size()), pic, alpha);
 }
 
 template<typename T1, typename T2>
@@ -135,36 +136,20 @@ void save_as_webp(T1& file, T2 const& image, WebPConfig const& config, bool alph
     pic.height = image.height();
     int ok = 0;
 #if (WEBP_ENCODER_ABI_VERSION >> 8) >= 1
-    pic.use_argb = !!config.lossless;
-    // lossless fast track
-    if (pic.use_argb)
+    // lossless encoding works on ARGB, and so does the sharp RGB to YUV
+    // conversion of lossy encoding
+    bool use_argb = config.lossless != 0;
+#if WEBP_ENCODER_ABI_VERSION >= 0x020e
+    use_argb = use_argb || config.use_sharp_yuv != 0;
+#endif
+    std::vector<std::uint32_t>& argb = detail::webp_argb_buffer();
+    if (use_argb)
     {
-        pic.colorspace = static_cast<WebPEncCSP>(pic.colorspace | WEBP_CSP_ALPHA_BIT);
-        if (WebPPictureAlloc(&pic))
-        {
-            ok = 1;
-            const int width = pic.width;
-            const int height = pic.height;
-            for (int y = 0; y < height; ++y)
-            {
-                typename T2::pixel_type const* row = image.get_row(y);
-                for (int x = 0; x < width; ++x)
-                {
-                    const unsigned rgba = row[x];
-                    unsigned a = (rgba >> 24) & 0xff;
-                    unsigned r = rgba & 0xff;
-                    unsigned g = (rgba >> 8) & 0xff;
-                    unsigned b = (rgba >> 16) & 0xff;
-                    const uint32_t argb = (a << 24) | (r << 16) | (g << 8) | (b);
-                    pic.argb[x + y * pic.argb_stride] = argb;
-                }
-            }
-        }
+        detail::import_argb(image, pic, alpha, argb);
+        ok = 1;
     }
     else
     {
-        // different approach for lossy since ImportYUVAFromRGBA is needed
-        // to prepare WebPPicture and working with view pixels is not viable
         ok = import_image(image, pic, alpha);
     }
 #else
@@ -179,6 +164,12 @@ void save_as_webp(T1& file, T2 const& image, WebPConfig const& config, bool alph
     pic.custom_ptr = &file;
     ok = WebPEncode(&config, &pic);
     WebPPictureFree(&pic);
+#if (WEBP_ENCODER_ABI_VERSION >> 8) >= 1
+    if (argb.capacity() > (1 << 22))
+    {
+        std::vector<std::uint32_t>().swap(argb);
+    }
+#endif
     if (!ok)
     {
         throw std::runtime_error(webp_encoding_error(pic.error_code));
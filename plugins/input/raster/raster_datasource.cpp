@@ -68,6 +68,8 @@ raster_datasource::raster_datasource(parameters const& params)
     multi_tiles_ = *params.get<mapnik::boolean_type>("multi", false);
     tile_size_ = *params.get<mapnik::value_integer>("tile_size", 1024);
     tile_stride_ = *params.get<mapnik::value_integer>("tile_stride", 1);
+    // jpeg and webp images shown smaller than their size are decoded smaller
+    scaled_decode_ = *params.get<mapnik::boolean_type>("scaled_decode", false);
 
     boost::optional<std::string> format_from_filename = mapnik::type_from_filename(*file);
     format_ = *params.get<std::string>("format", format_from_filename ? (*format_from_filename) : "tiff");
@@ -202,7 +204,7 @@ featureset_ptr raster_datasource::features(query const& q) const
         tiled_multi_file_policy
           policy(filename_, format_, tile_size_, extent_, q.get_bbox(), width_, height_, tile_stride_);
 
-        return std::make_shared<raster_featureset<tiled_multi_file_policy>>(policy, extent_, q);
+        return std::make_shared<raster_featureset<tiled_multi_file_policy>>(policy, extent_, q, scaled_decode_);
     }
     else if (width * height > static_cast<int>(tile_size_ * tile_size_ << 2))
     {
@@ -210,7 +212,7 @@ featureset_ptr raster_datasource::features(query const& q) const
 
         tiled_file_policy policy(filename_, format_, tile_size_, extent_, q.get_bbox(), width_, height_);
 
-        return std::make_shared<raster_featureset<tiled_file_policy>>(policy, extent_, q);
+        return std::make_shared<raster_featureset<tiled_file_policy>>(policy, extent_, q, scaled_decode_);
     }
     else
     {
@@ -219,7 +221,7 @@ featureset_ptr raster_datasource::features(query const& q) const
         raster_info info(filename_, format_, extent_, width_, height_);
         single_file_policy policy(info);
 
-        return std::make_shared<raster_featureset<single_file_policy>>(policy, extent_, q);
+        return std::make_shared<raster_featureset<single_file_policy>>(policy, extent_, q, scaled_decode_);
     }
 }
 
@@ -66,6 +66,7 @@ class raster_datasource : public mapnik::datasource
     bool multi_tiles_;
     unsigned tile_size_;
     unsigned tile_stride_;
+    bool scaled_decode_;
     unsigned width_;
     unsigned height_;
 };
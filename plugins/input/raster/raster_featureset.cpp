@@ -37,6 +37,10 @@ MAPNIK_DISABLE_WARNING_PUSH
 #include <boost/format.hpp>
 MAPNIK_DISABLE_WARNING_POP
 
+// stl
+#include <cmath>
+#include <tuple>
+
 #include "raster_featureset.hpp"
 
 using mapnik::feature_factory;
@@ -49,7 +53,8 @@ using mapnik::raster;
 template<typename LookupPolicy>
 raster_featureset<LookupPolicy>::raster_featureset(LookupPolicy const& policy,
                                                    box2d<double> const& extent,
-                                                   query const& q)
+                                                   query const& q,
+                                                   bool scaled_decode)
     : policy_(policy)
     , feature_id_(1)
     , ctx_(std::make_shared<mapnik::context_type>())
@@ -58,6 +63,10 @@ raster_featureset<LookupPolicy>::raster_featureset(LookupPolicy const& policy,
     , curIter_(policy_.begin())
     , endIter_(policy_.end())
     , filter_factor_(q.get_filter_factor())
+    , resolution_(q.resolution())
+    , reader_()
+    , reader_file_()
+    , scaled_decode_(scaled_decode)
 {}
 
 template<typename LookupPolicy>
@@ -73,12 +82,18 @@ feature_ptr raster_featureset<LookupPolicy>::next()
 
         try
         {
-            std::unique_ptr<image_reader> reader(mapnik::get_image_reader(curIter_->file(), curIter_->format()));
+            if (!reader_ || reader_file_ != curIter_->file())
+            {
+                reader_.reset();
+                reader_.reset(mapnik::get_image_reader(curIter_->file(), curIter_->format()));
+                reader_file_ = curIter_->file();
+            }
+            image_reader* reader = reader_.get();
 
             MAPNIK_LOG_DEBUG(raster) << "raster_featureset: Reader=" << curIter_->format() << "," << curIter_->file()
                                      << ",size(" << curIter_->width() << "," << curIter_->height() << ")";
 
-            if (reader.get())
+            if (reader)
             {
                 int image_width = policy_.img_width(reader->width());
                 int image_height = policy_.img_height(reader->height());
@@ -116,13 +131,43 @@ feature_ptr raster_featureset<LookupPolicy>::next()
                     if (height < 1)
                         height = 1;
 
+                    unsigned denominator = 1;
+                    if (scaled_decode_)
+                    {
+                        // map pixels covered by the window
+                        double scale_x = std::get<0>(resolution_) * extent_.width() / image_width;
+                        double scale_y = std::get<1>(resolution_) * extent_.height() / image_height;
+                        denominator = reader->scale_denominator(width,
+                                                                height,
+                                                                static_cast<unsigned>(std::ceil(width * scale_x)),
+                                                                static_cast<unsigned>(std::ceil(height * scale_y)));
+                    }
+                    double covered_width = width;
+                    double covered_height = height;
+                    if (denominator > 1)
+                    {
+                        // start the window on whole pixels of the shrunk image, the
+                        // reader tells how far its pixels reach, which depends on the
+                        // format next to the right and bottom edges
+                        int d = static_cast<int>(denominator);
+                        width += x_off % d;
+                        height += y_off % d;
+                        x_off -= x_off % d;
+                        y_off -= y_off % d;
+                        box2d<double> covered = reader->scaled_window(x_off, y_off, width, height, denominator);
+                        covered_width = covered.width();
+                        covered_height = covered.height();
+                    }
+
                     // calculate actual box2d of returned raster
                     box2d<double> feature_raster_extent(rem.minx() + x_off,
                                                         rem.miny() + y_off,
-                                                        rem.maxx() + x_off + width,
-                                                        rem.maxy() + y_off + height);
+                                                        rem.maxx() + x_off + covered_width,
+                                                        rem.maxy() + y_off + covered_height);
                     feature_raster_extent = t.backward(feature_raster_extent);
-                    mapnik::image_any data = reader->read(x_off, y_off, width, height);
+                    mapnik::image_any data = denominator > 1
+                                               ? reader->read_scaled(x_off, y_off, width, height, denominator)
+                                               : reader->read(x_off, y_off, width, height);
                     mapnik::raster_ptr raster = std::make_shared<mapnik::raster>(feature_raster_extent,
                                                                                  intersect,
                                                                                  std::move(data),
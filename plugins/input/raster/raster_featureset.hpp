@@ -29,8 +29,11 @@
 // mapnik
 #include <mapnik/feature.hpp>
 #include <mapnik/debug.hpp>
+#include <mapnik/image_reader.hpp>
 
 // stl
+#include <memory>
+#include <string>
 #include <vector>
 
 // boost
@@ -126,9 +129,11 @@ class tiled_file_policy
 
         box2d<double> e = bbox.intersect(extent);
 
-        for (int x = 0; x < max_x; ++x)
+        // rows of tiles from the top of the image down, png files are then
+        // decoded once by the reader the featureset keeps
+        for (int y = max_y - 1; y >= 0; --y)
         {
-            for (int y = 0; y < max_y; ++y)
+            for (int x = 0; x < max_x; ++x)
             {
                 double x0 = lox + x * tile_size * pixel_x;
                 double y0 = loy + y * tile_size * pixel_y;
@@ -258,7 +263,10 @@ class raster_featureset : public mapnik::Featureset
     using iterator_type = typename LookupPolicy::const_iterator;
 
   public:
-    raster_featureset(LookupPolicy const& policy, box2d<double> const& exttent, mapnik::query const& q);
+    raster_featureset(LookupPolicy const& policy,
+                      box2d<double> const& exttent,
+                      mapnik::query const& q,
+                      bool scaled_decode = false);
     virtual ~raster_featureset();
     mapnik::feature_ptr next();
 
@@ -271,6 +279,12 @@ class raster_featureset : public mapnik::Featureset
     iterator_type curIter_;
     iterator_type endIter_;
     double filter_factor_;
+    mapnik::query::resolution_type resolution_;
+    // the reader of the last file, tiles of one file share it
+    std::unique_ptr<mapnik::image_reader> reader_;
+    std::string reader_file_;
+    // decode the images at a reduced size when the map shows them smaller
+    bool scaled_decode_;
 };
 
 #endif // RASTER_FEATURESET_HPP
@@ -35,6 +35,8 @@
 #include <mapnik/font_set.hpp>
 #include <mapnik/parse_path.hpp>
 #include <mapnik/map.hpp>
+#include <mapnik/text/symbolizer_helpers.hpp>
+#include <mapnik/text/text_layout_pool.hpp>
 #include <mapnik/svg/svg_converter.hpp>
 #include <mapnik/svg/svg_renderer_agg.hpp>
 #include <mapnik/svg/svg_path_adapter.hpp>
@@ -42,6 +44,8 @@
 #include <mapnik/image_compositing.hpp>
 #include <mapnik/image_filter.hpp>
 #include <mapnik/image_any.hpp>
+#include <mapnik/image_row_writer.hpp>
+#include <mapnik/image_view.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -63,13 +67,17 @@ MAPNIK_DISABLE_WARNING_PUSH
 MAPNIK_DISABLE_WARNING_POP
 
 // stl
+#include <algorithm>
 #include <cmath>
+#include <deque>
+#include <vector>
 
 namespace mapnik {
 
 template<typename T0, typename T1>
 agg_renderer<T0, T1>::agg_renderer(Map const& m, T0& pixmap, double scale_factor, unsigned offset_x, unsigned offset_y)
     : feature_style_processor<agg_renderer>(m, scale_factor)
+    , m_(m)
     , buffers_()
     , internal_buffers_(m.width(), m.height())
     , inflated_buffer_()
@@ -90,6 +98,7 @@ agg_renderer<T0, T1>::agg_renderer(Map const& m,
                                    unsigned offset_x,
                                    unsigned offset_y)
     : feature_style_processor<agg_renderer>(m, scale_factor)
+    , m_(m)
     , buffers_()
     , internal_buffers_(req.width(), req.height())
     , inflated_buffer_()
@@ -109,6 +118,7 @@ agg_renderer<T0, T1>::agg_renderer(Map const& m,
                                    unsigned offset_x,
                                    unsigned offset_y)
     : feature_style_processor<agg_renderer>(m, scale_factor)
+    , m_(m)
     , buffers_()
     , internal_buffers_(m.width(), m.height())
     , inflated_buffer_()
@@ -212,10 +222,116 @@ void agg_renderer<T0, T1>::start_map_processing(Map const& map)
 template<typename T0, typename T1>
 void agg_renderer<T0, T1>::end_map_processing(Map const& map)
 {
+    render_queued_labels();
     mapnik::demultiply_alpha(buffers_.top().get());
     MAPNIK_LOG_DEBUG(agg_renderer) << "agg_renderer: End map processing";
 }
 
+namespace detail {
+
+template<typename Symbolizer>
+std::unique_ptr<text_symbolizer_helper> deferred_label_helper(Symbolizer const& sym,
+                                                              label_placement_candidate const& candidate,
+                                                              renderer_common& common,
+                                                              agg::trans_affine& tr)
+{
+    const auto transform = get_optional<transform_type>(sym, keys::geometry_transform);
+    if (transform)
+        evaluate_transform(tr, *candidate.feature, common.vars_, *transform, common.scale_factor_);
+    auto helper = std::make_unique<text_symbolizer_helper>(sym,
+                                                           *candidate.feature,
+                                                           common.vars_,
+                                                           *candidate.prj_trans,
+                                                           common.width_,
+                                                           common.height_,
+                                                           common.scale_factor_,
+                                                           common.t_,
+                                                           common.font_manager_,
+                                                           *common.detector_,
+                                                           candidate.clip_box,
+                                                           tr,
+                                                           true);
+    helper->set_vertex_cache_store(common.vertex_caches_.get());
+    return helper;
+}
+
+} // namespace detail
+
+template<typename T0, typename T1>
+void agg_renderer<T0, T1>::render_queued_labels()
+{
+    if (label_queue_.empty())
+        return;
+    const auto num_threads = m_.get_extra_parameters().get<value_integer>("text-layout-threads", 1);
+    if (*num_threads == 1 || label_queue_.size() == 1)
+    {
+        label_queue_.flush([this](label_placement_candidate const& candidate) {
+            if (candidate.shield)
+            {
+                render_label(static_cast<shield_symbolizer const&>(*candidate.sym),
+                             *candidate.feature,
+                             *candidate.prj_trans,
+                             candidate.clip_box);
+            }
+            else
+            {
+                render_label(static_cast<text_symbolizer const&>(*candidate.sym),
+                             *candidate.feature,
+                             *candidate.prj_trans,
+                             candidate.clip_box);
+            }
+        });
+        return;
+    }
+
+    // Lay out the text of all queued labels in parallel, then place them one
+    // after another as usual. The helpers are created before any of them is
+    // placed, so the collision detector prunes fewer points up front. Labels
+    // without a priority aren't queued, they are drawn and placed between the
+    // other symbolizers of their features and laid out right there.
+    label_queue_.sort();
+    // declared first so that it outlives the placements referencing its fonts
+    std::shared_ptr<text_layout_pool> pool =
+      m_.get_text_layout_pool(static_cast<std::size_t>(std::max(value_integer(0), *num_threads)));
+    std::deque<agg::trans_affine> transforms;
+    std::vector<std::unique_ptr<text_symbolizer_helper>> helpers;
+    std::vector<text_symbolizer_helper const*> pending;
+    helpers.reserve(label_queue_.size());
+    for (auto const& candidate : label_queue_)
+    {
+        transforms.emplace_back();
+        if (candidate.shield)
+        {
+            helpers.push_back(detail::deferred_label_helper(static_cast<shield_symbolizer const&>(*candidate.sym),
+                                                            candidate,
+                                                            common_,
+                                                            transforms.back()));
+        }
+        else
+        {
+            helpers.push_back(detail::deferred_label_helper(static_cast<text_symbolizer const&>(*candidate.sym),
+                                                            candidate,
+                                                            common_,
+                                                            transforms.back()));
+        }
+        if (helpers.back()->layout_pending())
+            pending.push_back(helpers.back().get());
+    }
+    // held until the labels are rendered
+    std::unique_lock<std::mutex> fonts = pool->layout(pending, common_.font_manager_);
+
+    auto helper_itr = helpers.begin();
+    for (auto const& candidate : label_queue_)
+    {
+        if (candidate.shield)
+            render_label(static_cast<shield_symbolizer const&>(*candidate.sym), *candidate.feature, **helper_itr);
+        else
+            render_label(static_cast<text_symbolizer const&>(*candidate.sym), *candidate.feature, **helper_itr);
+        ++helper_itr;
+    }
+    label_queue_.clear();
+}
+
 template<typename T0, typename T1>
 void agg_renderer<T0, T1>::start_layer_processing(layer const& lay, box2d<double> const& query_extent)
 {
@@ -223,6 +339,10 @@ void agg_renderer<T0, T1>::start_layer_processing(layer const& lay, box2d<double
     MAPNIK_LOG_DEBUG(agg_renderer) << "agg_renderer: -- datasource=" << lay.datasource().get();
     MAPNIK_LOG_DEBUG(agg_renderer) << "agg_renderer: -- query_extent=" << query_extent;
 
+    if (label_queue_.start_layer(m_, lay))
+    {
+        render_queued_labels();
+    }
     if (lay.clear_label_cache())
     {
         common_.detector_->clear();
@@ -257,6 +377,7 @@ void agg_renderer<T0, T1>::end_layer_processing(layer const& lyr)
 
     if (&current_buffer != &previous_buffer)
     {
+        previous_buffer.painted(previous_buffer.painted() || current_buffer.painted());
         composite_mode_e comp_op = lyr.comp_op() ? *lyr.comp_op() : src_over;
         composite(previous_buffer, current_buffer, comp_op, lyr.get_opacity(), 0, 0);
         internal_buffers_.pop();
@@ -268,6 +389,8 @@ void agg_renderer<T0, T1>::start_style_processing(feature_type_style const& st)
 {
     MAPNIK_LOG_DEBUG(agg_renderer) << "agg_renderer: Start processing style";
 
+    label_queue_.start_style(st);
+
     if (st.comp_op() || st.image_filters().size() > 0 || st.get_opacity() < 1)
     {
         if (st.image_filters_inflate())
@@ -295,6 +418,7 @@ void agg_renderer<T0, T1>::start_style_processing(feature_type_style const& st)
             else
             {
                 mapnik::fill(*inflated_buffer_, 0); // fill with transparent colour
+                inflated_buffer_->painted(false);
             }
             buffers_.emplace(*inflated_buffer_);
         }
@@ -322,6 +446,7 @@ void agg_renderer<T0, T1>::end_style_processing(feature_type_style const& st)
     buffer_type& previous_buffer = buffers_.top().get();
     if (&current_buffer != &previous_buffer)
     {
+        previous_buffer.painted(previous_buffer.painted() || current_buffer.painted());
         bool blend_from = false;
         if (st.image_filters().size() > 0)
         {
@@ -559,7 +684,7 @@ void agg_renderer<T0, T1>::render_marker(pixel_position const& pos,
 }
 
 template<typename T0, typename T1>
-bool agg_renderer<T0, T1>::painted()
+bool agg_renderer<T0, T1>::painted() const
 {
     return buffers_.top().get().painted();
 }
@@ -640,6 +765,41 @@ void agg_renderer<T0, T1>::draw_geo_extent(box2d<double> const& extent, mapnik::
     }
 }
 
+void render_in_bands(Map const& map, image_row_writer& writer, unsigned band_height, double scale_factor)
+{
+    unsigned const width = map.width();
+    unsigned const height = map.height();
+    if (writer.width() != width || writer.height() != height || writer.rows_written() != 0)
+    {
+        throw std::runtime_error("render_in_bands: the writer does not match the size of the map");
+    }
+    // bands are maps of their own, at least 16 rows tall, and set_height
+    // leaves the height alone for sizes a map can not have
+    Map band_map(map);
+    band_map.set_aspect_fix_mode(Map::RESPECT);
+    band_map.set_height(std::min(std::max(band_height, 16u), height));
+    band_height = band_map.height();
+    box2d<double> const extent = map.get_current_extent();
+    double const res = extent.height() / height;
+    image_rgba8 band(width, band_height);
+    for (unsigned y = 0; y < height;)
+    {
+        // the last band ends at the bottom of the map, overlapping rows
+        // written already
+        unsigned y0 = std::min(y, height - band_height);
+        band_map.zoom_to_box(box2d<double>(extent.minx(),
+                                           extent.maxy() - (y0 + band_height) * res,
+                                           extent.maxx(),
+                                           extent.maxy() - y0 * res));
+        band.set(0);
+        agg_renderer<image_rgba8> ren(band_map, band, scale_factor);
+        ren.apply();
+        writer.write(image_view_rgba8(0, y - y0, width, y0 + band_height - y, band));
+        y = y0 + band_height;
+    }
+    writer.finish();
+}
+
 template class agg_renderer<image_rgba8>;
 template void agg_renderer<image_rgba8>::debug_draw_box<agg::rendering_buffer>(agg::rendering_buffer& buf,
                                                                                box2d<double> const& box,
@@ -243,9 +243,10 @@ void agg_renderer<T0, T1>::process(debug_symbolizer const& sym,
     }
     else if (mode == debug_symbolizer_mode_enum::DEBUG_SYM_MODE_COLLISION)
     {
-        for (auto const& n : *common_.detector_)
+        label_collision_detector4 const& detector = *common_.detector_;
+        for (std::size_t i = 0; i < detector.size(); ++i)
         {
-            draw_rect(buffers_.top().get(), n.get().box);
+            draw_rect(buffers_.top().get(), detector.box(i));
         }
     }
     else if (mode == debug_symbolizer_mode_enum::DEBUG_SYM_MODE_VERTEX)
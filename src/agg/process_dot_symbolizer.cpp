@@ -32,6 +32,7 @@
 #include <mapnik/renderer_common.hpp>
 #include <mapnik/proj_transform.hpp>
 #include <mapnik/image_compositing.hpp>
+#include <mapnik/dot_rasterizer.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -45,6 +46,10 @@ MAPNIK_DISABLE_WARNING_PUSH
 #include "agg_renderer_base.h"
 MAPNIK_DISABLE_WARNING_POP
 
+// stl
+#include <memory>
+#include <vector>
+
 namespace mapnik {
 namespace detail {
 
@@ -93,6 +98,17 @@ struct render_dot_symbolizer : util::noncopyable
     agg::scanline_u8 sl_;
 };
 
+// Stamps of the last dot size drawn by this thread, point layers mostly use one.
+inline dot_rasterizer const& cached_dot_rasterizer(double rx, double ry)
+{
+    static thread_local std::unique_ptr<dot_rasterizer> dots;
+    if (!dots || dots->rx() != rx || dots->ry() != ry)
+    {
+        dots = std::make_unique<dot_rasterizer>(rx, ry);
+    }
+    return *dots;
+}
+
 } // namespace detail
 
 template<typename T0, typename T1>
@@ -121,6 +137,17 @@ void agg_renderer<T0, T1>::process(dot_symbolizer const& sym,
     const double ry = height / 2.0 * common_.scale_factor_;
     const double opacity = get<double>(sym, keys::opacity, feature, common_.vars_, 1.0);
     const color& fill = get<mapnik::color>(sym, keys::fill, feature, common_.vars_, mapnik::color(128, 128, 128));
+    const composite_mode_e comp_op = get<composite_mode_e>(sym, keys::comp_op, feature, common_.vars_, src_over);
+    if (get<marker_rasterizer_enum, keys::marker_rasterizer>(sym, feature, common_.vars_) ==
+        marker_rasterizer_enum::MARKER_RASTERIZER_SPRITE)
+    {
+        // all points of the feature are reprojected at once and stamped
+        static thread_local std::vector<dot_rasterizer::point_type> points;
+        points.clear();
+        dot_rasterizer::append_points(feature.get_geometry(), prj_trans, common_.t_, points);
+        detail::cached_dot_rasterizer(rx, ry).blend(buffers_.top().get(), fill, opacity, comp_op, points);
+        return;
+    }
     ras_ptr->reset();
     if (gamma_method_ != gamma_method_enum::GAMMA_POWER || gamma_ != 1.0)
     {
@@ -138,8 +165,7 @@ void agg_renderer<T0, T1>::process(dot_symbolizer const& sym,
     using renderer_base = agg::renderer_base<pixfmt_comp_type>;
     using renderer_type = agg::renderer_scanline_aa_solid<renderer_base>;
     pixfmt_comp_type pixf(buf);
-    pixf.comp_op(
-      static_cast<agg::comp_op_e>(get<composite_mode_e>(sym, keys::comp_op, feature, common_.vars_, src_over)));
+    pixf.comp_op(static_cast<agg::comp_op_e>(comp_op));
     renderer_base renb(pixf);
     renderer_type ren(renb);
 
@@ -68,6 +68,8 @@ struct agg_markers_renderer_context : markers_renderer_context
         , pixf_(buf_)
         , renb_(pixf_)
         , ras_(ras)
+        , gamma_(get<value_double, keys::gamma>(sym, feature, vars))
+        , gamma_method_(get<gamma_method_enum, keys::gamma_method>(sym, feature, vars))
     {
         auto comp_op = get<composite_mode_e, keys::comp_op>(sym, feature, vars);
         pixf_.comp_op(static_cast<agg::comp_op_e>(comp_op));
@@ -80,6 +82,21 @@ struct agg_markers_renderer_context : markers_renderer_context
                                agg::trans_affine const& marker_tr)
     {
         SvgRenderer svg_renderer(path, attrs);
+        if (params.rasterizer == marker_rasterizer_enum::MARKER_RASTERIZER_SPRITE && params.sprite_marker &&
+            render_vector_marker_sprite<RasterizerType>(svg_renderer,
+                                                        renb_,
+                                                        params.sprite_marker,
+                                                        params.sprite_style,
+                                                        src->bounding_box(),
+                                                        attrs,
+                                                        marker_tr,
+                                                        params.opacity,
+                                                        gamma_,
+                                                        gamma_method_,
+                                                        params.snap_to_pixels))
+        {
+            return;
+        }
         render_vector_marker(svg_renderer,
                              ras_,
                              renb_,
@@ -97,11 +114,26 @@ struct agg_markers_renderer_context : markers_renderer_context
         render_raster_marker(renb_, ras_, src, marker_tr, params.opacity, params.scale_factor, params.snap_to_pixels);
     }
 
+    virtual void render_markers(image_rgba8 const& src,
+                                markers_dispatch_params const& params,
+                                std::vector<agg::trans_affine> const& marker_trs)
+    {
+        render_raster_markers(renb_,
+                              ras_,
+                              src,
+                              marker_trs,
+                              params.opacity,
+                              params.scale_factor,
+                              params.snap_to_pixels);
+    }
+
   private:
     BufferType& buf_;
     pixfmt_type pixf_;
     renderer_base renb_;
     RasterizerType& ras_;
+    double gamma_;
+    gamma_method_enum gamma_method_;
 };
 
 } // namespace detail
@@ -38,22 +38,47 @@ void agg_renderer<T0, T1>::process(text_symbolizer const& sym,
                                    proj_transform const& prj_trans)
 {
     const box2d<double> clip_box = clipping_extent(common_);
+    const auto priority = get_optional<value_double>(sym, keys::priority, feature, common_.vars_);
+    if (priority && label_queue_.active())
+    {
+        // placed together with the other prioritized labels, see label_placement_queue
+        label_queue_.push(*priority, sym, feature, prj_trans, clip_box);
+        return;
+    }
+    render_label(sym, feature, prj_trans, clip_box);
+}
+
+template<typename T0, typename T1>
+void agg_renderer<T0, T1>::render_label(text_symbolizer const& sym,
+                                        mapnik::feature_impl& feature,
+                                        proj_transform const& prj_trans,
+                                        box2d<double> const& clip_box)
+{
     agg::trans_affine tr;
     const auto transform = get_optional<transform_type>(sym, keys::geometry_transform);
     if (transform)
         evaluate_transform(tr, feature, common_.vars_, *transform, common_.scale_factor_);
-    const text_symbolizer_helper helper(sym,
-                                        feature,
-                                        common_.vars_,
-                                        prj_trans,
-                                        common_.width_,
-                                        common_.height_,
-                                        common_.scale_factor_,
-                                        common_.t_,
-                                        common_.font_manager_,
-                                        *common_.detector_,
-                                        clip_box,
-                                        tr);
+    text_symbolizer_helper helper(sym,
+                                  feature,
+                                  common_.vars_,
+                                  prj_trans,
+                                  common_.width_,
+                                  common_.height_,
+                                  common_.scale_factor_,
+                                  common_.t_,
+                                  common_.font_manager_,
+                                  *common_.detector_,
+                                  clip_box,
+                                  tr);
+    helper.set_vertex_cache_store(common_.vertex_caches_.get());
+    render_label(sym, feature, helper);
+}
+
+template<typename T0, typename T1>
+void agg_renderer<T0, T1>::render_label(text_symbolizer const& sym,
+                                        mapnik::feature_impl& feature,
+                                        text_symbolizer_helper const& helper)
+{
 
     const halo_rasterizer_enum halo_rasterizer = get<halo_rasterizer_enum>(sym,
                                                                            keys::halo_rasterizer,
@@ -86,5 +111,12 @@ void agg_renderer<T0, T1>::process(text_symbolizer const& sym,
 }
 
 template void agg_renderer<image_rgba8>::process(text_symbolizer const&, mapnik::feature_impl&, proj_transform const&);
+template void agg_renderer<image_rgba8>::render_label(text_symbolizer const&,
+                                                      mapnik::feature_impl&,
+                                                      proj_transform const&,
+                                                      box2d<double> const&);
+template void agg_renderer<image_rgba8>::render_label(text_symbolizer const&,
+                                                      mapnik::feature_impl&,
+                                                      text_symbolizer_helper const&);
 
 } // namespace mapnik
@@ -177,6 +177,7 @@ source = Split(
     datasource_cache.cpp
     datasource_cache_static.cpp
     debug.cpp
+    dot_rasterizer.cpp
     geometry/box2d.cpp
     geometry/closest_point.cpp
     geometry/reprojection.cpp
@@ -205,11 +206,13 @@ source = Split(
     image_view_any.cpp
     image_any.cpp
     image_options.cpp
+    image_row_writer.cpp
     image_util.cpp
     image_util_jpeg.cpp
     image_util_png.cpp
     image_util_tiff.cpp
     image_util_webp.cpp
+    image_workers.cpp
     layer.cpp
     map.cpp
     load_map.cpp
@@ -225,6 +228,7 @@ source = Split(
     proj_transform_cache.cpp
     scale_denominator.cpp
     simplify.cpp
+    solid_image_cache.cpp
     parse_transform.cpp
     memory_datasource.cpp
     symbolizer.cpp
@@ -234,23 +238,25 @@ source = Split(
     raster_colorizer.cpp
     mapped_memory_cache.cpp
     marker_cache.cpp
+    marker_sprite_cache.cpp
     css/css_color_grammar_x3.cpp
     css/css_grammar_x3.cpp
     svg/svg_parser.cpp
+    svg/svg_icon_pack.cpp
     svg/svg_path_parser.cpp
-    svg/svg_points_parser.cpp
     svg/svg_transform_parser.cpp
-    svg/svg_path_grammar_x3.cpp
     warp.cpp
     vertex_cache.cpp
     vertex_adapters.cpp
     text/font_library.cpp
     text/text_layout.cpp
+    text/text_layout_pool.cpp
     text/text_line.cpp
     text/itemizer.cpp
     text/scrptrun.cpp
     text/face.cpp
     text/glyph_positions.cpp
+    text/glyph_sdf_atlas.cpp
     text/placement_finder.cpp
     text/properties_util.cpp
     text/renderer.cpp
@@ -276,9 +282,11 @@ source = Split(
     config_error.cpp
     color_factory.cpp
     renderer_common.cpp
+    renderer_common/label_placement_queue.cpp
     renderer_common/render_group_symbolizer.cpp
     renderer_common/render_markers_symbolizer.cpp
     renderer_common/render_pattern.cpp
+    renderer_common/render_thunk_cache.cpp
     renderer_common/render_thunk_extractor.cpp
     renderer_common/pattern_alignment.cpp
     util/math.cpp
@@ -174,9 +174,31 @@ void cairo_renderer<T>::start_map_processing(Map const& map)
 template<typename T>
 void cairo_renderer<T>::end_map_processing(Map const&)
 {
+    render_queued_labels();
     MAPNIK_LOG_DEBUG(cairo_renderer) << "cairo_renderer: End map processing";
 }
 
+template<typename T>
+void cairo_renderer<T>::render_queued_labels()
+{
+    label_queue_.flush([this](label_placement_candidate const& candidate) {
+        if (candidate.shield)
+        {
+            render_label(static_cast<shield_symbolizer const&>(*candidate.sym),
+                         *candidate.feature,
+                         *candidate.prj_trans,
+                         candidate.clip_box);
+        }
+        else
+        {
+            render_label(static_cast<text_symbolizer const&>(*candidate.sym),
+                         *candidate.feature,
+                         *candidate.prj_trans,
+                         candidate.clip_box);
+        }
+    });
+}
+
 template<typename T>
 void cairo_renderer<T>::start_layer_processing(layer const& lay, box2d<double> const& query_extent)
 {
@@ -184,6 +206,10 @@ void cairo_renderer<T>::start_layer_processing(layer const& lay, box2d<double> c
     MAPNIK_LOG_DEBUG(cairo_renderer) << "cairo_renderer: -- datasource=" << lay.datasource().get();
     MAPNIK_LOG_DEBUG(cairo_renderer) << "cairo_renderer: -- query_extent=" << query_extent;
 
+    if (label_queue_.start_layer(m_, lay))
+    {
+        render_queued_labels();
+    }
     if (lay.clear_label_cache())
     {
         common_.detector_->clear();
@@ -215,6 +241,8 @@ void cairo_renderer<T>::start_style_processing(feature_type_style const& st)
 {
     MAPNIK_LOG_DEBUG(cairo_renderer) << "cairo_renderer:start style processing";
 
+    label_queue_.start_style(st);
+
     style_level_compositing_ = st.comp_op() || st.get_opacity() < 1;
 
     if (style_level_compositing_)
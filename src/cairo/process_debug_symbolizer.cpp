@@ -111,9 +111,10 @@ void cairo_renderer<T>::process(debug_symbolizer const& sym,
 
     if (mode == debug_symbolizer_mode_enum::DEBUG_SYM_MODE_COLLISION)
     {
-        for (auto& n : *common_.detector_)
+        label_collision_detector4 const& detector = *common_.detector_;
+        for (std::size_t i = 0; i < detector.size(); ++i)
         {
-            render_debug_box(context_, n.get().box);
+            render_debug_box(context_, detector.box(i));
         }
     }
     else if (mode == debug_symbolizer_mode_enum::DEBUG_SYM_MODE_VERTEX)
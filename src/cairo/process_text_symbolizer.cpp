@@ -38,6 +38,22 @@ template<typename T>
 void cairo_renderer<T>::process(shield_symbolizer const& sym,
                                 mapnik::feature_impl& feature,
                                 proj_transform const& prj_trans)
+{
+    const auto priority = get_optional<value_double>(sym, keys::priority, feature, common_.vars_);
+    if (priority && label_queue_.active())
+    {
+        // placed together with the other prioritized labels, see label_placement_queue
+        label_queue_.push(*priority, sym, feature, prj_trans, common_.query_extent_);
+        return;
+    }
+    render_label(sym, feature, prj_trans, common_.query_extent_);
+}
+
+template<typename T>
+void cairo_renderer<T>::render_label(shield_symbolizer const& sym,
+                                     mapnik::feature_impl& feature,
+                                     proj_transform const& prj_trans,
+                                     box2d<double> const& clip_box)
 {
     agg::trans_affine tr;
     auto transform = get_optional<transform_type>(sym, keys::geometry_transform);
@@ -53,8 +69,9 @@ void cairo_renderer<T>::process(shield_symbolizer const& sym,
                                   common_.t_,
                                   common_.font_manager_,
                                   *common_.detector_,
-                                  common_.query_extent_,
+                                  clip_box,
                                   tr);
+    helper.set_vertex_cache_store(common_.vertex_caches_.get());
 
     cairo_save_restore guard(context_);
     composite_mode_e comp_op = get<composite_mode_e>(sym, keys::comp_op, feature, common_.vars_, src_over);
@@ -76,11 +93,31 @@ void cairo_renderer<T>::process(shield_symbolizer const& sym,
 
 template void
   cairo_renderer<cairo_ptr>::process(shield_symbolizer const&, mapnik::feature_impl&, proj_transform const&);
+template void cairo_renderer<cairo_ptr>::render_label(shield_symbolizer const&,
+                                                     mapnik::feature_impl&,
+                                                     proj_transform const&,
+                                                     box2d<double> const&);
 
 template<typename T>
 void cairo_renderer<T>::process(text_symbolizer const& sym,
                                 mapnik::feature_impl& feature,
                                 proj_transform const& prj_trans)
+{
+    const auto priority = get_optional<value_double>(sym, keys::priority, feature, common_.vars_);
+    if (priority && label_queue_.active())
+    {
+        // placed together with the other prioritized labels, see label_placement_queue
+        label_queue_.push(*priority, sym, feature, prj_trans, common_.query_extent_);
+        return;
+    }
+    render_label(sym, feature, prj_trans, common_.query_extent_);
+}
+
+template<typename T>
+void cairo_renderer<T>::render_label(text_symbolizer const& sym,
+                                     mapnik::feature_impl& feature,
+                                     proj_transform const& prj_trans,
+                                     box2d<double> const& clip_box)
 {
     agg::trans_affine tr;
     auto transform = get_optional<transform_type>(sym, keys::geometry_transform);
@@ -96,8 +133,9 @@ void cairo_renderer<T>::process(text_symbolizer const& sym,
                                   common_.t_,
                                   common_.font_manager_,
                                   *common_.detector_,
-                                  common_.query_extent_,
+                                  clip_box,
                                   tr);
+    helper.set_vertex_cache_store(common_.vertex_caches_.get());
 
     cairo_save_restore guard(context_);
     composite_mode_e comp_op = get<composite_mode_e>(sym, keys::comp_op, feature, common_.vars_, src_over);
@@ -111,6 +149,10 @@ void cairo_renderer<T>::process(text_symbolizer const& sym,
 }
 
 template void cairo_renderer<cairo_ptr>::process(text_symbolizer const&, mapnik::feature_impl&, proj_transform const&);
+template void cairo_renderer<cairo_ptr>::render_label(text_symbolizer const&,
+                                                     mapnik::feature_impl&,
+                                                     proj_transform const&,
+                                                     box2d<double> const&);
 
 } // namespace mapnik
 
@@ -0,0 +1,259 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/dot_rasterizer.hpp>
+#include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/view_transform.hpp>
+#include <mapnik/vertex.hpp>
+#include <mapnik/vertex_adapters.hpp>
+#include <mapnik/vertex_processor.hpp>
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore_agg.hpp>
+#include "agg_color_rgba.h"
+#include "agg_ellipse.h"
+#include "agg_pixfmt_rgba.h"
+#include "agg_scanline_u.h"
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <algorithm>
+#include <cmath>
+
+namespace mapnik {
+
+namespace {
+
+struct collect_vertices
+{
+    explicit collect_vertices(std::vector<dot_rasterizer::point_type>& points)
+        : points_(points)
+    {}
+
+    template<typename Adapter>
+    void operator()(Adapter const& va)
+    {
+        double x, y;
+        unsigned cmd = SEG_END;
+        va.rewind(0);
+        while ((cmd = va.vertex(&x, &y)) != SEG_END)
+        {
+            if (cmd == SEG_CLOSE)
+                continue;
+            points_.emplace_back(x, y);
+        }
+    }
+
+    std::vector<dot_rasterizer::point_type>& points_;
+};
+
+} // namespace
+
+dot_rasterizer::dot_rasterizer(double rx, double ry)
+    : rx_(rx)
+    , ry_(ry)
+    , stamps_()
+{
+    if (!(rx > 0.0 && ry > 0.0))
+        return;
+    if (rx <= 0.5 && ry <= 0.5)
+    {
+        auto cover = static_cast<std::uint8_t>(std::min(1.0, M_PI * rx * ry) * 255.0 + 0.5);
+        for (auto& s : stamps_)
+        {
+            s = stamp{0, 0, 1, 1, {cover}};
+        }
+        return;
+    }
+
+    // Margin around the dot center wide enough for every subpixel offset.
+    int pad_x = static_cast<int>(std::ceil(rx)) + 1;
+    int pad_y = static_cast<int>(std::ceil(ry)) + 1;
+    int size_x = 2 * pad_x + 1;
+    int size_y = 2 * pad_y + 1;
+    std::vector<std::uint8_t> coverage(size_x * size_y);
+    rasterizer ras;
+    agg::scanline_u8 sl;
+    agg::ellipse el(0, 0, rx, ry);
+    for (int i = 0; i < 16; ++i)
+    {
+        std::fill(coverage.begin(), coverage.end(), 0);
+        el.init(pad_x + (i % 4) * 0.25, pad_y + (i / 4) * 0.25, rx, ry, el.num_steps());
+        ras.reset();
+        ras.clip_box(0, 0, size_x, size_y);
+        ras.add_path(el);
+        int x0 = size_x, y0 = size_y, x1 = 0, y1 = 0;
+        if (ras.rewind_scanlines())
+        {
+            sl.reset(ras.min_x(), ras.max_x());
+            while (ras.sweep_scanline(sl))
+            {
+                int y = sl.y();
+                auto span = sl.begin();
+                for (unsigned n = sl.num_spans(); n > 0; --n, ++span)
+                {
+                    for (int k = 0; k < span->len; ++k)
+                    {
+                        std::uint8_t cover = span->covers[k];
+                        if (cover == 0)
+                            continue;
+                        int x = span->x + k;
+                        coverage[y * size_x + x] = cover;
+                        x0 = std::min(x0, x);
+                        x1 = std::max(x1, x + 1);
+                        y0 = std::min(y0, y);
+                        y1 = std::max(y1, y + 1);
+                    }
+                }
+            }
+        }
+        stamp& s = stamps_[i];
+        if (x0 >= x1)
+        {
+            s = stamp{0, 0, 0, 0, {}};
+            continue;
+        }
+        s.x = x0 - pad_x;
+        s.y = y0 - pad_y;
+        s.width = x1 - x0;
+        s.height = y1 - y0;
+        s.cover.resize(s.width * s.height);
+        for (int y = y0; y < y1; ++y)
+        {
+            std::copy_n(&coverage[y * size_x + x0], s.width, &s.cover[(y - y0) * s.width]);
+        }
+    }
+}
+
+// Calls op(x, y, covers, len) for every row of a stamp clipped to the image.
+template<typename Op>
+void dot_rasterizer::apply(int width, int height, std::vector<point_type> const& points, Op op) const
+{
+    if (!(rx_ > 0.0 && ry_ > 0.0))
+        return;
+    // Single pixel dots go to the pixel of their center, larger ones are
+    // drawn at the nearest quarter pixel.
+    bool single_pixel = rx_ <= 0.5 && ry_ <= 0.5;
+    double round = single_pixel ? 0.0 : 0.5;
+    double margin_x = rx_ + 2.0;
+    double margin_y = ry_ + 2.0;
+    for (auto const& pt : points)
+    {
+        // also drops points that failed to reproject
+        if (!(pt.x > -margin_x && pt.x < width + margin_x && pt.y > -margin_y && pt.y < height + margin_y))
+            continue;
+        int qx = static_cast<int>(std::floor(pt.x * 4.0 + round));
+        int qy = static_cast<int>(std::floor(pt.y * 4.0 + round));
+        int px = qx >> 2;
+        int py = qy >> 2;
+        stamp const& s = stamps_[single_pixel ? 0 : (qy & 3) * 4 + (qx & 3)];
+        int x = px + s.x;
+        int y = py + s.y;
+        int x0 = std::max(x, 0);
+        int x1 = std::min(x + s.width, width);
+        int y0 = std::max(y, 0);
+        int y1 = std::min(y + s.height, height);
+        for (int row = y0; row < y1; ++row)
+        {
+            op(x0, row, &s.cover[(row - y) * s.width + (x0 - x)], x1 - x0);
+        }
+    }
+}
+
+void dot_rasterizer::blend(image_rgba8& image,
+                           color const& fill,
+                           double opacity,
+                           composite_mode_e comp_op,
+                           std::vector<point_type> const& points) const
+{
+    using blender_type = agg::comp_op_adaptor_rgba_pre<agg::rgba8, agg::order_rgba>;
+    agg::rgba8 c = agg::rgba8_pre(fill.red(), fill.green(), fill.blue(), int(fill.alpha() * opacity));
+    auto op = static_cast<unsigned>(comp_op);
+    int width = static_cast<int>(image.width());
+    int height = static_cast<int>(image.height());
+    if (op == agg::comp_op_src_over)
+    {
+        if (c.a == 0)
+            return;
+        apply(width, height, points, [&](int x, int y, std::uint8_t const* covers, int len) {
+            std::uint8_t* p = reinterpret_cast<std::uint8_t*>(image.get_row(y, x));
+            for (int i = 0; i < len; ++i, p += 4)
+            {
+                unsigned cover = covers[i];
+                if (cover == 0)
+                    continue;
+                agg::comp_op_rgba_src_over<agg::rgba8, agg::order_rgba>::blend_pix(p, c.r, c.g, c.b, c.a, cover);
+            }
+        });
+    }
+    else
+    {
+        apply(width, height, points, [&](int x, int y, std::uint8_t const* covers, int len) {
+            std::uint8_t* p = reinterpret_cast<std::uint8_t*>(image.get_row(y, x));
+            for (int i = 0; i < len; ++i, p += 4)
+            {
+                if (covers[i] == 0)
+                    continue;
+                blender_type::blend_pix(op, p, c.r, c.g, c.b, c.a, covers[i]);
+            }
+        });
+    }
+}
+
+void dot_rasterizer::accumulate(image_gray32f& density, std::vector<point_type> const& points, float weight) const
+{
+    float scale = weight / 255.0f;
+    apply(static_cast<int>(density.width()),
+          static_cast<int>(density.height()),
+          points,
+          [&](int x, int y, std::uint8_t const* covers, int len) {
+              float* p = density.get_row(y, x);
+              for (int i = 0; i < len; ++i)
+              {
+                  p[i] += covers[i] * scale;
+              }
+          });
+}
+
+void dot_rasterizer::append_points(geometry::geometry<double> const& geom,
+                                   proj_transform const& prj_trans,
+                                   view_transform const& tr,
+                                   std::vector<point_type>& points)
+{
+    std::size_t start = points.size();
+    collect_vertices collect(points);
+    util::apply_visitor(geometry::vertex_processor<collect_vertices>(collect), geom);
+    std::size_t count = points.size() - start;
+    if (count == 0)
+        return;
+    // points that fail to reproject are set to HUGE_VAL and not drawn
+    prj_trans.backward(&points[start].x, &points[start].y, nullptr, count, 2);
+    for (std::size_t i = start; i < points.size(); ++i)
+    {
+        tr.forward(&points[i].x, &points[i].y);
+    }
+}
+
+} // namespace mapnik
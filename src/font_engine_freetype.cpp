@@ -337,7 +337,7 @@ face_ptr freetype_engine::create_face_impl(std::string const& family_name,
                                  itr->second.first,                                                  // face index
                                  &face);
             if (!error)
-                return std::make_shared<font_face>(face);
+                return std::make_shared<font_face>(face, itr->second.second);
         }
         // we don't add to cache here because the map and its font_cache
         // must be immutable during rendering for predictable thread safety
@@ -361,7 +361,7 @@ face_ptr freetype_engine::create_face_impl(std::string const& family_name,
                                      itr->second.first,                                                  // face index
                                      &face);
                 if (!error)
-                    return std::make_shared<font_face>(face);
+                    return std::make_shared<font_face>(face, itr->second.second);
             }
             found_font_file = true;
         }
@@ -389,7 +389,7 @@ face_ptr freetype_engine::create_face_impl(std::string const& family_name,
                 global_memory_fonts.erase(result.first);
                 return face_ptr();
             }
-            return std::make_shared<font_face>(face);
+            return std::make_shared<font_face>(face, itr->second.second);
         }
     }
     return face_ptr();
@@ -63,6 +63,7 @@ namespace mapnik {
 template<typename T>
 grid_renderer<T>::grid_renderer(Map const& m, T& pixmap, double scale_factor, unsigned offset_x, unsigned offset_y)
     : feature_style_processor<grid_renderer>(m, scale_factor)
+    , m_(m)
     , pixmap_(pixmap)
     , ras_ptr(new grid_rasterizer)
     , common_(m, attributes(), offset_x, offset_y, m.width(), m.height(), scale_factor)
@@ -79,6 +80,7 @@ grid_renderer<T>::grid_renderer(Map const& m,
                                 unsigned offset_x,
                                 unsigned offset_y)
     : feature_style_processor<grid_renderer>(m, scale_factor)
+    , m_(m)
     , pixmap_(pixmap)
     , ras_ptr(new grid_rasterizer)
     , common_(m, req, vars, offset_x, offset_y, req.width(), req.height(), scale_factor)
@@ -108,9 +110,31 @@ void grid_renderer<T>::start_map_processing(Map const& m)
 template<typename T>
 void grid_renderer<T>::end_map_processing(Map const& /*m*/)
 {
+    render_queued_labels();
     MAPNIK_LOG_DEBUG(grid_renderer) << "grid_renderer: End map processing";
 }
 
+template<typename T>
+void grid_renderer<T>::render_queued_labels()
+{
+    label_queue_.flush([this](label_placement_candidate const& candidate) {
+        if (candidate.shield)
+        {
+            render_label(static_cast<shield_symbolizer const&>(*candidate.sym),
+                         *candidate.feature,
+                         *candidate.prj_trans,
+                         candidate.clip_box);
+        }
+        else
+        {
+            render_label(static_cast<text_symbolizer const&>(*candidate.sym),
+                         *candidate.feature,
+                         *candidate.prj_trans,
+                         candidate.clip_box);
+        }
+    });
+}
+
 template<typename T>
 void grid_renderer<T>::start_layer_processing(layer const& lay, box2d<double> const& query_extent)
 {
@@ -118,6 +142,10 @@ void grid_renderer<T>::start_layer_processing(layer const& lay, box2d<double> co
     MAPNIK_LOG_DEBUG(grid_renderer) << "grid_renderer: datasource=" << lay.datasource().get();
     MAPNIK_LOG_DEBUG(grid_renderer) << "grid_renderer: query_extent = " << query_extent;
 
+    if (label_queue_.start_layer(m_, lay))
+    {
+        render_queued_labels();
+    }
     if (lay.clear_label_cache())
     {
         common_.detector_->clear();
@@ -130,6 +158,12 @@ void grid_renderer<T>::start_layer_processing(layer const& lay, box2d<double> co
     }
 }
 
+template<typename T>
+void grid_renderer<T>::start_style_processing(feature_type_style const& st)
+{
+    label_queue_.start_style(st);
+}
+
 template<typename T>
 void grid_renderer<T>::end_layer_processing(layer const&)
 {
@@ -46,6 +46,22 @@ template<typename T>
 void grid_renderer<T>::process(shield_symbolizer const& sym,
                                mapnik::feature_impl& feature,
                                proj_transform const& prj_trans)
+{
+    const auto priority = get_optional<value_double>(sym, keys::priority, feature, common_.vars_);
+    if (priority && label_queue_.active())
+    {
+        // placed together with the other prioritized labels, see label_placement_queue
+        label_queue_.push(*priority, sym, feature, prj_trans, common_.query_extent_);
+        return;
+    }
+    render_label(sym, feature, prj_trans, common_.query_extent_);
+}
+
+template<typename T>
+void grid_renderer<T>::render_label(shield_symbolizer const& sym,
+                                    mapnik::feature_impl& feature,
+                                    proj_transform const& prj_trans,
+                                    box2d<double> const& clip_box)
 {
     agg::trans_affine tr;
     auto transform = get_optional<transform_type>(sym, keys::geometry_transform);
@@ -62,8 +78,9 @@ void grid_renderer<T>::process(shield_symbolizer const& sym,
                                   common_.t_,
                                   common_.font_manager_,
                                   *common_.detector_,
-                                  common_.query_extent_,
+                                  clip_box,
                                   tr);
+    helper.set_vertex_cache_store(common_.vertex_caches_.get());
     bool placement_found = false;
 
     composite_mode_e comp_op = get<composite_mode_e>(sym, keys::comp_op, feature, common_.vars_, src_over);
@@ -91,6 +108,10 @@ void grid_renderer<T>::process(shield_symbolizer const& sym,
 }
 
 template void grid_renderer<grid>::process(shield_symbolizer const&, mapnik::feature_impl&, proj_transform const&);
+template void grid_renderer<grid>::render_label(shield_symbolizer const&,
+                                               mapnik::feature_impl&,
+                                               proj_transform const&,
+                                               box2d<double> const&);
 
 } // namespace mapnik
 
@@ -39,6 +39,22 @@ void grid_renderer<T>::process(text_symbolizer const& sym,
                                proj_transform const& prj_trans)
 {
     box2d<double> clip_box = clipping_extent(common_);
+    const auto priority = get_optional<value_double>(sym, keys::priority, feature, common_.vars_);
+    if (priority && label_queue_.active())
+    {
+        // placed together with the other prioritized labels, see label_placement_queue
+        label_queue_.push(*priority, sym, feature, prj_trans, clip_box);
+        return;
+    }
+    render_label(sym, feature, prj_trans, clip_box);
+}
+
+template<typename T>
+void grid_renderer<T>::render_label(text_symbolizer const& sym,
+                                    mapnik::feature_impl& feature,
+                                    proj_transform const& prj_trans,
+                                    box2d<double> const& clip_box)
+{
     agg::trans_affine tr;
     auto transform = get_optional<transform_type>(sym, keys::geometry_transform);
     if (transform)
@@ -55,6 +71,7 @@ void grid_renderer<T>::process(text_symbolizer const& sym,
                                   *common_.detector_,
                                   clip_box,
                                   tr);
+    helper.set_vertex_cache_store(common_.vertex_caches_.get());
     bool placement_found = false;
 
     composite_mode_e comp_op = get<composite_mode_e>(sym, keys::comp_op, feature, common_.vars_, src_over);
@@ -84,6 +101,10 @@ void grid_renderer<T>::process(text_symbolizer const& sym,
 }
 
 template void grid_renderer<grid>::process(text_symbolizer const&, mapnik::feature_impl&, proj_transform const&);
+template void grid_renderer<grid>::render_label(text_symbolizer const&,
+                                               mapnik::feature_impl&,
+                                               proj_transform const&,
+                                               box2d<double> const&);
 
 } // namespace mapnik
 
@@ -22,6 +22,7 @@
 
 // mapnik
 #include <mapnik/image_compositing.hpp>
+#include <mapnik/agg_blit.hpp>
 #include <mapnik/image.hpp>
 #include <mapnik/image_any.hpp>
 #include <mapnik/safe_cast.hpp>
@@ -122,7 +123,6 @@ MAPNIK_DECL void
 {
     using color = agg::rgba8;
     using order = agg::order_rgba;
-    using const_rendering_buffer = util::rendering_buffer<image_rgba8>;
     using blender_type = agg::comp_op_adaptor_rgba_pre<color, order>;
     using pixfmt_type = agg::pixfmt_custom_blend_rgba<blender_type, agg::rendering_buffer>;
     using renderer_type = agg::renderer_base<pixfmt_type>;
@@ -131,11 +131,8 @@ MAPNIK_DECL void
                                      safe_cast<unsigned>(dst.width()),
                                      safe_cast<unsigned>(dst.height()),
                                      safe_cast<int>(dst.row_size()));
-    const_rendering_buffer src_buffer(src);
     pixfmt_type pixf(dst_buffer);
     pixf.comp_op(static_cast<agg::comp_op_e>(mode));
-    agg::pixfmt_alpha_blend_rgba<agg::blender_rgba32_pre, const_rendering_buffer, agg::pixel32_type> pixf_mask(
-      src_buffer);
 #ifdef MAPNIK_DEBUG
     if (!src.get_premultiplied())
     {
@@ -147,7 +144,7 @@ MAPNIK_DECL void
     }
 #endif
     renderer_type ren(pixf);
-    ren.blend_from(pixf_mask, 0, dx, dy, safe_cast<agg::cover_type>(255 * opacity));
+    blit_rgba8(ren, src, dx, dy, safe_cast<agg::cover_type>(255 * opacity));
 }
 
 template<>
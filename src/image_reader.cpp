@@ -25,8 +25,26 @@
 #include <mapnik/image_util.hpp>
 #include <mapnik/factory.hpp>
 
+// stl
+#include <algorithm>
+#include <atomic>
+
 namespace mapnik {
 
+namespace {
+std::atomic<std::size_t> png_cache_size(64 * 1024 * 1024);
+}
+
+std::size_t png_reader_cache_size()
+{
+    return png_cache_size.load(std::memory_order_relaxed);
+}
+
+void set_png_reader_cache_size(std::size_t bytes)
+{
+    png_cache_size.store(bytes, std::memory_order_relaxed);
+}
+
 inline boost::optional<std::string> type_from_bytes(char const* data, size_t size)
 {
     using result_type = boost::optional<std::string>;
@@ -63,6 +81,54 @@ inline boost::optional<std::string> type_from_bytes(char const* data, size_t siz
     return result_type();
 }
 
+unsigned image_reader::scale_denominator(unsigned, unsigned, unsigned, unsigned) const
+{
+    return 1;
+}
+
+image_any image_reader::read_scaled(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator)
+{
+    if (denominator != 1)
+    {
+        throw image_reader_exception("image_reader: can't decode this format at a reduced size");
+    }
+    return read(x, y, width, height);
+}
+
+box2d<double>
+  image_reader::scaled_window(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator) const
+{
+    unsigned d = std::max(denominator, 1u);
+    return box2d<double>(x, y, x + (width + d - 1) / d * d, y + (height + d - 1) / d * d);
+}
+
+std::vector<image_any> image_reader::read_windows(std::vector<window> const& windows)
+{
+    std::vector<image_any> images;
+    images.reserve(windows.size());
+    for (auto const& w : windows)
+    {
+        images.push_back(read(w.x, w.y, w.width, w.height));
+    }
+    return images;
+}
+
+unsigned image_reader::power_of_two_denominator(unsigned width,
+                                                unsigned height,
+                                                unsigned target_width,
+                                                unsigned target_height)
+{
+    for (unsigned denominator = 8; denominator > 1; denominator >>= 1)
+    {
+        if ((width + denominator - 1) / denominator >= target_width &&
+            (height + denominator - 1) / denominator >= target_height)
+        {
+            return denominator;
+        }
+    }
+    return 1;
+}
+
 image_reader* get_image_reader(char const* data, size_t size)
 {
     boost::optional<std::string> type = type_from_bytes(data, size);
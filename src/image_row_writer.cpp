@@ -0,0 +1,102 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+// mapnik
+#include <mapnik/image_row_writer.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/image_util_jpeg.hpp>
+#include <mapnik/image_util_png.hpp>
+#include <mapnik/image_util_tiff.hpp>
+
+// stl
+#include <algorithm>
+#include <ostream>
+
+namespace mapnik {
+
+image_row_writer::image_row_writer(unsigned width, unsigned height)
+    : width_(width)
+    , height_(height)
+    , rows_written_(0)
+    , finished_(false)
+{}
+
+image_row_writer::~image_row_writer() {}
+
+void image_row_writer::write(image_view_rgba8 const& rows)
+{
+    if (finished_)
+    {
+        throw image_writer_exception("can not write rows to a finished image");
+    }
+    if (rows.width() != width_ || rows.height() > height_ - rows_written_)
+    {
+        throw image_writer_exception("rows do not fit in the image being written");
+    }
+    if (rows.height() == 0)
+        return;
+    write_rows(rows);
+    rows_written_ += rows.height();
+}
+
+void image_row_writer::finish()
+{
+    if (finished_)
+        return;
+    if (rows_written_ != height_)
+    {
+        throw image_writer_exception("can not finish an image before all of its rows are written");
+    }
+    finish_image();
+    finished_ = true;
+}
+
+std::unique_ptr<image_row_writer>
+  create_image_row_writer(std::ostream& stream, std::string const& type, unsigned width, unsigned height)
+{
+    if (!stream || width == 0 || height == 0)
+    {
+        throw image_writer_exception("Could not write to empty stream");
+    }
+    std::string t = type;
+    std::transform(t.begin(), t.end(), t.begin(), ::tolower);
+    if (boost::algorithm::starts_with(t, "png"))
+    {
+        return detail::create_png_row_writer(stream, t, width, height);
+    }
+    else if (boost::algorithm::starts_with(t, "tif"))
+    {
+        return detail::create_tiff_row_writer(stream, t, width, height);
+    }
+    else if (boost::algorithm::starts_with(t, "jpeg"))
+    {
+        return detail::create_jpeg_row_writer(stream, t, width, height);
+    }
+    else if (boost::algorithm::starts_with(t, "webp"))
+    {
+        throw image_writer_exception("webp images can not be written row by row");
+    }
+    throw image_writer_exception("unknown file type: " + type);
+}
+
+} // namespace mapnik
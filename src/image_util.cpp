@@ -36,6 +36,8 @@
 #include <mapnik/util/variant.hpp>
 #include <mapnik/debug.hpp>
 #include <mapnik/safe_cast.hpp>
+#include <mapnik/solid_image_cache.hpp>
+#include <mapnik/image_workers.hpp>
 #ifdef SSE_MATH
 #include <mapnik/sse.hpp>
 #endif
@@ -53,6 +55,13 @@ MAPNIK_DISABLE_WARNING_POP
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <vector>
+#ifdef MAPNIK_THREADSAFE
+#include <thread>
+#endif
 
 #if __cpp_lib_execution >= 201603
 #include <execution>
@@ -195,6 +204,125 @@ MAPNIK_DECL void save_to_stream<image_view_rgba8>(image_view_rgba8 const& image,
         throw image_writer_exception("Could not write to empty stream");
 }
 
+namespace detail {
+
+template<typename Saver, typename T>
+void apply_saver(Saver& saver, T const& image)
+{
+    saver(image);
+}
+
+template<typename Saver>
+void apply_saver(Saver& saver, image_any const& image)
+{
+    util::apply_visitor(saver, image);
+}
+
+template<typename Saver>
+void apply_saver(Saver& saver, image_view_any const& image)
+{
+    util::apply_visitor(saver, image);
+}
+
+// t is the lower case type
+template<typename T>
+void encode_to_stream(T const& image, std::ostream& stream, std::string const& t, std::string const& type)
+{
+    if (boost::algorithm::starts_with(t, "png"))
+    {
+        png_saver visitor(stream, t);
+        apply_saver(visitor, image);
+    }
+    else if (boost::algorithm::starts_with(t, "tif"))
+    {
+        tiff_saver visitor(stream, t);
+        apply_saver(visitor, image);
+    }
+    else if (boost::algorithm::starts_with(t, "jpeg"))
+    {
+        jpeg_saver visitor(stream, t);
+        apply_saver(visitor, image);
+    }
+    else if (boost::algorithm::starts_with(t, "webp"))
+    {
+        webp_saver visitor(stream, t);
+        apply_saver(visitor, image);
+    }
+    else
+        throw image_writer_exception("unknown file type: " + type);
+}
+
+// The color of an rgba8 image of a single color.
+template<typename T>
+bool solid_rgba8(T const&, std::uint32_t&)
+{
+    return false;
+}
+
+bool solid_rgba8(image_rgba8 const& image, std::uint32_t& color)
+{
+    if (!is_solid(image))
+        return false;
+    color = image(0, 0);
+    return true;
+}
+
+bool solid_rgba8(image_view_rgba8 const& image, std::uint32_t& color)
+{
+    if (!is_solid(image))
+        return false;
+    color = image(0, 0);
+    return true;
+}
+
+bool solid_rgba8(image_any const& image, std::uint32_t& color)
+{
+    return image.is<image_rgba8>() && solid_rgba8(image.get<image_rgba8>(), color);
+}
+
+bool solid_rgba8(image_view_any const& image, std::uint32_t& color)
+{
+    return image.is<image_view_rgba8>() && solid_rgba8(image.get<image_view_rgba8>(), color);
+}
+
+// Writes solid rgba8 images from the solid_image_cache, encoding them once.
+// solid and color are what solid_rgba8 returned for the image, solid is false
+// when the cache is disabled.
+template<typename T>
+void encode_or_reuse(T const& image,
+                     std::ostream& stream,
+                     std::string const& t,
+                     std::string const& type,
+                     bool solid,
+                     std::uint32_t color)
+{
+    if (!solid)
+    {
+        encode_to_stream(image, stream, t, type);
+        return;
+    }
+    solid_image_cache& cache = solid_image_cache::instance();
+    solid_image_cache::key k{color, image.get_premultiplied(), image.width(), image.height(), t};
+    std::shared_ptr<std::string const> encoded = cache.find(k);
+    if (!encoded)
+    {
+        std::ostringstream ss(std::ios::out | std::ios::binary);
+        encode_to_stream(image, ss, t, type);
+        encoded = cache.insert(k, ss.str());
+    }
+    stream.write(encoded->data(), static_cast<std::streamsize>(encoded->size()));
+}
+
+template<typename T>
+void encode_or_reuse(T const& image, std::ostream& stream, std::string const& t, std::string const& type)
+{
+    std::uint32_t color = 0;
+    bool solid = solid_image_cache::instance().capacity() > 0 && solid_rgba8(image, color);
+    encode_or_reuse(image, stream, t, type, solid, color);
+}
+
+} // namespace detail
+
 template<typename T>
 MAPNIK_DECL void save_to_stream(T const& image, std::ostream& stream, std::string const& type)
 {
@@ -202,28 +330,7 @@ MAPNIK_DECL void save_to_stream(T const& image, std::ostream& stream, std::strin
     {
         std::string t = type;
         std::transform(t.begin(), t.end(), t.begin(), ::tolower);
-        if (boost::algorithm::starts_with(t, "png"))
-        {
-            png_saver visitor(stream, t);
-            util::apply_visitor(visitor, image);
-        }
-        else if (boost::algorithm::starts_with(t, "tif"))
-        {
-            tiff_saver visitor(stream, t);
-            util::apply_visitor(visitor, image);
-        }
-        else if (boost::algorithm::starts_with(t, "jpeg"))
-        {
-            jpeg_saver visitor(stream, t);
-            util::apply_visitor(visitor, image);
-        }
-        else if (boost::algorithm::starts_with(t, "webp"))
-        {
-            webp_saver visitor(stream, t);
-            util::apply_visitor(visitor, image);
-        }
-        else
-            throw image_writer_exception("unknown file type: " + type);
+        detail::encode_or_reuse(image, stream, t, type);
     }
     else
         throw image_writer_exception("Could not write to empty stream");
@@ -238,32 +345,7 @@ MAPNIK_DECL void save_to_stream<image_rgba8>(image_rgba8 const& image, std::ostr
     {
         std::string t = type;
         std::transform(t.begin(), t.end(), t.begin(), ::tolower);
-        if (boost::algorithm::starts_with(t, "png"))
-        {
-            png_saver visitor(stream, t);
-            visitor(image);
-            // util::apply_visitor(visitor, image);
-        }
-        else if (boost::algorithm::starts_with(t, "tif"))
-        {
-            tiff_saver visitor(stream, t);
-            visitor(image);
-            // util::apply_visitor(visitor, image);
-        }
-        else if (boost::algorithm::starts_with(t, "jpeg"))
-        {
-            jpeg_saver visitor(stream, t);
-            visitor(image);
-            // util::apply_visitor(visitor, image);
-        }
-        else if (boost::algorithm::starts_with(t, "webp"))
-        {
-            webp_saver visitor(stream, t);
-            visitor(image);
-            // util::apply_visitor(visitor, image);
-        }
-        else
-            throw image_writer_exception("unknown file type: " + type);
+        detail::encode_or_reuse(image, stream, t, type);
     }
     else
         throw image_writer_exception("Could not write to empty stream");
@@ -279,35 +361,79 @@ MAPNIK_DECL void
     {
         std::string t = type;
         std::transform(t.begin(), t.end(), t.begin(), ::tolower);
-        if (boost::algorithm::starts_with(t, "png"))
-        {
-            png_saver visitor(stream, t);
-            visitor(image);
-            // util::apply_visitor(visitor, image);
-        }
-        else if (boost::algorithm::starts_with(t, "tif"))
+        detail::encode_or_reuse(image, stream, t, type);
+    }
+    else
+        throw image_writer_exception("Could not write to empty stream");
+}
+
+template<typename T>
+MAPNIK_DECL std::vector<std::string> save_to_strings(T const& image, std::vector<std::string> const& types, int threads)
+{
+    if (image.width() == 0 || image.height() == 0)
+        throw image_writer_exception("Could not write to empty stream");
+    // each type is encoded once, however often it is listed
+    std::vector<std::string> lower;
+    std::vector<std::string const*> names;
+    std::vector<std::size_t> index(types.size());
+    for (std::size_t i = 0; i < types.size(); ++i)
+    {
+        std::string t = types[i];
+        std::transform(t.begin(), t.end(), t.begin(), ::tolower);
+        index[i] = std::find(lower.begin(), lower.end(), t) - lower.begin();
+        if (index[i] == lower.size())
         {
-            tiff_saver visitor(stream, t);
-            visitor(image);
-            // util::apply_visitor(visitor, image);
+            lower.push_back(std::move(t));
+            names.push_back(&types[i]);
         }
-        else if (boost::algorithm::starts_with(t, "jpeg"))
+    }
+    // scanned once for all the encoders
+    std::uint32_t color = 0;
+    bool solid = solid_image_cache::instance().capacity() > 0 && detail::solid_rgba8(image, color);
+
+    std::vector<std::string> encoded(lower.size());
+    std::atomic<std::size_t> next(0);
+    auto work = [&](std::exception_ptr& error) {
+        try
         {
-            jpeg_saver visitor(stream, t);
-            visitor(image);
-            // util::apply_visitor(visitor, image);
+            std::size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) < lower.size())
+            {
+                std::ostringstream ss(std::ios::out | std::ios::binary);
+                detail::encode_or_reuse(image, ss, lower[i], *names[i], solid, color);
+                encoded[i] = ss.str();
+            }
         }
-        else if (boost::algorithm::starts_with(t, "webp"))
+        catch (...)
         {
-            webp_saver visitor(stream, t);
-            visitor(image);
-            // util::apply_visitor(visitor, image);
+            error = std::current_exception();
+            next.store(lower.size(), std::memory_order_relaxed);
         }
-        else
-            throw image_writer_exception("unknown file type: " + type);
+    };
+    unsigned num_threads = threads > 0 ? static_cast<unsigned>(threads) : 1;
+#ifdef MAPNIK_THREADSAFE
+    if (threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+#endif
+    std::size_t num_workers = std::max<std::size_t>(std::min<std::size_t>(num_threads, lower.size()), 1) - 1;
+    std::vector<std::exception_ptr> errors(num_workers + 1);
+    std::atomic<std::size_t> slot(0);
+    detail::run_image_workers(num_workers, [&] { work(errors[slot.fetch_add(1, std::memory_order_relaxed)]); });
+    for (auto const& error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
     }
-    else
-        throw image_writer_exception("Could not write to empty stream");
+
+    if (lower.size() == types.size())
+        return encoded;
+    std::vector<std::string> result;
+    result.reserve(types.size());
+    for (std::size_t i : index)
+    {
+        result.push_back(encoded[i]);
+    }
+    return result;
 }
 
 template<typename T>
@@ -350,6 +476,9 @@ template MAPNIK_DECL std::string save_to_string<image_rgba8>(image_rgba8 const&,
 template MAPNIK_DECL std::string
   save_to_string<image_rgba8>(image_rgba8 const&, std::string const&, rgba_palette const& palette);
 
+template MAPNIK_DECL std::vector<std::string>
+  save_to_strings<image_rgba8>(image_rgba8 const&, std::vector<std::string> const&, int);
+
 // image_view_any
 template MAPNIK_DECL void save_to_file<image_view_any>(image_view_any const&, std::string const&, std::string const&);
 
@@ -368,11 +497,17 @@ template MAPNIK_DECL std::string save_to_string<image_view_rgba8>(image_view_rgb
 template MAPNIK_DECL std::string
   save_to_string<image_view_rgba8>(image_view_rgba8 const&, std::string const&, rgba_palette const& palette);
 
+template MAPNIK_DECL std::vector<std::string>
+  save_to_strings<image_view_rgba8>(image_view_rgba8 const&, std::vector<std::string> const&, int);
+
 template MAPNIK_DECL std::string save_to_string<image_view_any>(image_view_any const&, std::string const&);
 
 template MAPNIK_DECL std::string
   save_to_string<image_view_any>(image_view_any const&, std::string const&, rgba_palette const& palette);
 
+template MAPNIK_DECL std::vector<std::string>
+  save_to_strings<image_view_any>(image_view_any const&, std::vector<std::string> const&, int);
+
 // image_any
 template MAPNIK_DECL void save_to_file<image_any>(image_any const&, std::string const&, std::string const&);
 
@@ -388,6 +523,9 @@ template MAPNIK_DECL std::string save_to_string<image_any>(image_any const&, std
 template MAPNIK_DECL std::string
   save_to_string<image_any>(image_any const&, std::string const&, rgba_palette const& palette);
 
+template MAPNIK_DECL std::vector<std::string>
+  save_to_strings<image_any>(image_any const&, std::vector<std::string> const&, int);
+
 namespace detail {
 
 struct is_solid_visitor
@@ -27,13 +27,16 @@
 
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_util_jpeg.hpp>
+#include <mapnik/image_row_writer.hpp>
 #include <mapnik/image.hpp>
 #include <mapnik/image_view.hpp>
 #include <mapnik/image_options.hpp>
 #include <mapnik/util/conversions.hpp>
 
 // stl
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace mapnik {
 
@@ -44,9 +47,9 @@ jpeg_saver::jpeg_saver(std::ostream& stream, std::string const& t)
 
 namespace detail {
 
-int parse_jpeg_quality(std::string const& params)
+jpeg_options parse_jpeg_options(std::string const& params)
 {
-    int quality = 85;
+    jpeg_options opts;
     if (params != "jpeg")
     {
         for (auto const& kv : parse_image_options(params))
@@ -58,7 +61,7 @@ int parse_jpeg_quality(std::string const& params)
                 continue;
             else if (key.size() > 4 && key.substr(0, 4) == "jpeg")
             {
-                if (!mapnik::util::string2int(key.substr(4), quality))
+                if (!mapnik::util::string2int(key.substr(4), opts.quality))
                 {
                     throw image_writer_exception("invalid jpeg quality: '" + key.substr(4) + "'");
                 }
@@ -67,15 +70,87 @@ int parse_jpeg_quality(std::string const& params)
             {
                 if (val && !(*val).empty())
                 {
-                    if (!mapnik::util::string2int(*val, quality) || quality < 0 || quality > 100)
+                    if (!mapnik::util::string2int(*val, opts.quality) || opts.quality < 0 || opts.quality > 100)
                     {
                         throw image_writer_exception("invalid jpeg quality: '" + *val + "'");
                     }
                 }
             }
+            else if (key == "optimize" || key == "progressive")
+            {
+                bool& flag = key == "optimize" ? opts.optimize : opts.progressive;
+                flag = true;
+                if (val && !(*val).empty() && !mapnik::util::string2bool(*val, flag))
+                {
+                    throw image_writer_exception("invalid jpeg " + key + ": '" + *val + "'");
+                }
+            }
+        }
+    }
+    return opts;
+}
+
+int parse_jpeg_quality(std::string const& params)
+{
+    return parse_jpeg_options(params).quality;
+}
+
+#if defined(HAVE_JPEG)
+
+namespace {
+
+// Compresses rows as they come, as save_as_jpeg does.
+class jpeg_row_writer : public image_row_writer
+{
+  public:
+    jpeg_row_writer(std::ostream& stream, jpeg_options const& opts, unsigned width, unsigned height)
+        : image_row_writer(width, height)
+        , rgb_()
+    {
+        cinfo_.err = jpeg_std_error(&jerr_);
+        jerr_.error_exit = jpeg_detail::on_error;
+        jpeg_create_compress(&cinfo_);
+        try
+        {
+            jpeg_detail::set_stream_dest(&cinfo_, &stream);
+            cinfo_.image_width = width;
+            cinfo_.image_height = height;
+            jpeg_detail::set_rgba8_input(&cinfo_);
+            jpeg_detail::set_options(&cinfo_, opts);
+            jpeg_start_compress(&cinfo_, boolean(1));
+        }
+        catch (...)
+        {
+            jpeg_destroy_compress(&cinfo_);
+            throw;
         }
     }
-    return quality;
+
+    ~jpeg_row_writer() { jpeg_destroy_compress(&cinfo_); }
+
+  protected:
+    void write_rows(image_view_rgba8 const& rows) override { jpeg_detail::write_rgba8_rows(&cinfo_, rows, rgb_); }
+
+    void finish_image() override { jpeg_finish_compress(&cinfo_); }
+
+  private:
+    struct jpeg_compress_struct cinfo_;
+    struct jpeg_error_mgr jerr_;
+    std::vector<JSAMPLE> rgb_;
+};
+
+} // namespace
+
+#endif
+
+std::unique_ptr<image_row_writer>
+  create_jpeg_row_writer(std::ostream& stream, std::string const& t, unsigned width, unsigned height)
+{
+#if defined(HAVE_JPEG)
+    return std::make_unique<jpeg_row_writer>(stream, parse_jpeg_options(t), width, height);
+#else
+    throw image_writer_exception("jpeg output is not enabled in your build of Mapnik");
+#endif
 }
 
 } // namespace detail
@@ -84,8 +159,7 @@ template<typename T>
 void process_rgba8_jpeg(T const& image, std::string const& type, std::ostream& stream)
 {
 #if defined(HAVE_JPEG)
-    int quality = detail::parse_jpeg_quality(type);
-    save_as_jpeg(stream, quality, image);
+    save_as_jpeg(stream, detail::parse_jpeg_options(type), image);
 #else
     throw image_writer_exception("jpeg output is not enabled in your build of Mapnik");
 #endif
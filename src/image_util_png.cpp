@@ -36,6 +36,7 @@ extern "C" {
 
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_util_png.hpp>
+#include <mapnik/image_row_writer.hpp>
 #include <mapnik/image.hpp>
 #include <mapnik/image_any.hpp>
 #include <mapnik/image_view.hpp>
@@ -43,6 +44,7 @@ extern "C" {
 #include <mapnik/util/conversions.hpp>
 
 // stl
+#include <memory>
 #include <string>
 #include <iostream>
 
@@ -104,6 +106,14 @@ void handle_png_options(std::string const& type, png_options& opts)
                 throw image_writer_exception("invalid trans_mode parameter: " + to_string(val));
             }
         }
+        else if (key == "j")
+        {
+            // "t" is the transparency mode
+            if (!val || !mapnik::util::string2int(*val, opts.threads) || opts.threads < 0)
+            {
+                throw image_writer_exception("invalid threads parameter: " + to_string(val));
+            }
+        }
         else if (key == "g")
         {
             set_gamma = true;
@@ -195,6 +205,7 @@ void handle_png_options(std::string const& type, png_options& opts)
         throw image_writer_exception("invalid compression value: (only -1 through 9 are valid)");
     }
 }
+
 #endif
 
 png_saver::png_saver(std::ostream& stream, std::string const& t)
@@ -379,4 +390,139 @@ template void png_saver_pal::operator()<image_view_gray64>(image_view_gray64 con
 template void png_saver_pal::operator()<image_view_gray64s>(image_view_gray64s const& image) const;
 template void png_saver_pal::operator()<image_view_gray64f>(image_view_gray64f const& image) const;
 
+namespace detail {
+
+#if defined(HAVE_PNG)
+
+namespace {
+
+void png_row_writer_error(png_structp /*png_ptr*/, png_const_charp error_msg)
+{
+    throw image_writer_exception(std::string("failed to write png: '") + error_msg + "'");
+}
+
+void png_row_writer_warning(png_structp /*png_ptr*/, png_const_charp /*warning_msg*/) {}
+
+// Rows go to libpng as they come, which filters and compresses them with
+// the options of save_as_png. Bands are not compressed on several threads.
+class png_row_writer : public image_row_writer
+{
+  public:
+    png_row_writer(std::ostream& stream, png_options const& opts, unsigned width, unsigned height)
+        : image_row_writer(width, height)
+        , png_ptr_(
+            png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, png_row_writer_error, png_row_writer_warning))
+        , info_ptr_(nullptr)
+    {
+        if (!png_ptr_)
+        {
+            throw image_writer_exception("failed to create png write struct");
+        }
+        try
+        {
+            info_ptr_ = png_create_info_struct(png_ptr_);
+            if (!info_ptr_)
+            {
+                throw image_writer_exception("failed to create png info struct");
+            }
+            png_set_write_fn(png_ptr_, &stream, &write_data<std::ostream>, &flush_data<std::ostream>);
+            png_set_filter(png_ptr_, PNG_FILTER_TYPE_BASE, opts.filters);
+            png_set_compression_level(png_ptr_, opts.compression);
+            png_set_compression_strategy(png_ptr_, opts.strategy);
+            png_set_compression_buffer_size(png_ptr_, 32768);
+            png_set_IHDR(png_ptr_,
+                         info_ptr_,
+                         width,
+                         height,
+                         8,
+                         (opts.trans_mode == 0) ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_RGB_ALPHA,
+                         PNG_INTERLACE_NONE,
+                         PNG_COMPRESSION_TYPE_DEFAULT,
+                         PNG_FILTER_TYPE_DEFAULT);
+            png_write_info(png_ptr_, info_ptr_);
+            if (detail::png_filter_in_mapnik(opts))
+            {
+                // same bytes as save_as_png
+                rgb_ = opts.trans_mode == 0;
+                row_.resize(width * (rgb_ ? 3 : 4));
+                deflater_ = std::make_unique<detail::png_row_deflater>(png_ptr_, row_.size(), rgb_ ? 3 : 4, opts);
+            }
+            else if (opts.trans_mode == 0)
+            {
+                png_set_filler(png_ptr_, 0, PNG_FILLER_AFTER);
+            }
+        }
+        catch (...)
+        {
+            png_destroy_write_struct(&png_ptr_, &info_ptr_);
+            throw;
+        }
+    }
+
+    ~png_row_writer() { png_destroy_write_struct(&png_ptr_, &info_ptr_); }
+
+  protected:
+    void write_rows(image_view_rgba8 const& rows) override
+    {
+        for (std::size_t y = 0; y < rows.height(); ++y)
+        {
+            auto const* row = reinterpret_cast<std::uint8_t const*>(rows.get_row(y));
+            if (!deflater_)
+            {
+                png_write_row(png_ptr_, row);
+            }
+            else if (rgb_)
+            {
+                for (std::size_t x = 0; x < rows.width(); ++x)
+                {
+                    std::copy_n(row + 4 * x, 3, &row_[3 * x]);
+                }
+                deflater_->write(row_.data());
+            }
+            else
+            {
+                deflater_->write(row);
+            }
+        }
+    }
+
+    void finish_image() override
+    {
+        if (deflater_)
+            deflater_->finish();
+        else
+            png_write_end(png_ptr_, info_ptr_);
+    }
+
+  private:
+    png_structp png_ptr_;
+    png_infop info_ptr_;
+    // set when the rows are filtered by mapnik
+    std::unique_ptr<detail::png_row_deflater> deflater_;
+    bool rgb_ = false;
+    std::vector<std::uint8_t> row_;
+};
+
+} // namespace
+
+#endif
+
+std::unique_ptr<image_row_writer>
+  create_png_row_writer(std::ostream& stream, std::string const& t, unsigned width, unsigned height)
+{
+#if defined(HAVE_PNG)
+    png_options opts;
+    handle_png_options(t, opts);
+    if (opts.paletted)
+    {
+        throw image_writer_exception("paletted png images can not be written row by row");
+    }
+    return std::make_unique<png_row_writer>(stream, opts, width, height);
+#else
+    throw image_writer_exception("png output is not enabled in your build of Mapnik");
+#endif
+}
+
+} // namespace detail
+
 } // namespace mapnik
@@ -27,13 +27,17 @@
 
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_util_tiff.hpp>
+#include <mapnik/image_row_writer.hpp>
 #include <mapnik/image.hpp>
 #include <mapnik/image_view.hpp>
 #include <mapnik/image_options.hpp>
 #include <mapnik/util/conversions.hpp>
 
 // stl
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace mapnik {
 
@@ -149,6 +153,171 @@ void handle_tiff_options(std::string const& type, tiff_config& config)
 }
 #endif
 
+namespace detail {
+
+#if defined(HAVE_TIFF)
+
+namespace {
+
+// Writes rows as they come for the scanline method, and a strip or a row of
+// tiles at a time otherwise. Strips and tiles as tall as the image would hold
+// all of it, those default to TIFFDefaultStripSize and 256 rows instead.
+class tiff_row_writer : public image_row_writer
+{
+  public:
+    tiff_row_writer(std::ostream& stream, tiff_config const& config, unsigned width, unsigned height)
+        : image_row_writer(width, height)
+        , output_(RealTIFFOpen("mapnik_tiff_stream",
+                               "wm",
+                               (thandle_t)&stream,
+                               tiff_dummy_read_proc,
+                               tiff_write_proc,
+                               tiff_seek_proc,
+                               tiff_close_proc,
+                               tiff_size_proc,
+                               tiff_dummy_map_proc,
+                               tiff_dummy_unmap_proc))
+        , method_(config.method)
+        , block_rows_(1)
+        , tile_width_(0)
+        , block_y_(0)
+        , filled_(0)
+        , block_()
+        , tile_()
+    {
+        if (!output_)
+        {
+            throw image_writer_exception("Could not write TIFF");
+        }
+        TIFFSetField(output_, TIFFTAG_IMAGEWIDTH, width);
+        TIFFSetField(output_, TIFFTAG_IMAGELENGTH, height);
+        TIFFSetField(output_, TIFFTAG_IMAGEDEPTH, 1);
+        set_tiff_config(output_, config);
+        tag_setter set(output_, config);
+        set(image_rgba8());
+        if (TIFF_WRITE_STRIPPED == method_)
+        {
+            block_rows_ = config.rows_per_strip > 0 ? static_cast<unsigned>(config.rows_per_strip)
+                                                    : TIFFDefaultStripSize(output_, 0);
+            TIFFSetField(output_, TIFFTAG_ROWSPERSTRIP, block_rows_);
+        }
+        else if (TIFF_WRITE_TILED == method_)
+        {
+            tile_width_ = config.tile_width > 0 ? static_cast<unsigned>(config.tile_width) : (width + 15) / 16 * 16;
+            block_rows_ = config.tile_height > 0 ? static_cast<unsigned>(config.tile_height) : 256;
+            TIFFSetField(output_, TIFFTAG_TILEWIDTH, tile_width_);
+            TIFFSetField(output_, TIFFTAG_TILELENGTH, block_rows_);
+            TIFFSetField(output_, TIFFTAG_TILEDEPTH, 1);
+            tile_.resize(static_cast<std::size_t>(tile_width_) * block_rows_);
+        }
+        else
+        {
+            TIFFSetField(output_, TIFFTAG_ROWSPERSTRIP, 1);
+        }
+        block_.resize(static_cast<std::size_t>(width) * block_rows_);
+    }
+
+    ~tiff_row_writer()
+    {
+        if (output_)
+        {
+            RealTIFFClose(output_);
+        }
+    }
+
+  protected:
+    void write_rows(image_view_rgba8 const& rows) override
+    {
+        for (std::size_t y = 0; y < rows.height(); ++y)
+        {
+            std::copy_n(rows.get_row(y), width(), &block_[static_cast<std::size_t>(filled_) * width()]);
+            if (++filled_ == block_rows_)
+            {
+                write_block();
+            }
+        }
+    }
+
+    void finish_image() override
+    {
+        if (filled_ > 0)
+        {
+            write_block();
+        }
+        RealTIFFClose(output_);
+        output_ = nullptr;
+    }
+
+  private:
+    void write_block()
+    {
+        std::size_t const row_size = static_cast<std::size_t>(width()) * sizeof(std::uint32_t);
+        if (TIFF_WRITE_STRIPPED == method_)
+        {
+            if (TIFFWriteEncodedStrip(output_,
+                                      TIFFComputeStrip(output_, block_y_, 0),
+                                      block_.data(),
+                                      filled_ * row_size) == -1)
+            {
+                throw image_writer_exception("Could not write TIFF - TIFF Strip Write failed");
+            }
+        }
+        else if (TIFF_WRITE_TILED == method_)
+        {
+            for (unsigned x = 0; x < width(); x += tile_width_)
+            {
+                unsigned tx1 = std::min(width(), x + tile_width_);
+                std::fill(tile_.begin(), tile_.end(), 0);
+                for (unsigned ty = 0; ty < filled_; ++ty)
+                {
+                    auto const* row = &block_[static_cast<std::size_t>(ty) * width()];
+                    std::copy(row + x, row + tx1, &tile_[static_cast<std::size_t>(ty) * tile_width_]);
+                }
+                if (TIFFWriteEncodedTile(output_,
+                                         TIFFComputeTile(output_, x, block_y_, 0, 0),
+                                         tile_.data(),
+                                         tile_.size() * sizeof(std::uint32_t)) == -1)
+                {
+                    throw image_writer_exception("Could not write TIFF - TIFF Tile Write failed");
+                }
+            }
+        }
+        else if (TIFFWriteScanline(output_, block_.data(), block_y_, 0) == -1)
+        {
+            throw image_writer_exception("Could not write TIFF - TIFF Scanline Write failed");
+        }
+        block_y_ += filled_;
+        filled_ = 0;
+    }
+
+    TIFF* output_;
+    int method_;
+    unsigned block_rows_;
+    unsigned tile_width_;
+    unsigned block_y_;
+    unsigned filled_;
+    std::vector<std::uint32_t> block_;
+    std::vector<std::uint32_t> tile_;
+};
+
+} // namespace
+
+#endif
+
+std::unique_ptr<image_row_writer>
+  create_tiff_row_writer(std::ostream& stream, std::string const& t, unsigned width, unsigned height)
+{
+#if defined(HAVE_TIFF)
+    tiff_config opts;
+    handle_tiff_options(t, opts);
+    return std::make_unique<tiff_row_writer>(stream, opts, width, height);
+#else
+    throw image_writer_exception("tiff output is not enabled in your build of Mapnik");
+#endif
+}
+
+} // namespace detail
+
 tiff_saver::tiff_saver(std::ostream& stream, std::string const& t)
     : stream_(stream)
     , t_(t)
@@ -48,12 +48,40 @@ void handle_webp_options(std::string const& type, WebPConfig& config, bool& alph
     }
     if (type.length() > 4)
     {
-        for (auto const& kv : parse_image_options(type))
+        image_options_map options = parse_image_options(type);
+        // a preset sets most of the other options, which then override it
+        auto preset_itr = options.find("preset");
+        if (preset_itr != options.end() && preset_itr->second && !preset_itr->second->empty())
+        {
+            std::string const& name = *preset_itr->second;
+            WebPPreset preset = WEBP_PRESET_DEFAULT;
+            if (name == "default")
+                preset = WEBP_PRESET_DEFAULT;
+            else if (name == "picture")
+                preset = WEBP_PRESET_PICTURE;
+            else if (name == "photo")
+                preset = WEBP_PRESET_PHOTO;
+            else if (name == "drawing")
+                preset = WEBP_PRESET_DRAWING;
+            else if (name == "icon")
+                preset = WEBP_PRESET_ICON;
+            else if (name == "text")
+                preset = WEBP_PRESET_TEXT;
+            else
+            {
+                throw image_writer_exception("invalid webp preset: '" + name + "'");
+            }
+            if (!WebPConfigPreset(&config, preset, config.quality))
+            {
+                throw std::runtime_error("version mismatch");
+            }
+        }
+        for (auto const& kv : options)
         {
             auto const& key = kv.first;
             auto const& val = kv.second;
 
-            if (key == "webp")
+            if (key == "webp" || key == "preset")
                 continue;
             else if (key == "quality")
             {
@@ -153,7 +181,8 @@ void handle_webp_options(std::string const& type, WebPConfig& config, bool& alph
             {
                 if (val && !(*val).empty())
                 {
-                    if (!mapnik::util::string2int(*val, config.segments))
+                    if (!mapnik::util::string2int(*val, config.segments) || config.segments < 1 ||
+                        config.segments > 4)
                     {
                         throw image_writer_exception("invalid webp segments: '" + *val + "'");
                     }
@@ -261,7 +290,7 @@ void handle_webp_options(std::string const& type, WebPConfig& config, bool& alph
             {
                 if (val && !(*val).empty())
                 {
-                    if (!mapnik::util::string2int(*val, config.pass))
+                    if (!mapnik::util::string2int(*val, config.pass) || config.pass < 1 || config.pass > 10)
                     {
                         throw image_writer_exception("invalid webp pass: '" + *val + "'");
                     }
@@ -297,6 +326,64 @@ void handle_webp_options(std::string const& type, WebPConfig& config, bool& alph
                     }
                 }
             }
+            else if (key == "thread_level")
+            {
+                if (val && !(*val).empty())
+                {
+                    if (!mapnik::util::string2int(*val, config.thread_level) || config.thread_level < 0 ||
+                        config.thread_level > 1)
+                    {
+                        throw image_writer_exception("invalid webp thread_level: '" + *val + "'");
+                    }
+                }
+            }
+            else if (key == "near_lossless")
+            {
+                if (val && !(*val).empty())
+                {
+#if WEBP_ENCODER_ABI_VERSION >= 0x0209 // >= v0.5.0
+                    if (!mapnik::util::string2int(*val, config.near_lossless) || config.near_lossless < 0 ||
+                        config.near_lossless > 100)
+                    {
+                        throw image_writer_exception("invalid webp near_lossless: '" + *val + "'");
+                    }
+#else
+                    throw image_writer_exception("your webp version does not support the near_lossless option");
+#endif
+                }
+            }
+            else if (key == "exact")
+            {
+                if (val && !(*val).empty())
+                {
+#if WEBP_ENCODER_ABI_VERSION >= 0x0209 // >= v0.5.0
+                    bool exact = false;
+                    if (!mapnik::util::string2bool(*val, exact))
+                    {
+                        throw image_writer_exception("invalid webp exact: '" + *val + "'");
+                    }
+                    config.exact = exact ? 1 : 0;
+#else
+                    throw image_writer_exception("your webp version does not support the exact option");
+#endif
+                }
+            }
+            else if (key == "use_sharp_yuv")
+            {
+                if (val && !(*val).empty())
+                {
+#if WEBP_ENCODER_ABI_VERSION >= 0x020e // >= v0.6.0
+                    bool sharp_yuv = false;
+                    if (!mapnik::util::string2bool(*val, sharp_yuv))
+                    {
+                        throw image_writer_exception("invalid webp use_sharp_yuv: '" + *val + "'");
+                    }
+                    config.use_sharp_yuv = sharp_yuv ? 1 : 0;
+#else
+                    throw image_writer_exception("your webp version does not support the use_sharp_yuv option");
+#endif
+                }
+            }
             else
             {
                 throw image_writer_exception("unhandled webp option: " + key);
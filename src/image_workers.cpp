@@ -0,0 +1,149 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/image_workers.hpp>
+
+// stl
+#ifdef MAPNIK_THREADSAFE
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+namespace mapnik {
+namespace detail {
+
+#ifdef MAPNIK_THREADSAFE
+namespace {
+
+// Threads encoding images and compressing bands of PNG images, started when
+// an encode asks for more than there are and kept until exit.
+class image_worker_pool
+{
+  public:
+    static image_worker_pool& instance()
+    {
+        static image_worker_pool pool;
+        return pool;
+    }
+
+    void run(std::size_t helpers, std::function<void()> const& work)
+    {
+        job j(work, helpers);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (threads_.size() < helpers)
+            {
+                threads_.emplace_back(&image_worker_pool::loop, this);
+            }
+            jobs_.push_back(&j);
+        }
+        wake_.notify_all();
+        work();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (j.pending > 0)
+        {
+            jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &j));
+            j.pending = 0;
+        }
+        j.finished.wait(lock, [&j] { return j.running == 0; });
+    }
+
+    ~image_worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+  private:
+    struct job
+    {
+        job(std::function<void()> const& _work, std::size_t _pending)
+            : work(_work)
+            , pending(_pending)
+            , running(0)
+        {}
+
+        std::function<void()> const& work;
+        // copies not started yet and still running
+        std::size_t pending;
+        std::size_t running;
+        std::condition_variable finished;
+    };
+
+    image_worker_pool() = default;
+
+    void loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            wake_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (stop_)
+                return;
+            job* j = jobs_.front();
+            if (--j->pending == 0)
+                jobs_.pop_front();
+            ++j->running;
+            lock.unlock();
+            j->work();
+            lock.lock();
+            if (--j->running == 0)
+                j->finished.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<job*> jobs_;
+    std::vector<std::thread> threads_;
+    bool stop_ = false;
+};
+
+} // namespace
+#endif
+
+void run_image_workers(std::size_t helpers, std::function<void()> const& work)
+{
+#ifdef MAPNIK_THREADSAFE
+    if (helpers > 0)
+    {
+        image_worker_pool::instance().run(helpers, work);
+        return;
+    }
+#endif
+    work();
+}
+
+} // namespace detail
+} // namespace mapnik
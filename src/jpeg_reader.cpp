@@ -34,6 +34,7 @@ extern "C" {
 #include <cstdio>
 #include <memory>
 #include <fstream>
+#include <string>
 
 namespace mapnik {
 
@@ -79,9 +80,13 @@ class jpeg_reader : public image_reader
     inline bool has_alpha() const final { return false; }
     void read(unsigned x, unsigned y, image_rgba8& image) final;
     image_any read(unsigned x, unsigned y, unsigned width, unsigned height) final;
+    unsigned
+      scale_denominator(unsigned width, unsigned height, unsigned target_width, unsigned target_height) const final;
+    image_any read_scaled(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator) final;
 
   private:
     void init();
+    void decode(unsigned x, unsigned y, image_rgba8& image, unsigned denominator);
     static void on_error(j_common_ptr cinfo);
     static void on_error_message(j_common_ptr cinfo);
     static void init_source(j_decompress_ptr cinfo);
@@ -267,6 +272,14 @@ boost::optional<box2d<double>> jpeg_reader<T>::bounding_box() const
 
 template<typename T>
 void jpeg_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
+{
+    decode(x0, y0, image, 1);
+}
+
+// Decodes the image shrunk by denominator with DCT scaling, from x0, y0 of
+// the shrunk image.
+template<typename T>
+void jpeg_reader<T>::decode(unsigned x0, unsigned y0, image_rgba8& image, unsigned denominator)
 {
     stream_.clear();
     stream_.seekg(0, std::ios_base::beg);
@@ -282,6 +295,8 @@ void jpeg_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
     int ret = jpeg_read_header(&cinfo, TRUE);
     if (ret != JPEG_HEADER_OK)
         throw image_reader_exception("JPEG Reader read(): failed to read header");
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = denominator;
     jpeg_start_decompress(&cinfo);
     JSAMPARRAY buffer;
     int row_stride;
@@ -289,12 +304,14 @@ void jpeg_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
     row_stride = cinfo.output_width * cinfo.output_components;
     buffer = (*cinfo.mem->alloc_sarray)((j_common_ptr)&cinfo, JPOOL_IMAGE, row_stride, 1);
 
-    unsigned w = std::min(unsigned(image.width()), width_ - x0);
-    unsigned h = std::min(unsigned(image.height()), height_ - y0);
+    unsigned w = std::min(unsigned(image.width()), cinfo.output_width - x0);
+    unsigned h = std::min(unsigned(image.height()), cinfo.output_height - y0);
 
     const std::unique_ptr<unsigned int[]> out_row(new unsigned int[w]);
     unsigned row = 0;
-    while (cinfo.output_scanline < cinfo.output_height)
+    // the rows below the window are not decoded
+    unsigned end = std::min(cinfo.output_height, y0 + h);
+    while (cinfo.output_scanline < end)
     {
         jpeg_read_scanlines(&cinfo, buffer, 1);
         if (row >= y0 && row < y0 + h)
@@ -320,7 +337,10 @@ void jpeg_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
         }
         ++row;
     }
-    jpeg_finish_decompress(&cinfo);
+    if (cinfo.output_scanline == cinfo.output_height)
+    {
+        jpeg_finish_decompress(&cinfo);
+    }
 }
 
 template<typename T>
@@ -331,4 +351,25 @@ image_any jpeg_reader<T>::read(unsigned x, unsigned y, unsigned width, unsigned
     return image_any(std::move(data));
 }
 
+template<typename T>
+unsigned jpeg_reader<T>::scale_denominator(unsigned width,
+                                           unsigned height,
+                                           unsigned target_width,
+                                           unsigned target_height) const
+{
+    return power_of_two_denominator(width, height, target_width, target_height);
+}
+
+template<typename T>
+image_any jpeg_reader<T>::read_scaled(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator)
+{
+    if (denominator != 1 && denominator != 2 && denominator != 4 && denominator != 8)
+    {
+        throw image_reader_exception("JPEG Reader: can't decode at 1/" + std::to_string(denominator) + " of the size");
+    }
+    image_rgba8 data((width + denominator - 1) / denominator, (height + denominator - 1) / denominator, true, true);
+    decode(x / denominator, y / denominator, data, denominator);
+    return image_any(std::move(data));
+}
+
 } // namespace mapnik
@@ -90,7 +90,8 @@ class map_parser : util::noncopyable
 {
   public:
     map_parser(Map& map, bool strict, std::string const& filename = "")
-        : strict_(strict)
+        : map_(map)
+        , strict_(strict)
         , filename_(filename)
         , font_library_()
         , font_file_mapping_(map.get_font_file_mapping())
@@ -140,6 +141,7 @@ class map_parser : util::noncopyable
     void check_styles(Map const& map);
     boost::optional<color> get_opt_color_attr(boost::property_tree::ptree const& node, std::string const& name);
 
+    Map& map_;
     bool strict_;
     std::string filename_;
     std::map<std::string, parameters> datasource_templates_;
@@ -279,6 +281,7 @@ void map_parser::parse_map(Map& map, xml_node const& node, std::string const& ba
             if (image_filename)
             {
                 map.set_background_image(ensure_relative_to_xml(image_filename));
+                map.pin_marker(*map.background_image());
             }
 
             optional<std::string> comp_op_name = map_node.get_opt_attr<std::string>("background-image-comp-op");
@@ -1071,6 +1074,7 @@ void map_parser::parse_dot_symbolizer(rule& rule, xml_node const& node)
         set_symbolizer_property<symbolizer_base, double>(sym, keys::width, node);
         set_symbolizer_property<symbolizer_base, double>(sym, keys::height, node);
         set_symbolizer_property<symbolizer_base, composite_mode_e>(sym, keys::comp_op, node);
+        set_symbolizer_property<symbolizer_base, marker_rasterizer_enum>(sym, keys::marker_rasterizer, node);
         rule.append(std::move(sym));
     }
     catch (config_error const& ex)
@@ -1146,6 +1150,7 @@ void map_parser::parse_markers_symbolizer(rule& rule, xml_node const& node)
         set_symbolizer_property<symbolizer_base, marker_placement_enum>(sym, keys::markers_placement_type, node);
         set_symbolizer_property<symbolizer_base, marker_multi_policy_enum>(sym, keys::markers_multipolicy, node);
         set_symbolizer_property<symbolizer_base, direction_enum>(sym, keys::direction, node);
+        set_symbolizer_property<symbolizer_base, marker_rasterizer_enum>(sym, keys::marker_rasterizer, node);
         parse_stroke(sym, node);
         rule.append(std::move(sym));
     }
@@ -1270,6 +1275,7 @@ void map_parser::parse_text_symbolizer(rule& rule, xml_node const& node)
             set_symbolizer_property<symbolizer_base, halo_rasterizer_enum>(sym, keys::halo_rasterizer, node);
             set_symbolizer_property<symbolizer_base, transform_type>(sym, keys::halo_transform, node);
             set_symbolizer_property<symbolizer_base, value_double>(sym, keys::offset, node);
+            set_symbolizer_property<symbolizer_base, value_double>(sym, keys::priority, node);
             rule.append(std::move(sym));
         }
     }
@@ -1311,6 +1317,7 @@ void map_parser::parse_shield_symbolizer(rule& rule, xml_node const& node)
         set_symbolizer_property<symbolizer_base, double>(sym, keys::opacity, node);
         set_symbolizer_property<symbolizer_base, value_bool>(sym, keys::unlock_image, node);
         set_symbolizer_property<symbolizer_base, value_double>(sym, keys::offset, node);
+        set_symbolizer_property<symbolizer_base, value_double>(sym, keys::priority, node);
 
         std::string file = node.get_attr<std::string>("file");
         if (file.empty())
@@ -1771,15 +1778,18 @@ std::string map_parser::ensure_relative_to_xml(boost::optional<std::string> cons
 
 void map_parser::ensure_exists(std::string const& file_path)
 {
-    if (marker_cache::instance().is_uri(file_path))
+    auto& cache = marker_cache::instance();
+    if (cache.is_uri(file_path))
         return;
     // validate that the filename exists if it is not a dynamic PathExpression
     if (file_path.find('[') == std::string::npos && file_path.find(']') == std::string::npos)
     {
-        if (!mapnik::util::exists(file_path))
+        if (!cache.is_data_uri(file_path) && !mapnik::util::exists(file_path))
         {
             throw mapnik::config_error("file could not be found: '" + file_path + "'");
         }
+        // markers used by the map stay cached while it exists
+        map_.pin_marker(file_path);
     }
 }
 
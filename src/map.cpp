@@ -39,11 +39,17 @@
 #include <mapnik/config_error.hpp>
 #include <mapnik/config.hpp> // for PROJ_ENVELOPE_POINTS
 #include <mapnik/text/font_library.hpp>
+#include <mapnik/text/text_layout_pool.hpp>
+#include <mapnik/marker_cache.hpp>
 #include <mapnik/util/file_io.hpp>
 #include <mapnik/font_engine_freetype.hpp>
 
 // stl
+#include <algorithm>
 #include <stdexcept>
+#ifdef MAPNIK_THREADSAFE
+#include <thread>
+#endif
 
 namespace mapnik {
 namespace {
@@ -76,6 +82,8 @@ Map::Map()
     , font_directory_()
     , font_file_mapping_()
     , font_memory_cache_()
+    , text_layout_pool_()
+    , marker_pins_()
 {}
 
 Map::Map(int width, int height, std::string const& srs)
@@ -91,6 +99,8 @@ Map::Map(int width, int height, std::string const& srs)
     , font_directory_()
     , font_file_mapping_()
     , font_memory_cache_()
+    , text_layout_pool_()
+    , marker_pins_()
 {}
 
 Map::Map(Map const& rhs)
@@ -115,6 +125,8 @@ Map::Map(Map const& rhs)
     ,
     // on copy discard memory caches
     font_memory_cache_()
+    , text_layout_pool_()
+    , marker_pins_(rhs.marker_pins_)
 {
     init_proj_transforms();
 }
@@ -139,6 +151,9 @@ Map::Map(Map&& rhs)
     , font_directory_(std::move(rhs.font_directory_))
     , font_file_mapping_(std::move(rhs.font_file_mapping_))
     , font_memory_cache_(std::move(rhs.font_memory_cache_))
+    // the workers of rhs reference its fonts
+    , text_layout_pool_()
+    , marker_pins_(std::move(rhs.marker_pins_))
 {}
 
 Map::~Map() {}
@@ -171,6 +186,9 @@ void swap(Map& lhs, Map& rhs)
     std::swap(lhs.extra_params_, rhs.extra_params_);
     std::swap(lhs.font_directory_, rhs.font_directory_);
     std::swap(lhs.font_file_mapping_, rhs.font_file_mapping_);
+    std::atomic_store(&lhs.text_layout_pool_, {});
+    std::atomic_store(&rhs.text_layout_pool_, {});
+    std::swap(lhs.marker_pins_, rhs.marker_pins_);
     // on assignment discard memory caches
     // std::swap(lhs.font_memory_cache_,rhs.font_memory_cache_);
 }
@@ -282,12 +300,39 @@ std::map<std::string, font_set>& Map::fontsets()
 
 bool Map::register_fonts(std::string const& dir, bool recurse)
 {
+    std::atomic_store(&text_layout_pool_, {});
     font_library library;
     return freetype_engine::instance().register_fonts_impl(dir, library, font_file_mapping_, recurse);
 }
 
+std::shared_ptr<text_layout_pool> Map::get_text_layout_pool(std::size_t num_threads) const
+{
+#ifdef MAPNIK_THREADSAFE
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+#else
+    num_threads = 1;
+#endif
+    std::shared_ptr<text_layout_pool> pool = std::atomic_load(&text_layout_pool_);
+    if (!pool || pool->num_threads() != num_threads)
+    {
+        pool = std::make_shared<text_layout_pool>(font_file_mapping_, font_memory_cache_, num_threads);
+        std::atomic_store(&text_layout_pool_, pool);
+    }
+    return pool;
+}
+
+void Map::pin_marker(std::string const& key)
+{
+    if (marker_pins_.find(key) == marker_pins_.end())
+    {
+        marker_pins_.emplace(key, marker_cache::instance().pin_until_released(key));
+    }
+}
+
 bool Map::load_fonts()
 {
+    std::atomic_store(&text_layout_pool_, {});
     bool result = false;
     auto const& global_mapping = freetype_engine::get_mapping();
     for (auto const& kv : font_file_mapping_) // for every face-name -> idx/filepath
@@ -29,6 +29,7 @@
 #include <mapnik/svg/svg_converter.hpp>
 #include <mapnik/svg/svg_path_adapter.hpp>
 #include <mapnik/svg/svg_path_attributes.hpp>
+#include <mapnik/svg/svg_icon_pack.hpp>
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_reader.hpp>
 #include <mapnik/util/fs.hpp>
@@ -47,10 +48,304 @@ MAPNIK_DISABLE_WARNING_PUSH
 #include "agg_pixfmt_rgba.h"
 MAPNIK_DISABLE_WARNING_POP
 
+// stl
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <utility>
+#include <vector>
+
 namespace mapnik {
 
+namespace detail {
+
+struct visitor_create_marker
+{
+    marker operator()(image_rgba8& data) const
+    {
+        mapnik::premultiply_alpha(data);
+        return mapnik::marker(mapnik::marker_rgba8(data));
+    }
+
+    marker operator()(image_null&) const { throw std::runtime_error("Can not make marker from null image data type"); }
+
+    template<typename T>
+    marker operator()(T&) const
+    {
+        throw std::runtime_error("Can not make marker from this data type");
+    }
+};
+
+// Runs parse(svg_parser&) and returns the marker of the parsed document.
+template<typename Parse>
+std::shared_ptr<mapnik::marker const> make_svg_marker(Parse parse, bool strict, bool log_errors = true)
+{
+    using namespace mapnik::svg;
+    svg_path_ptr marker_path(std::make_shared<svg_storage_type>());
+    vertex_stl_adapter<svg_path_storage> stl_storage(marker_path->source());
+    svg_path_adapter svg_path(stl_storage);
+    svg_converter_type svg(svg_path, marker_path->attributes());
+    svg_parser p(svg, strict);
+    parse(p);
+
+    if (!strict && log_errors)
+    {
+        for (auto const& msg : p.err_handler().error_messages())
+        {
+            MAPNIK_LOG_ERROR(marker_cache) << msg;
+        }
+    }
+    // svg.arrange_orientations();
+    double lox, loy, hix, hiy;
+    svg.bounding_rect(&lox, &loy, &hix, &hiy);
+    marker_path->set_bounding_box(lox, loy, hix, hiy);
+    marker_path->set_dimensions(svg.width(), svg.height());
+    marker_path->source().shrink_to_fit();
+    return std::make_shared<mapnik::marker const>(mapnik::marker_svg(marker_path));
+}
+
+std::shared_ptr<mapnik::marker const> make_image_marker(mapnik::image_reader& reader)
+{
+    unsigned width = reader.width();
+    unsigned height = reader.height();
+    BOOST_ASSERT(width > 0 && height > 0);
+    image_any im = reader.read(0, 0, width, height);
+    return std::make_shared<mapnik::marker const>(util::apply_visitor(detail::visitor_create_marker(), im));
+}
+
+// SVG documents start with markup, encoded images with their signature.
+bool is_svg_data(char const* data, std::size_t size)
+{
+    char const* end = data + size;
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    {
+        data += 3;
+    }
+    while (data != end && std::isspace(static_cast<unsigned char>(*data)))
+    {
+        ++data;
+    }
+    return data != end && *data == '<';
+}
+
+std::shared_ptr<mapnik::marker const> make_marker(char const* data, std::size_t size, bool strict)
+{
+    if (is_svg_data(data, size))
+    {
+        return make_svg_marker([&](svg::svg_parser& p) { p.parse_from_buffer(data, size); }, strict);
+    }
+    std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(data, size));
+    if (!reader)
+    {
+        throw std::runtime_error("unknown image format");
+    }
+    return make_image_marker(*reader);
+}
+
+int base64_value(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+' || c == '-')
+        return 62;
+    if (c == '/' || c == '_')
+        return 63;
+    return -1;
+}
+
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Finds the payload of a data URI. Plain payloads are used in place, base64
+// and percent encoded ones are decoded into decoded.
+bool data_uri_payload(std::string const& uri, std::string& decoded, char const*& data, std::size_t& size)
+{
+    std::size_t comma = uri.find(',');
+    if (comma == std::string::npos)
+    {
+        return false;
+    }
+    std::string header = uri.substr(5, comma - 5);
+    data = uri.data() + comma + 1;
+    size = uri.size() - comma - 1;
+    if (boost::algorithm::iends_with(header, ";base64"))
+    {
+        decoded.reserve(size / 4 * 3);
+        unsigned bits = 0;
+        int count = 0;
+        for (char const* itr = data; itr != data + size; ++itr)
+        {
+            if (*itr == '=')
+                break;
+            int value = base64_value(*itr);
+            if (value < 0)
+            {
+                if (std::isspace(static_cast<unsigned char>(*itr)))
+                    continue;
+                return false;
+            }
+            bits = (bits << 6) | static_cast<unsigned>(value);
+            count += 6;
+            if (count >= 8)
+            {
+                count -= 8;
+                decoded.push_back(static_cast<char>((bits >> count) & 0xff));
+            }
+        }
+    }
+    else if (std::memchr(data, '%', size) != nullptr)
+    {
+        decoded.reserve(size);
+        for (char const* itr = data; itr != data + size; ++itr)
+        {
+            int hi, lo;
+            if (*itr == '%' && data + size - itr > 2 && (hi = hex_value(itr[1])) >= 0 && (lo = hex_value(itr[2])) >= 0)
+            {
+                decoded.push_back(static_cast<char>(hi * 16 + lo));
+                itr += 2;
+            }
+            else
+            {
+                decoded.push_back(*itr);
+            }
+        }
+    }
+    else
+    {
+        return true;
+    }
+    data = decoded.data();
+    size = decoded.size();
+    return true;
+}
+
+struct visitor_marker_bytes
+{
+    std::size_t operator()(marker_null const&) const { return 0; }
+
+    std::size_t operator()(marker_rgba8 const& mark) const { return mark.get_data().size(); }
+
+    std::size_t operator()(marker_svg const& mark) const
+    {
+        auto const& path = mark.get_data();
+        if (!path)
+            return 0;
+        // views into icon packs are held by the mapped file
+        auto const& source = path->source();
+        std::size_t bytes = source.is_view() ? 0 : source.size() * sizeof(svg::svg_path_storage::value_type);
+        return bytes + path->attributes().size() * sizeof(svg::path_attributes);
+    }
+};
+
+std::size_t marker_bytes(mapnik::marker const& mark)
+{
+    // roughly the size of the marker itself and of its map entry
+    return 256 + util::apply_visitor(visitor_marker_bytes(), mark);
+}
+
+} // namespace detail
+
+// Pin counts of keys, shared with the handles of pin_until_released.
+struct marker_cache::pin_table
+{
+    void pin(std::string const& key)
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex);
+#endif
+        ++counts[key];
+    }
+
+    bool unpin(std::string const& key)
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex);
+#endif
+        auto itr = counts.find(key);
+        if (itr == counts.end())
+        {
+            return false;
+        }
+        if (--itr->second == 0)
+        {
+            counts.erase(itr);
+        }
+        return true;
+    }
+
+    bool pinned(std::string const& key)
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex);
+#endif
+        return counts.find(key) != counts.end();
+    }
+
+#ifdef MAPNIK_THREADSAFE
+    std::mutex mutex;
+#endif
+    std::unordered_map<std::string, std::size_t> counts;
+};
+
+// Markers a thread found before, and how often it found one. Registered with
+// the cache, so that stats() can add up the hits of all threads without
+// every hit writing to memory shared between them.
+struct marker_cache::local_markers
+{
+    explicit local_markers(marker_cache& cache)
+        : cache_(cache)
+        , generation(0)
+        , markers()
+        , hits(0)
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(marker_cache::mutex_);
+#endif
+        cache_.locals_.push_back(this);
+    }
+
+    ~local_markers()
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(marker_cache::mutex_);
+#endif
+        cache_.hits_ += hits.load(std::memory_order_relaxed);
+        cache_.locals_.erase(std::find(cache_.locals_.begin(), cache_.locals_.end(), this));
+    }
+
+    // only called by the owning thread
+    void found() { hits.store(hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    marker_cache& cache_;
+    std::size_t generation;
+    marker_map markers;
+    std::atomic<std::size_t> hits;
+};
+
 marker_cache::marker_cache()
-    : known_svg_prefix_("shape://")
+    : markers_()
+    , ring_()
+    , generation_(1)
+    , bytes_(0)
+    , capacity_(256 * 1024 * 1024)
+    , pins_(std::make_shared<pin_table>())
+    , locals_()
+    , hits_(0)
+    , misses_(0)
+    , evictions_(0)
+    , known_svg_prefix_("shape://")
     , known_image_prefix_("image://")
 {
     insert_svg("ellipse",
@@ -64,7 +359,7 @@ marker_cache::marker_cache()
                "<path fill='#0000FF' stroke='black' stroke-width='.5' d='m 31.698405,7.5302648 -8.910967,-6.0263712 "
                "0.594993,4.8210971 -18.9822542,0 0,2.4105482 18.9822542,0 -0.594993,4.8210971 z'/>"
                "</svg>");
-    marker_cache_.emplace("image://square", std::make_shared<mapnik::marker const>(mapnik::marker_rgba8()));
+    add("image://square", std::make_shared<mapnik::marker const>(mapnik::marker_rgba8()), false);
 }
 
 marker_cache::~marker_cache() {}
@@ -74,18 +369,134 @@ void marker_cache::clear()
 #ifdef MAPNIK_THREADSAFE
     std::lock_guard<std::mutex> lock(mutex_);
 #endif
-    auto itr = marker_cache_.begin();
-    while (itr != marker_cache_.end())
+    for (auto itr = markers_.begin(); itr != markers_.end();)
     {
-        if (!is_uri(itr->first))
+        if (is_uri(itr->first))
         {
-            marker_cache_.erase(itr++);
+            ++itr;
         }
         else
         {
-            ++itr;
+            itr = drop(itr);
         }
     }
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+void marker_cache::set_capacity(std::size_t bytes)
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    capacity_ = bytes;
+    shrink();
+}
+
+std::size_t marker_cache::capacity()
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    return capacity_;
+}
+
+void marker_cache::pin(std::string const& key)
+{
+    pins_->pin(key);
+}
+
+bool marker_cache::unpin(std::string const& key)
+{
+    return pins_->unpin(key);
+}
+
+std::shared_ptr<void const> marker_cache::pin_until_released(std::string const& key)
+{
+    pins_->pin(key);
+    std::shared_ptr<pin_table> pins = pins_;
+    return std::shared_ptr<void const>(pins.get(), [pins, key](void const*) { pins->unpin(key); });
+}
+
+bool marker_cache::is_pinned(std::string const& key)
+{
+    return is_uri(key) || pins_->pinned(key);
+}
+
+marker_cache::statistics marker_cache::stats()
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    std::size_t hits = hits_;
+    for (auto const* local : locals_)
+    {
+        hits += local->hits.load(std::memory_order_relaxed);
+    }
+    return statistics{hits, misses_, evictions_, markers_.size(), bytes_, capacity_};
+}
+
+void marker_cache::add(std::string const& key, std::shared_ptr<mapnik::marker const> const& mark, bool registered)
+{
+    auto value = std::make_shared<entry const>(mark, detail::marker_bytes(*mark), registered);
+    auto result = markers_.emplace(key, nullptr);
+    auto& item = result.first->second;
+    bool replaced = !result.second;
+    if (replaced)
+    {
+        bytes_ -= item->bytes_;
+        ring_.erase(item->ring_pos_);
+    }
+    bytes_ += value->bytes_;
+    value->ring_pos_ = ring_.insert(ring_.end(), &*result.first);
+    item = std::move(value);
+    if (replaced)
+    {
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+marker_cache::marker_map::iterator marker_cache::drop(marker_map::iterator itr)
+{
+    bytes_ -= itr->second->bytes_;
+    ring_.erase(itr->second->ring_pos_);
+    return markers_.erase(itr);
+}
+
+void marker_cache::evict()
+{
+    // Dropping down to 7/8 of the capacity rather than to the capacity itself
+    // leaves room for some markers before the next sweep.
+    std::size_t target = capacity_ - capacity_ / 8;
+    // Markers which can't be dropped, or were found since the last sweep,
+    // go to the back. Found ones lose that chance, so every marker is looked
+    // at twice at most.
+    std::size_t steps = 2 * ring_.size();
+    std::size_t evicted = 0;
+    while (bytes_ > target && steps-- > 0)
+    {
+        auto const& item = *ring_.front();
+        entry const& value = *item.second;
+        if (value.registered_ || is_pinned(item.first) || value.found_.exchange(false, std::memory_order_relaxed))
+        {
+            ring_.splice(ring_.end(), ring_, ring_.begin());
+            continue;
+        }
+        drop(markers_.find(item.first));
+        ++evicted;
+    }
+    if (evicted > 0)
+    {
+        evictions_ += evicted;
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void marker_cache::shrink()
+{
+    if (bytes_ > capacity_)
+    {
+        evict();
+    }
 }
 
 bool marker_cache::is_svg_uri(std::string const& path)
@@ -98,13 +509,21 @@ bool marker_cache::is_image_uri(std::string const& path)
     return boost::algorithm::starts_with(path, known_image_prefix_);
 }
 
+bool marker_cache::is_data_uri(std::string const& path)
+{
+    return boost::algorithm::istarts_with(path, "data:");
+}
+
 bool marker_cache::insert_svg(std::string const& name, std::string const& svg_string)
 {
     std::string key = known_svg_prefix_ + name;
     auto itr = svg_cache_.find(key);
     if (itr == svg_cache_.end())
     {
-        return svg_cache_.emplace(key, svg_string).second;
+        // the 100% sizes of the built-in shapes are expected, not worth reporting
+        auto mark =
+          detail::make_svg_marker([&](svg::svg_parser& p) { p.parse_from_string(svg_string); }, false, false);
+        return svg_cache_.emplace(key, mark).second;
     }
     return false;
 }
@@ -114,29 +533,111 @@ bool marker_cache::insert_marker(std::string const& uri, mapnik::marker&& path)
 #ifdef MAPNIK_THREADSAFE
     std::lock_guard<std::mutex> lock(mutex_);
 #endif
-    return marker_cache_.emplace(uri, std::make_shared<mapnik::marker const>(std::move(path))).second;
+    if (markers_.find(uri) != markers_.end())
+    {
+        return false;
+    }
+    publish(uri, std::make_shared<mapnik::marker const>(std::move(path)));
+    return true;
 }
 
-namespace detail {
+std::shared_ptr<mapnik::marker const> marker_cache::publish(std::string const& key,
+                                                            std::shared_ptr<mapnik::marker const> const& mark)
+{
+    // Called with mutex_ held.
+    auto itr = markers_.find(key);
+    if (itr != markers_.end())
+    {
+        return itr->second->mark_;
+    }
+    add(key, mark, false);
+    shrink();
+    return mark;
+}
 
-struct visitor_create_marker
+std::size_t marker_cache::load_icon_pack(std::string const& filename)
 {
-    marker operator()(image_rgba8& data) const
+    std::vector<svg::icon_pack_entry> icons;
+    try
     {
-        mapnik::premultiply_alpha(data);
-        return mapnik::marker(mapnik::marker_rgba8(data));
+        icons = svg::read_icon_pack(filename);
+    }
+    catch (std::exception const& ex)
+    {
+        MAPNIK_LOG_ERROR(marker_cache) << "Exception caught while loading icon pack: '" << filename << "' ("
+                                       << ex.what() << ")";
+        return 0;
     }
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    std::size_t count = 0;
+    for (auto& icon : icons)
+    {
+        // icons can't be loaded again by name
+        if (markers_.find(icon.first) == markers_.end())
+        {
+            add(icon.first, std::make_shared<mapnik::marker const>(mapnik::marker_svg(icon.second)), true);
+            ++count;
+        }
+    }
+    shrink();
+    return count;
+}
 
-    marker operator()(image_null&) const { throw std::runtime_error("Can not make marker from null image data type"); }
+void marker_cache::replace(std::string const& key, std::shared_ptr<mapnik::marker const> const& mark)
+{
+    // Called with mutex_ held.
+    if (mark)
+    {
+        // registered markers can't be loaded again
+        add(key, mark, true);
+        shrink();
+    }
+    else
+    {
+        auto itr = markers_.find(key);
+        if (itr != markers_.end())
+        {
+            drop(itr);
+            generation_.fetch_add(1, std::memory_order_release);
+        }
+    }
+}
 
-    template<typename T>
-    marker operator()(T&) const
+std::shared_ptr<mapnik::marker const>
+  marker_cache::insert(std::string const& key, char const* data, std::size_t size, bool strict)
+{
+    std::shared_ptr<mapnik::marker const> mark;
+    try
     {
-        throw std::runtime_error("Can not make marker from this data type");
+        // parsed before locking, other threads keep loading markers meanwhile
+        mark = detail::make_marker(data, size, strict);
     }
-};
+    catch (std::exception const& ex)
+    {
+        MAPNIK_LOG_ERROR(marker_cache) << "Exception caught while loading: '" << key << "' (" << ex.what() << ")";
+        return std::make_shared<mapnik::marker const>(mapnik::marker_null());
+    }
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    replace(key, mark);
+    return mark;
+}
 
-} // namespace detail
+bool marker_cache::remove(std::string const& key)
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    if (markers_.find(key) == markers_.end())
+    {
+        return false;
+    }
+    replace(key, nullptr);
+    return true;
+}
 
 std::shared_ptr<mapnik::marker const> marker_cache::find(std::string const& uri, bool update_cache, bool strict)
 {
@@ -145,17 +646,51 @@ std::shared_ptr<mapnik::marker const> marker_cache::find(std::string const& uri,
         return std::make_shared<mapnik::marker const>(mapnik::marker_null());
     }
 
+    // Every thread keeps the markers it found before, so finding them again
+    // never waits for the mutex. They are dropped as soon as a cached marker
+    // was replaced or removed, rather than kept alive until the thread exits.
+    static thread_local local_markers local(*this);
+    if (local.generation != generation_.load(std::memory_order_acquire))
+    {
+        local.markers.clear();
+        local.generation = 0;
+    }
+    auto itr = local.markers.find(uri);
+    if (itr != local.markers.end())
+    {
+        // only stored once per sweep, so hits on hot markers don't keep
+        // writing to shared memory
+        if (!itr->second->found_.load(std::memory_order_relaxed))
+        {
+            itr->second->found_.store(true, std::memory_order_relaxed);
+        }
+        local.found();
+        return itr->second->mark_;
+    }
+
+    // loading is serialized
 #ifdef MAPNIK_THREADSAFE
     std::lock_guard<std::mutex> lock(mutex_);
 #endif
-    auto itr = marker_cache_.find(uri);
-    if (itr != marker_cache_.end())
+    itr = markers_.find(uri);
+    if (itr != markers_.end())
     {
-        return itr->second;
+        std::size_t generation = generation_.load(std::memory_order_relaxed);
+        if (local.generation != generation)
+        {
+            local.markers.clear();
+            local.generation = generation;
+        }
+        local.markers.insert(*itr);
+        itr->second->found_.store(true, std::memory_order_relaxed);
+        local.found();
+        return itr->second->mark_;
     }
+    ++misses_;
 
     try
     {
+        std::shared_ptr<mapnik::marker const> mark;
         // if uri references a built-in marker
         if (is_svg_uri(uri))
         {
@@ -165,37 +700,19 @@ std::shared_ptr<mapnik::marker const> marker_cache::find(std::string const& uri,
                 MAPNIK_LOG_ERROR(marker_cache) << "Marker does not exist: " << uri;
                 return std::make_shared<mapnik::marker const>(mapnik::marker_null());
             }
-            std::string known_svg_string = mark_itr->second;
-            using namespace mapnik::svg;
-            svg_path_ptr marker_path(std::make_shared<svg_storage_type>());
-            vertex_stl_adapter<svg_path_storage> stl_storage(marker_path->source());
-            svg_path_adapter svg_path(stl_storage);
-            svg_converter_type svg(svg_path, marker_path->attributes());
-            svg_parser p(svg, strict);
-            p.parse_from_string(known_svg_string);
-
-            if (!strict)
-            {
-                for (auto const& msg : p.err_handler().error_messages())
-                {
-                    MAPNIK_LOG_ERROR(marker_cache) << msg;
-                }
-            }
-            // svg.arrange_orientations();
-            double lox, loy, hix, hiy;
-            svg.bounding_rect(&lox, &loy, &hix, &hiy);
-            marker_path->set_bounding_box(lox, loy, hix, hiy);
-            marker_path->set_dimensions(svg.width(), svg.height());
-            if (update_cache)
-            {
-                auto emplace_result =
-                  marker_cache_.emplace(uri, std::make_shared<mapnik::marker const>(mapnik::marker_svg(marker_path)));
-                return emplace_result.first->second;
-            }
-            else
+            mark = mark_itr->second;
+        }
+        else if (is_data_uri(uri))
+        {
+            std::string decoded;
+            char const* data = nullptr;
+            std::size_t size = 0;
+            if (!detail::data_uri_payload(uri, decoded, data, size))
             {
-                return std::make_shared<mapnik::marker const>(mapnik::marker_svg(marker_path));
+                MAPNIK_LOG_ERROR(marker_cache) << "Invalid data URI: " << uri.substr(0, 64);
+                return std::make_shared<mapnik::marker const>(mapnik::marker_null());
             }
+            mark = detail::make_marker(data, size, strict);
         }
         // otherwise assume file-based
         else
@@ -207,69 +724,20 @@ std::shared_ptr<mapnik::marker const> marker_cache::find(std::string const& uri,
             }
             if (is_svg(uri))
             {
-                using namespace mapnik::svg;
-                svg_path_ptr marker_path(std::make_shared<svg_storage_type>());
-                vertex_stl_adapter<svg_path_storage> stl_storage(marker_path->source());
-                svg_path_adapter svg_path(stl_storage);
-                svg_converter_type svg(svg_path, marker_path->attributes());
-                svg_parser p(svg, strict);
-                p.parse(uri);
-
-                if (!strict)
-                {
-                    for (auto const& msg : p.err_handler().error_messages())
-                    {
-                        MAPNIK_LOG_ERROR(marker_cache) << msg;
-                    }
-                }
-                // svg.arrange_orientations();
-                double lox, loy, hix, hiy;
-                svg.bounding_rect(&lox, &loy, &hix, &hiy);
-                marker_path->set_bounding_box(lox, loy, hix, hiy);
-                marker_path->set_dimensions(svg.width(), svg.height());
-                if (update_cache)
-                {
-                    auto emplace_result =
-                      marker_cache_.emplace(uri,
-                                            std::make_shared<mapnik::marker const>(mapnik::marker_svg(marker_path)));
-                    return emplace_result.first->second;
-                }
-                else
-                {
-                    return std::make_shared<mapnik::marker const>(mapnik::marker_svg(marker_path));
-                }
+                mark = detail::make_svg_marker([&](svg::svg_parser& p) { p.parse(uri); }, strict);
             }
             else
             {
-                // TODO - support reading images from string
                 std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(uri));
-                if (reader.get())
-                {
-                    unsigned width = reader->width();
-                    unsigned height = reader->height();
-                    BOOST_ASSERT(width > 0 && height > 0);
-                    image_any im = reader->read(0, 0, width, height);
-                    if (update_cache)
-                    {
-                        auto emplace_result =
-                          marker_cache_.emplace(uri,
-                                                std::make_shared<mapnik::marker const>(
-                                                  util::apply_visitor(detail::visitor_create_marker(), im)));
-                        return emplace_result.first->second;
-                    }
-                    else
-                    {
-                        return std::make_shared<mapnik::marker const>(
-                          util::apply_visitor(detail::visitor_create_marker(), im));
-                    }
-                }
-                else
+                if (!reader)
                 {
                     MAPNIK_LOG_ERROR(marker_cache) << "could not initialize reader for: '" << uri << "'";
                     return std::make_shared<mapnik::marker const>(mapnik::marker_null());
                 }
+                mark = detail::make_image_marker(*reader);
             }
         }
+        return update_cache ? publish(uri, mark) : mark;
     }
     catch (std::exception const& ex)
     {
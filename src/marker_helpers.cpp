@@ -145,6 +145,19 @@ bool push_explicit_style(svg_attribute_type const& src,
     return false;
 }
 
+marker_sprite_style explicit_marker_style(symbolizer_base const& sym, feature_impl& feature, attributes const& vars)
+{
+    marker_sprite_style style;
+    style.fill = get_optional<color>(sym, keys::fill, feature, vars);
+    style.fill_opacity = get_optional<double>(sym, keys::fill_opacity, feature, vars);
+    style.stroke = get_optional<color>(sym, keys::stroke, feature, vars);
+    style.stroke_width = get_optional<double>(sym, keys::stroke_width, feature, vars);
+    style.stroke_opacity = get_optional<double>(sym, keys::stroke_opacity, feature, vars);
+    style.width = get_optional<double>(sym, keys::width, feature, vars);
+    style.height = get_optional<double>(sym, keys::height, feature, vars);
+    return style;
+}
+
 void setup_transform_scaling(agg::trans_affine& tr,
                              double svg_width,
                              double svg_height,
@@ -0,0 +1,235 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/marker_sprite_cache.hpp>
+#include <mapnik/svg/svg_storage.hpp>
+
+// stl
+#include <algorithm>
+#include <cmath>
+
+namespace mapnik {
+
+template class singleton<marker_sprite_cache, CreateStatic>;
+
+namespace {
+
+constexpr std::size_t default_capacity = 64 << 20; // bytes
+
+// A step of the linear part of a transform moves no corner of the marker
+// bounding box by more than 1/8 pixel.
+double quantization_step(box2d<double> const& bbox)
+{
+    double extent = std::max(std::abs(bbox.minx()), std::abs(bbox.maxx())) +
+                    std::max(std::abs(bbox.miny()), std::abs(bbox.maxy()));
+    return 0.125 / std::max(extent, 1e-9);
+}
+
+// Splits a coordinate into a whole pixel and quarter pixels.
+int split_subpixel(double value, int& pixel)
+{
+    int quarters = static_cast<int>(std::floor(value * 4.0 + 0.5));
+    pixel = static_cast<int>(std::floor(quarters / 4.0));
+    return quarters - pixel * 4;
+}
+
+} // namespace
+
+marker_sprite_cache::marker_sprite_cache()
+    : sprites_()
+    , generation_(1)
+    , order_()
+    , bytes_(0)
+    , capacity_(default_capacity)
+{}
+
+marker_sprite_cache::key marker_sprite_cache::make_key(svg_path_ptr const& marker,
+                                                       marker_sprite_style const& style,
+                                                       box2d<double> const& bbox,
+                                                       agg::trans_affine const& tr,
+                                                       double opacity,
+                                                       double gamma,
+                                                       gamma_method_enum gamma_method,
+                                                       bool snap_to_pixels,
+                                                       int& x,
+                                                       int& y)
+{
+    double step = quantization_step(bbox);
+    double tx = tr.tx;
+    double ty = tr.ty;
+    if (snap_to_pixels)
+    {
+        tx = std::floor(tx + .5);
+        ty = std::floor(ty + .5);
+    }
+    key k;
+    k.marker = marker.get();
+    k.style = style;
+    k.linear = {{std::llround(tr.sx / step),
+                 std::llround(tr.shy / step),
+                 std::llround(tr.shx / step),
+                 std::llround(tr.sy / step)}};
+    k.dx = split_subpixel(tx, x);
+    k.dy = split_subpixel(ty, y);
+    k.opacity = opacity;
+    k.gamma = gamma;
+    k.gamma_method = gamma_method;
+    return k;
+}
+
+agg::trans_affine marker_sprite_cache::sprite_transform(key const& k, box2d<double> const& bbox)
+{
+    double step = quantization_step(bbox);
+    return agg::trans_affine(k.linear[0] * step,
+                             k.linear[1] * step,
+                             k.linear[2] * step,
+                             k.linear[3] * step,
+                             k.dx / 4.0,
+                             k.dy / 4.0);
+}
+
+std::shared_ptr<marker_sprite const> marker_sprite_cache::find(key const& k) const
+{
+    // Entries hold their marker, so its address can't be reused by another
+    // marker while a thread keeps them.
+    struct local_sprites
+    {
+        std::size_t generation = 0;
+        sprite_map sprites;
+    };
+    static thread_local local_sprites local;
+    if (local.generation != generation_.load(std::memory_order_acquire))
+    {
+        local.sprites.clear();
+        local.generation = 0;
+    }
+    auto local_itr = local.sprites.find(k);
+    if (local_itr != local.sprites.end())
+    {
+        return local_itr->second.sprite;
+    }
+
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    auto itr = sprites_.find(k);
+    if (itr == sprites_.end())
+    {
+        return nullptr;
+    }
+    std::size_t generation = generation_.load(std::memory_order_relaxed);
+    if (local.generation != generation)
+    {
+        local.sprites.clear();
+        local.generation = generation;
+    }
+    local.sprites.insert(*itr);
+    return itr->second.sprite;
+}
+
+std::shared_ptr<marker_sprite const>
+  marker_sprite_cache::insert(key const& k, svg_path_ptr const& marker, image_rgba8 const& image, int x, int y)
+{
+    int width = static_cast<int>(image.width());
+    int height = static_cast<int>(image.height());
+    int x0 = width;
+    int y0 = height;
+    int x1 = -1;
+    int y1 = -1;
+    for (int j = 0; j < height; ++j)
+    {
+        image_rgba8::pixel_type const* row = image.get_row(j);
+        for (int i = 0; i < width; ++i)
+        {
+            if (row[i] != 0)
+            {
+                x0 = std::min(x0, i);
+                x1 = std::max(x1, i);
+                y0 = std::min(y0, j);
+                y1 = j;
+            }
+        }
+    }
+    auto sprite = std::make_shared<marker_sprite>();
+    if (x1 >= x0)
+    {
+        sprite->image = image_rgba8(x1 - x0 + 1, y1 - y0 + 1, false, true);
+        for (int j = y0; j <= y1; ++j)
+        {
+            image_rgba8::pixel_type const* row = image.get_row(j);
+            std::copy(row + x0, row + x1 + 1, sprite->image.get_row(j - y0));
+        }
+        sprite->x = x + x0;
+        sprite->y = y + y0;
+    }
+    else
+    {
+        sprite->x = x;
+        sprite->y = y;
+    }
+
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    auto result = sprites_.emplace(k, entry{marker, sprite});
+    if (!result.second)
+    {
+        // drawn by another thread meanwhile
+        return result.first->second.sprite;
+    }
+    order_.push_back(k);
+    bytes_ += sprite->image.size();
+    if (bytes_ > capacity_ && order_.size() > 1)
+    {
+        while (bytes_ > capacity_ && order_.size() > 1)
+        {
+            auto oldest = sprites_.find(order_.front());
+            bytes_ -= oldest->second.sprite->image.size();
+            sprites_.erase(oldest);
+            order_.pop_front();
+        }
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+    return sprite;
+}
+
+std::size_t marker_sprite_cache::size() const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    return sprites_.size();
+}
+
+void marker_sprite_cache::clear()
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    sprites_.clear();
+    order_.clear();
+    bytes_ = 0;
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+} // namespace mapnik
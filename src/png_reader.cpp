@@ -30,9 +30,12 @@ extern "C" {
 }
 
 // stl
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <fstream>
+#include <vector>
 
 namespace mapnik {
 
@@ -54,6 +57,29 @@ class png_reader : public image_reader
         png_infopp i_;
     };
 
+    // libpng reading rows one after the other, kept between reads
+    struct decoder
+    {
+        decoder()
+            : png_ptr(nullptr)
+            , info_ptr(nullptr)
+            , guard(&png_ptr, &info_ptr)
+            , next_row(0)
+        {}
+
+        png_structp png_ptr;
+        png_infop info_ptr;
+        png_struct_guard guard;
+        unsigned next_row;
+    };
+
+    struct target
+    {
+        unsigned x;
+        unsigned y;
+        image_rgba8* image;
+    };
+
   private:
 
     source_type source_;
@@ -63,6 +89,17 @@ class png_reader : public image_reader
     int bit_depth_;
     int color_type_;
     bool has_alpha_;
+    bool interlaced_;
+    std::unique_ptr<decoder> decoder_;
+    // bound on the memory of the pixels kept for the next read
+    std::size_t max_cached_bytes_;
+    // decoded pixels of rows [cache_begin_, cache_end_) and columns
+    // [cache_x_begin_, cache_x_end_) of the last read
+    std::vector<std::uint32_t> cache_;
+    unsigned cache_begin_;
+    unsigned cache_end_;
+    unsigned cache_x_begin_;
+    unsigned cache_x_end_;
 
   public:
     explicit png_reader(std::string const& filename);
@@ -74,9 +111,15 @@ class png_reader : public image_reader
     inline bool has_alpha() const final { return has_alpha_; }
     void read(unsigned x, unsigned y, image_rgba8& image) final;
     image_any read(unsigned x, unsigned y, unsigned width, unsigned height) final;
+    std::vector<image_any> read_windows(std::vector<window> const& windows) final;
 
   private:
     void init();
+    void create_read_struct(png_structp& png_ptr, png_infop& info_ptr);
+    void set_transforms(png_structp png_ptr, png_infop info_ptr);
+    void read_targets(std::vector<target> const& targets);
+    void decode_row(unsigned y, std::uint32_t* row);
+    void decode_image(std::uint32_t* pixels, std::size_t stride);
     static void png_read_data(png_structp png_ptr, png_bytep data, png_size_t length);
 };
 
@@ -127,6 +170,14 @@ png_reader<T>::png_reader(std::string const& filename)
     , bit_depth_(0)
     , color_type_(0)
     , has_alpha_(false)
+    , interlaced_(false)
+    , decoder_()
+    , max_cached_bytes_(png_reader_cache_size())
+    , cache_()
+    , cache_begin_(0)
+    , cache_end_(0)
+    , cache_x_begin_(0)
+    , cache_x_end_(0)
 {
     source_.open(filename, std::ios_base::in | std::ios_base::binary);
     if (!source_.is_open())
@@ -143,6 +194,14 @@ png_reader<T>::png_reader(char const* data, std::size_t size)
     , bit_depth_(0)
     , color_type_(0)
     , has_alpha_(false)
+    , interlaced_(false)
+    , decoder_()
+    , max_cached_bytes_(png_reader_cache_size())
+    , cache_()
+    , cache_begin_(0)
+    , cache_end_(0)
+    , cache_x_begin_(0)
+    , cache_x_end_(0)
 {
     if (!stream_)
         throw image_reader_exception("PNG reader: cannot open image stream");
@@ -192,6 +251,7 @@ void png_reader<T>::init()
     png_uint_32 width, height;
     png_get_IHDR(png_ptr, info_ptr, &width, &height, &bit_depth_, &color_type_, 0, 0, 0);
     has_alpha_ = (color_type_ & PNG_COLOR_MASK_ALPHA) || png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS);
+    interlaced_ = png_get_interlace_type(png_ptr, info_ptr) == PNG_INTERLACE_ADAM7;
     width_ = width;
     height_ = height;
 
@@ -217,12 +277,12 @@ boost::optional<box2d<double>> png_reader<T>::bounding_box() const
 }
 
 template<typename T>
-void png_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
+void png_reader<T>::create_read_struct(png_structp& png_ptr, png_infop& info_ptr)
 {
     stream_.clear();
     stream_.seekg(0, std::ios_base::beg);
 
-    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+    png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
 
     if (!png_ptr)
     {
@@ -232,15 +292,18 @@ void png_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
     // catch errors in a custom way to avoid the need for setjmp
     png_set_error_fn(png_ptr, png_get_error_ptr(png_ptr), user_error_fn, user_warning_fn);
 
-    png_infop info_ptr;
-    png_struct_guard sguard(&png_ptr, &info_ptr);
     info_ptr = png_create_info_struct(png_ptr);
     if (!info_ptr)
         throw image_reader_exception("failed to create info_ptr");
 
     png_set_read_fn(png_ptr, (png_voidp)&stream_, png_read_data);
     png_read_info(png_ptr, info_ptr);
+    set_transforms(png_ptr, info_ptr);
+}
 
+template<typename T>
+void png_reader<T>::set_transforms(png_structp png_ptr, png_infop info_ptr)
+{
     if (color_type_ == PNG_COLOR_TYPE_PALETTE)
         png_set_expand(png_ptr);
     if (color_type_ == PNG_COLOR_TYPE_GRAY && bit_depth_ < 8)
@@ -258,43 +321,179 @@ void png_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
     double gamma;
     if (png_get_gAMA(png_ptr, info_ptr, &gamma))
         png_set_gamma(png_ptr, 2.2, gamma);
+}
 
+template<typename T>
+void png_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
+{
     if (x0 == 0 && y0 == 0 && image.width() >= width_ && image.height() >= height_)
     {
-        if (png_get_interlace_type(png_ptr, info_ptr) == PNG_INTERLACE_ADAM7)
+        // the whole image at once, the rows kept from windows are of no use
+        decoder_.reset();
+        decode_image(image.data(), image.width());
+        return;
+    }
+    read_targets({target{x0, y0, &image}});
+}
+
+// Reads the whole image into pixels, stride pixels apart from row to row.
+template<typename T>
+void png_reader<T>::decode_image(std::uint32_t* pixels, std::size_t stride)
+{
+    png_structp png_ptr = nullptr;
+    png_infop info_ptr = nullptr;
+    png_struct_guard sguard(&png_ptr, &info_ptr);
+    create_read_struct(png_ptr, info_ptr);
+    if (interlaced_)
+    {
+        png_set_interlace_handling(png_ptr); // FIXME: libpng bug?
+        // according to docs png_read_image
+        // "..automatically handles interlacing,
+        // so you don't need to call png_set_interlace_handling()"
+    }
+    png_read_update_info(png_ptr, info_ptr);
+    // we can read whole image at once
+    // alloc row pointers
+    const std::unique_ptr<png_bytep[]> rows(new png_bytep[height_]);
+    for (unsigned i = 0; i < height_; ++i)
+        rows[i] = reinterpret_cast<png_bytep>(pixels + i * stride);
+    png_read_image(png_ptr, rows.get());
+    png_read_end(png_ptr, 0);
+}
+
+// Decodes row y into row, going on from the last row decoded when it is
+// above y and starting over otherwise.
+template<typename T>
+void png_reader<T>::decode_row(unsigned y, std::uint32_t* row)
+{
+    if (!decoder_ || decoder_->next_row > y)
+    {
+        decoder_.reset();
+        auto d = std::make_unique<decoder>();
+        create_read_struct(d->png_ptr, d->info_ptr);
+        png_read_update_info(d->png_ptr, d->info_ptr);
+        decoder_ = std::move(d);
+    }
+    // the rows above y are decoded and dropped
+    for (; decoder_->next_row <= y; ++decoder_->next_row)
+    {
+        png_read_row(decoder_->png_ptr, reinterpret_cast<png_bytep>(row), 0);
+    }
+}
+
+// Decodes the rows covered by the windows of the targets once, from the
+// pixels kept from the last read where they are there. The pixels stay for
+// the next read, so that windows next to each other share the decoding of
+// their rows, and reads further down go on from where the last one stopped.
+// When whole rows are too large to keep, the columns of the windows are kept
+// together with as many columns to the right of them as fit, for the windows
+// read next.
+template<typename T>
+void png_reader<T>::read_targets(std::vector<target> const& targets)
+{
+    unsigned x_begin = width_;
+    unsigned x_end = 0;
+    unsigned y_begin = height_;
+    unsigned y_end = 0;
+    for (auto const& t : targets)
+    {
+        if (t.x >= width_ || t.y >= height_)
+            continue;
+        x_begin = std::min(x_begin, t.x);
+        x_end = std::max(x_end, t.x + std::min(unsigned(t.image->width()), width_ - t.x));
+        y_begin = std::min(y_begin, t.y);
+        y_end = std::max(y_end, t.y + std::min(unsigned(t.image->height()), height_ - t.y));
+    }
+    if (y_begin >= y_end)
+        return;
+
+    // the pixels of row y from column x on
+    auto set_rows = [&](unsigned y, std::uint32_t const* row, unsigned x) {
+        for (auto const& t : targets)
+        {
+            if (t.x >= width_ || y < t.y || y >= t.y + t.image->height())
+                continue;
+            unsigned w = std::min(unsigned(t.image->width()), width_ - t.x);
+            t.image->set_row(y - t.y, row + (t.x - x), w);
+        }
+    };
+
+    if (interlaced_ && !(cache_begin_ == 0 && cache_end_ == height_ && cache_x_begin_ == 0 && cache_x_end_ == width_))
+    {
+        // rows are only complete after the last pass
+        decoder_.reset();
+        cache_.resize(std::size_t(width_) * height_);
+        cache_begin_ = cache_end_ = 0;
+        decode_image(cache_.data(), width_);
+        cache_end_ = height_;
+        cache_x_begin_ = 0;
+        cache_x_end_ = width_;
+    }
+    if (y_begin >= cache_begin_ && y_end <= cache_end_ && x_begin >= cache_x_begin_ && x_end <= cache_x_end_)
+    {
+        std::size_t stride = cache_x_end_ - cache_x_begin_;
+        for (unsigned y = y_begin; y < y_end; ++y)
         {
-            png_set_interlace_handling(png_ptr); // FIXME: libpng bug?
-            // according to docs png_read_image
-            // "..automatically handles interlacing,
-            // so you don't need to call png_set_interlace_handling()"
+            set_rows(y, &cache_[(y - cache_begin_) * stride], cache_x_begin_);
         }
-        png_read_update_info(png_ptr, info_ptr);
-        // we can read whole image at once
-        // alloc row pointers
-        const std::unique_ptr<png_bytep[]> rows(new png_bytep[height_]);
-        for (unsigned i = 0; i < height_; ++i)
-            rows[i] = (png_bytep)image.get_row(i);
-        png_read_image(png_ptr, rows.get());
+        if (interlaced_ && cache_.size() * sizeof(std::uint32_t) > max_cached_bytes_)
+        {
+            // too large to keep around
+            cache_ = std::vector<std::uint32_t>();
+            cache_begin_ = cache_end_ = 0;
+        }
+        return;
+    }
+
+    std::size_t band_rows = y_end - y_begin;
+    unsigned columns =
+      static_cast<unsigned>(std::min<std::size_t>(width_, max_cached_bytes_ / (band_rows * sizeof(std::uint32_t))));
+    bool keep = x_end - x_begin <= columns;
+    if (keep)
+    {
+        x_begin = std::min(x_begin, width_ - columns);
+        x_end = x_begin + columns;
     }
-    else
+    std::vector<std::uint32_t> band(keep ? band_rows * columns : 0);
+    std::vector<std::uint32_t> row(keep && columns == width_ ? 0 : width_);
+    try
     {
-        png_read_update_info(png_ptr, info_ptr);
-        unsigned w = std::min(unsigned(image.width()), width_ - x0);
-        unsigned h = std::min(unsigned(image.height()), height_ - y0);
-        unsigned rowbytes = png_get_rowbytes(png_ptr, info_ptr);
-        const std::unique_ptr<png_byte[]> row(new png_byte[rowbytes]);
-        // START read image rows
-        for (unsigned i = 0; i < height_; ++i)
+        for (unsigned y = y_begin; y < y_end; ++y)
         {
-            png_read_row(png_ptr, row.get(), 0);
-            if (i >= y0 && i < (y0 + h))
+            // whole rows are decoded into the band, others through row
+            std::uint32_t* out = row.empty() ? &band[(y - y_begin) * columns] : row.data();
+            std::uint32_t const* pixels = out + x_begin;
+            if (y >= cache_begin_ && y < cache_end_ && x_begin >= cache_x_begin_ && x_end <= cache_x_end_)
+            {
+                pixels = &cache_[(y - cache_begin_) * (cache_x_end_ - cache_x_begin_) + (x_begin - cache_x_begin_)];
+            }
+            else
+            {
+                decode_row(y, out);
+            }
+            if (keep)
             {
-                image.set_row(i - y0, reinterpret_cast<unsigned*>(&row[x0 * 4]), w);
+                std::uint32_t* kept = &band[(y - y_begin) * columns];
+                if (pixels != kept)
+                    std::copy_n(pixels, columns, kept);
+                pixels = kept;
             }
+            set_rows(y, pixels, x_begin);
         }
-        // END
     }
-    png_read_end(png_ptr, 0);
+    catch (...)
+    {
+        decoder_.reset();
+        throw;
+    }
+    if (keep)
+    {
+        cache_.swap(band);
+        cache_begin_ = y_begin;
+        cache_end_ = y_end;
+        cache_x_begin_ = x_begin;
+        cache_x_end_ = x_end;
+    }
 }
 
 template<typename T>
@@ -305,4 +504,26 @@ image_any png_reader<T>::read(unsigned x, unsigned y, unsigned width, unsigned h
     return image_any(std::move(data));
 }
 
+template<typename T>
+std::vector<image_any> png_reader<T>::read_windows(std::vector<window> const& windows)
+{
+    std::vector<image_rgba8> images;
+    std::vector<target> targets;
+    images.reserve(windows.size());
+    targets.reserve(windows.size());
+    for (auto const& w : windows)
+    {
+        images.emplace_back(w.width, w.height);
+        targets.push_back(target{w.x, w.y, &images.back()});
+    }
+    read_targets(targets);
+    std::vector<image_any> result;
+    result.reserve(images.size());
+    for (auto& image : images)
+    {
+        result.emplace_back(std::move(image));
+    }
+    return result;
+}
+
 } // namespace mapnik
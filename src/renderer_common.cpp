@@ -26,6 +26,8 @@
 #include <mapnik/request.hpp>
 #include <mapnik/attribute.hpp>
 #include <mapnik/safe_cast.hpp>
+#include <mapnik/text/vertex_cache_store.hpp>
+#include <mapnik/renderer_common/render_thunk_cache.hpp>
 
 namespace mapnik {
 
@@ -41,6 +43,8 @@ renderer_common::renderer_common(renderer_common const& other)
     , query_extent_(other.query_extent_)
     , t_(other.t_)
     , detector_(other.detector_)
+    , vertex_caches_(other.vertex_caches_)
+    , render_thunks_(other.render_thunks_)
 {}
 
 renderer_common::renderer_common(Map const& map,
@@ -60,6 +64,9 @@ renderer_common::renderer_common(Map const& map,
     , query_extent_()
     , t_(t)
     , detector_(detector)
+    , vertex_caches_(std::make_shared<vertex_cache_store>())
+    , render_thunks_(std::make_shared<render_thunk_cache>(
+        safe_cast<std::size_t>(*map.get_extra_parameters().get<value_integer>("group-layout-cache-size", 4096))))
 {}
 
 renderer_common::renderer_common(Map const& m,
@@ -121,6 +128,7 @@ renderer_common::~renderer_common()
 {
     // defined in .cpp to make this destructible elsewhere without
     // having to #include <mapnik/label_collision_detector.hpp>
+    // or <mapnik/text/vertex_cache_store.hpp>
 }
 
 } // namespace mapnik
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/renderer_common/label_placement_queue.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/map.hpp>
+
+namespace mapnik {
+
+namespace {
+
+bool blends_other_than_src_over(boost::optional<composite_mode_e> const& comp_op)
+{
+    return comp_op && *comp_op != src_over;
+}
+
+} // namespace
+
+bool label_placement_queue::start_layer(Map const& map, layer const& lay)
+{
+    layer_composited_ = lay.comp_op() || lay.get_opacity() < 1.0;
+    active_ = false;
+    if (candidates_.empty())
+        return false;
+    if (lay.clear_label_cache() || blends_other_than_src_over(lay.comp_op()))
+        return true;
+    for (std::string const& name : lay.styles())
+    {
+        boost::optional<feature_type_style const&> st = map.find_style(name);
+        if (st && (blends_other_than_src_over(st->comp_op()) || !st->direct_image_filters().empty()))
+            return true;
+    }
+    return false;
+}
+
+void label_placement_queue::start_style(feature_type_style const& st)
+{
+    active_ = !layer_composited_ && !st.comp_op() && st.get_opacity() >= 1.0 && st.image_filters().empty() &&
+              st.direct_image_filters().empty();
+}
+
+} // namespace mapnik
@@ -27,6 +27,7 @@
 #include <mapnik/group/group_symbolizer_helper.hpp>
 #include <mapnik/group/group_symbolizer_properties.hpp>
 #include <mapnik/renderer_common/render_group_symbolizer.hpp>
+#include <mapnik/renderer_common/render_thunk_cache.hpp>
 #include <mapnik/renderer_common/render_thunk_extractor.hpp>
 #include <mapnik/util/conversions.hpp>
 
@@ -61,12 +62,21 @@ void render_group_symbolizer(group_symbolizer const& sym,
     std::vector<std::pair<group_rule_ptr, feature_ptr>> matches;
 
     // create a copied 'virtual' common renderer for processing sub feature symbolizers
-    // create an empty detector for it, so we are sure we won't hit anything
-    virtual_renderer_common virtual_renderer(common);
+    // create an empty detector for it, so we are sure we won't hit anything.
+    // Only needed when a member is not in the cache yet.
+    std::unique_ptr<virtual_renderer_common> virtual_renderer;
 
     // keep track of which lists of render thunks correspond to
     // entries in the group_layout_manager.
-    std::list<render_thunk_list> layout_thunks;
+    std::vector<render_thunk_list const*> layout_thunks;
+
+    // members laid out by earlier features with the same values are reused,
+    // the layouts of all features of this call stay valid until it returns
+    render_thunk_cache& cache = *common.render_thunks_;
+    if (cache.size() >= cache.capacity())
+    {
+        cache.clear();
+    }
 
     // layout manager to store and arrange bboxes of matched features
     group_layout_manager layout_manager(props->get_layout());
@@ -130,21 +140,43 @@ void render_group_symbolizer(group_symbolizer const& sym,
                 // add matched rule and feature to the list of things to draw
                 matches.emplace_back(rule, sub_feature);
 
-                // construct a bounding box around all symbolizers for the matched rule
-                box2d<double> bounds;
-                render_thunk_list thunks;
-                render_thunk_extractor
-                  extractor(bounds, thunks, *sub_feature, common.vars_, prj_trans, virtual_renderer, clipping_extent);
-
-                for (auto const& _sym : *rule)
+                // the layout only depends on the rule and the sub feature
+                render_thunk_cache::key key{rule.get(), col_idx, clipping_extent, {}};
+                key.values.reserve(columns.size());
+                for (auto const& col_name : columns)
+                {
+                    key.values.push_back(sub_feature->get(col_name));
+                }
+                render_thunk_cache::layout const* layout = cache.find(key);
+                if (!layout)
                 {
-                    // TODO: construct layout and obtain bounding box
-                    util::apply_visitor(extractor, _sym);
+                    if (!virtual_renderer)
+                    {
+                        virtual_renderer = std::make_unique<virtual_renderer_common>(common);
+                    }
+                    render_thunk_cache::layout& extracted = cache.insert(std::move(key));
+                    extracted.feature = sub_feature;
+
+                    // construct a bounding box around all symbolizers for the matched rule
+                    render_thunk_extractor extractor(extracted.bounds,
+                                                     extracted.thunks,
+                                                     *sub_feature,
+                                                     common.vars_,
+                                                     prj_trans,
+                                                     *virtual_renderer,
+                                                     clipping_extent);
+
+                    for (auto const& _sym : *rule)
+                    {
+                        // TODO: construct layout and obtain bounding box
+                        util::apply_visitor(extractor, _sym);
+                    }
+                    layout = &extracted;
                 }
 
                 // add the bounding box to the layout manager
-                layout_manager.add_member_bound_box(bounds);
-                layout_thunks.emplace_back(std::move(thunks));
+                layout_manager.add_member_bound_box(layout->bounds);
+                layout_thunks.push_back(&layout->thunks);
                 break;
             }
         }
@@ -192,11 +224,11 @@ void render_group_symbolizer(group_symbolizer const& sym,
     for (pixel_position const& pos : positions)
     {
         size_t layout_i = 0;
-        for (auto const& thunks : layout_thunks)
+        for (auto const* thunks : layout_thunks)
         {
             pixel_position const& offset = layout_manager.offset_at(layout_i);
             pixel_position render_offset = pos + offset;
-            render_thunks.render_list(thunks, render_offset);
+            render_thunks.render_list(*thunks, render_offset);
             ++layout_i;
         }
     }
@@ -171,6 +171,15 @@ struct render_marker_symbolizer_visitor
                                                  snap_to_pixels,
                                                  renderer_context_);
 
+        if (get<marker_rasterizer_enum, keys::marker_rasterizer>(sym_, feature_, common_.vars_) ==
+            marker_rasterizer_enum::MARKER_RASTERIZER_SPRITE)
+        {
+            // sized ellipses are built for every feature, their stock marker
+            // together with the size identifies them
+            rasterizer_dispatch.set_sprite_source(stock_vector_marker,
+                                                  explicit_marker_style(sym_, feature_, common_.vars_));
+        }
+
         render_marker(mark, rasterizer_dispatch);
     }
 
@@ -233,6 +242,9 @@ markers_dispatch_params::markers_dispatch_params(box2d<double> const& size,
     , snap_to_pixels(snap)
     , scale_factor(scale)
     , opacity(get<value_double, keys::opacity>(sym, feature, vars))
+    , rasterizer(get<marker_rasterizer_enum, keys::marker_rasterizer>(sym, feature, vars))
+    , sprite_marker()
+    , sprite_style()
 {
     placement_params.spacing *= scale;
 }
@@ -244,18 +256,30 @@ void render_markers_symbolizer(markers_symbolizer const& sym,
                                box2d<double> const& clip_box,
                                markers_renderer_context& renderer_context)
 {
-    using Detector = label_collision_detector4;
-    using RendererType = renderer_common;
-    using ContextType = markers_renderer_context;
-    using VisitorType = detail::render_marker_symbolizer_visitor<Detector, RendererType, ContextType>;
-
     std::string filename = get<std::string>(sym, keys::file, feature, common.vars_, "shape://ellipse");
     if (!filename.empty())
     {
         auto mark = mapnik::marker_cache::instance().find(filename, true);
-        VisitorType visitor(filename, sym, feature, prj_trans, common, clip_box, renderer_context);
-        util::apply_visitor(visitor, *mark);
+        render_markers_symbolizer(sym, feature, prj_trans, common, clip_box, filename, *mark, renderer_context);
     }
 }
 
+void render_markers_symbolizer(markers_symbolizer const& sym,
+                               mapnik::feature_impl& feature,
+                               proj_transform const& prj_trans,
+                               renderer_common const& common,
+                               box2d<double> const& clip_box,
+                               std::string const& filename,
+                               marker const& mark,
+                               markers_renderer_context& renderer_context)
+{
+    using Detector = label_collision_detector4;
+    using RendererType = renderer_common;
+    using ContextType = markers_renderer_context;
+    using VisitorType = detail::render_marker_symbolizer_visitor<Detector, RendererType, ContextType>;
+
+    VisitorType visitor(filename, sym, feature, prj_trans, common, clip_box, renderer_context);
+    util::apply_visitor(visitor, mark);
+}
+
 } // namespace mapnik
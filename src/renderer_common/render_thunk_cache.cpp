@@ -0,0 +1,85 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/renderer_common/render_thunk_cache.hpp>
+
+// stl
+#include <functional>
+
+namespace mapnik {
+
+bool render_thunk_cache::key::operator==(key const& rhs) const
+{
+    if (rule != rhs.rule || index != rhs.index || clipping_extent != rhs.clipping_extent ||
+        values.size() != rhs.values.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        // 1 and 1.0 compare equal but are not formatted the same
+        if (values[i].which() != rhs.values[i].which() || values[i] != rhs.values[i])
+            return false;
+    }
+    return true;
+}
+
+std::size_t render_thunk_cache::key_hash::operator()(key const& k) const
+{
+    std::size_t seed = std::hash<void const*>()(k.rule);
+    auto combine = [&seed](std::size_t value) { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); };
+    combine(std::hash<value_integer>()(k.index));
+    for (auto const& v : k.values)
+    {
+        combine(value_hash(v));
+    }
+    return seed;
+}
+
+render_thunk_cache::render_thunk_cache(std::size_t capacity)
+    : index_()
+    , layouts_()
+    , capacity_(capacity)
+{}
+
+render_thunk_cache::layout const* render_thunk_cache::find(key const& k) const
+{
+    auto itr = index_.find(k);
+    return itr != index_.end() ? itr->second : nullptr;
+}
+
+render_thunk_cache::layout& render_thunk_cache::insert(key&& k)
+{
+    layouts_.emplace_back();
+    layout& result = layouts_.back();
+    index_[std::move(k)] = &result;
+    return result;
+}
+
+void render_thunk_cache::clear()
+{
+    index_.clear();
+    layouts_.clear();
+}
+
+} // namespace mapnik
@@ -22,6 +22,7 @@
 
 // mapnik
 #include <mapnik/label_collision_detector.hpp>
+#include <mapnik/marker_cache.hpp>
 #include <mapnik/renderer_common/render_markers_symbolizer.hpp>
 #include <mapnik/renderer_common/render_thunk_extractor.hpp>
 
@@ -41,8 +42,10 @@ struct thunk_markers_renderer_context : markers_renderer_context
     thunk_markers_renderer_context(symbolizer_base const& sym,
                                    feature_impl const& feature,
                                    attributes const& vars,
+                                   std::shared_ptr<marker const> const& mark,
                                    render_thunk_list& thunks)
         : comp_op_(get<composite_mode_e, keys::comp_op>(sym, feature, vars))
+        , mark_(mark)
         , thunks_(thunks)
     {}
 
@@ -59,12 +62,13 @@ struct thunk_markers_renderer_context : markers_renderer_context
     virtual void
       render_marker(image_rgba8 const& src, markers_dispatch_params const& params, agg::trans_affine const& marker_tr)
     {
-        raster_marker_render_thunk thunk(src, marker_tr, params.opacity, comp_op_, params.snap_to_pixels);
+        raster_marker_render_thunk thunk(src, mark_, marker_tr, params.opacity, comp_op_, params.snap_to_pixels);
         thunks_.emplace_back(std::move(thunk));
     }
 
   private:
     composite_mode_e comp_op_;
+    std::shared_ptr<marker const> mark_;
     render_thunk_list& thunks_;
 };
 
@@ -89,61 +93,72 @@ render_thunk_extractor::render_thunk_extractor(box2d<double>& box,
 void render_thunk_extractor::operator()(markers_symbolizer const& sym) const
 {
     using renderer_context_type = detail::thunk_markers_renderer_context;
-    renderer_context_type renderer_context(sym, feature_, vars_, thunks_);
-
-    render_markers_symbolizer(sym, feature_, prj_trans_, common_, clipping_extent_, renderer_context);
+    std::string filename = get<std::string>(sym, keys::file, feature_, common_.vars_, "shape://ellipse");
+    if (!filename.empty())
+    {
+        // held by the thunks, the marker cache may drop it while they are cached
+        auto mark = marker_cache::instance().find(filename, true);
+        renderer_context_type renderer_context(sym, feature_, vars_, mark, thunks_);
+        render_markers_symbolizer(sym,
+                                  feature_,
+                                  prj_trans_,
+                                  common_,
+                                  clipping_extent_,
+                                  filename,
+                                  *mark,
+                                  renderer_context);
+    }
 
     update_box();
 }
 
 void render_thunk_extractor::operator()(text_symbolizer const& sym) const
 {
-    auto helper = std::make_unique<text_symbolizer_helper>(sym,
-                                                           feature_,
-                                                           vars_,
-                                                           prj_trans_,
-                                                           common_.width_,
-                                                           common_.height_,
-                                                           common_.scale_factor_,
-                                                           common_.t_,
-                                                           common_.font_manager_,
-                                                           *common_.detector_,
-                                                           clipping_extent_,
-                                                           agg::trans_affine::identity);
-
-    extract_text_thunk(std::move(helper), sym);
+    text_symbolizer_helper helper(sym,
+                                  feature_,
+                                  vars_,
+                                  prj_trans_,
+                                  common_.width_,
+                                  common_.height_,
+                                  common_.scale_factor_,
+                                  common_.t_,
+                                  common_.font_manager_,
+                                  *common_.detector_,
+                                  clipping_extent_,
+                                  agg::trans_affine::identity);
+
+    extract_text_thunk(helper, sym);
 }
 
 void render_thunk_extractor::operator()(shield_symbolizer const& sym) const
 {
-    auto helper = std::make_unique<text_symbolizer_helper>(sym,
-                                                           feature_,
-                                                           vars_,
-                                                           prj_trans_,
-                                                           common_.width_,
-                                                           common_.height_,
-                                                           common_.scale_factor_,
-                                                           common_.t_,
-                                                           common_.font_manager_,
-                                                           *common_.detector_,
-                                                           clipping_extent_,
-                                                           agg::trans_affine::identity);
-
-    extract_text_thunk(std::move(helper), sym);
+    text_symbolizer_helper helper(sym,
+                                  feature_,
+                                  vars_,
+                                  prj_trans_,
+                                  common_.width_,
+                                  common_.height_,
+                                  common_.scale_factor_,
+                                  common_.t_,
+                                  common_.font_manager_,
+                                  *common_.detector_,
+                                  clipping_extent_,
+                                  agg::trans_affine::identity);
+
+    extract_text_thunk(helper, sym);
 }
 
-void render_thunk_extractor::extract_text_thunk(text_render_thunk::helper_ptr&& helper,
-                                                text_symbolizer const& sym) const
+void render_thunk_extractor::extract_text_thunk(text_symbolizer_helper& helper, text_symbolizer const& sym) const
 {
     double opacity = get<double>(sym, keys::opacity, feature_, common_.vars_, 1.0);
     composite_mode_e comp_op = get<composite_mode_e>(sym, keys::comp_op, feature_, common_.vars_, src_over);
     halo_rasterizer_enum halo_rasterizer = get<halo_rasterizer_enum>(sym,
-                                                                     keys::halo_rasterizer,
-                                                                     feature_,
-                                                                     common_.vars_,
-                                                                     halo_rasterizer_enum::HALO_RASTERIZER_FULL);
+                                                           keys::halo_rasterizer,
+                                                           feature_,
+                                                           common_.vars_,
+                                                           halo_rasterizer_enum::HALO_RASTERIZER_FULL);
 
-    text_render_thunk thunk(std::move(helper), opacity, comp_op, halo_rasterizer);
+    text_render_thunk thunk(helper, opacity, comp_op, halo_rasterizer);
     thunks_.emplace_back(std::move(thunk));
 
     update_box();
@@ -153,15 +168,15 @@ void render_thunk_extractor::update_box() const
 {
     label_collision_detector4& detector = *common_.detector_;
 
-    for (auto const& label : detector)
+    for (std::size_t i = 0; i < detector.size(); ++i)
     {
         if (box_.width() > 0 && box_.height() > 0)
         {
-            box_.expand_to_include(label.get().box);
+            box_.expand_to_include(detector.box(i));
         }
         else
         {
-            box_ = label.get().box;
+            box_ = detector.box(i);
         }
     }
 
@@ -0,0 +1,107 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+// mapnik
+#include <mapnik/solid_image_cache.hpp>
+
+namespace mapnik {
+
+template class singleton<solid_image_cache, CreateStatic>;
+
+solid_image_cache::solid_image_cache()
+    : images_()
+    , order_()
+    , capacity_(256)
+{}
+
+std::shared_ptr<std::string const> solid_image_cache::find(key const& k) const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    auto itr = images_.find(k);
+    return itr != images_.end() ? itr->second : nullptr;
+}
+
+std::shared_ptr<std::string const> solid_image_cache::insert(key const& k, std::string&& encoded)
+{
+    auto image = std::make_shared<std::string const>(std::move(encoded));
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    if (capacity_.load(std::memory_order_relaxed) == 0)
+    {
+        return image;
+    }
+    auto result = images_.emplace(k, image);
+    if (!result.second)
+    {
+        // encoded by another thread meanwhile
+        return result.first->second;
+    }
+    order_.push_back(k);
+    shrink();
+    return image;
+}
+
+void solid_image_cache::set_capacity(std::size_t capacity)
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    capacity_.store(capacity, std::memory_order_relaxed);
+    shrink();
+}
+
+std::size_t solid_image_cache::capacity() const
+{
+    return capacity_.load(std::memory_order_relaxed);
+}
+
+std::size_t solid_image_cache::size() const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    return images_.size();
+}
+
+void solid_image_cache::clear()
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    images_.clear();
+    order_.clear();
+}
+
+void solid_image_cache::shrink()
+{
+    while (order_.size() > capacity_.load(std::memory_order_relaxed))
+    {
+        images_.erase(order_.front());
+        order_.pop_front();
+    }
+}
+
+} // namespace mapnik
@@ -0,0 +1,485 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+// mapnik
+#include <mapnik/svg/svg_icon_pack.hpp>
+#include <mapnik/util/file_io.hpp>
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+#include <mapnik/mapped_memory_cache.hpp>
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+MAPNIK_DISABLE_WARNING_POP
+#endif
+
+// stl
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace mapnik {
+namespace svg {
+
+namespace {
+
+// Layout: header, gradient table, attribute table, icon records and, aligned
+// to 8 bytes, the vertex block. Numbers are stored in native byte order,
+// the byte order tag rejects packs written on a different architecture.
+constexpr char pack_magic[8] = {'M', 'N', 'K', 'I', 'C', 'O', 'N', 'S'};
+constexpr std::uint32_t pack_version = 1;
+constexpr std::uint32_t pack_byte_order = 0x01020304;
+
+static_assert(sizeof(vertex_f) == 3 * 4, "vertices are stored as two floats and a command");
+
+struct pack_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t gradient_count;
+    std::uint32_t attribute_count;
+    std::uint32_t icon_count;
+    std::uint32_t reserved;
+    std::uint64_t vertex_offset;
+    std::uint64_t vertex_count;
+};
+
+enum : std::uint8_t {
+    fill_flag = 1 << 0,
+    fill_none = 1 << 1,
+    stroke_flag = 1 << 2,
+    stroke_none = 1 << 3,
+    even_odd_flag = 1 << 4,
+    visibility_flag = 1 << 5,
+    display_flag = 1 << 6
+};
+
+// The smallest records, without gradient stops, dashes or a name, bound the
+// counts of the header by the size of the pack.
+constexpr std::size_t min_gradient_size = 2 + 6 * 8 + 5 * 8 + 4;
+constexpr std::size_t min_attributes_size = 2 * 4 + 6 * 8 + 5 * 8 + 2 * 4 + 3 + 4 + 8;
+constexpr std::size_t min_icon_size = 4 + 6 * 8 + 2 * 8 + 4;
+
+template<typename T>
+void write(std::string& out, T value)
+{
+    out.append(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+void write(std::string& out, agg::trans_affine const& tr)
+{
+    double m[6];
+    tr.store_to(m);
+    out.append(reinterpret_cast<char const*>(m), sizeof(m));
+}
+
+void write(std::string& out, color const& c)
+{
+    write(out, c.red());
+    write(out, c.green());
+    write(out, c.blue());
+    write(out, c.alpha());
+    write(out, std::uint8_t(c.get_premultiplied()));
+}
+
+class pack_reader
+{
+  public:
+    pack_reader(char const* data, std::size_t size)
+        : pos_(data)
+        , end_(data + size)
+    {}
+
+    template<typename T>
+    T read()
+    {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    agg::trans_affine read_transform()
+    {
+        double m[6];
+        std::memcpy(m, take(sizeof(m)), sizeof(m));
+        return agg::trans_affine(m);
+    }
+
+    // A byte holding one of the enumerators up to last.
+    template<typename E>
+    E read_enum(E last, char const* what)
+    {
+        auto value = read<std::uint8_t>();
+        if (value > last)
+        {
+            throw std::runtime_error(std::string("icon pack has an invalid ") + what);
+        }
+        return static_cast<E>(value);
+    }
+
+    color read_color()
+    {
+        auto r = read<std::uint8_t>();
+        auto g = read<std::uint8_t>();
+        auto b = read<std::uint8_t>();
+        auto a = read<std::uint8_t>();
+        return color(r, g, b, a, read<std::uint8_t>() != 0);
+    }
+
+    // Throws unless the rest of the pack can hold count records of at least
+    // record_size bytes.
+    void check_count(std::size_t count, std::size_t record_size) const
+    {
+        if (count > std::size_t(end_ - pos_) / record_size)
+        {
+            throw std::runtime_error("icon pack is truncated");
+        }
+    }
+
+    char const* take(std::size_t size)
+    {
+        if (size > std::size_t(end_ - pos_))
+        {
+            throw std::runtime_error("icon pack is truncated");
+        }
+        char const* result = pos_;
+        pos_ += size;
+        return result;
+    }
+
+  private:
+    char const* pos_;
+    char const* end_;
+};
+
+gradient read_gradient(pack_reader& reader)
+{
+    gradient grad;
+    grad.set_gradient_type(reader.read_enum(RADIAL, "gradient type"));
+    grad.set_units(reader.read_enum(OBJECT_BOUNDING_BOX, "gradient unit"));
+    grad.set_transform(reader.read_transform());
+    double x1 = reader.read<double>();
+    double y1 = reader.read<double>();
+    double x2 = reader.read<double>();
+    double y2 = reader.read<double>();
+    double r = reader.read<double>();
+    grad.set_control_points(x1, y1, x2, y2, r);
+    auto stops = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < stops; ++i)
+    {
+        double offset = reader.read<double>();
+        grad.add_stop(offset, reader.read_color());
+    }
+    return grad;
+}
+
+path_attributes read_attributes(pack_reader& reader, std::vector<gradient_ref> const& gradients)
+{
+    path_attributes attr;
+    auto fill = reader.read<std::uint32_t>();
+    auto stroke = reader.read<std::uint32_t>();
+    if (fill >= gradients.size() || stroke >= gradients.size())
+    {
+        throw std::runtime_error("icon pack references an unknown gradient");
+    }
+    attr.fill_gradient = gradients[fill];
+    attr.stroke_gradient = gradients[stroke];
+    attr.transform = reader.read_transform();
+    attr.opacity = reader.read<double>();
+    attr.fill_opacity = reader.read<double>();
+    attr.stroke_opacity = reader.read<double>();
+    attr.miter_limit = reader.read<double>();
+    attr.stroke_width = reader.read<double>();
+    for (auto* c : {&attr.fill_color, &attr.stroke_color})
+    {
+        c->r = reader.read<std::uint8_t>();
+        c->g = reader.read<std::uint8_t>();
+        c->b = reader.read<std::uint8_t>();
+        c->a = reader.read<std::uint8_t>();
+    }
+    attr.line_join = reader.read_enum(agg::miter_join_round, "line join");
+    attr.line_cap = reader.read_enum(agg::round_cap, "line cap");
+    auto flags = reader.read<std::uint8_t>();
+    attr.fill_flag = (flags & fill_flag) != 0;
+    attr.fill_none = (flags & fill_none) != 0;
+    attr.stroke_flag = (flags & stroke_flag) != 0;
+    attr.stroke_none = (flags & stroke_none) != 0;
+    attr.even_odd_flag = (flags & even_odd_flag) != 0;
+    attr.visibility_flag = (flags & visibility_flag) != 0;
+    attr.display_flag = (flags & display_flag) != 0;
+    auto dashes = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; i < dashes; ++i)
+    {
+        double dash = reader.read<double>();
+        attr.dash.emplace_back(dash, reader.read<double>());
+    }
+    attr.dash_offset = reader.read<double>();
+    return attr;
+}
+
+} // namespace
+
+icon_pack_writer::icon_pack_writer()
+    : icon_count_(0)
+{}
+
+std::uint32_t icon_pack_writer::add_gradient(gradient const& grad)
+{
+    std::string record;
+    write(record, std::uint8_t(grad.get_gradient_type()));
+    write(record, std::uint8_t(grad.get_units()));
+    write(record, grad.get_transform());
+    double x1, y1, x2, y2, r;
+    grad.get_control_points(x1, y1, x2, y2, r);
+    for (double v : {x1, y1, x2, y2, r})
+    {
+        write(record, v);
+    }
+    write(record, std::uint32_t(grad.get_stop_array().size()));
+    for (auto const& stop : grad.get_stop_array())
+    {
+        write(record, stop.first);
+        write(record, stop.second);
+    }
+    auto result = gradient_ids_.emplace(record, std::uint32_t(gradient_ids_.size()));
+    if (result.second)
+    {
+        gradients_ += record;
+    }
+    return result.first->second;
+}
+
+std::uint32_t icon_pack_writer::add_attributes(path_attributes const& attr)
+{
+    // everything but the index of the path, which is stored with the icon
+    std::string record;
+    write(record, add_gradient(attr.fill_gradient));
+    write(record, add_gradient(attr.stroke_gradient));
+    write(record, attr.transform);
+    for (double v : {attr.opacity, attr.fill_opacity, attr.stroke_opacity, attr.miter_limit, attr.stroke_width})
+    {
+        write(record, v);
+    }
+    for (auto const& c : {attr.fill_color, attr.stroke_color})
+    {
+        write(record, c.r);
+        write(record, c.g);
+        write(record, c.b);
+        write(record, c.a);
+    }
+    write(record, std::uint8_t(attr.line_join));
+    write(record, std::uint8_t(attr.line_cap));
+    write(record,
+          std::uint8_t((attr.fill_flag ? fill_flag : 0) | (attr.fill_none ? fill_none : 0) |
+                       (attr.stroke_flag ? stroke_flag : 0) | (attr.stroke_none ? stroke_none : 0) |
+                       (attr.even_odd_flag ? even_odd_flag : 0) | (attr.visibility_flag ? visibility_flag : 0) |
+                       (attr.display_flag ? display_flag : 0)));
+    write(record, std::uint32_t(attr.dash.size()));
+    for (auto const& dash : attr.dash)
+    {
+        write(record, dash.first);
+        write(record, dash.second);
+    }
+    write(record, attr.dash_offset);
+    auto result = attribute_ids_.emplace(record, std::uint32_t(attribute_ids_.size()));
+    if (result.second)
+    {
+        attributes_ += record;
+    }
+    return result.first->second;
+}
+
+void icon_pack_writer::add(std::string const& name, svg_storage_type const& icon)
+{
+    auto const& vertices = icon.source();
+    auto const& attributes = icon.attributes();
+    write(icons_, std::uint32_t(name.size()));
+    icons_ += name;
+    box2d<double> const& bbox = icon.bounding_box();
+    for (double v : {bbox.minx(), bbox.miny(), bbox.maxx(), bbox.maxy(), icon.width(), icon.height()})
+    {
+        write(icons_, v);
+    }
+    write(icons_, std::uint64_t(vertices_.size()));
+    write(icons_, std::uint64_t(vertices.size()));
+    write(icons_, std::uint32_t(attributes.size()));
+    for (auto const& attr : attributes)
+    {
+        write(icons_, add_attributes(attr));
+        write(icons_, std::uint32_t(attr.index));
+    }
+    vertices_.insert(vertices_.end(), vertices.data(), vertices.data() + vertices.size());
+    ++icon_count_;
+}
+
+std::string icon_pack_writer::data() const
+{
+    pack_header header;
+    std::memcpy(header.magic, pack_magic, sizeof(pack_magic));
+    header.version = pack_version;
+    header.byte_order = pack_byte_order;
+    header.gradient_count = std::uint32_t(gradient_ids_.size());
+    header.attribute_count = std::uint32_t(attribute_ids_.size());
+    header.icon_count = icon_count_;
+    header.reserved = 0;
+    std::size_t tables = sizeof(pack_header) + gradients_.size() + attributes_.size() + icons_.size();
+    header.vertex_offset = (tables + 7) & ~std::uint64_t(7);
+    header.vertex_count = vertices_.size();
+
+    std::string out;
+    out.reserve(header.vertex_offset + vertices_.size() * sizeof(vertex_f));
+    out.append(reinterpret_cast<char const*>(&header), sizeof(header));
+    out += gradients_;
+    out += attributes_;
+    out += icons_;
+    out.resize(header.vertex_offset, '\0');
+    out.append(reinterpret_cast<char const*>(vertices_.data()), vertices_.size() * sizeof(vertex_f));
+    return out;
+}
+
+void icon_pack_writer::save(std::string const& filename) const
+{
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        throw std::runtime_error("failed to open icon pack for writing: " + filename);
+    }
+    std::string const buffer = data();
+    file.write(buffer.data(), buffer.size());
+    if (!file)
+    {
+        throw std::runtime_error("failed to write icon pack: " + filename);
+    }
+}
+
+std::vector<icon_pack_entry> read_icon_pack(char const* data, std::size_t size, std::shared_ptr<void const> owner)
+{
+    pack_reader reader(data, size);
+    pack_header header;
+    std::memcpy(&header, reader.take(sizeof(pack_header)), sizeof(pack_header));
+    if (std::memcmp(header.magic, pack_magic, sizeof(pack_magic)) != 0)
+    {
+        throw std::runtime_error("not an icon pack");
+    }
+    if (header.version != pack_version || header.byte_order != pack_byte_order)
+    {
+        throw std::runtime_error("unsupported icon pack version or byte order");
+    }
+    if (header.vertex_offset % alignof(vertex_f) != 0 || header.vertex_offset > size ||
+        header.vertex_count > (size - header.vertex_offset) / sizeof(vertex_f))
+    {
+        throw std::runtime_error("icon pack vertices are out of bounds");
+    }
+    // vertices are used in place, which needs them to be aligned in memory
+    if (reinterpret_cast<std::uintptr_t>(data + header.vertex_offset) % alignof(vertex_f) != 0)
+    {
+        throw std::runtime_error("icon pack is not aligned");
+    }
+    vertex_f const* vertices = reinterpret_cast<vertex_f const*>(data + header.vertex_offset);
+
+    reader.check_count(header.gradient_count, min_gradient_size);
+    std::vector<gradient_ref> gradients;
+    gradients.reserve(header.gradient_count);
+    for (std::uint32_t i = 0; i < header.gradient_count; ++i)
+    {
+        gradients.emplace_back(read_gradient(reader));
+    }
+    reader.check_count(header.attribute_count, min_attributes_size);
+    std::vector<path_attributes> attributes;
+    attributes.reserve(header.attribute_count);
+    for (std::uint32_t i = 0; i < header.attribute_count; ++i)
+    {
+        attributes.push_back(read_attributes(reader, gradients));
+    }
+
+    reader.check_count(header.icon_count, min_icon_size);
+    std::vector<icon_pack_entry> icons;
+    icons.reserve(header.icon_count);
+    for (std::uint32_t i = 0; i < header.icon_count; ++i)
+    {
+        auto name_size = reader.read<std::uint32_t>();
+        std::string name(reader.take(name_size), name_size);
+        double minx = reader.read<double>();
+        double miny = reader.read<double>();
+        double maxx = reader.read<double>();
+        double maxy = reader.read<double>();
+        double width = reader.read<double>();
+        double height = reader.read<double>();
+        auto first = reader.read<std::uint64_t>();
+        auto count = reader.read<std::uint64_t>();
+        if (first > header.vertex_count || count > header.vertex_count - first)
+        {
+            throw std::runtime_error("icon pack vertices are out of bounds");
+        }
+        auto icon = std::make_shared<svg_storage_type>();
+        icon->source() = svg_path_storage(vertices + first, count, owner);
+        auto paths = reader.read<std::uint32_t>();
+        for (std::uint32_t j = 0; j < paths; ++j)
+        {
+            auto id = reader.read<std::uint32_t>();
+            auto index = reader.read<std::uint32_t>();
+            if (id >= attributes.size())
+            {
+                throw std::runtime_error("icon pack references unknown path attributes");
+            }
+            icon->attributes().emplace_back(attributes[id], index);
+        }
+        box2d<double> bbox;
+        if (minx <= maxx && miny <= maxy)
+        {
+            bbox.init(minx, miny, maxx, maxy);
+        }
+        icon->set_bounding_box(bbox);
+        icon->set_dimensions(width, height);
+        icons.emplace_back(std::move(name), std::move(icon));
+    }
+    return icons;
+}
+
+std::vector<icon_pack_entry> read_icon_pack(std::string const& filename)
+{
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+    boost::optional<mapped_region_ptr> region = mapped_memory_cache::instance().find(filename, false);
+    if (!region)
+    {
+        throw std::runtime_error("failed to map icon pack: " + filename);
+    }
+    return read_icon_pack(static_cast<char const*>((*region)->get_address()), (*region)->get_size(), *region);
+#else
+    mapnik::util::file file(filename);
+    if (!file)
+    {
+        throw std::runtime_error("failed to open icon pack: " + filename);
+    }
+    std::shared_ptr<char const> buffer(file.data().release(), std::default_delete<char const[]>());
+    if (!buffer)
+    {
+        throw std::runtime_error("failed to read icon pack: " + filename);
+    }
+    return read_icon_pack(buffer.get(), file.size(), buffer);
+#endif
+}
+
+} // namespace svg
+} // namespace mapnik
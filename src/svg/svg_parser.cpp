@@ -51,7 +51,8 @@ MAPNIK_DISABLE_WARNING_POP
 #include <stdexcept>
 #include <vector>
 #include <cstring>
-#include <fstream>
+#include <cstdio>
+#include <sstream>
 #include <array>
 
 namespace mapnik {
@@ -160,27 +161,6 @@ void handle_unsupported(svg_parser& parser, T const& ar, char const* name, char
     }
 }
 
-namespace grammar {
-
-namespace x3 = boost::spirit::x3;
-
-using color_lookup_type = std::vector<std::pair<double, agg::rgba8>>;
-using pairs_type = std::vector<std::pair<std::string, std::string>>;
-
-x3::rule<class key_value_sequence_ordered_tag, pairs_type> const
-  key_value_sequence_ordered("key_value_sequence_ordered");
-x3::rule<class key_value_tag, std::pair<std::string, std::string>> const key_value("key_value");
-x3::rule<class key_tag, std::string> const key("key");
-x3::rule<class value_tag, std::string> const value("value");
-
-auto const key_def = x3::char_("a-zA-Z_") > *x3::char_("a-zA-Z_0-9-");
-auto const value_def = +(x3::char_ - ';');
-auto const key_value_def = key > -(':' > value);
-auto const key_value_sequence_ordered_def = key_value % ';';
-
-BOOST_SPIRIT_DEFINE(key, value, key_value, key_value_sequence_ordered);
-
-} // namespace grammar
 } // namespace
 
 boost::property_tree::detail::rapidxml::xml_attribute<char> const* parse_id(svg_parser& parser,
@@ -244,8 +224,8 @@ template<typename T>
 double parse_svg_value(T& parser, char const* str, bool& is_percent)
 {
     namespace x3 = boost::spirit::x3;
+    static const css_unit_value units;
     double val = 0.0;
-    css_unit_value units;
     const char* cur = str; // phrase_parse mutates the first iterator
     const char* end = str + std::strlen(str);
     double font_size = parser.font_sizes_.back();
@@ -287,10 +267,10 @@ template<typename T>
 bool parse_font_size(T& parser, char const* str)
 {
     namespace x3 = boost::spirit::x3;
+    static const css_unit_value units;
+    static const css_absolute_size absolute;
+    static const css_relative_size relative;
     double val = 0.0;
-    css_unit_value units;
-    css_absolute_size absolute;
-    css_relative_size relative;
 
     std::size_t size = parser.font_sizes_.size();
     double parent_font_size = size > 1 ? parser.font_sizes_[size - 2] : 10.0;
@@ -394,10 +374,63 @@ std::pair<unsigned, bool> parse_preserve_aspect_ratio(T& err_handler, char const
     return preserve_aspect_ratio;
 }
 
-bool parse_style(char const* str, grammar::pairs_type& v)
+inline bool is_style_space(char c)
 {
-    namespace x3 = boost::spirit::x3;
-    return x3::phrase_parse(str, str + std::strlen(str), grammar::key_value_sequence_ordered, x3::space, v);
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool is_style_name_start(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+inline bool is_style_name(char c)
+{
+    return is_style_name_start(c) || (c >= '0' && c <= '9') || c == '-';
+}
+
+// Splits a `style` attribute into its declarations in a single pass and calls
+// visitor(name, value) for each of them. Whitespace is dropped from names and values,
+// a name without ':' has an empty value. The terminated names and values are written
+// to one scratch buffer instead of allocating a pair of strings per declaration.
+template<typename Visitor>
+void parse_style(char const* str, Visitor&& visitor)
+{
+    std::size_t len = std::strlen(str);
+    // every declaration takes at least one input character besides its ';'
+    // and adds two terminators
+    std::vector<char> buffer(2 * len + 2);
+    char* out = buffer.data();
+    char const* cur = str;
+    auto skip = [&cur] {
+        while (is_style_space(*cur))
+            ++cur;
+    };
+    for (;;)
+    {
+        skip();
+        if (!is_style_name_start(*cur))
+            break;
+        char const* name = out;
+        *out++ = *cur++;
+        for (skip(); is_style_name(*cur); skip())
+            *out++ = *cur++;
+        *out++ = 0;
+        char const* value = out;
+        if (*cur == ':')
+        {
+            ++cur;
+            for (skip(); *cur != 0 && *cur != ';'; skip())
+                *out++ = *cur++;
+            if (out == value)
+                break; // ':' without a value
+        }
+        *out++ = 0;
+        visitor(name, value);
+        if (*cur != ';')
+            break;
+        ++cur;
+    }
 }
 
 bool parse_id_from_url(char const* str, std::string& id)
@@ -869,14 +902,8 @@ void parse_attr(svg_parser& parser, rapidxml::xml_node<char> const* node)
         auto const* name = attr->name();
         if (std::strcmp(name, "style") == 0)
         {
-            using cont_type = std::vector<std::pair<std::string, std::string>>;
-            using value_type = cont_type::value_type;
-            cont_type vec;
-            parse_style(attr->value(), vec);
-            for (value_type kv : vec)
-            {
-                parse_attr(parser, kv.first.c_str(), kv.second.c_str());
-            }
+            parse_style(attr->value(),
+                        [&parser](char const* key, char const* value) { parse_attr(parser, key, value); });
         }
         else
         {
@@ -1426,22 +1453,16 @@ void parse_gradient_stop(svg_parser& parser, mapnik::gradient& gr, rapidxml::xml
     attr = node->first_attribute("style");
     if (attr != nullptr)
     {
-        using cont_type = std::vector<std::pair<std::string, std::string>>;
-        using value_type = cont_type::value_type;
-        cont_type vec;
-        parse_style(attr->value(), vec);
-
-        for (value_type kv : vec)
-        {
-            if (kv.first == "stop-color")
+        parse_style(attr->value(), [&](char const* key, char const* value) {
+            if (std::strcmp(key, "stop-color") == 0)
             {
-                stop_color = parse_color(parser.err_handler(), kv.second.c_str());
+                stop_color = parse_color(parser.err_handler(), value);
             }
-            else if (kv.first == "stop-opacity")
+            else if (std::strcmp(key, "stop-opacity") == 0)
             {
-                opacity = parse_double(parser.err_handler(), kv.second.c_str());
+                opacity = parse_double(parser.err_handler(), value);
             }
-        }
+        });
     }
 
     attr = node->first_attribute("stop-color");
@@ -1475,7 +1496,7 @@ bool parse_common_gradient(svg_parser& parser,
             std::string linkid(&value[1]); // FIXME !!!
             if (parser.gradient_map_.count(linkid))
             {
-                gr = parser.gradient_map_[linkid];
+                gr = parser.gradient_map_[linkid].get();
             }
             else
             {
@@ -1652,21 +1673,22 @@ svg_parser::~svg_parser() {}
 
 void svg_parser::parse(std::string const& filename)
 {
-#ifdef _WIN32
-    std::basic_ifstream<char> stream(mapnik::utf8_to_utf16(filename));
-#else
-    std::basic_ifstream<char> stream(filename.c_str());
-#endif
-    if (!stream)
+    mapnik::util::file file(filename);
+    if (!file)
     {
         std::stringstream ss;
         ss << "SVG error: unable to open \"" << filename << "\"";
         throw std::runtime_error(ss.str());
     }
 
-    stream.unsetf(std::ios::skipws);
-    std::vector<char> buffer(std::istreambuf_iterator<char>(stream.rdbuf()), std::istreambuf_iterator<char>());
-    buffer.push_back(0);
+    // read in one go, rapidxml parses the terminated buffer in place
+    std::vector<char> buffer(file.size() + 1, 0);
+    if (file.size() > 0 && std::fread(buffer.data(), file.size(), 1, file.get()) != 1)
+    {
+        std::stringstream ss;
+        ss << "SVG error: unable to read \"" << filename << "\"";
+        throw std::runtime_error(ss.str());
+    }
 
     const int flags = rapidxml::parse_trim_whitespace | rapidxml::parse_validate_closing_tags;
     rapidxml::xml_document<> doc;
@@ -1688,10 +1710,16 @@ void svg_parser::parse(std::string const& filename)
 }
 
 void svg_parser::parse_from_string(std::string const& svg)
+{
+    parse_from_buffer(svg.data(), svg.size());
+}
+
+void svg_parser::parse_from_buffer(char const* data, std::size_t size)
 {
     const int flags = rapidxml::parse_trim_whitespace | rapidxml::parse_validate_closing_tags;
     rapidxml::xml_document<> doc;
-    std::vector<char> buffer(svg.begin(), svg.end());
+    // rapidxml parses in place, the document needs its own terminated copy
+    std::vector<char> buffer(data, data + size);
     buffer.push_back(0);
     try
     {
@@ -1700,8 +1728,8 @@ void svg_parser::parse_from_string(std::string const& svg)
     catch (rapidxml::parse_error const& ex)
     {
         std::stringstream ss;
-        std::string str = (svg.length() > 1024) ? svg.substr(0, 1024) + "..." : svg;
-        ss << "SVG error: unable to parse \"" << str << "\"";
+        ss << "SVG error: unable to parse \"" << std::string(data, std::min(size, std::size_t(1024)))
+           << (size > 1024 ? "..." : "") << "\"";
         throw std::runtime_error(ss.str());
     }
     for (rapidxml::xml_node<char> const* child = doc.first_node(); child; child = child->next_sibling())
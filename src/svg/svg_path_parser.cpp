@@ -21,47 +21,337 @@
  *****************************************************************************/
 
 // mapnik
-
 #include <mapnik/svg/svg_path_parser.hpp>
-#include <mapnik/svg/svg_path_grammar_x3.hpp>
+#include <mapnik/util/math.hpp>
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <boost/spirit/home/x3/core/parse.hpp>
+#include <boost/spirit/home/x3/numeric/real.hpp>
+MAPNIK_DISABLE_WARNING_POP
+
 // stl
 #include <cstring>
-#include <string>
 
 namespace mapnik {
 namespace svg {
 
+namespace {
+
+// Single pass scanner for path data and point lists. Commands are handed to the
+// converter as soon as their arguments are read, without building any intermediate
+// attribute. It accepts the same language as the former X3 grammar: numbers are read
+// with x3::double_, whitespace is skipped between tokens, a comma may separate any two
+// arguments and a dangling comma at the end of an argument list is an error.
 template<typename PathType>
-bool parse_path(const char* wkt, PathType& p)
+class path_scanner
 {
-    using namespace boost::spirit;
-    using iterator_type = char const*;
-    iterator_type first = wkt;
-    iterator_type last = wkt + std::strlen(wkt);
-    bool relative = false;
-    using space_type = mapnik::svg::grammar::space_type;
-#if BOOST_VERSION >= 106700
-    auto const grammar = x3::with<mapnik::svg::grammar::svg_path_tag>(
-      p)[x3::with<mapnik::svg::grammar::relative_tag>(relative)[mapnik::svg::grammar::svg_path]];
-#else
-    auto const grammar = x3::with<mapnik::svg::grammar::svg_path_tag>(
-      std::ref(p))[x3::with<mapnik::svg::grammar::relative_tag>(std::ref(relative))[mapnik::svg::grammar::svg_path]];
-#endif
-    try
+  public:
+    path_scanner(char const* str, PathType& path)
+        : first_(str),
+          last_(str + std::strlen(str)),
+          path_(path)
+    {}
+
+    bool parse_path()
+    {
+        if (!move_to())
+            return false;
+        for (;;)
+        {
+            if (!drawto())
+                return false;
+            skip();
+            if (first_ == last_)
+                return true;
+            if (!move_to())
+                return false;
+        }
+    }
+
+    bool parse_points()
+    {
+        double x, y;
+        if (!coord(x, y))
+            return false;
+        path_.move_to(x, y, false);
+        for (;;)
+        {
+            char const* save = first_;
+            comma();
+            if (!coord(x, y))
+            {
+                if (failed_)
+                    return false;
+                first_ = save;
+                break;
+            }
+            path_.line_to(x, y, false);
+        }
+        skip();
+        return first_ == last_;
+    }
+
+  private:
+    static bool is_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+    void skip()
+    {
+        while (first_ != last_ && is_space(*first_))
+            ++first_;
+    }
+
+    void comma()
+    {
+        skip();
+        if (first_ != last_ && *first_ == ',')
+            ++first_;
+    }
+
+    bool number(double& value)
+    {
+        skip();
+        return boost::spirit::x3::parse(first_, last_, boost::spirit::x3::double_, value);
+    }
+
+    // single digit, non-zero is true
+    bool flag(bool& value)
+    {
+        skip();
+        if (first_ == last_ || *first_ < '0' || *first_ > '9')
+            return false;
+        value = *first_++ != '0';
+        return true;
+    }
+
+    // A missing first number ends an argument list, anything missing after it is an error.
+    bool coord(double& x, double& y)
+    {
+        if (!number(x))
+            return false;
+        comma();
+        return expect(number(y));
+    }
+
+    bool expect(bool ok)
+    {
+        failed_ = failed_ || !ok;
+        return ok;
+    }
+
+    bool command(char upper, bool& relative)
+    {
+        skip();
+        if (first_ == last_)
+            return false;
+        if (*first_ == upper)
+            relative = false;
+        else if (*first_ == upper + ('a' - 'A'))
+            relative = true;
+        else
+            return false;
+        ++first_;
+        return true;
+    }
+
+    bool move_to()
+    {
+        if (!command('M', relative_))
+            return false;
+        double x, y;
+        if (!expect(coord(x, y)))
+            return false;
+        path_.move_to(x, y, relative_);
+        for (;;)
+        {
+            char const* save = first_;
+            comma();
+            if (!coord(x, y))
+            {
+                if (failed_)
+                    return false;
+                first_ = save;
+                return true;
+            }
+            path_.line_to(x, y, relative_);
+        }
+    }
+
+    // Parses one or more argument groups separated by optional commas.
+    template<typename Group>
+    bool arguments(Group group)
     {
-        if (!x3::phrase_parse(first, last, grammar, space_type()) || first != last)
+        if (!expect(group()))
+            return false;
+        for (;;)
         {
-            throw std::runtime_error("Failed to parse svg-path");
+            char const* save = first_;
+            comma();
+            if (!group())
+            {
+                if (failed_)
+                    return false;
+                first_ = save;
+                return true;
+            }
         }
     }
-    catch (...)
+
+    // Parses drawto commands until the next moveto or the end of input.
+    bool drawto()
     {
-        return false;
+        for (;;)
+        {
+            skip();
+            if (first_ == last_)
+                return true;
+            char c = *first_;
+            bool ok = true;
+            switch (c)
+            {
+                case 'L':
+                case 'l':
+                    ok = command('L', relative_) && arguments([this] {
+                             double x, y;
+                             if (!coord(x, y))
+                                 return false;
+                             path_.line_to(x, y, relative_);
+                             return true;
+                         });
+                    break;
+                case 'H':
+                case 'h':
+                    ok = command('H', relative_) && arguments([this] {
+                             double x;
+                             if (!number(x))
+                                 return false;
+                             path_.hline_to(x, relative_);
+                             return true;
+                         });
+                    break;
+                case 'V':
+                case 'v':
+                    ok = command('V', relative_) && arguments([this] {
+                             double y;
+                             if (!number(y))
+                                 return false;
+                             path_.vline_to(y, relative_);
+                             return true;
+                         });
+                    break;
+                case 'C':
+                case 'c':
+                    ok = command('C', relative_) && arguments([this] {
+                             double x1, y1, x2, y2, x, y;
+                             if (!coord(x1, y1))
+                                 return false;
+                             comma();
+                             if (!expect(coord(x2, y2)))
+                                 return false;
+                             comma();
+                             if (!expect(coord(x, y)))
+                                 return false;
+                             path_.curve4(x1, y1, x2, y2, x, y, relative_);
+                             return true;
+                         });
+                    break;
+                case 'S':
+                case 's':
+                    ok = command('S', relative_) && arguments([this] {
+                             double x2, y2, x, y;
+                             if (!coord(x2, y2))
+                                 return false;
+                             comma();
+                             if (!expect(coord(x, y)))
+                                 return false;
+                             path_.curve4(x2, y2, x, y, relative_);
+                             return true;
+                         });
+                    break;
+                case 'Q':
+                case 'q':
+                    ok = command('Q', relative_) && arguments([this] {
+                             double x1, y1, x, y;
+                             if (!coord(x1, y1))
+                                 return false;
+                             comma();
+                             if (!expect(coord(x, y)))
+                                 return false;
+                             path_.curve3(x1, y1, x, y, relative_);
+                             return true;
+                         });
+                    break;
+                case 'T':
+                case 't':
+                    ok = command('T', relative_) && arguments([this] {
+                             double x, y;
+                             if (!coord(x, y))
+                                 return false;
+                             path_.curve3(x, y, relative_);
+                             return true;
+                         });
+                    break;
+                case 'A':
+                case 'a':
+                    ok = command('A', relative_) && arguments([this] {
+                             double rx, ry, angle, x, y;
+                             bool large_arc_flag, sweep_flag;
+                             if (!coord(rx, ry))
+                                 return false;
+                             comma();
+                             if (!expect(number(angle)))
+                                 return false;
+                             comma();
+                             if (!expect(flag(large_arc_flag)))
+                                 return false;
+                             comma();
+                             if (!expect(flag(sweep_flag)))
+                                 return false;
+                             comma();
+                             if (!expect(coord(x, y)))
+                                 return false;
+                             path_.arc_to(rx, ry, util::radians(angle), large_arc_flag, sweep_flag, x, y, relative_);
+                             return true;
+                         });
+                    break;
+                case 'Z':
+                case 'z':
+                    ++first_;
+                    path_.close_subpath();
+                    break;
+                default:
+                    // moveto or something the caller rejects
+                    return true;
+            }
+            if (!ok)
+                return false;
+        }
     }
-    return true;
+
+    char const* first_;
+    char const* const last_;
+    PathType& path_;
+    bool relative_ = false;
+    bool failed_ = false;
+};
+
+} // namespace
+
+template<typename PathType>
+bool parse_path(const char* wkt, PathType& p)
+{
+    return path_scanner<PathType>(wkt, p).parse_path();
+}
+
+template<typename PathType>
+bool parse_points(const char* wkt, PathType& p)
+{
+    return path_scanner<PathType>(wkt, p).parse_points();
 }
 
 template bool MAPNIK_DECL parse_path<svg_converter_type>(const char*, svg_converter_type&);
+template bool parse_points<svg_converter_type>(const char*, svg_converter_type&);
 
 } // namespace svg
 } // namespace mapnik
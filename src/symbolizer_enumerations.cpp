@@ -106,13 +106,22 @@ IMPLEMENT_ENUM(pattern_alignment_e, pattern_alignment_enum)
 
 // text
 using halo_rasterizer_e_str = detail::EnumStringT<halo_rasterizer_enum>;
-constexpr detail::EnumMapT<halo_rasterizer_enum, 3> halo_rasterizer_e_map{{
+constexpr detail::EnumMapT<halo_rasterizer_enum, 4> halo_rasterizer_e_map{{
   halo_rasterizer_e_str{halo_rasterizer_enum::HALO_RASTERIZER_FULL, "full"},
   halo_rasterizer_e_str{halo_rasterizer_enum::HALO_RASTERIZER_FAST, "fast"},
+  halo_rasterizer_e_str{halo_rasterizer_enum::HALO_RASTERIZER_SDF, "sdf"},
   halo_rasterizer_e_str{halo_rasterizer_enum::halo_rasterizer_enum_MAX, ""},
 }};
 IMPLEMENT_ENUM(halo_rasterizer_e, halo_rasterizer_enum)
 
+using marker_rasterizer_e_str = detail::EnumStringT<marker_rasterizer_enum>;
+constexpr detail::EnumMapT<marker_rasterizer_enum, 3> marker_rasterizer_e_map{{
+  marker_rasterizer_e_str{marker_rasterizer_enum::MARKER_RASTERIZER_FULL, "full"},
+  marker_rasterizer_e_str{marker_rasterizer_enum::MARKER_RASTERIZER_SPRITE, "sprite"},
+  marker_rasterizer_e_str{marker_rasterizer_enum::marker_rasterizer_enum_MAX, ""},
+}};
+IMPLEMENT_ENUM(marker_rasterizer_e, marker_rasterizer_enum)
+
 using label_placement_e_str = detail::EnumStringT<label_placement_enum>;
 constexpr detail::EnumMapT<label_placement_enum, 8> label_placement_e_map{{
   label_placement_e_str{label_placement_enum::POINT_PLACEMENT, "point"},
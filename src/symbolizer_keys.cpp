@@ -151,6 +151,11 @@ static const property_meta_type key_meta[const_max_key] = {
   property_meta_type{"line-pattern",
                      [](enumeration_wrapper e) { return line_pattern_e(line_pattern_enum(e.value)).as_string(); },
                      property_types::target_line_pattern},
+  property_meta_type{"priority", nullptr, property_types::target_double},
+  property_meta_type{
+    "marker-rasterizer",
+    [](enumeration_wrapper e) { return marker_rasterizer_e(marker_rasterizer_enum(e.value)).as_string(); },
+    property_types::target_marker_rasterizer},
 
 };
 
@@ -36,8 +36,9 @@ MAPNIK_DISABLE_WARNING_POP
 
 namespace mapnik {
 
-font_face::font_face(FT_Face face)
+font_face::font_face(FT_Face face, std::string const& file_name)
     : face_(face)
+    , file_name_(file_name)
     , color_font_(init_color_font())
 {}
 
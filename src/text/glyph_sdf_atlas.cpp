@@ -0,0 +1,375 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/text/glyph_sdf_atlas.hpp>
+#include <mapnik/text/face.hpp>
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+extern "C" {
+#include FT_OUTLINE_H
+}
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace mapnik {
+
+template class singleton<glyph_sdf_atlas, CreateStatic>;
+
+namespace {
+
+// Fields are padded by this many texels, which bounds the distances they hold.
+constexpr int sdf_padding = 24;
+// Fields have at least two texels per pixel of text, so that stems thinner than a pixel
+// survive interpolation, and at least this size.
+constexpr double sdf_min_size = 32.0;
+// Larger text is scaled up from fields of this size.
+constexpr int sdf_max_index = 4; // 128 pixels
+
+int size_class_index(double size)
+{
+    double field_size = 2.0 * size;
+    if (field_size <= sdf_min_size)
+        return 0;
+    int index = static_cast<int>(std::ceil(2.0 * std::log2(field_size / sdf_min_size) - 1e-9));
+    return std::min(index, sdf_max_index);
+}
+
+double class_size(int index)
+{
+    return sdf_min_size * std::pow(2.0, 0.5 * index);
+}
+
+// Outline of a glyph flattened to line segments, in pixels with y pointing up.
+struct flat_outline
+{
+    struct segment
+    {
+        double x0, y0, x1, y1;
+    };
+
+    void line_to(double x, double y)
+    {
+        segments.push_back(segment{x_, y_, x, y});
+        x_ = x;
+        y_ = y;
+    }
+
+    std::vector<segment> segments;
+    double x_ = 0.0;
+    double y_ = 0.0;
+};
+
+// Curves are flattened until the chords deviate less than this from them, in pixels.
+constexpr double sdf_flatness = 0.02;
+
+int move_to(FT_Vector const* to, void* user)
+{
+    auto* outline = static_cast<flat_outline*>(user);
+    outline->x_ = to->x / 64.0;
+    outline->y_ = to->y / 64.0;
+    return 0;
+}
+
+int line_to(FT_Vector const* to, void* user)
+{
+    static_cast<flat_outline*>(user)->line_to(to->x / 64.0, to->y / 64.0);
+    return 0;
+}
+
+int conic_to(FT_Vector const* control, FT_Vector const* to, void* user)
+{
+    auto* outline = static_cast<flat_outline*>(user);
+    double x0 = outline->x_;
+    double y0 = outline->y_;
+    double cx = control->x / 64.0;
+    double cy = control->y / 64.0;
+    double x1 = to->x / 64.0;
+    double y1 = to->y / 64.0;
+    double dev = std::hypot(x0 - 2 * cx + x1, y0 - 2 * cy + y1);
+    int steps = std::max(1, static_cast<int>(std::ceil(std::sqrt(dev / (8 * sdf_flatness)))));
+    for (int i = 1; i <= steps; ++i)
+    {
+        double t = static_cast<double>(i) / steps;
+        double mt = 1.0 - t;
+        outline->line_to(mt * mt * x0 + 2 * mt * t * cx + t * t * x1, mt * mt * y0 + 2 * mt * t * cy + t * t * y1);
+    }
+    return 0;
+}
+
+int cubic_to(FT_Vector const* control1, FT_Vector const* control2, FT_Vector const* to, void* user)
+{
+    auto* outline = static_cast<flat_outline*>(user);
+    double x0 = outline->x_;
+    double y0 = outline->y_;
+    double c1x = control1->x / 64.0;
+    double c1y = control1->y / 64.0;
+    double c2x = control2->x / 64.0;
+    double c2y = control2->y / 64.0;
+    double x1 = to->x / 64.0;
+    double y1 = to->y / 64.0;
+    double dev = std::max(std::hypot(x0 - 2 * c1x + c2x, y0 - 2 * c1y + c2y),
+                          std::hypot(c1x - 2 * c2x + x1, c1y - 2 * c2y + y1));
+    int steps = std::max(1, static_cast<int>(std::ceil(std::sqrt(0.75 * dev / sdf_flatness))));
+    for (int i = 1; i <= steps; ++i)
+    {
+        double t = static_cast<double>(i) / steps;
+        double mt = 1.0 - t;
+        double a = mt * mt * mt;
+        double b = 3 * mt * mt * t;
+        double c = 3 * mt * t * t;
+        double d = t * t * t;
+        outline->line_to(a * x0 + b * c1x + c * c2x + d * x1, a * y0 + b * c1y + c * c2y + d * y1);
+    }
+    return 0;
+}
+
+std::shared_ptr<glyph_sdf const> generate_sdf(font_face& face, unsigned glyph_index, double size)
+{
+    FT_Face ft_face = face.get_face();
+    if (face.is_color() || !FT_IS_SCALABLE(ft_face) || !face.set_character_sizes(size))
+        return nullptr;
+    FT_Set_Transform(ft_face, nullptr, nullptr);
+    if (FT_Load_Glyph(ft_face, glyph_index, FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING) != 0 ||
+        ft_face->glyph->format != FT_GLYPH_FORMAT_OUTLINE)
+        return nullptr;
+    FT_Outline& ft_outline = ft_face->glyph->outline;
+
+    auto sdf = std::make_shared<glyph_sdf>();
+    sdf->size = size;
+    sdf->width = 0;
+    sdf->height = 0;
+    sdf->left = 0;
+    sdf->top = 0;
+
+    flat_outline outline;
+    FT_Outline_Funcs funcs;
+    funcs.move_to = move_to;
+    funcs.line_to = line_to;
+    funcs.conic_to = conic_to;
+    funcs.cubic_to = cubic_to;
+    funcs.shift = 0;
+    funcs.delta = 0;
+    if (FT_Outline_Decompose(&ft_outline, &funcs, &outline) != 0)
+        return nullptr;
+    if (outline.segments.empty())
+        return sdf; // blank glyph, e.g. a space
+
+    FT_BBox cbox;
+    FT_Outline_Get_CBox(&ft_outline, &cbox);
+    int x_min = static_cast<int>(std::floor(cbox.xMin / 64.0));
+    int y_max = static_cast<int>(std::ceil(cbox.yMax / 64.0));
+    int width = static_cast<int>(std::ceil(cbox.xMax / 64.0)) - x_min + 2 * sdf_padding;
+    int height = y_max - static_cast<int>(std::floor(cbox.yMin / 64.0)) + 2 * sdf_padding;
+    sdf->width = static_cast<unsigned>(width);
+    sdf->height = static_cast<unsigned>(height);
+    sdf->left = x_min - sdf_padding;
+    sdf->top = y_max + sdf_padding;
+
+    // Squared distance of every texel center to the closest segment. Segments only
+    // affect texels within the padding, farther distances aren't needed.
+    double const far = 4.0 * sdf_padding * sdf_padding;
+    std::vector<double> dist2(static_cast<std::size_t>(width) * height, far);
+    for (auto const& seg : outline.segments)
+    {
+        double dx = seg.x1 - seg.x0;
+        double dy = seg.y1 - seg.y0;
+        double len2 = dx * dx + dy * dy;
+        int u0 = std::max(0, static_cast<int>(std::floor(std::min(seg.x0, seg.x1) - sdf_padding - sdf->left)));
+        int u1 = std::min(width, static_cast<int>(std::ceil(std::max(seg.x0, seg.x1) + sdf_padding - sdf->left)));
+        int v0 = std::max(0, static_cast<int>(std::floor(sdf->top - std::max(seg.y0, seg.y1) - sdf_padding)));
+        int v1 = std::min(height, static_cast<int>(std::ceil(sdf->top - std::min(seg.y0, seg.y1) + sdf_padding)));
+        for (int v = v0; v < v1; ++v)
+        {
+            double py = sdf->top - v - 0.5;
+            for (int u = u0; u < u1; ++u)
+            {
+                double px = sdf->left + u + 0.5;
+                double t = len2 > 0.0 ? ((px - seg.x0) * dx + (py - seg.y0) * dy) / len2 : 0.0;
+                t = std::min(1.0, std::max(0.0, t));
+                double ex = seg.x0 + t * dx - px;
+                double ey = seg.y0 + t * dy - py;
+                double& d2 = dist2[static_cast<std::size_t>(v) * width + u];
+                d2 = std::min(d2, ex * ex + ey * ey);
+            }
+        }
+    }
+
+    // Inside test along each texel row, with the fill rule of the outline.
+    bool even_odd = (ft_outline.flags & FT_OUTLINE_EVEN_ODD_FILL) != 0;
+    std::vector<std::pair<double, int>> crossings;
+    sdf->data.resize(dist2.size());
+    for (int v = 0; v < height; ++v)
+    {
+        double py = sdf->top - v - 0.5;
+        crossings.clear();
+        for (auto const& seg : outline.segments)
+        {
+            if ((seg.y0 <= py && seg.y1 > py) || (seg.y1 <= py && seg.y0 > py))
+            {
+                double x = seg.x0 + (py - seg.y0) * (seg.x1 - seg.x0) / (seg.y1 - seg.y0);
+                crossings.emplace_back(x, seg.y1 > seg.y0 ? 1 : -1);
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        auto crossing = crossings.begin();
+        int winding = 0;
+        for (int u = 0; u < width; ++u)
+        {
+            double px = sdf->left + u + 0.5;
+            for (; crossing != crossings.end() && crossing->first < px; ++crossing)
+            {
+                winding += crossing->second;
+            }
+            bool inside = even_odd ? (winding & 1) != 0 : winding != 0;
+            std::size_t i = static_cast<std::size_t>(v) * width + u;
+            double d = std::sqrt(dist2[i]);
+            sdf->data[i] = static_cast<float>(inside ? -d : d);
+        }
+    }
+    return sdf;
+}
+
+} // namespace
+
+double glyph_sdf::distance(double x, double y) const
+{
+    if (width == 0 || height == 0)
+        return std::numeric_limits<double>::max();
+    // texel centers are at half integer coordinates
+    double fx = x - 0.5;
+    double fy = y - 0.5;
+    double cx = std::min(std::max(fx, 0.0), width - 1.0);
+    double cy = std::min(std::max(fy, 0.0), height - 1.0);
+    double outside = std::hypot(fx - cx, fy - cy);
+    unsigned x0 = static_cast<unsigned>(cx);
+    unsigned y0 = static_cast<unsigned>(cy);
+    unsigned x1 = std::min(x0 + 1, width - 1);
+    unsigned y1 = std::min(y0 + 1, height - 1);
+    double tx = cx - x0;
+    double ty = cy - y0;
+    double d0 = data[y0 * width + x0] * (1.0 - tx) + data[y0 * width + x1] * tx;
+    double d1 = data[y1 * width + x0] * (1.0 - tx) + data[y1 * width + x1] * tx;
+    return d0 * (1.0 - ty) + d1 * ty + outside;
+}
+
+glyph_sdf_atlas::glyph_sdf_atlas()
+    : files_()
+    , fields_()
+    , order_()
+    , capacity_(16384)
+{}
+
+double glyph_sdf_atlas::size_class(double size)
+{
+    return class_size(size_class_index(size));
+}
+
+double glyph_sdf_atlas::max_distance(double size)
+{
+    return sdf_padding * size / size_class(size);
+}
+
+std::shared_ptr<glyph_sdf const> glyph_sdf_atlas::get(font_face& face, unsigned glyph_index, double size)
+{
+    int index = size_class_index(size);
+    key k{0, face.face_index(), glyph_index, index};
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        auto file = files_.find(face.file_name());
+        if (file == files_.end())
+            file = files_.emplace(face.file_name(), files_.size()).first;
+        k.file = file->second;
+        auto itr = fields_.find(k);
+        if (itr != fields_.end())
+            return itr->second;
+    }
+    // The face belongs to the calling renderer, other threads keep using the
+    // atlas while the field is generated.
+    std::shared_ptr<glyph_sdf const> sdf = generate_sdf(face, glyph_index, class_size(index));
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    if (capacity_ == 0)
+        return sdf;
+    auto result = fields_.emplace(k, sdf);
+    if (result.second)
+    {
+        order_.push_back(k);
+        shrink();
+    }
+    return result.first->second;
+}
+
+void glyph_sdf_atlas::shrink()
+{
+    while (order_.size() > capacity_)
+    {
+        fields_.erase(order_.front());
+        order_.pop_front();
+    }
+}
+
+void glyph_sdf_atlas::set_capacity(std::size_t capacity)
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    capacity_ = capacity;
+    shrink();
+}
+
+std::size_t glyph_sdf_atlas::capacity() const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    return capacity_;
+}
+
+std::size_t glyph_sdf_atlas::size() const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    return fields_.size();
+}
+
+void glyph_sdf_atlas::clear()
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    fields_.clear();
+    order_.clear();
+}
+
+} // namespace mapnik
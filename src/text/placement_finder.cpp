@@ -32,6 +32,7 @@
 #include <mapnik/text/glyph_positions.hpp>
 #include <mapnik/vertex_cache.hpp>
 #include <mapnik/util/math.hpp>
+#include <mapnik/tolerance_iterator.hpp>
 
 // stl
 #include <vector>
@@ -88,6 +89,7 @@ placement_finder::placement_finder(feature_impl const& feature,
     , extent_(extent)
     , info_(placement_info)
     , text_props_(evaluate_text_properties(info_.properties, feature_, attr_))
+    , repeat_key_(DetectorType::no_text)
     , scale_factor_(scale_factor)
     , font_manager_(font_manager)
     , placements_()
@@ -101,6 +103,16 @@ placement_finder::placement_finder(feature_impl const& feature,
 {}
 
 bool placement_finder::next_position()
+{
+    if (prepare_position())
+    {
+        layout_position();
+        return true;
+    }
+    return false;
+}
+
+bool placement_finder::prepare_position()
 {
     if (info_.next())
     {
@@ -124,15 +136,28 @@ bool placement_finder::next_position()
             layouts_.clear();
         // Note: multiple layouts_ may result from this add() call
         layouts_.add(layout);
-        layouts_.layout();
-        // cache a few values for use elsewhere in placement finder
-        move_dx_ = layout->displacement().x;
-        horizontal_alignment_ = layout->horizontal_alignment();
+        // interned on first use, see intern_repeat_key()
+        repeat_key_ = DetectorType::no_text;
         return true;
     }
     return false;
 }
 
+void placement_finder::layout_position(face_manager_freetype& font_manager)
+{
+    layouts_.layout(font_manager);
+    // cache a few values for use elsewhere in placement finder
+    text_layout_ptr const& layout = *layouts_.begin();
+    move_dx_ = layout->displacement().x;
+    horizontal_alignment_ = layout->horizontal_alignment();
+}
+
+void placement_finder::intern_repeat_key()
+{
+    if (repeat_key_ == DetectorType::no_text)
+        repeat_key_ = detector_.intern(layouts_.text());
+}
+
 text_upright_e placement_finder::simplify_upright(text_upright_e upright, double angle) const
 {
     if (upright == text_upright_enum::UPRIGHT_AUTO)
@@ -158,6 +183,7 @@ text_upright_e placement_finder::simplify_upright(text_upright_e upright, double
 
 bool placement_finder::find_point_placement(pixel_position const& pos)
 {
+    intern_repeat_key();
     glyph_positions_ptr glyphs = std::make_unique<glyph_positions>();
     std::vector<box2d<double>> bboxes;
 
@@ -183,7 +209,7 @@ bool placement_finder::find_point_placement(pixel_position const& pos)
         bbox.re_center(layout_center.x, layout_center.y);
 
         /* For point placements it is faster to just check the bounding box. */
-        if (collision(bbox, layouts_.text(), false))
+        if (collision(bbox, repeat_key_, false))
             return false;
 
         if (layout.glyphs_count())
@@ -238,8 +264,8 @@ bool placement_finder::find_point_placement(pixel_position const& pos)
         {
             label_box.expand_to_include(box);
         }
-        detector_.insert(box, layouts_.text());
     }
+    detector_.insert(bboxes, repeat_key_);
     // do not render text off the canvas
     if (extent_.intersects(label_box))
     {
@@ -249,6 +275,75 @@ bool placement_finder::find_point_placement(pixel_position const& pos)
     return true;
 }
 
+bool placement_finder::find_line_placements(vertex_cache& pp, bool points)
+{
+    if (!layouts_.line_count())
+        return true; // TODO
+    intern_repeat_key();
+    // the path may be shared with other symbolizers, start from its beginning
+    pp.reset();
+
+    bool success = false;
+    while (pp.next_subpath())
+    {
+        if (points)
+        {
+            if (pp.length() <= 0.001)
+            {
+                success = find_point_placement(pp.current_position()) || success;
+                continue;
+            }
+        }
+        else
+        {
+            if ((pp.length() < text_props_->minimum_path_length * scale_factor_) ||
+                (pp.length() <= 0.001) // Clipping removed whole geometry
+                || (pp.length() < layouts_.width()))
+            {
+                continue;
+            }
+        }
+
+        double spacing = get_spacing(pp.length(), points ? 0. : layouts_.width());
+
+        // horizontal_alignment_e halign = layouts_.back()->horizontal_alignment();
+
+        // halign == H_LEFT -> don't move
+        if (horizontal_alignment_ == horizontal_alignment_enum::H_MIDDLE ||
+            horizontal_alignment_ == horizontal_alignment_enum::H_AUTO ||
+            horizontal_alignment_ == horizontal_alignment_enum::H_ADJUST)
+        {
+            if (!pp.forward(spacing / 2.0))
+                continue;
+        }
+        else if (horizontal_alignment_ == horizontal_alignment_enum::H_RIGHT)
+        {
+            if (!pp.forward(pp.length()))
+                continue;
+        }
+
+        if (move_dx_ != 0.0)
+            path_move_dx(pp, move_dx_);
+
+        do
+        {
+            tolerance_iterator tolerance_offset(text_props_->label_position_tolerance * scale_factor_,
+                                                spacing); // TODO: Handle halign
+            while (tolerance_offset.next())
+            {
+                vertex_cache::scoped_state state(pp);
+                if (pp.move(tolerance_offset.get()) && ((points && find_point_placement(pp.current_position())) ||
+                                                        (!points && single_line_placement(pp, text_props_->upright))))
+                {
+                    success = true;
+                    break;
+                }
+            }
+        } while (pp.forward(spacing));
+    }
+    return success;
+}
+
 bool placement_finder::single_line_placement(vertex_cache& pp, text_upright_e orientation)
 {
     //
@@ -359,7 +454,7 @@ bool placement_finder::single_line_placement(vertex_cache& pp, text_upright_e or
                 cluster_offset.y -= rot.sin * glyph.advance();
 
                 box2d<double> bbox = get_bbox(layout, glyph, pos, rot);
-                if (collision(bbox, layouts_.text(), true))
+                if (collision(bbox, repeat_key_, true))
                     return false;
                 bboxes.push_back(std::move(bbox));
                 glyphs->emplace_back(glyph, pos, rot);
@@ -410,8 +505,8 @@ bool placement_finder::single_line_placement(vertex_cache& pp, text_upright_e or
         {
             label_box.expand_to_include(box);
         }
-        detector_.insert(box, layouts_.text());
     }
+    detector_.insert(bboxes, repeat_key_);
     // do not render text off the canvas
     if (extent_.intersects(label_box))
     {
@@ -443,8 +538,8 @@ double placement_finder::get_spacing(double path_length, double layout_width) co
     return path_length / num_labels;
 }
 
-bool placement_finder::collision(const box2d<double>& box,
-                                 const value_unicode_string& repeat_key,
+bool placement_finder::collision(box2d<double> const& box,
+                                 DetectorType::text_id repeat_key,
                                  bool line_placement) const
 {
     double margin, repeat_distance;
@@ -464,8 +559,7 @@ bool placement_finder::collision(const box2d<double>& box,
            (text_props_->minimum_padding > 0 &&
             !extent_.contains(box + (scale_factor_ * text_props_->minimum_padding))) ||
            (!text_props_->allow_overlap &&
-            ((repeat_key.length() == 0 && !detector_.has_placement(box, margin)) ||
-             (repeat_key.length() > 0 && !detector_.has_placement(box, margin, repeat_key, repeat_distance))));
+            !detector_.has_placement(box, margin, repeat_key, repeat_distance));
 }
 
 void placement_finder::set_marker(marker_info_ptr m,
@@ -487,7 +581,7 @@ bool placement_finder::add_marker(glyph_positions_ptr& glyphs,
     pixel_position real_pos = (marker_unlocked_ ? pos : glyphs->get_base_point()) + marker_displacement_;
     box2d<double> bbox = marker_box_;
     bbox.move(real_pos.x, real_pos.y);
-    if (collision(bbox, layouts_.text(), false))
+    if (collision(bbox, repeat_key_, false))
         return false;
     detector_.insert(bbox);
     bboxes.push_back(std::move(bbox));
@@ -28,10 +28,16 @@
 #include <mapnik/image_compositing.hpp>
 #include <mapnik/image_scaling.hpp>
 #include <mapnik/text/face.hpp>
+#include <mapnik/text/glyph_sdf_atlas.hpp>
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_any.hpp>
 #include <mapnik/agg_rasterizer.hpp>
 
+// stl
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace mapnik {
 
 text_renderer::text_renderer(halo_rasterizer_e rasterizer,
@@ -161,6 +167,8 @@ agg_text_renderer<T>::agg_text_renderer(pixmap_type& pixmap,
 template<typename T>
 void agg_text_renderer<T>::render(glyph_positions const& pos)
 {
+    if (rasterizer_ == halo_rasterizer_enum::HALO_RASTERIZER_SDF && render_sdf(pos))
+        return;
     prepare_glyphs(pos);
     FT_Error error;
     FT_Vector start;
@@ -209,7 +217,7 @@ void agg_text_renderer<T>::render(glyph_positions const& pos)
         if (!error)
         {
             FT_Glyph_Transform(g, &halo_matrix, &start_halo);
-            if (rasterizer_ == halo_rasterizer_enum::HALO_RASTERIZER_FULL)
+            if (rasterizer_ != halo_rasterizer_enum::HALO_RASTERIZER_FAST)
             {
                 stroker_->init(halo_radius);
                 FT_Glyph_Stroke(&g, stroker_->get(), 1);
@@ -302,6 +310,166 @@ void agg_text_renderer<T>::render(glyph_positions const& pos)
     }
 }
 
+namespace detail {
+
+struct sdf_glyph
+{
+    std::shared_ptr<glyph_sdf const> sdf;
+    detail::evaluated_format_properties const* properties;
+    // texel coordinates to glyph coordinates in pixels, y up, relative to the base point
+    agg::trans_affine mtx;
+    // distance scale from field texels to pixels
+    double scale;
+};
+
+// Coverage of pixel (x, y) by the area within threshold of the glyph outline.
+inline double sdf_coverage(glyph_sdf const& sdf,
+                           agg::trans_affine const& inv,
+                           int x,
+                           int y,
+                           double scale,
+                           double threshold)
+{
+    double u = x + 0.5;
+    double v = y + 0.5;
+    inv.transform(&u, &v);
+    double d = sdf.distance(u, v) * scale - threshold;
+    // a pixel whose center is this far from the contour is entirely on one side
+    if (d >= 0.75)
+        return 0.0;
+    if (d <= -0.75)
+        return 1.0;
+    // Edge pixel: average 4x4 sub-pixels, which keeps stems thinner than a pixel.
+    double sum = 0.0;
+    for (int j = 0; j < 4; ++j)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            double su = x + (i + 0.5) * 0.25;
+            double sv = y + (j + 0.5) * 0.25;
+            inv.transform(&su, &sv);
+            double sd = sdf.distance(su, sv) * scale - threshold;
+            sum += std::min(1.0, std::max(0.0, 0.5 - 4.0 * sd));
+        }
+    }
+    return sum / 16.0;
+}
+
+template<typename T>
+void composite_sdf(T& pixmap,
+                   glyph_sdf const& sdf,
+                   agg::trans_affine const& mtx,
+                   double scale,
+                   double threshold,
+                   unsigned rgba,
+                   double opacity,
+                   composite_mode_e comp_op)
+{
+    // bounding box of the field in image coordinates
+    double xs[4] = {0.0, static_cast<double>(sdf.width), static_cast<double>(sdf.width), 0.0};
+    double ys[4] = {0.0, 0.0, static_cast<double>(sdf.height), static_cast<double>(sdf.height)};
+    double minx = std::numeric_limits<double>::max();
+    double miny = minx;
+    double maxx = -minx;
+    double maxy = -minx;
+    for (int i = 0; i < 4; ++i)
+    {
+        mtx.transform(&xs[i], &ys[i]);
+        minx = std::min(minx, xs[i]);
+        miny = std::min(miny, ys[i]);
+        maxx = std::max(maxx, xs[i]);
+        maxy = std::max(maxy, ys[i]);
+    }
+    int x0 = std::max(0, static_cast<int>(std::floor(minx)));
+    int y0 = std::max(0, static_cast<int>(std::floor(miny)));
+    int x1 = std::min(static_cast<int>(pixmap.width()), static_cast<int>(std::ceil(maxx)));
+    int y1 = std::min(static_cast<int>(pixmap.height()), static_cast<int>(std::ceil(maxy)));
+    agg::trans_affine inv(mtx);
+    inv.invert();
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; ++x)
+        {
+            double cover = sdf_coverage(sdf, inv, x, y, scale, threshold);
+            unsigned gray = static_cast<unsigned>(cover * 255.0 + 0.5);
+            if (gray)
+            {
+                mapnik::composite_pixel(pixmap, comp_op, x, y, rgba, gray, opacity);
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+template<typename T>
+bool agg_text_renderer<T>::render_sdf(glyph_positions const& pos)
+{
+    glyph_sdf_atlas& atlas = glyph_sdf_atlas::instance();
+    std::vector<detail::sdf_glyph> glyphs;
+    glyphs.reserve(pos.size());
+    double const text_scale = std::sqrt(std::abs(transform_.determinant()));
+    double const halo_scale = std::sqrt(std::abs(halo_transform_.determinant()));
+    for (auto const& glyph_pos : pos)
+    {
+        glyph_info const& glyph = glyph_pos.glyph;
+        double size = glyph.format->text_size * scale_factor_;
+        double halo_radius = glyph.format->halo_radius * scale_factor_;
+        if (halo_radius > 0.0 && (halo_radius + 1.0) > glyph_sdf_atlas::max_distance(size) * halo_scale)
+            return false;
+        std::shared_ptr<glyph_sdf const> sdf = atlas.get(*glyph.face, glyph.glyph_index, size);
+        if (!sdf)
+            return false;
+        if (sdf->width == 0 || sdf->height == 0)
+            continue;
+        double ratio = size / sdf->size;
+        pixel_position p = glyph_pos.pos + glyph.offset.rotate(glyph_pos.rot);
+        agg::trans_affine mtx(1.0, 0.0, 0.0, -1.0, sdf->left, sdf->top);
+        mtx *= agg::trans_affine_scaling(ratio);
+        mtx *= agg::trans_affine(glyph_pos.rot.cos, glyph_pos.rot.sin, -glyph_pos.rot.sin, glyph_pos.rot.cos, p.x, p.y);
+        glyphs.push_back(detail::sdf_glyph{sdf, glyph.format.get(), mtx, ratio});
+    }
+
+    // Same placement as the FreeType path: glyph coordinates are transformed,
+    // moved to the base point and flipped into the image.
+    pixel_position const& base_point = pos.get_base_point();
+    agg::trans_affine const to_image(1.0, 0.0, 0.0, -1.0, base_point.x, base_point.y);
+    for (auto const& g : glyphs)
+    {
+        detail::evaluated_format_properties const& props = *g.properties;
+        double halo_radius = props.halo_radius * scale_factor_;
+        if (halo_radius <= 0.0 || halo_radius > 1024.0)
+            continue;
+        agg::trans_affine mtx(g.mtx);
+        mtx *= halo_transform_;
+        mtx *= to_image;
+        detail::composite_sdf(pixmap_,
+                              *g.sdf,
+                              mtx,
+                              g.scale * halo_scale,
+                              halo_radius,
+                              props.halo_fill.rgba(),
+                              props.halo_opacity,
+                              halo_comp_op_);
+    }
+    for (auto const& g : glyphs)
+    {
+        detail::evaluated_format_properties const& props = *g.properties;
+        agg::trans_affine mtx(g.mtx);
+        mtx *= transform_;
+        mtx *= to_image;
+        detail::composite_sdf(pixmap_,
+                              *g.sdf,
+                              mtx,
+                              g.scale * text_scale,
+                              0.0,
+                              props.fill.rgba(),
+                              props.text_opacity,
+                              comp_op_);
+    }
+    return true;
+}
+
 template<typename T>
 void grid_text_renderer<T>::render(glyph_positions const& pos, value_integer feature_id)
 {
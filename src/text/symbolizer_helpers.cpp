@@ -41,6 +41,7 @@
 #include <mapnik/text/placement_finder_impl.hpp>
 #include <mapnik/text/placements/base.hpp>
 #include <mapnik/text/placements/dummy.hpp>
+#include <mapnik/text/vertex_cache_store.hpp>
 #include <mapnik/geometry/transform.hpp>
 #include <mapnik/geometry/strategy.hpp>
 #include <mapnik/grid_vertex_converter.hpp>
@@ -381,18 +382,22 @@ text_symbolizer_helper::text_symbolizer_helper(text_symbolizer const& sym,
                                                FaceManagerT& font_manager,
                                                DetectorT& detector,
                                                box2d<double> const& query_extent,
-                                               agg::trans_affine const& affine_trans)
+                                               agg::trans_affine const& affine_trans,
+                                               bool defer_layout)
     : base_symbolizer_helper(sym, feature, vars, prj_trans, width, height, scale_factor, t, query_extent)
     , finder_(feature, vars, detector, dims_, *info_ptr_, font_manager, scale_factor)
     , adapter_(finder_, false)
     , converter_(query_extent_, sym_, t, prj_trans, affine_trans, feature, vars, scale_factor)
+    , affine_trans_(affine_trans)
 {
     init_converters();
 
     if (geometries_to_process_.size())
     {
         text_symbolizer_helper::initialize_points();
-        finder_.next_position();
+        discard_blocked_points(detector);
+        if (!point_placement_ || !points_.empty())
+            init_position(defer_layout);
     }
 }
 
@@ -430,8 +435,30 @@ void text_symbolizer_helper::init_converters()
         converter_.template set<offset_transform_tag>(); // optional offset converter
 }
 
+void text_symbolizer_helper::init_position(bool defer_layout) const
+{
+    if (defer_layout)
+        layout_pending_ = finder_.prepare_position();
+    else
+        finder_.next_position();
+}
+
+void text_symbolizer_helper::layout(face_manager_freetype& font_manager) const
+{
+    if (layout_pending_)
+    {
+        finder_.layout_position(font_manager);
+        layout_pending_ = false;
+    }
+}
+
 placements_list const& text_symbolizer_helper::get() const
 {
+    if (layout_pending_)
+    {
+        finder_.layout_position();
+        layout_pending_ = false;
+    }
     if (point_placement_)
     {
         while (next_point_placement())
@@ -445,27 +472,89 @@ placements_list const& text_symbolizer_helper::get() const
     return finder_.placements();
 }
 
-class apply_line_placement_visitor
+namespace detail {
+
+struct vertex_cache_builder
+{
+    template<typename PathT>
+    void add_path(PathT& path)
+    {
+        cache = std::make_shared<vertex_cache>(path);
+    }
+
+    std::shared_ptr<vertex_cache> cache;
+};
+
+class measure_line_visitor
 {
   public:
-    apply_line_placement_visitor(vertex_converter_type& converter,
-                                 placement_finder_adapter<placement_finder> const& adapter)
+    measure_line_visitor(vertex_converter_type& converter)
         : converter_(converter)
-        , adapter_(adapter)
     {}
 
-    bool operator()(geometry::line_string<double> const& geo) const
+    std::shared_ptr<vertex_cache> operator()(geometry::line_string<double> const& geo) const
     {
         geometry::line_string_vertex_adapter<double> va(geo);
-        converter_.apply(va, adapter_);
-        return adapter_.status();
+        vertex_cache_builder builder;
+        converter_.apply(va, builder);
+        return builder.cache;
     }
 
-    bool operator()(geometry::polygon<double> const& geo) const
+    std::shared_ptr<vertex_cache> operator()(geometry::polygon<double> const& geo) const
     {
         geometry::polygon_vertex_adapter<double> va(geo);
-        converter_.apply(va, adapter_);
-        return adapter_.status();
+        vertex_cache_builder builder;
+        converter_.apply(va, builder);
+        return builder.cache;
+    }
+
+    template<typename T>
+    std::shared_ptr<vertex_cache> operator()(T const&) const
+    {
+        return nullptr;
+    }
+
+  private:
+    vertex_converter_type& converter_;
+};
+
+struct geometry_address
+{
+    template<typename T>
+    void const* operator()(T const& geo) const
+    {
+        return &geo;
+    }
+};
+
+// Collects the source vertices, which identify a geometry across features and
+// symbolizers better than its address: features are copied by the label queue
+// and recycled by some datasources.
+class geometry_vertices_visitor
+{
+  public:
+    geometry_vertices_visitor(std::vector<double>& vertices)
+        : vertices_(vertices)
+    {}
+
+    bool operator()(geometry::line_string<double> const& line) const
+    {
+        vertices_.reserve(2 + 2 * line.size());
+        vertices_.push_back(static_cast<double>(geometry::geometry_types::LineString));
+        add_points(line);
+        return !line.empty();
+    }
+
+    bool operator()(geometry::polygon<double> const& poly) const
+    {
+        std::size_t num_vertices = 0;
+        vertices_.push_back(static_cast<double>(geometry::geometry_types::Polygon));
+        for (auto const& ring : poly)
+        {
+            add_points(ring);
+            num_vertices += ring.size();
+        }
+        return num_vertices > 0;
     }
 
     template<typename T>
@@ -475,10 +564,75 @@ class apply_line_placement_visitor
     }
 
   private:
-    vertex_converter_type& converter_;
-    placement_finder_adapter<placement_finder> const& adapter_;
+    template<typename Points>
+    void add_points(Points const& points) const
+    {
+        vertices_.push_back(static_cast<double>(points.size()));
+        for (auto const& pt : points)
+        {
+            vertices_.push_back(pt.x);
+            vertices_.push_back(pt.y);
+        }
+    }
+
+    std::vector<double>& vertices_;
 };
 
+} // namespace detail
+
+vertex_cache* text_symbolizer_helper::line_vertex_cache(geometry_cref const& geom) const
+{
+    void const* address = util::apply_visitor(detail::geometry_address(), geom);
+    auto itr = vertex_caches_.find(address);
+    if (itr != vertex_caches_.end())
+        return itr->second.get();
+
+    std::shared_ptr<vertex_cache> cache;
+    if (vertex_cache_store_)
+    {
+        label_placement_enum how_placed = text_props_->label_placement;
+        vertex_cache_store::key key;
+        bool has_vertices = util::apply_visitor(detail::geometry_vertices_visitor(key.vertices), geom);
+        key.prj_trans = &prj_trans_;
+        key.args = {{static_cast<double>(mapnik::get<value_bool, keys::clip>(sym_, feature_, vars_)),
+                     mapnik::get<value_double, keys::simplify_tolerance>(sym_, feature_, vars_),
+                     static_cast<double>(
+                       mapnik::get<simplify_algorithm_e, keys::simplify_algorithm>(sym_, feature_, vars_)),
+                     mapnik::get<value_double, keys::smooth>(sym_, feature_, vars_),
+                     static_cast<double>(
+                       mapnik::get<smooth_algorithm_enum, keys::smooth_algorithm>(sym_, feature_, vars_)),
+                     mapnik::get<value_double, keys::extend>(sym_, feature_, vars_),
+                     mapnik::get<value_double, keys::offset>(sym_, feature_, vars_),
+                     static_cast<double>(how_placed),
+                     affine_trans_.sx,
+                     affine_trans_.shy,
+                     affine_trans_.shx,
+                     affine_trans_.sy,
+                     affine_trans_.tx,
+                     affine_trans_.ty,
+                     query_extent_.minx(),
+                     query_extent_.miny(),
+                     query_extent_.maxx(),
+                     query_extent_.maxy()}};
+        if (has_vertices)
+        {
+            cache = vertex_cache_store_->find(key);
+            if (!cache)
+            {
+                cache = util::apply_visitor(detail::measure_line_visitor(converter_), geom);
+                if (cache)
+                    vertex_cache_store_->insert(key, cache);
+            }
+        }
+    }
+    else
+    {
+        cache = util::apply_visitor(detail::measure_line_visitor(converter_), geom);
+    }
+    vertex_caches_.emplace(address, cache);
+    return cache.get();
+}
+
 bool text_symbolizer_helper::next_line_placement() const
 {
     while (!geometries_to_process_.empty())
@@ -493,7 +647,8 @@ bool text_symbolizer_helper::next_line_placement() const
             continue; // Reexecute size check
         }
 
-        if (mapnik::util::apply_visitor(apply_line_placement_visitor(converter_, adapter_), *geo_itr_))
+        vertex_cache* pp = line_vertex_cache(*geo_itr_);
+        if (pp && finder_.find_line_placements(*pp, adapter_.points_on_line_))
         {
             // Found a placement
             geo_itr_ = geometries_to_process_.erase(geo_itr_);
@@ -506,6 +661,31 @@ bool text_symbolizer_helper::next_line_placement() const
     return false;
 }
 
+void text_symbolizer_helper::discard_blocked_points(label_collision_detector4 const& detector) const
+{
+    if (!point_placement_ || text_props_->allow_overlap || points_.empty())
+        return;
+    // Alternative placements move the label away from the point.
+    if (!dynamic_cast<text_placement_info_dummy const*>(info_ptr_.get()))
+        return;
+    // Without displacement the label box is centered on the point (alignment
+    // moves it by at most half its size), so a point which is already covered
+    // by another label can't be used and the expensive layout can be skipped.
+    text_layout_properties const& layout = info_ptr_->properties.layout_defaults;
+    double dx = util::apply_visitor(extract_value<value_double>(feature_, vars_), layout.dx);
+    double dy = util::apply_visitor(extract_value<value_double>(feature_, vars_), layout.dy);
+    if (dx != 0.0 || dy != 0.0)
+        return;
+    for (auto itr = points_.begin(); itr != points_.end();)
+    {
+        if (detector.has_placement(box2d<double>(itr->x, itr->y, itr->x, itr->y)))
+            ++itr;
+        else
+            itr = points_.erase(itr);
+    }
+    point_itr_ = points_.begin();
+}
+
 bool text_symbolizer_helper::next_point_placement() const
 {
     while (!points_.empty())
@@ -543,19 +723,25 @@ text_symbolizer_helper::text_symbolizer_helper(shield_symbolizer const& sym,
                                                FaceManagerT& font_manager,
                                                DetectorT& detector,
                                                box2d<double> const& query_extent,
-                                               agg::trans_affine const& affine_trans)
+                                               agg::trans_affine const& affine_trans,
+                                               bool defer_layout)
     : base_symbolizer_helper(sym, feature, vars, prj_trans, width, height, scale_factor, t, query_extent)
     , finder_(feature, vars, detector, dims_, *info_ptr_, font_manager, scale_factor)
     , adapter_(finder_, true)
     , converter_(query_extent_, sym_, t, prj_trans, affine_trans, feature, vars, scale_factor)
+    , affine_trans_(affine_trans)
 {
     init_converters();
 
     if (geometries_to_process_.size())
     {
         text_symbolizer_helper::initialize_points();
-        init_marker();
-        finder_.next_position();
+        discard_blocked_points(detector);
+        if (!point_placement_ || !points_.empty())
+        {
+            init_marker();
+            init_position(defer_layout);
+        }
     }
 }
 
@@ -641,7 +827,8 @@ template text_symbolizer_helper::text_symbolizer_helper(text_symbolizer const& s
                                                         face_manager_freetype& font_manager,
                                                         label_collision_detector4& detector,
                                                         box2d<double> const& query_extent,
-                                                        agg::trans_affine const&);
+                                                        agg::trans_affine const&,
+                                                        bool);
 
 template text_symbolizer_helper::text_symbolizer_helper(shield_symbolizer const& sym,
                                                         feature_impl const& feature,
@@ -654,5 +841,6 @@ template text_symbolizer_helper::text_symbolizer_helper(shield_symbolizer const&
                                                         face_manager_freetype& font_manager,
                                                         label_collision_detector4& detector,
                                                         box2d<double> const& query_extent,
-                                                        agg::trans_affine const&);
+                                                        agg::trans_affine const&,
+                                                        bool);
 } // namespace mapnik
@@ -99,7 +99,7 @@ text_layout::text_layout(face_manager_freetype& font_manager,
                          text_symbolizer_properties const& properties,
                          text_layout_properties const& layout_defaults,
                          formatting::node_ptr tree)
-    : font_manager_(font_manager)
+    : font_manager_(&font_manager)
     , scale_factor_(scale_factor)
     , itemizer_()
     , width_map_()
@@ -461,7 +461,7 @@ void text_layout::clear()
 
 void text_layout::shape_text(text_line& line)
 {
-    harfbuzz_shaper::shape_text(line, itemizer_, width_map_, font_manager_, scale_factor_);
+    harfbuzz_shaper::shape_text(line, itemizer_, width_map_, *font_manager_, scale_factor_);
 }
 
 void text_layout::init_auto_alignment()
@@ -574,6 +574,15 @@ void layout_container::layout()
     }
 }
 
+void layout_container::layout(face_manager_freetype& font_manager)
+{
+    for (text_layout_ptr const& layout : layouts_)
+    {
+        layout->set_font_manager(font_manager);
+    }
+    layout();
+}
+
 void layout_container::clear()
 {
     layouts_.clear();
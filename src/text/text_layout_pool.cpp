@@ -0,0 +1,198 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/text/text_layout_pool.hpp>
+#include <mapnik/text/symbolizer_helpers.hpp>
+#include <mapnik/text/font_library.hpp>
+
+// stl
+#include <algorithm>
+#ifdef MAPNIK_THREADSAFE
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <thread>
+#endif
+
+namespace mapnik {
+
+namespace {
+
+struct worker_fonts
+{
+    worker_fonts(freetype_engine::font_file_mapping_type const& font_file_mapping,
+                 freetype_engine::font_memory_cache_type const& font_cache)
+        : library()
+        , font_manager(library, font_file_mapping, font_cache)
+    {}
+
+    font_library library;
+    face_manager_freetype font_manager;
+};
+
+} // namespace
+
+struct text_layout_pool::impl
+{
+    // held by the render using the workers
+    std::mutex busy;
+    std::vector<std::unique_ptr<worker_fonts>> fonts;
+#ifdef MAPNIK_THREADSAFE
+    // guards the job below
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    std::vector<text_symbolizer_helper const*> const* helpers = nullptr;
+    std::atomic<std::size_t> next{0};
+    std::vector<std::exception_ptr> errors;
+    // number of workers taking part in the current job
+    std::size_t active = 0;
+    std::size_t running = 0;
+    std::size_t generation = 0;
+    bool stop = false;
+    std::vector<std::thread> threads;
+
+    void work(face_manager_freetype& font_manager, std::exception_ptr& error)
+    {
+        try
+        {
+            std::size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) < helpers->size())
+            {
+                (*helpers)[i]->layout(font_manager);
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+            // let the other threads finish early
+            next.store(helpers->size(), std::memory_order_relaxed);
+        }
+    }
+
+    void run(std::size_t index)
+    {
+        std::size_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            start.wait(lock, [&] { return stop || generation != seen; });
+            if (stop)
+                return;
+            seen = generation;
+            if (index >= active)
+                continue;
+            lock.unlock();
+            work(fonts[index]->font_manager, errors[index + 1]);
+            lock.lock();
+            if (--running == 0)
+                done.notify_one();
+        }
+    }
+#endif
+};
+
+text_layout_pool::text_layout_pool(freetype_engine::font_file_mapping_type const& font_file_mapping,
+                                   freetype_engine::font_memory_cache_type const& font_cache,
+                                   std::size_t num_threads)
+    : impl_(std::make_unique<impl>())
+{
+#ifdef MAPNIK_THREADSAFE
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 1; i < num_threads; ++i)
+    {
+        impl_->fonts.push_back(std::make_unique<worker_fonts>(font_file_mapping, font_cache));
+    }
+    impl_->threads.reserve(impl_->fonts.size());
+    for (std::size_t i = 0; i < impl_->fonts.size(); ++i)
+    {
+        impl_->threads.emplace_back(&impl::run, impl_.get(), i);
+    }
+#else
+    (void)font_file_mapping;
+    (void)font_cache;
+    (void)num_threads;
+#endif
+}
+
+text_layout_pool::~text_layout_pool()
+{
+#ifdef MAPNIK_THREADSAFE
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->stop = true;
+    }
+    impl_->start.notify_all();
+    for (auto& thread : impl_->threads)
+    {
+        thread.join();
+    }
+#endif
+}
+
+std::size_t text_layout_pool::num_threads() const
+{
+    return impl_->fonts.size() + 1;
+}
+
+std::unique_lock<std::mutex> text_layout_pool::layout(std::vector<text_symbolizer_helper const*> const& helpers,
+                                                      face_manager_freetype& font_manager)
+{
+    std::unique_lock<std::mutex> busy(impl_->busy, std::try_to_lock);
+#ifdef MAPNIK_THREADSAFE
+    std::size_t const num_workers = std::min(impl_->fonts.size(), helpers.empty() ? 0 : helpers.size() - 1);
+    if (busy && num_workers > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            impl_->helpers = &helpers;
+            impl_->next.store(0, std::memory_order_relaxed);
+            impl_->errors.assign(num_workers + 1, nullptr);
+            impl_->active = num_workers;
+            impl_->running = num_workers;
+            ++impl_->generation;
+        }
+        impl_->start.notify_all();
+        impl_->work(font_manager, impl_->errors[0]);
+        {
+            std::unique_lock<std::mutex> lock(impl_->mutex);
+            impl_->done.wait(lock, [this] { return impl_->running == 0; });
+            impl_->helpers = nullptr;
+        }
+        for (auto const& error : impl_->errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+        return busy;
+    }
+#endif
+    for (auto const* helper : helpers)
+    {
+        helper->layout(font_manager);
+    }
+    return busy;
+}
+
+} // namespace mapnik
@@ -23,6 +23,7 @@
 #include <mapnik/util/math.hpp>
 #include <mapnik/vertex_cache.hpp>
 #include <mapnik/offset_converter.hpp>
+#include <algorithm>
 #include <memory>
 
 namespace mapnik {
@@ -108,6 +109,32 @@ void vertex_cache::reset()
     initialized_ = false;
 }
 
+bool vertex_cache::seek_segment(double& distance)
+{
+    auto& segments = current_subpath_->vector;
+    angle_valid_ = false;
+    if (distance < 0)
+    {
+        current_segment_ = segments.begin();
+        segment_starting_point_ = current_segment_->pos;
+        return false;
+    }
+    // first segment ending after distance
+    current_segment_ = std::upper_bound(segments.begin(),
+                                        segments.end(),
+                                        distance,
+                                        [](double d, segment const& seg) { return d < seg.distance; });
+    if (current_segment_ == segments.end())
+    {
+        segment_starting_point_ = segments.back().pos;
+        return false;
+    }
+    // The first segment has length 0, so it never contains a distance
+    segment_starting_point_ = (current_segment_ - 1)->pos;
+    distance -= current_segment_->distance - current_segment_->length;
+    return true;
+}
+
 bool vertex_cache::next_segment()
 {
     segment_starting_point_ = current_segment_->pos; // Next segments starts at the end of the current one
@@ -259,17 +286,13 @@ bool vertex_cache::move(double length)
 
     position_ += length;
     length += position_in_segment_;
-    while (length >= current_segment_->length)
-    {
-        length -= current_segment_->length;
-        if (!next_segment())
-            return false; // Skip all complete segments
-    }
-    while (length < 0)
+    if (length < 0 || length >= current_segment_->length)
     {
-        if (!previous_segment())
+        // Jump to the target segment instead of stepping through all segments in between,
+        // labels on long lines move by large distances.
+        length += current_segment_->distance - current_segment_->length;
+        if (!seek_segment(length))
             return false;
-        length += current_segment_->length;
     }
     double factor = length / current_segment_->length;
     position_in_segment_ = length;
@@ -105,9 +105,16 @@ class webp_reader : public image_reader
     inline bool has_alpha() const final { return has_alpha_; }
     void read(unsigned x, unsigned y, image_rgba8& image) final;
     image_any read(unsigned x, unsigned y, unsigned width, unsigned height) final;
+    unsigned
+      scale_denominator(unsigned width, unsigned height, unsigned target_width, unsigned target_height) const final;
+    image_any read_scaled(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator) final;
+    box2d<double>
+      scaled_window(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator) const final;
 
   private:
     void init();
+    static std::size_t crop_size(unsigned pos, std::size_t size, unsigned image_size, unsigned denominator);
+    void decode(unsigned x, unsigned y, std::size_t width, std::size_t height, image_rgba8& image, unsigned denominator);
 };
 
 image_reader* create_webp_reader(char const* data, std::size_t size)
@@ -215,6 +222,34 @@ boost::optional<box2d<double>> webp_reader<T>::bounding_box() const
 
 template<typename T>
 void webp_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
+{
+    decode(x0, y0, image.width(), image.height(), image, 1);
+}
+
+// Pixels of the image decoded for size pixels at pos. Shrunk windows grow to
+// whole pixels of the shrunk image as far as the image goes, libwebp scales
+// the crop to the size asked for and shrinks by exactly denominator then.
+template<typename T>
+std::size_t webp_reader<T>::crop_size(unsigned pos, std::size_t size, unsigned image_size, unsigned denominator)
+{
+    std::size_t left = image_size - pos;
+    std::size_t crop = std::min(left, size);
+    if (denominator > 1)
+    {
+        crop = std::min(left, (crop + denominator - 1) / denominator * denominator);
+    }
+    return crop;
+}
+
+// Decodes the window at x0, y0 of width by height pixels, scaled down by
+// denominator while decoding.
+template<typename T>
+void webp_reader<T>::decode(unsigned x0,
+                            unsigned y0,
+                            std::size_t width,
+                            std::size_t height,
+                            image_rgba8& image,
+                            unsigned denominator)
 {
     WebPDecoderConfig config;
     config_guard guard(config);
@@ -226,8 +261,14 @@ void webp_reader<T>::read(unsigned x0, unsigned y0, image_rgba8& image)
     config.options.use_cropping = 1;
     config.options.crop_left = x0;
     config.options.crop_top = y0;
-    config.options.crop_width = std::min(static_cast<std::size_t>(width_ - x0), image.width());
-    config.options.crop_height = std::min(static_cast<std::size_t>(height_ - y0), image.height());
+    config.options.crop_width = crop_size(x0, width, width_, denominator);
+    config.options.crop_height = crop_size(y0, height, height_, denominator);
+    if (denominator > 1)
+    {
+        config.options.use_scaling = 1;
+        config.options.scaled_width = (config.options.crop_width + denominator - 1) / denominator;
+        config.options.scaled_height = (config.options.crop_height + denominator - 1) / denominator;
+    }
 
     if (WebPGetFeatures(buffer_->data(), buffer_->size(), &config.input) != VP8_STATUS_OK)
     {
@@ -253,4 +294,42 @@ image_any webp_reader<T>::read(unsigned x, unsigned y, unsigned width, unsigned
     return image_any(std::move(data));
 }
 
+template<typename T>
+unsigned webp_reader<T>::scale_denominator(unsigned width,
+                                           unsigned height,
+                                           unsigned target_width,
+                                           unsigned target_height) const
+{
+    return power_of_two_denominator(width, height, target_width, target_height);
+}
+
+template<typename T>
+image_any webp_reader<T>::read_scaled(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator)
+{
+    if (denominator == 0)
+    {
+        throw image_reader_exception("WEBP reader: invalid scale denominator");
+    }
+    image_rgba8 data((width + denominator - 1) / denominator, (height + denominator - 1) / denominator);
+    decode(x, y, width, height, data, denominator);
+    return image_any(std::move(data));
+}
+
+// Next to the right and bottom edges, the pixels left of the image are
+// stretched over the last pixels of the shrunk window.
+template<typename T>
+box2d<double>
+  webp_reader<T>::scaled_window(unsigned x, unsigned y, unsigned width, unsigned height, unsigned denominator) const
+{
+    unsigned d = std::max(denominator, 1u);
+    auto extent = [d](unsigned pos, unsigned size, unsigned image_size) {
+        double pixels = (size + d - 1) / d;
+        if (pos >= image_size)
+            return pixels * d;
+        std::size_t crop = crop_size(pos, size, image_size, d);
+        return pixels * crop / ((crop + d - 1) / d);
+    };
+    return box2d<double>(x, y, x + extent(x, width, width_), y + extent(y, height, height_));
+}
+
 } // namespace mapnik
@@ -0,0 +1,185 @@
+#include "catch.hpp"
+
+#include <mapnik/marker.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/map.hpp>
+
+#include <string>
+#ifdef MAPNIK_THREADSAFE
+#include <thread>
+#endif
+
+namespace {
+
+const std::string square_svg = "<svg width='10' height='8' xmlns='http://www.w3.org/2000/svg'>"
+                               "<rect width='10' height='8' fill='red'/>"
+                               "</svg>";
+
+} // namespace
+
+TEST_CASE("marker_cache")
+{
+    auto& cache = mapnik::marker_cache::instance();
+
+    SECTION("built-in shapes")
+    {
+        auto ellipse = cache.find("shape://ellipse");
+        REQUIRE(ellipse->is<mapnik::marker_svg>());
+        // parsed once, every lookup shares it
+        CHECK(cache.find("shape://ellipse") == ellipse);
+        CHECK(cache.find("shape://unknown")->is<mapnik::marker_null>());
+    }
+
+    SECTION("markers from memory")
+    {
+        // not null terminated
+        std::string buffer = square_svg + "garbage";
+        auto mark = cache.insert("mem://square", buffer.data(), square_svg.size());
+        REQUIRE(mark->is<mapnik::marker_svg>());
+        CHECK(mark->width() == 10);
+        CHECK(mark->height() == 8);
+        CHECK(cache.find("mem://square") == mark);
+        buffer.assign(buffer.size(), 'x');
+        CHECK(cache.find("mem://square") == mark);
+
+        // registering again replaces the marker
+        std::string small = "<svg xmlns='http://www.w3.org/2000/svg'><rect width='4' height='4'/></svg>";
+        auto replaced = cache.insert("mem://square", small.data(), small.size());
+        CHECK(cache.find("mem://square") == replaced);
+        CHECK(replaced->width() == 4);
+
+        CHECK(cache.remove("mem://square"));
+        CHECK(!cache.remove("mem://square"));
+        // markers still in use are kept alive by their users
+        CHECK(mark->width() == 10);
+        CHECK(cache.find("mem://square")->is<mapnik::marker_null>());
+
+        std::string junk = "not a marker";
+        CHECK(cache.insert("mem://junk", junk.data(), junk.size())->is<mapnik::marker_null>());
+        CHECK(!cache.remove("mem://junk"));
+    }
+
+    SECTION("data URIs")
+    {
+        CHECK(cache.is_data_uri("data:image/svg+xml,<svg/>"));
+        CHECK(!cache.is_data_uri("shape://ellipse"));
+        std::string plain = "data:image/svg+xml;utf8," + square_svg;
+        CHECK(cache.find(plain)->width() == 10);
+        std::string percent = "data:image/svg+xml,%3Csvg%20width='10'%20height='8'%20"
+                              "xmlns='http://www.w3.org/2000/svg'%3E%3Crect%20width='10'%20height='8'/%3E%3C/svg%3E";
+        CHECK(cache.find(percent)->height() == 8);
+        // "<svg xmlns='http://www.w3.org/2000/svg'><rect width='6' height='6'/></svg>"
+        std::string base64 = "data:image/svg+xml;base64,PHN2ZyB4bWxucz0naHR0cDovL3d3dy53My5vcmcvMjAwMC9zdmcnPjxyZWN0"
+                             "IHdpZHRoPSc2JyBoZWlnaHQ9JzYnLz48L3N2Zz4=";
+        auto mark = cache.find(base64, true);
+        CHECK(mark->width() == 6);
+        CHECK(cache.find(base64) == mark);
+        CHECK(cache.remove(base64));
+        CHECK(cache.find("data:image/png;base64,!!!")->is<mapnik::marker_null>());
+        CHECK(cache.find("data:no-comma")->is<mapnik::marker_null>());
+    }
+
+    SECTION("bounded size")
+    {
+        cache.clear();
+        auto svg_uri = [](int width) {
+            return "data:image/svg+xml,<svg xmlns='http://www.w3.org/2000/svg'><rect width='" + std::to_string(width) +
+                   "' height='1'/></svg>";
+        };
+        auto before = cache.stats();
+        auto first = cache.find(svg_uri(1), true);
+        auto after = cache.stats();
+        CHECK(after.misses == before.misses + 1);
+        CHECK(after.size == before.size + 1);
+        CHECK(cache.find(svg_uri(1), true) == first);
+        CHECK(cache.stats().hits == after.hits + 1);
+
+        // every marker takes the same memory
+        std::size_t bytes = after.bytes - before.bytes;
+        std::size_t capacity = cache.capacity();
+        cache.set_capacity(before.bytes + 4 * bytes);
+        cache.pin(svg_uri(2));
+        auto pinned = cache.find(svg_uri(2), true);
+        auto third = cache.find(svg_uri(3), true);
+        cache.find(svg_uri(4), true);
+        CHECK(cache.stats().evictions == after.evictions);
+        // found again, the third one is now the least recently used
+        CHECK(cache.find(svg_uri(1)) == first);
+        auto fifth = cache.find(svg_uri(5), true);
+        auto stats = cache.stats();
+        CHECK(stats.evictions > after.evictions);
+        CHECK(stats.bytes <= stats.capacity);
+        CHECK(cache.find(svg_uri(2)) == pinned);
+        CHECK(cache.find(svg_uri(3)) != third);
+        CHECK(cache.find(svg_uri(5)) == fifth);
+        CHECK(cache.find("image://square", true)->is<mapnik::marker_rgba8>());
+
+        CHECK(cache.unpin(svg_uri(2)));
+        cache.set_capacity(capacity);
+        cache.clear();
+    }
+
+    SECTION("pins")
+    {
+        std::string const key = "data:image/svg+xml;utf8," + square_svg;
+        cache.pin(key);
+        cache.pin(key);
+        CHECK(cache.unpin(key));
+        CHECK(cache.is_pinned(key));
+        CHECK(cache.unpin(key));
+        CHECK(!cache.is_pinned(key));
+        CHECK(!cache.unpin(key));
+
+        // maps keep their markers pinned until the last copy is gone
+        {
+            mapnik::Map m(16, 16);
+            m.pin_marker(key);
+            m.pin_marker(key);
+            {
+                mapnik::Map copy(m);
+                CHECK(cache.is_pinned(key));
+            }
+            CHECK(cache.is_pinned(key));
+        }
+        CHECK(!cache.is_pinned(key));
+
+        // registered markers are kept without pinning their keys
+        auto mark = cache.insert("mem://square", square_svg.data(), square_svg.size());
+        CHECK(!cache.is_pinned("mem://square"));
+        CHECK(cache.remove("mem://square"));
+    }
+
+#ifdef MAPNIK_THREADSAFE
+    SECTION("hits of every thread are counted")
+    {
+        std::string const key = "data:image/svg+xml;utf8," + square_svg;
+        auto mark = cache.find(key, true);
+        auto before = cache.stats();
+        std::thread t([&] {
+            for (int i = 0; i < 10; ++i)
+            {
+                CHECK(cache.find(key) == mark);
+            }
+        });
+        t.join();
+        CHECK(cache.stats().hits == before.hits + 10);
+        CHECK(cache.remove(key));
+    }
+#endif
+
+#if defined(HAVE_PNG)
+    SECTION("images from memory")
+    {
+        mapnik::image_rgba8 image(3, 2);
+        image.set(0xff0000ff);
+        std::string png = mapnik::save_to_string(image, "png");
+        auto mark = cache.insert("mem://red.png", png.data(), png.size());
+        REQUIRE(mark->is<mapnik::marker_rgba8>());
+        CHECK(mark->width() == 3);
+        CHECK(mark->height() == 2);
+        CHECK(cache.remove("mem://red.png"));
+    }
+#endif
+}
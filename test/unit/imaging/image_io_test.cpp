@@ -1,11 +1,18 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
+#include <sstream>
+#include <vector>
 #include <mapnik/color.hpp>
 #include <mapnik/image.hpp>
 #include <mapnik/image_reader.hpp>
+#include <mapnik/image_row_writer.hpp>
 #include <mapnik/image_util.hpp>
 #include <mapnik/image_util_jpeg.hpp>
+#include <mapnik/solid_image_cache.hpp>
 #include <mapnik/util/fs.hpp>
 #if defined(HAVE_CAIRO)
 #include <mapnik/cairo/cairo_context.hpp>
@@ -153,6 +160,15 @@ TEST_CASE("image io")
         int q0 = mapnik::detail::parse_jpeg_quality("jpeg50");
         int q1 = mapnik::detail::parse_jpeg_quality("jpeg:quality=50");
         REQUIRE(q0 == q1);
+        auto opts = mapnik::detail::parse_jpeg_options("jpeg70:optimize:progressive=true");
+        CHECK(opts.quality == 70);
+        CHECK(opts.optimize);
+        CHECK(opts.progressive);
+        opts = mapnik::detail::parse_jpeg_options("jpeg:optimize=false");
+        CHECK(opts.quality == 85);
+        CHECK_FALSE(opts.optimize);
+        CHECK_FALSE(opts.progressive);
+        REQUIRE_THROWS(mapnik::detail::parse_jpeg_options("jpeg:progressive=maybe"));
 #endif
     } // END SECTION
 
@@ -214,6 +230,488 @@ TEST_CASE("image io")
         }
     }
 
+    SECTION("png encoding filtered by mapnik")
+    {
+#if defined(HAVE_PNG)
+        mapnik::image_rgba8 im(300, 700);
+        for (unsigned y = 0; y < im.height(); ++y)
+        {
+            for (unsigned x = 0; x < im.width(); ++x)
+            {
+                im(x, y) = 0xff000000 | ((x * 7 + y) & 0xff) << 16 | ((x ^ y) & 0xff) << 8 | (y / 3 & 0xff);
+            }
+        }
+        for (std::string format : {"png32", "png24", "png8:m=h", "png8:m=o:c=16"})
+        {
+            // written by libpng
+            std::string expected = mapnik::save_to_string(im, format + ":z=6");
+            std::unique_ptr<mapnik::image_reader> reader1(mapnik::get_image_reader(expected.data(), expected.size()));
+            auto im1 = reader1->read(0, 0, im.width(), im.height());
+            for (std::string options : {":z=6:f=all", ":z=6:f=paeth", ":z=6:j=3:f=all", ":z=6:j=2:f=paeth", ":z=1:j=2"})
+            {
+                std::string actual = mapnik::save_to_string(im, format + options);
+                std::unique_ptr<mapnik::image_reader> reader2(mapnik::get_image_reader(actual.data(), actual.size()));
+                REQUIRE(reader2->width() == im.width());
+                REQUIRE(reader2->height() == im.height());
+                auto im2 = reader2->read(0, 0, im.width(), im.height());
+                CHECK(0 == std::memcmp(im1.bytes(), im2.bytes(), im1.size()));
+            }
+        }
+        REQUIRE_THROWS(mapnik::save_to_string(im, "png32:j=-1"));
+
+        // libpng writes IDAT chunks of 32k, rows filtered by mapnik go into
+        // chunks of 64k, also on a single thread
+        auto first_idat_size = [](std::string const& png) {
+            for (std::size_t pos = 8; pos + 8 <= png.size();)
+            {
+                auto const* bytes = reinterpret_cast<unsigned char const*>(png.data() + pos);
+                std::size_t size = std::size_t(bytes[0]) << 24 | bytes[1] << 16 | bytes[2] << 8 | bytes[3];
+                if (png.compare(pos + 4, 4, "IDAT") == 0)
+                    return size;
+                pos += size + 12;
+            }
+            return std::size_t(0);
+        };
+        std::uint32_t seed = 1;
+        for (unsigned y = 0; y < im.height(); ++y)
+        {
+            for (unsigned x = 0; x < im.width(); ++x)
+            {
+                seed = seed * 1103515245u + 12345u;
+                im(x, y) = seed;
+            }
+        }
+        CHECK(first_idat_size(mapnik::save_to_string(im, "png32:z=1")) == 32768);
+        CHECK(first_idat_size(mapnik::save_to_string(im, "png32:z=1:f=all")) == 65536);
+        CHECK(first_idat_size(mapnik::save_to_string(im, "png32:z=1:j=1:f=paeth")) == 65536);
+#endif
+    } // END SECTION
+
+    SECTION("png bands primed by rows starting at odd y")
+    {
+#if defined(HAVE_PNG)
+        // noise compresses only where rows repeat, the repeated rows start
+        // bands whose dictionary starts at an odd row
+        mapnik::image_rgba8 im(1024, 1024);
+        std::uint32_t seed = 1;
+        for (unsigned y = 0; y < im.height(); ++y)
+        {
+            for (unsigned x = 0; x < im.width(); ++x)
+            {
+                seed = seed * 1103515245u + 12345u;
+                im(x, y) = (y == 256 || y == 512 || y == 768) ? im(x, y - 1) : (0xff000000 | seed >> 8);
+            }
+        }
+        // rgb rows are copied to the row buffers of the bands
+        std::string rgb = mapnik::save_to_string(im, "png24:t=0:f=all:j=4");
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(rgb.data(), rgb.size()));
+        REQUIRE(reader->width() == im.width());
+        REQUIRE(reader->height() == im.height());
+        auto decoded = reader->read(0, 0, im.width(), im.height());
+        REQUIRE(decoded.size() == im.size());
+        CHECK(0 == std::memcmp(decoded.bytes(), im.bytes(), im.size()));
+#endif
+    } // END SECTION
+
+    SECTION("solid images are encoded once")
+    {
+#if defined(HAVE_PNG)
+        auto& cache = mapnik::solid_image_cache::instance();
+        cache.clear();
+        mapnik::image_rgba8 im(256, 256);
+        mapnik::fill(im, mapnik::color(170, 211, 223));
+        std::string png8 = mapnik::save_to_string(im, "png8:z=1");
+        CHECK(cache.size() == 1);
+        CHECK(mapnik::save_to_string(im, "PNG8:z=1") == png8);
+        CHECK(mapnik::save_to_string(mapnik::image_any(mapnik::image_rgba8(im)), "png8:z=1") == png8);
+        CHECK(cache.size() == 1);
+        std::string png32 = mapnik::save_to_string(im, "png32");
+        CHECK(cache.size() == 2);
+        mapnik::image_rgba8 empty(256, 256);
+        CHECK(mapnik::save_to_string(empty, "png8:z=1") != png8);
+        CHECK(cache.size() == 3);
+        mapnik::image_rgba8 premultiplied(im);
+        premultiplied.set_premultiplied(true);
+        mapnik::save_to_string(premultiplied, "png32");
+        CHECK(cache.size() == 4);
+
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(png8.data(), png8.size()));
+        auto decoded = reader->read(0, 0, im.width(), im.height());
+        CHECK(mapnik::is_solid(decoded));
+        CHECK(decoded.get<mapnik::image_rgba8>()(7, 7) == im(7, 7));
+
+        // other images are encoded as before
+        im(5, 5) = 0;
+        CHECK(mapnik::save_to_string(im, "png8:z=1") != png8);
+        CHECK(cache.size() == 4);
+        im(5, 5) = im(0, 0);
+        cache.set_capacity(0);
+        CHECK(cache.size() == 0);
+        CHECK(mapnik::save_to_string(im, "png8:z=1") == png8);
+        CHECK(mapnik::save_to_string(im, "png32") == png32);
+        CHECK(cache.size() == 0);
+        cache.set_capacity(256);
+#endif
+    } // END SECTION
+
+    SECTION("png8 hextree quantization quality")
+    {
+#if defined(HAVE_PNG)
+        // flat areas, an antialiased line, a gradient and translucent pixels
+        mapnik::image_rgba8 im(256, 256);
+        for (unsigned y = 0; y < im.height(); ++y)
+        {
+            for (unsigned x = 0; x < im.width(); ++x)
+            {
+                unsigned r = 200, g = 220, b = 180, a = 255;
+                if ((x / 32 + y / 32) % 2)
+                {
+                    r = 240;
+                    g = 240;
+                    b = 230;
+                }
+                int d = std::abs(int(x) - int(y));
+                if (d < 3)
+                {
+                    r = (r * d + 80 * (3 - d)) / 3;
+                    g = g * d / 3;
+                    b = b * d / 3;
+                }
+                if (y >= 192)
+                {
+                    r = x;
+                    g = (y - 192) * 4;
+                    b = 128;
+                    a = 255 - x / 2;
+                }
+                im(x, y) = a << 24 | b << 16 | g << 8 | r;
+            }
+        }
+        im(0, 0) = 0;
+        for (std::string format : {"png8:m=h", "png8:m=h:c=64", "png8:m=h:c=16"})
+        {
+            std::string encoded = mapnik::save_to_string(im, format);
+            std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(encoded.data(), encoded.size()));
+            auto decoded = reader->read(0, 0, im.width(), im.height());
+            REQUIRE(decoded.is<mapnik::image_rgba8>());
+            auto const& im2 = decoded.get<mapnik::image_rgba8>();
+            double sum = 0;
+            for (std::size_t i = 0; i < im.size(); ++i)
+            {
+                double diff = double(im.bytes()[i]) - im2.bytes()[i];
+                sum += diff * diff;
+            }
+            double rmse = std::sqrt(sum / im.size());
+            INFO(format << " rmse " << rmse);
+            CHECK(rmse < (format == "png8:m=h" ? 2.5 : format == "png8:m=h:c=64" ? 4.75 : 12.5));
+            // flat colors and transparent pixels are kept
+            CHECK(im2(0, 0) == 0);
+            if (format != "png8:m=h:c=16")
+            {
+                CHECK(im2(10, 40) == im(10, 40));
+                CHECK(im2(40, 10) == im(40, 10));
+            }
+        }
+#endif
+    } // END SECTION
+
+    SECTION("images written row by row")
+    {
+        mapnik::image_rgba8 im(97, 61);
+        for (std::size_t y = 0; y < im.height(); ++y)
+        {
+            for (std::size_t x = 0; x < im.width(); ++x)
+            {
+                im(x, y) = mapnik::color(x * 2, y * 4, (x * y) % 256, 128 + (x + y) % 128).rgba();
+            }
+        }
+        auto write_in_bands = [&](std::string const& format, unsigned band_height) {
+            std::ostringstream ss(std::ios::out | std::ios::binary);
+            auto writer = mapnik::create_image_row_writer(ss, format, im.width(), im.height());
+            for (unsigned y = 0; y < im.height(); y += band_height)
+            {
+                unsigned rows = std::min<unsigned>(band_height, im.height() - y);
+                writer->write(mapnik::image_view_rgba8(0, y, im.width(), rows, im));
+            }
+            writer->finish();
+            return ss.str();
+        };
+#if defined(HAVE_PNG)
+        for (std::string const format : {"png32", "png24", "png32:z=1:s=filtered"})
+        {
+            INFO(format);
+            CHECK(write_in_bands(format, 16) == mapnik::save_to_string(im, format));
+            CHECK(write_in_bands(format, 1) == mapnik::save_to_string(im, format));
+        }
+        // filtered by mapnik in both cases
+        std::string filtered = write_in_bands("png32:f=all", 20);
+        CHECK(filtered == mapnik::save_to_string(im, "png32:f=all"));
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(filtered.data(), filtered.size()));
+        auto decoded = reader->read(0, 0, im.width(), im.height());
+        CHECK(mapnik::compare(decoded.get<mapnik::image_rgba8>(), im) == 0);
+        CHECK_THROWS_AS(write_in_bands("png8", 16), mapnik::image_writer_exception);
+#endif
+#if defined(HAVE_JPEG)
+        CHECK(write_in_bands("jpeg80", 7) == mapnik::save_to_string(im, "jpeg80"));
+#endif
+#if defined(HAVE_TIFF)
+        for (std::string const format :
+             {"tiff:method=scanline", "tiff:rows_per_strip=8", "tiff:method=tiled:tile_width=32:tile_height=16"})
+        {
+            INFO(format);
+            std::string banded = write_in_bands(format, 5);
+            std::string whole = mapnik::save_to_string(im, format);
+            std::unique_ptr<mapnik::image_reader> banded_reader(mapnik::get_image_reader(banded.data(), banded.size()));
+            std::unique_ptr<mapnik::image_reader> whole_reader(mapnik::get_image_reader(whole.data(), whole.size()));
+            CHECK(mapnik::compare(banded_reader->read(0, 0, im.width(), im.height()),
+                                  whole_reader->read(0, 0, im.width(), im.height())) == 0);
+        }
+#endif
+        CHECK_THROWS_AS(write_in_bands("webp", 16), mapnik::image_writer_exception);
+        std::ostringstream ss(std::ios::out | std::ios::binary);
+        auto writer = mapnik::create_image_row_writer(ss, "png32", im.width(), im.height());
+        CHECK_THROWS_AS(writer->write(mapnik::image_view_rgba8(0, 0, 50, 8, im)), mapnik::image_writer_exception);
+        writer->write(mapnik::image_view_rgba8(0, 0, im.width(), 60, im));
+        CHECK_THROWS_AS(writer->finish(), mapnik::image_writer_exception);
+        CHECK_THROWS_AS(writer->write(mapnik::image_view_rgba8(0, 0, im.width(), 2, im)),
+                        mapnik::image_writer_exception);
+        writer->write(mapnik::image_view_rgba8(0, 60, im.width(), 1, im));
+        writer->finish();
+        CHECK(writer->rows_written() == im.height());
+    } // END SECTION
+
+#if defined(HAVE_JPEG)
+    SECTION("jpeg encoding options")
+    {
+        mapnik::image_rgba8 im(123, 77);
+        for (std::size_t y = 0; y < im.height(); ++y)
+        {
+            for (std::size_t x = 0; x < im.width(); ++x)
+            {
+                im(x, y) = mapnik::color(x * 2, y * 3, (x * y) % 256, 200).rgba();
+            }
+        }
+        auto decode = [](std::string const& data) {
+            std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(data.data(), data.size()));
+            REQUIRE(reader->width() == 123);
+            REQUIRE(reader->height() == 77);
+            return reader->read(0, 0, 123, 77).get<mapnik::image_rgba8>();
+        };
+        std::string baseline = mapnik::save_to_string(im, "jpeg90");
+        // the compressor of the thread is reused
+        CHECK(mapnik::save_to_string(im, "jpeg90") == baseline);
+        CHECK(mapnik::save_to_string(mapnik::image_view_rgba8(0, 0, 123, 77, im), "jpeg90") == baseline);
+        auto decoded = decode(baseline);
+        for (std::string const format : {"jpeg90:optimize", "jpeg90:progressive"})
+        {
+            INFO(format);
+            std::string data = mapnik::save_to_string(im, format);
+            CHECK(data != baseline);
+            // only the entropy coding differs
+            CHECK(mapnik::compare(decode(data), decoded) == 0);
+        }
+        CHECK(mapnik::save_to_string(im, "jpeg90:optimize").size() < baseline.size());
+        // a failed encode leaves the compressor usable
+        std::ostringstream ss(std::ios::out | std::ios::binary);
+        CHECK_THROWS_AS(mapnik::save_to_stream(mapnik::image_rgba8(70000, 1), ss, "jpeg"),
+                        mapnik::image_writer_exception);
+        CHECK(mapnik::save_to_string(im, "jpeg90") == baseline);
+    } // END SECTION
+#endif
+
+    SECTION("images decoded at a reduced size")
+    {
+        mapnik::image_rgba8 im(200, 120);
+        for (std::size_t y = 0; y < im.height(); ++y)
+        {
+            for (std::size_t x = 0; x < im.width(); ++x)
+            {
+                im(x, y) = mapnik::color(x, y * 2, 128, 255).rgba();
+            }
+        }
+#if defined(HAVE_JPEG)
+        std::string jpeg = mapnik::save_to_string(im, "jpeg95");
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(jpeg.data(), jpeg.size()));
+        REQUIRE(reader);
+        CHECK(reader->scale_denominator(200, 120, 25, 15) == 8);
+        CHECK(reader->scale_denominator(200, 120, 50, 15) == 4);
+        CHECK(reader->scale_denominator(200, 120, 26, 60) == 2);
+        CHECK(reader->scale_denominator(200, 120, 101, 10) == 1);
+        auto quarter = reader->read_scaled(0, 0, 200, 120, 4).get<mapnik::image_rgba8>();
+        CHECK(quarter.width() == 50);
+        CHECK(quarter.height() == 30);
+        // close to the averages of the 4x4 pixels
+        for (std::size_t y = 0; y < quarter.height(); ++y)
+        {
+            for (std::size_t x = 0; x < quarter.width(); ++x)
+            {
+                mapnik::color c(quarter(x, y), false);
+                CHECK(std::abs(int(c.red()) - int(x * 4 + 1)) <= 3);
+                CHECK(std::abs(int(c.green()) - int(y * 8 + 3)) <= 3);
+            }
+        }
+        // windows are cut from the shrunk image
+        auto window = reader->read_scaled(40, 16, 84, 40, 4).get<mapnik::image_rgba8>();
+        REQUIRE(window.width() == 21);
+        REQUIRE(window.height() == 10);
+        for (std::size_t y = 0; y < window.height(); ++y)
+        {
+            for (std::size_t x = 0; x < window.width(); ++x)
+            {
+                CHECK(window(x, y) == quarter(x + 10, y + 4));
+            }
+        }
+        CHECK(mapnik::compare(reader->read_scaled(0, 0, 200, 120, 1), reader->read(0, 0, 200, 120)) == 0);
+        CHECK_THROWS_AS(reader->read_scaled(0, 0, 200, 120, 3), mapnik::image_reader_exception);
+        // whole pixels of the shrunk image, also past the edges
+        CHECK(reader->scaled_window(40, 16, 82, 38, 4) == mapnik::box2d<double>(40, 16, 124, 56));
+        CHECK(reader->scaled_window(192, 112, 8, 8, 8) == mapnik::box2d<double>(192, 112, 200, 120));
+        CHECK(reader->scaled_window(188, 104, 12, 16, 8) == mapnik::box2d<double>(188, 104, 204, 120));
+#endif
+#if defined(HAVE_WEBP)
+        std::string webp = mapnik::save_to_string(im, "webp:lossless=1");
+        std::unique_ptr<mapnik::image_reader> webp_reader(mapnik::get_image_reader(webp.data(), webp.size()));
+        REQUIRE(webp_reader);
+        auto webp_quarter = webp_reader->read_scaled(0, 0, 200, 120, 4).get<mapnik::image_rgba8>();
+        // shrunk by exactly 4 inside the image, whatever the size of the window
+        auto webp_window = webp_reader->read_scaled(40, 16, 82, 38, 4).get<mapnik::image_rgba8>();
+        REQUIRE(webp_window.width() == 21);
+        REQUIRE(webp_window.height() == 10);
+        for (std::size_t y = 0; y < webp_window.height(); ++y)
+        {
+            for (std::size_t x = 0; x < webp_window.width(); ++x)
+            {
+                mapnik::color c(webp_window(x, y), false);
+                mapnik::color expected(webp_quarter(x + 10, y + 4), false);
+                CHECK(std::abs(int(c.red()) - int(expected.red())) <= 2);
+                CHECK(std::abs(int(c.green()) - int(expected.green())) <= 2);
+            }
+        }
+        CHECK(webp_reader->scaled_window(40, 16, 82, 38, 4) == mapnik::box2d<double>(40, 16, 124, 56));
+        // what is left of the image is stretched over the last pixels
+        CHECK(webp_reader->scaled_window(188, 104, 12, 16, 8) == mapnik::box2d<double>(188, 104, 200, 120));
+#endif
+#if defined(HAVE_PNG)
+        std::string png = mapnik::save_to_string(im, "png32");
+        std::unique_ptr<mapnik::image_reader> png_reader(mapnik::get_image_reader(png.data(), png.size()));
+        REQUIRE(png_reader);
+        CHECK(png_reader->scale_denominator(200, 120, 25, 15) == 1);
+        CHECK(mapnik::compare(png_reader->read_scaled(0, 0, 200, 120, 1), png_reader->read(0, 0, 200, 120)) == 0);
+        CHECK_THROWS_AS(png_reader->read_scaled(0, 0, 200, 120, 2), mapnik::image_reader_exception);
+#endif
+    } // END SECTION
+
+#if defined(HAVE_PNG)
+    SECTION("png windows")
+    {
+        mapnik::image_rgba8 im(300, 200);
+        for (std::size_t y = 0; y < im.height(); ++y)
+        {
+            for (std::size_t x = 0; x < im.width(); ++x)
+            {
+                im(x, y) = mapnik::color(x % 256, y, (x * y) % 256, 255 - x % 100).rgba();
+            }
+        }
+        // whole rows kept, 100 columns of 64 rows, and nothing kept
+        for (std::size_t cache_size : {std::size_t(64 * 1024 * 1024), std::size_t(64 * 100 * 4), std::size_t(16)})
+        {
+            INFO(cache_size);
+            mapnik::set_png_reader_cache_size(cache_size);
+            for (std::string const format : {"png32", "png8"})
+            {
+                INFO(format);
+                std::string data = mapnik::save_to_string(im, format);
+                std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(data.data(), data.size()));
+                REQUIRE(reader);
+                auto full = reader->read(0, 0, 300, 200).get<mapnik::image_rgba8>();
+                auto crop = [&](unsigned x, unsigned y, unsigned width, unsigned height) {
+                    mapnik::image_rgba8 result(width, height);
+                    for (unsigned j = y; j < std::min(y + height, 200u); ++j)
+                    {
+                        for (unsigned i = x; i < std::min(x + width, 300u); ++i)
+                        {
+                            result(i - x, j - y) = full(i, j);
+                        }
+                    }
+                    return result;
+                };
+                // next to each other, within the last one, further down, back up
+                // and past the edges
+                std::vector<mapnik::image_reader::window> windows{{0, 20, 64, 64},
+                                                                  {64, 20, 64, 40},
+                                                                  {70, 30, 20, 20},
+                                                                  {200, 90, 64, 64},
+                                                                  {10, 5, 30, 10},
+                                                                  {250, 180, 64, 64},
+                                                                  {0, 199, 300, 1}};
+                for (auto const& w : windows)
+                {
+                    auto window = reader->read(w.x, w.y, w.width, w.height).get<mapnik::image_rgba8>();
+                    CHECK(mapnik::compare(window, crop(w.x, w.y, w.width, w.height)) == 0);
+                }
+                auto images = reader->read_windows(windows);
+                REQUIRE(images.size() == windows.size());
+                for (std::size_t i = 0; i < windows.size(); ++i)
+                {
+                    auto const& w = windows[i];
+                    CHECK(mapnik::compare(images[i].get<mapnik::image_rgba8>(), crop(w.x, w.y, w.width, w.height)) ==
+                          0);
+                }
+                // a fresh reader too
+                std::unique_ptr<mapnik::image_reader> other(mapnik::get_image_reader(data.data(), data.size()));
+                images = other->read_windows(windows);
+                CHECK(mapnik::compare(images[3].get<mapnik::image_rgba8>(), crop(200, 90, 64, 64)) == 0);
+                CHECK(mapnik::compare(other->read(0, 0, 300, 200), reader->read(0, 0, 300, 200)) == 0);
+            }
+        }
+        mapnik::set_png_reader_cache_size(64 * 1024 * 1024);
+    } // END SECTION
+#endif
+
+#if defined(HAVE_PNG)
+    SECTION("several formats at once")
+    {
+        mapnik::image_rgba8 im(300, 200);
+        for (std::size_t y = 0; y < im.height(); ++y)
+        {
+            for (std::size_t x = 0; x < im.width(); ++x)
+            {
+                im(x, y) = mapnik::color(x % 256, y, (x * y) % 256, 255 - x % 100).rgba();
+            }
+        }
+        std::vector<std::string> formats{"png8", "png32:z=1", "PNG8", "png8:m=o"};
+#if defined(HAVE_JPEG)
+        formats.emplace_back("jpeg80");
+#endif
+        for (int threads : {1, 0, 3})
+        {
+            auto encoded = mapnik::save_to_strings(im, formats, threads);
+            REQUIRE(encoded.size() == formats.size());
+            for (std::size_t i = 0; i < formats.size(); ++i)
+            {
+                CHECK(encoded[i] == mapnik::save_to_string(im, formats[i]));
+            }
+        }
+        mapnik::image_any any{mapnik::image_rgba8(im)};
+        CHECK(mapnik::save_to_strings(any, {"png32", "png8"}) ==
+              std::vector<std::string>{mapnik::save_to_string(im, "png32"), mapnik::save_to_string(im, "png8")});
+        CHECK(mapnik::save_to_strings(im, {}).empty());
+        CHECK_THROWS_AS(mapnik::save_to_strings(im, {"png32", "bogus"}), mapnik::image_writer_exception);
+        CHECK_THROWS_AS(mapnik::save_to_strings(mapnik::image_rgba8(), {"png32"}), mapnik::image_writer_exception);
+
+        // solid images come from the cache for every format
+        auto& cache = mapnik::solid_image_cache::instance();
+        cache.clear();
+        mapnik::image_rgba8 solid(256, 256);
+        mapnik::fill(solid, mapnik::color(170, 211, 223));
+        auto tiles = mapnik::save_to_strings(solid, {"png8", "png32"});
+        CHECK(cache.size() == 2);
+        CHECK(tiles[0] == mapnik::save_to_string(solid, "png8"));
+        CHECK(tiles[1] == mapnik::save_to_string(solid, "png32"));
+        CHECK(cache.size() == 2);
+    } // END SECTION
+#endif
+
     SECTION("Quantising small (less than 3 pixel images preserve original colours")
     {
 #if defined(HAVE_PNG)
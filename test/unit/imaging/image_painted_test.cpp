@@ -69,4 +69,57 @@ TEST_CASE("image")
             REQUIRE(false);
         }
     }
+
+    SECTION("painting on an intermediate buffer")
+    {
+        using namespace mapnik;
+
+        std::string csv_plugin("./plugins/input/csv.input");
+        if (mapnik::util::exists(csv_plugin))
+        {
+            Map m(256, 256);
+
+            feature_type_style lines_style;
+            {
+                rule r;
+                r.set_filter(parse_expression("[name] = 'a'"));
+                line_symbolizer line_sym;
+                r.append(std::move(line_sym));
+                lines_style.add_rule(std::move(r));
+            }
+            // drawn on an internal buffer and composited
+            lines_style.set_comp_op(multiply);
+            m.insert_style("lines", std::move(lines_style));
+
+            parameters p;
+            p["type"] = "csv";
+            p["separator"] = "|";
+            p["inline"] = "wkt|name\nLINESTRING(-10  0, 0 20, 10 0, 15 5)|b";
+
+            layer lyr("layer");
+            lyr.set_datasource(datasource_cache::instance().create(p));
+            lyr.add_style("lines");
+            lyr.set_opacity(0.5);
+            m.add_layer(lyr);
+            m.zoom_all();
+
+            {
+                image_rgba8 image(m.width(), m.height());
+                agg_renderer<image_rgba8> ren(m, image);
+                ren.apply();
+                CHECK_FALSE(ren.painted());
+                CHECK_FALSE(image.painted());
+            }
+
+            p["inline"] = "wkt|name\nLINESTRING(-10  0, 0 20, 10 0, 15 5)|a";
+            m.get_layer(0).set_datasource(datasource_cache::instance().create(p));
+            {
+                image_rgba8 image(m.width(), m.height());
+                agg_renderer<image_rgba8> ren(m, image);
+                ren.apply();
+                CHECK(ren.painted());
+                CHECK(image.painted());
+            }
+        }
+    }
 }
@@ -3,8 +3,14 @@
 
 #include "catch.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <sstream>
+#include <string>
 
+#include <mapnik/color.hpp>
+#include <mapnik/image_reader.hpp>
+#include <mapnik/image_util.hpp>
 #include <mapnik/image_view.hpp>
 #include <mapnik/webp_io.hpp>
 
@@ -22,6 +28,84 @@ TEST_CASE("webp io")
         }
         save_as_webp(s, view, config, true);
     }
+
+    mapnik::image_rgba8 im(64, 48);
+    for (std::size_t y = 0; y < im.height(); ++y)
+    {
+        for (std::size_t x = 0; x < im.width(); ++x)
+        {
+            im(x, y) = mapnik::color(x * 4, y * 5, (x * y) % 256, x < 8 ? 0 : 255).rgba();
+        }
+    }
+
+    SECTION("views are encoded like images")
+    {
+        mapnik::image_rgba8 big(128, 96);
+        mapnik::image_view_rgba8 view(32, 16, im.width(), im.height(), big);
+        for (std::size_t y = 0; y < im.height(); ++y)
+        {
+            std::copy_n(im.get_row(y), im.width(), big.get_row(y + 16, 32));
+        }
+        for (std::string const format : {"webp", "webp:alpha=false", "webp:lossless=1", "webp:use_sharp_yuv=1"})
+        {
+            INFO(format);
+            CHECK(mapnik::save_to_string(view, format) == mapnik::save_to_string(im, format));
+            // again, with the buffers of the previous call
+            CHECK(mapnik::save_to_string(im, format) == mapnik::save_to_string(im, format));
+        }
+    }
+
+    SECTION("encoder options")
+    {
+        for (std::string const format : {"webp:thread_level=1:method=6:pass=3:segments=2",
+                                         "webp:preset=drawing:quality=80",
+                                         "webp:preset=photo:use_sharp_yuv=1",
+                                         "webp:lossless=1:near_lossless=60",
+                                         "webp:lossless=1:exact=true"})
+        {
+            INFO(format);
+            CHECK(!mapnik::save_to_string(im, format).empty());
+        }
+        for (std::string const format : {"webp:thread_level=2",
+                                         "webp:pass=0",
+                                         "webp:segments=5",
+                                         "webp:preset=map",
+                                         "webp:near_lossless=101",
+                                         "webp:exact=maybe",
+                                         "webp:use_sharp_yuv=2"})
+        {
+            INFO(format);
+            CHECK_THROWS_AS(mapnik::save_to_string(im, format), mapnik::image_writer_exception);
+        }
+        // the options of a preset give way to those set
+        CHECK(mapnik::save_to_string(im, "webp:preset=text:quality=75:method=4") ==
+              mapnik::save_to_string(im, "webp:method=4:preset=text"));
+    }
+
+    SECTION("lossless exact keeps every pixel")
+    {
+        std::string encoded = mapnik::save_to_string(im, "webp:lossless=1:exact=1");
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(encoded.data(), encoded.size()));
+        REQUIRE(reader);
+        auto decoded = reader->read(0, 0, im.width(), im.height());
+        REQUIRE(decoded.is<mapnik::image_rgba8>());
+        CHECK(mapnik::compare(decoded.get<mapnik::image_rgba8>(), im) == 0);
+    }
+
+    SECTION("decoded at a reduced size")
+    {
+        std::string encoded = mapnik::save_to_string(im, "webp:lossless=1");
+        std::unique_ptr<mapnik::image_reader> reader(mapnik::get_image_reader(encoded.data(), encoded.size()));
+        REQUIRE(reader);
+        CHECK(reader->scale_denominator(64, 48, 16, 12) == 4);
+        CHECK(reader->scale_denominator(64, 48, 17, 12) == 2);
+        auto scaled = reader->read_scaled(8, 8, 40, 30, 4);
+        REQUIRE(scaled.is<mapnik::image_rgba8>());
+        CHECK(scaled.width() == 10);
+        CHECK(scaled.height() == 8);
+        auto full = reader->read_scaled(0, 0, 64, 48, 1);
+        CHECK(mapnik::compare(full.get<mapnik::image_rgba8>(), im) == 0);
+    }
 }
 
 #endif
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <mapnik/agg_blit.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/geometry/point.hpp>
+
+#include "agg_color_rgba.h"
+#include "agg_pixfmt_rgba.h"
+#include "agg_rendering_buffer.h"
+#include "agg_renderer_base.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using blender_type = agg::comp_op_adaptor_rgba_pre<agg::rgba8, agg::order_rgba>;
+using pixfmt_type = agg::pixfmt_custom_blend_rgba<blender_type, agg::rendering_buffer>;
+using renderer_type = agg::renderer_base<pixfmt_type>;
+
+// premultiplied pixels, a third of them transparent and a third opaque
+mapnik::image_rgba8 random_image(std::default_random_engine& engine, int width, int height)
+{
+    mapnik::image_rgba8 image(width, height);
+    std::uniform_int_distribution<int> kind(0, 2);
+    std::uniform_int_distribution<int> value(0, 255);
+    unsigned char* bytes = image.bytes();
+    for (std::size_t i = 0; i < image.size(); i += 4)
+    {
+        int k = kind(engine);
+        unsigned a = k == 0 ? 0 : k == 1 ? 255 : value(engine);
+        for (std::size_t c = 0; c < 3; ++c)
+        {
+            bytes[i + c] = static_cast<unsigned char>(value(engine) * a / 255);
+        }
+        bytes[i + 3] = static_cast<unsigned char>(a);
+    }
+    image.set_premultiplied(true);
+    return image;
+}
+
+struct canvas
+{
+    canvas(mapnik::image_rgba8 const& background, agg::comp_op_e op)
+        : image(background)
+        , buffer(image.bytes(), image.width(), image.height(), image.row_size())
+        , pixf(buffer)
+        , renb(pixf)
+    {
+        pixf.comp_op(op);
+        // a clip box smaller than the image
+        renb.clip_box(3, 2, image.width() - 5, image.height() - 4);
+    }
+
+    mapnik::image_rgba8 image;
+    agg::rendering_buffer buffer;
+    pixfmt_type pixf;
+    renderer_type renb;
+};
+
+bool same(mapnik::image_rgba8 const& a, mapnik::image_rgba8 const& b)
+{
+    return std::memcmp(a.bytes(), b.bytes(), a.size()) == 0;
+}
+
+} // namespace
+
+TEST_CASE("agg blit")
+{
+    std::default_random_engine engine(7);
+    mapnik::image_rgba8 background = random_image(engine, 48, 40);
+    std::vector<mapnik::geometry::point<int>> positions{
+      {-20, 5}, {0, 0}, {10, 12}, {13, 12}, {40, 33}, {-5, -7}, {60, 5}, {30, -30}};
+
+    SECTION("matches blend_from")
+    {
+        for (agg::comp_op_e op : {agg::comp_op_src_over, agg::comp_op_multiply})
+        {
+            for (unsigned cover : {255u, 180u, 1u, 0u})
+            {
+                mapnik::image_rgba8 src = random_image(engine, 13, 9);
+                canvas expected(background, op);
+                canvas actual(background, op);
+                for (auto const& pos : positions)
+                {
+                    mapnik::detail::blend_from(expected.renb, src, pos.x, pos.y, cover);
+                    mapnik::blit_rgba8(actual.renb, src, pos.x, pos.y, cover);
+                }
+                CHECK(same(expected.image, actual.image));
+            }
+        }
+    }
+
+    SECTION("instances match single blits")
+    {
+        for (agg::comp_op_e op : {agg::comp_op_src_over, agg::comp_op_multiply})
+        {
+            for (unsigned cover : {255u, 100u})
+            {
+                mapnik::image_rgba8 src = random_image(engine, 11, 14);
+                canvas expected(background, op);
+                canvas actual(background, op);
+                for (auto const& pos : positions)
+                {
+                    mapnik::detail::blend_from(expected.renb, src, pos.x, pos.y, cover);
+                }
+                mapnik::blit_rgba8_instances(actual.renb, src, positions, cover);
+                CHECK(same(expected.image, actual.image));
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#include "catch.hpp"
+
+#include <mapnik/renderer_common/label_placement_queue.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/geometry.hpp>
+#include <mapnik/image_filter_types.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+
+#include <vector>
+
+TEST_CASE("label_placement_queue")
+{
+    SECTION("candidates are flushed by descending priority")
+    {
+        mapnik::projection merc("epsg:3857");
+        mapnik::proj_transform prj_trans(merc, merc);
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        mapnik::text_symbolizer text;
+        mapnik::shield_symbolizer shield;
+        mapnik::label_placement_queue queue;
+        mapnik::box2d<double> clip_box(0, 0, 256, 256);
+        std::vector<double> priorities{1.0, 5.0, 1.0, 10.0, 5.0};
+        for (std::size_t i = 0; i < priorities.size(); ++i)
+        {
+            mapnik::feature_impl feature(ctx, static_cast<mapnik::value_integer>(i));
+            feature.set_geometry(mapnik::geometry::point<double>(i, i));
+            if (i % 2 == 0)
+                queue.push(priorities[i], text, feature, prj_trans, clip_box);
+            else
+                queue.push(priorities[i], shield, feature, prj_trans, clip_box);
+        }
+        REQUIRE(queue.size() == priorities.size());
+
+        std::vector<mapnik::value_integer> order;
+        queue.flush([&](mapnik::label_placement_candidate const& candidate) {
+            order.push_back(candidate.feature->id());
+            CHECK(candidate.shield == (candidate.feature->id() % 2 == 1));
+            CHECK(candidate.prj_trans == &prj_trans);
+            CHECK(candidate.feature->get_geometry().is<mapnik::geometry::point<double>>());
+        });
+        CHECK(queue.empty());
+        // equal priorities keep the order they were queued in
+        CHECK(order == std::vector<mapnik::value_integer>{3, 1, 4, 0, 2});
+    }
+
+    SECTION("only styles drawn straight onto the map queue labels")
+    {
+        mapnik::Map map(256, 256);
+        mapnik::feature_type_style plain;
+        mapnik::feature_type_style blended;
+        blended.set_comp_op(mapnik::multiply);
+        mapnik::feature_type_style translucent;
+        translucent.set_opacity(0.5f);
+        mapnik::feature_type_style filtered;
+        filtered.direct_image_filters().emplace_back(mapnik::filter::blur());
+        map.insert_style("plain", plain);
+        map.insert_style("blended", blended);
+        map.insert_style("translucent", translucent);
+        map.insert_style("filtered", filtered);
+
+        mapnik::label_placement_queue queue;
+        mapnik::layer lay("roads");
+        lay.add_style("plain");
+        CHECK_FALSE(queue.start_layer(map, lay));
+        queue.start_style(plain);
+        CHECK(queue.active());
+        queue.start_style(translucent);
+        CHECK_FALSE(queue.active());
+        queue.start_style(filtered);
+        CHECK_FALSE(queue.active());
+
+        mapnik::layer composited("water");
+        composited.set_opacity(0.5);
+        composited.add_style("plain");
+        CHECK_FALSE(queue.start_layer(map, composited));
+        queue.start_style(plain);
+        CHECK_FALSE(queue.active());
+
+        // queued labels are placed before layers changing what is below them
+        mapnik::projection merc("epsg:3857");
+        mapnik::proj_transform prj_trans(merc, merc);
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        mapnik::feature_impl feature(ctx, 1);
+        mapnik::text_symbolizer text;
+        queue.push(1.0, text, feature, prj_trans, mapnik::box2d<double>(0, 0, 256, 256));
+        CHECK_FALSE(queue.start_layer(map, lay));
+        CHECK_FALSE(queue.start_layer(map, composited));
+        mapnik::layer cleared("places");
+        cleared.set_clear_label_cache(true);
+        CHECK(queue.start_layer(map, cleared));
+        mapnik::layer multiply("hillshade");
+        multiply.add_style("blended");
+        CHECK(queue.start_layer(map, multiply));
+        mapnik::layer blurred("shadows");
+        blurred.add_style("filtered");
+        CHECK(queue.start_layer(map, blurred));
+    }
+}
@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/image_row_writer.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/symbolizer.hpp>
+
+#include <algorithm>
+
+namespace {
+
+// Copies the rows it is given into an image.
+class image_copy_writer : public mapnik::image_row_writer
+{
+  public:
+    image_copy_writer(unsigned width, unsigned height)
+        : mapnik::image_row_writer(width, height)
+        , image(width, height)
+        , finished(false)
+        , max_rows(0)
+    {}
+
+    mapnik::image_rgba8 image;
+    bool finished;
+    unsigned max_rows;
+
+  protected:
+    void write_rows(mapnik::image_view_rgba8 const& rows) override
+    {
+        for (std::size_t y = 0; y < rows.height(); ++y)
+        {
+            std::copy_n(rows.get_row(y), rows.width(), image.get_row(rows_written() + y));
+        }
+        max_rows = std::max(max_rows, static_cast<unsigned>(rows.height()));
+    }
+
+    void finish_image() override { finished = true; }
+};
+
+mapnik::Map prepare_map()
+{
+    mapnik::parameters params;
+    params["type"] = "memory";
+    auto ds = std::make_shared<mapnik::memory_datasource>(params);
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    for (int i = 0; i < 20; ++i)
+    {
+        mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i));
+        mapnik::geometry::line_string<double> path;
+        path.emplace_back(-100 + i * 10, -80);
+        path.emplace_back(-60 + i * 7, 90 - i * 3);
+        path.emplace_back(100 - i * 9, -20 + i * 5);
+        feature->set_geometry(std::move(path));
+        ds->push(feature);
+    }
+
+    mapnik::Map map(200, 150);
+    map.set_background(mapnik::color(250, 240, 230));
+    map.set_buffer_size(16);
+    mapnik::feature_type_style style;
+    mapnik::rule rule;
+    mapnik::line_symbolizer line_sym;
+    mapnik::put(line_sym, mapnik::keys::stroke_width, 3.0);
+    rule.append(std::move(line_sym));
+    style.add_rule(std::move(rule));
+    map.insert_style("lines", std::move(style));
+    mapnik::layer lyr("layer");
+    lyr.set_datasource(ds);
+    lyr.add_style("lines");
+    map.add_layer(lyr);
+    map.zoom_to_box(mapnik::box2d<double>(-100, -75, 100, 75));
+    return map;
+}
+
+} // namespace
+
+TEST_CASE("render_in_bands")
+{
+    mapnik::Map map = prepare_map();
+    mapnik::image_rgba8 whole(map.width(), map.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(map, whole);
+    ren.apply();
+
+    SECTION("bands put together match the whole image")
+    {
+        for (unsigned band_height : {1u, 32u, 40u, 150u, 1000u})
+        {
+            INFO(band_height);
+            image_copy_writer writer(map.width(), map.height());
+            mapnik::render_in_bands(map, writer, band_height);
+            CHECK(writer.finished);
+            CHECK(writer.max_rows == std::min(std::max(band_height, 16u), map.height()));
+            CHECK(mapnik::compare(writer.image, whole, 1) == 0);
+        }
+    }
+
+    SECTION("the writer has the size of the map")
+    {
+        image_copy_writer writer(map.width(), map.height() + 1);
+        CHECK_THROWS(mapnik::render_in_bands(map, writer, 32));
+    }
+}
@@ -0,0 +1,153 @@
+#include "catch.hpp"
+
+#include <mapnik/renderer_common/render_thunk_cache.hpp>
+#include <mapnik/group/group_layout.hpp>
+#include <mapnik/group/group_rule.hpp>
+#include <mapnik/group/group_symbolizer_properties.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/expression.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/text/placements/dummy.hpp>
+#include <mapnik/text/formatting/text.hpp>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace {
+
+mapnik::text_placements_ptr make_placements(std::string const& text)
+{
+    mapnik::text_placements_ptr placements = std::make_shared<mapnik::text_placements_dummy>();
+    placements->defaults.format_defaults.face_name = "DejaVu Sans Book";
+    placements->defaults.format_defaults.text_size = 10.0;
+    placements->defaults.format_defaults.fill = mapnik::color(0, 0, 0);
+    placements->defaults.set_format_tree(
+      std::make_shared<mapnik::formatting::text_node>(mapnik::parse_expression(text)));
+    return placements;
+}
+
+mapnik::image_rgba8 render_groups(mapnik::Map& m, mapnik::value_integer cache_size)
+{
+    m.get_extra_parameters()["group-layout-cache-size"] = cache_size;
+    mapnik::image_rgba8 buf(m.width(), m.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(m, buf);
+    ren.apply();
+    return buf;
+}
+
+} // namespace
+
+TEST_CASE("render_thunk_cache")
+{
+    using cache_type = mapnik::render_thunk_cache;
+    mapnik::box2d<double> extent(0, 0, 256, 256);
+    auto rule = std::make_shared<mapnik::group_rule>();
+    auto other = std::make_shared<mapnik::group_rule>();
+    auto make_key = [&](mapnik::group_rule const* r, mapnik::value_integer index, mapnik::value const& ref) {
+        return cache_type::key{r, index, extent, {ref, mapnik::value_unicode_string("shield")}};
+    };
+
+    SECTION("keys compare rule, index, extent and values")
+    {
+        auto key = make_key(rule.get(), 1, mapnik::value_integer(7));
+        CHECK(key == make_key(rule.get(), 1, mapnik::value_integer(7)));
+        CHECK(!(key == make_key(other.get(), 1, mapnik::value_integer(7))));
+        CHECK(!(key == make_key(rule.get(), 2, mapnik::value_integer(7))));
+        CHECK(!(key == make_key(rule.get(), 1, mapnik::value_integer(8))));
+        // equal values of other types are formatted differently
+        CHECK(!(key == make_key(rule.get(), 1, mapnik::value_double(7.0))));
+        CHECK(!(key == make_key(rule.get(), 1, mapnik::value_unicode_string("7"))));
+        auto moved = make_key(rule.get(), 1, mapnik::value_integer(7));
+        moved.clipping_extent = mapnik::box2d<double>(-64, -64, 320, 320);
+        CHECK(!(key == moved));
+    }
+
+    SECTION("layouts are found until cleared")
+    {
+        cache_type cache(2);
+        CHECK(cache.capacity() == 2);
+        CHECK(cache.find(make_key(rule.get(), 1, mapnik::value_integer(7))) == nullptr);
+        auto& layout = cache.insert(make_key(rule.get(), 1, mapnik::value_integer(7)));
+        layout.bounds = mapnik::box2d<double>(-10, -5, 10, 5);
+        layout.feature = mapnik::feature_factory::create(std::make_shared<mapnik::context_type>(), 1);
+        cache.insert(make_key(rule.get(), 2, mapnik::value_integer(7)));
+        CHECK(cache.size() == 2);
+        auto const* found = cache.find(make_key(rule.get(), 1, mapnik::value_integer(7)));
+        REQUIRE(found == &layout);
+        CHECK(found->bounds == mapnik::box2d<double>(-10, -5, 10, 5));
+        CHECK(found->thunks.empty());
+        cache.clear();
+        CHECK(cache.size() == 0);
+        CHECK(cache.find(make_key(rule.get(), 1, mapnik::value_integer(7))) == nullptr);
+    }
+}
+
+TEST_CASE("group symbolizer layouts")
+{
+    SECTION("reused layouts render the same map as layouts of every feature")
+    {
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        ctx->push("ref1");
+        ctx->push("ref2");
+        mapnik::parameters params;
+        params["type"] = "memory";
+        auto ds = std::make_shared<mapnik::memory_datasource>(params);
+        mapnik::transcoder tr("utf-8");
+        for (int i = 0; i < 300; ++i)
+        {
+            // few distinct routes, as along roads
+            mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i));
+            feature->put("ref1", tr.transcode(("A" + std::to_string(i % 5)).c_str()));
+            feature->put("ref2", tr.transcode(("B" + std::to_string(i % 3)).c_str()));
+            feature->set_geometry(mapnik::geometry::point<double>((i * 37) % 480 - 240, (i * 53) % 480 - 240));
+            ds->push(feature);
+        }
+
+        auto group_rule = std::make_shared<mapnik::group_rule>();
+        mapnik::markers_symbolizer marker_sym;
+        mapnik::put<double>(marker_sym, mapnik::keys::width, 16.0);
+        mapnik::put<double>(marker_sym, mapnik::keys::height, 12.0);
+        group_rule->append(std::move(marker_sym));
+        mapnik::text_symbolizer text_sym;
+        mapnik::put<mapnik::text_placements_ptr>(text_sym, mapnik::keys::text_placements_, make_placements("[ref%]"));
+        group_rule->append(std::move(text_sym));
+        auto props = std::make_shared<mapnik::group_symbolizer_properties>();
+        props->set_layout(mapnik::simple_row_layout(2.0));
+        props->add_rule(group_rule);
+        mapnik::group_symbolizer group_sym;
+        mapnik::put<mapnik::value_integer>(group_sym, mapnik::keys::start_column, 1);
+        mapnik::put<mapnik::value_integer>(group_sym, mapnik::keys::num_columns, 2);
+        mapnik::put<mapnik::text_placements_ptr>(group_sym, mapnik::keys::text_placements_, make_placements("''"));
+        mapnik::put(group_sym, mapnik::keys::group_properties, props);
+
+        mapnik::Map m(256, 256);
+        REQUIRE(m.register_fonts("fonts", true));
+        mapnik::layer lyr("layer");
+        lyr.set_datasource(ds);
+        lyr.add_style("style");
+        m.add_layer(lyr);
+        mapnik::feature_type_style the_style;
+        mapnik::rule r;
+        r.append(std::move(group_sym));
+        the_style.add_rule(std::move(r));
+        m.insert_style("style", std::move(the_style));
+        m.zoom_to_box(mapnik::box2d<double>(-256, -256, 256, 256));
+
+        mapnik::image_rgba8 cached = render_groups(m, 4096);
+        CHECK(!mapnik::is_solid(cached));
+        // 0 keeps the layouts for one feature only
+        CHECK(mapnik::compare(cached, render_groups(m, 0)) == 0);
+        // dropped while rendering
+        CHECK(mapnik::compare(cached, render_groups(m, 4)) == 0);
+    }
+}
@@ -0,0 +1,236 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+#include "catch.hpp"
+
+#include <mapnik/marker.hpp>
+#include <mapnik/marker_cache.hpp>
+#include <mapnik/vertex.hpp>
+#include <mapnik/svg/svg_parser.hpp>
+#include <mapnik/svg/svg_converter.hpp>
+#include <mapnik/svg/svg_path_adapter.hpp>
+#include <mapnik/svg/svg_path_attributes.hpp>
+#include <mapnik/svg/svg_icon_pack.hpp>
+#include <mapnik/util/fs.hpp>
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+mapnik::svg_path_ptr parse(std::string const& svg_string)
+{
+    using namespace mapnik::svg;
+    mapnik::svg_path_ptr marker_path(std::make_shared<mapnik::svg_storage_type>());
+    vertex_stl_adapter<svg_path_storage> stl_storage(marker_path->source());
+    svg_path_adapter svg_path(stl_storage);
+    svg_converter_type svg(svg_path, marker_path->attributes());
+    svg_parser p(svg, true);
+    p.parse_from_string(svg_string);
+    double lox, loy, hix, hiy;
+    svg.bounding_rect(&lox, &loy, &hix, &hiy);
+    marker_path->set_bounding_box(lox, loy, hix, hiy);
+    marker_path->set_dimensions(svg.width(), svg.height());
+    return marker_path;
+}
+
+std::string const gradients_svg =
+  "<svg width='120' height='60' xmlns='http://www.w3.org/2000/svg'>"
+  "<defs><linearGradient id='g' x1='0' y1='0' x2='1' y2='0'>"
+  "<stop offset='0' stop-color='red'/><stop offset='1' stop-color='blue' stop-opacity='0.5'/>"
+  "</linearGradient></defs>"
+  "<rect x='1' y='1' width='50' height='50' fill='url(#g)'/>"
+  "<rect x='60' y='1' width='50' height='50' fill='url(#g)' stroke='black' stroke-dasharray='2,1'/>"
+  "<path d='M 5.25 55.5 C 10 58 20.125 58 30 55.5' fill='none' stroke='#336699' stroke-width='1.5'/>"
+  "</svg>";
+
+std::string const arrow_svg = "<svg width='20' height='10' xmlns='http://www.w3.org/2000/svg'>"
+                              "<path fill='#0000FF' stroke='black' stroke-width='.5' "
+                              "d='m 19.5,5 -8,-4.5 0,3 -11,0 0,3 11,0 0,3 z'/>"
+                              "</svg>";
+
+unsigned rgba(agg::rgba8 const& c)
+{
+    return unsigned(c.r) << 24 | unsigned(c.g) << 16 | unsigned(c.b) << 8 | unsigned(c.a);
+}
+
+void require_equal(mapnik::svg_storage_type const& expected, mapnik::svg_storage_type const& actual)
+{
+    REQUIRE(actual.bounding_box() == expected.bounding_box());
+    REQUIRE(actual.width() == expected.width());
+    REQUIRE(actual.height() == expected.height());
+    REQUIRE(actual.source().size() == expected.source().size());
+    for (std::size_t i = 0; i < expected.source().size(); ++i)
+    {
+        CHECK(actual.source()[i].x == expected.source()[i].x);
+        CHECK(actual.source()[i].y == expected.source()[i].y);
+        CHECK(actual.source()[i].cmd == expected.source()[i].cmd);
+    }
+    REQUIRE(actual.attributes().size() == expected.attributes().size());
+    for (std::size_t i = 0; i < expected.attributes().size(); ++i)
+    {
+        auto const& a = expected.attributes()[i];
+        auto const& b = actual.attributes()[i];
+        CHECK(b.index == a.index);
+        CHECK(b.fill_gradient == a.fill_gradient);
+        CHECK(b.stroke_gradient == a.stroke_gradient);
+        CHECK(b.transform == a.transform);
+        CHECK(b.opacity == a.opacity);
+        CHECK(b.fill_opacity == a.fill_opacity);
+        CHECK(b.stroke_opacity == a.stroke_opacity);
+        CHECK(b.stroke_width == a.stroke_width);
+        CHECK(rgba(b.fill_color) == rgba(a.fill_color));
+        CHECK(rgba(b.stroke_color) == rgba(a.stroke_color));
+        CHECK(b.line_join == a.line_join);
+        CHECK(b.line_cap == a.line_cap);
+        CHECK(b.fill_flag == a.fill_flag);
+        CHECK(b.fill_none == a.fill_none);
+        CHECK(b.stroke_flag == a.stroke_flag);
+        CHECK(b.stroke_none == a.stroke_none);
+        CHECK(b.dash == a.dash);
+        CHECK(b.dash_offset == a.dash_offset);
+    }
+}
+
+} // namespace
+
+TEST_CASE("SVG icon pack")
+{
+    SECTION("paths share gradients")
+    {
+        auto icon = parse(gradients_svg);
+        auto const& attrs = icon->attributes();
+        REQUIRE(attrs.size() == 3);
+        CHECK(attrs[0].fill_gradient.get_gradient_type() == mapnik::LINEAR);
+        CHECK(attrs[0].fill_gradient.ptr() == attrs[1].fill_gradient.ptr());
+        CHECK(attrs[0].stroke_gradient.ptr() == attrs[2].fill_gradient.ptr());
+    }
+
+    SECTION("round trip")
+    {
+        auto gradients = parse(gradients_svg);
+        auto arrow = parse(arrow_svg);
+        mapnik::svg::icon_pack_writer writer;
+        writer.add("gradients", *gradients);
+        writer.add("arrow", *arrow);
+        writer.add("arrow-copy", *arrow);
+        CHECK(writer.size() == 3);
+        auto data = std::make_shared<std::string const>(writer.data());
+
+        auto icons = mapnik::svg::read_icon_pack(data->data(), data->size(), data);
+        REQUIRE(icons.size() == 3);
+        CHECK(icons[0].first == "gradients");
+        CHECK(icons[1].first == "arrow");
+        CHECK(icons[2].first == "arrow-copy");
+        require_equal(*gradients, *icons[0].second);
+        require_equal(*arrow, *icons[1].second);
+        require_equal(*arrow, *icons[2].second);
+
+        // vertices are used in place, gradients and attributes are read once
+        CHECK(icons[0].second->source().is_view());
+        CHECK(icons[0].second->source().data() >= reinterpret_cast<mapnik::svg::vertex_f const*>(data->data()));
+        auto const& attrs = icons[0].second->attributes();
+        CHECK(attrs[0].fill_gradient.ptr() == attrs[1].fill_gradient.ptr());
+        CHECK(attrs[0].stroke_gradient.ptr() == attrs[2].fill_gradient.ptr());
+        CHECK(icons[1].second->attributes()[0].fill_gradient.ptr() == attrs[0].stroke_gradient.ptr());
+
+        // adding the same icon again only adds its vertices and a record
+        mapnik::svg::icon_pack_writer single;
+        single.add("arrow", *arrow);
+        mapnik::svg::icon_pack_writer twice;
+        twice.add("arrow", *arrow);
+        twice.add("arrow", *arrow);
+        std::size_t vertices = arrow->source().size() * sizeof(mapnik::svg::vertex_f);
+        CHECK(twice.data().size() < 2 * single.data().size() - vertices);
+
+        // modifying a view copies it first
+        mapnik::svg::svg_path_storage copy(icons[1].second->source());
+        mapnik::svg::vertex_stl_adapter<mapnik::svg::svg_path_storage> stl_storage(copy);
+        stl_storage.modify_vertex(0, 1.0, 2.0);
+        CHECK(!copy.is_view());
+        CHECK(copy[0].x == 1.0f);
+        CHECK(icons[1].second->source()[0].x == arrow->source()[0].x);
+    }
+
+    SECTION("malformed packs")
+    {
+        mapnik::svg::icon_pack_writer writer;
+        writer.add("arrow", *parse(arrow_svg));
+        std::string data = writer.data();
+        CHECK_THROWS_AS(mapnik::svg::read_icon_pack(data.data(), 16, nullptr), std::runtime_error);
+        std::string truncated = data.substr(0, data.size() - 1);
+        CHECK_THROWS_AS(mapnik::svg::read_icon_pack(truncated.data(), truncated.size(), nullptr), std::runtime_error);
+        std::string other = data;
+        other[0] = 'X';
+        CHECK_THROWS_AS(mapnik::svg::read_icon_pack(other.data(), other.size(), nullptr), std::runtime_error);
+        // counts larger than the pack can hold, before anything is reserved
+        for (std::size_t offset : {16, 20, 24})
+        {
+            other = data;
+            std::uint32_t count = 0xffffffff;
+            std::memcpy(&other[offset], &count, sizeof(count));
+            CHECK_THROWS_AS(mapnik::svg::read_icon_pack(other.data(), other.size(), nullptr), std::runtime_error);
+        }
+        // the gradient type and units after the 48 bytes of the header, then
+        // the line join and cap of the attributes after the gradient
+        for (std::size_t offset : {48, 49, 48 + 94 + 104, 48 + 94 + 105})
+        {
+            other = data;
+            other[offset] = char(0x7f);
+            CHECK_THROWS_AS(mapnik::svg::read_icon_pack(other.data(), other.size(), nullptr), std::runtime_error);
+        }
+    }
+
+    SECTION("marker cache")
+    {
+        std::string const filename = "/tmp/mapnik-icon-pack-test.bin";
+        mapnik::svg::icon_pack_writer writer;
+        writer.add("icons/arrow.svg", *parse(arrow_svg));
+        writer.add("icons/gradients.svg", *parse(gradients_svg));
+        writer.save(filename);
+
+        auto& cache = mapnik::marker_cache::instance();
+        CHECK(cache.load_icon_pack(filename) == 2);
+        CHECK(cache.load_icon_pack(filename) == 0);
+        CHECK(cache.load_icon_pack("/tmp/does-not-exist.bin") == 0);
+        std::shared_ptr<mapnik::marker const> marker = cache.find("icons/arrow.svg");
+        REQUIRE(marker->is<mapnik::marker_svg>());
+        auto const& svg = mapnik::util::get<mapnik::marker_svg>(*marker);
+        CHECK(svg.bounding_box() == parse(arrow_svg)->bounding_box());
+        // reading the vertices through the adapters keeps them in place
+        mapnik::svg::vertex_stl_adapter<mapnik::svg::svg_path_storage> stl_storage(svg.get_data()->source());
+        mapnik::svg::svg_path_adapter path(stl_storage);
+        path.rewind(0);
+        double x, y;
+        std::size_t count = 0;
+        while (path.vertex(&x, &y) != mapnik::SEG_END)
+            ++count;
+        CHECK(count > 0);
+        CHECK(svg.get_data()->source().is_view());
+        cache.clear();
+        std::remove(filename.c_str());
+    }
+}
@@ -0,0 +1,131 @@
+#include "catch.hpp"
+
+#include <mapnik/dot_rasterizer.hpp>
+#include <mapnik/agg_rasterizer.hpp>
+#include <mapnik/image.hpp>
+
+#include "agg_color_rgba.h"
+#include "agg_ellipse.h"
+#include "agg_pixfmt_rgba.h"
+#include "agg_rendering_buffer.h"
+#include "agg_renderer_base.h"
+#include "agg_renderer_scanline.h"
+#include "agg_scanline_u.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+using point_type = mapnik::dot_rasterizer::point_type;
+
+// what dot-symbolizer draws with marker-rasterizer="full"
+mapnik::image_rgba8 render_ellipses(double rx,
+                                    double ry,
+                                    mapnik::color const& fill,
+                                    agg::comp_op_e op,
+                                    std::vector<point_type> const& points)
+{
+    using blender_type = agg::comp_op_adaptor_rgba_pre<agg::rgba8, agg::order_rgba>;
+    using pixfmt_type = agg::pixfmt_custom_blend_rgba<blender_type, agg::rendering_buffer>;
+    using renderer_base = agg::renderer_base<pixfmt_type>;
+    mapnik::image_rgba8 image(64, 48);
+    image.set(0xc8a05028); // premultiplied
+    agg::rendering_buffer buf(image.bytes(), image.width(), image.height(), image.row_size());
+    pixfmt_type pixf(buf);
+    pixf.comp_op(op);
+    renderer_base renb(pixf);
+    agg::renderer_scanline_aa_solid<renderer_base> ren(renb);
+    ren.color(agg::rgba8_pre(fill.red(), fill.green(), fill.blue(), fill.alpha()));
+    mapnik::rasterizer ras;
+    agg::scanline_u8 sl;
+    agg::ellipse el(0, 0, rx, ry);
+    for (auto const& pt : points)
+    {
+        el.init(pt.x, pt.y, rx, ry, el.num_steps());
+        ras.add_path(el);
+        agg::render_scanlines(ras, sl, ren);
+    }
+    return image;
+}
+
+mapnik::image_rgba8 render_stamps(double rx,
+                                  double ry,
+                                  mapnik::color const& fill,
+                                  agg::comp_op_e op,
+                                  std::vector<point_type> const& points)
+{
+    mapnik::image_rgba8 image(64, 48);
+    image.set(0xc8a05028); // premultiplied
+    mapnik::dot_rasterizer(rx, ry).blend(image, fill, 1.0, static_cast<mapnik::composite_mode_e>(op), points);
+    return image;
+}
+
+int max_difference(mapnik::image_rgba8 const& a, mapnik::image_rgba8 const& b)
+{
+    int result = 0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        result = std::max(result, std::abs(int(a.bytes()[i]) - int(b.bytes()[i])));
+    }
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("dot_rasterizer")
+{
+    // centers on quarter pixels, overlapping and partly outside of the image
+    std::vector<point_type> points;
+    for (int i = 0; i < 60; ++i)
+    {
+        points.emplace_back((i * 37) % 72 - 4 + (i % 4) * 0.25, (i * 23) % 56 - 4 + (i % 3) * 0.25);
+    }
+    mapnik::color fill(200, 30, 60, 180);
+
+    SECTION("matches the ellipses of dot-symbolizer")
+    {
+        for (agg::comp_op_e op : {agg::comp_op_src_over, agg::comp_op_multiply})
+        {
+            CHECK(max_difference(render_ellipses(3.5, 2, fill, op, points), render_stamps(3.5, 2, fill, op, points)) <=
+                  1);
+            CHECK(max_difference(render_ellipses(1, 1, fill, op, points), render_stamps(1, 1, fill, op, points)) <= 1);
+        }
+    }
+
+    SECTION("single pixel dots")
+    {
+        mapnik::image_rgba8 image(8, 8);
+        mapnik::dot_rasterizer dots(0.5, 0.5);
+        dots.blend(image, mapnik::color(255, 255, 255), 1.0, mapnik::src_over, {{2.9, 3.1}, {-0.5, 2}, {8, 2}});
+        CHECK(image(2, 3) == 0xc8c8c8c8);
+        image(2, 3) = 0;
+        CHECK(std::all_of(image.begin(), image.end(), [](std::uint32_t pixel) { return pixel == 0; }));
+    }
+
+    SECTION("density")
+    {
+        mapnik::image_gray32f density(64, 48);
+        mapnik::dot_rasterizer dots(3, 3);
+        dots.accumulate(density, {{32, 24}});
+        // the area of the polygon agg approximates the circle with
+        double area = 0;
+        for (float value : density)
+        {
+            area += value;
+        }
+        CHECK(area == Approx(3.14159 * 9).epsilon(0.1));
+        CHECK(density(32, 24) == 1.0f);
+        dots.accumulate(density, {{32, 24}, {32.25, 24}}, 0.5f);
+        CHECK(density(32, 24) == 2.0f);
+        CHECK(density(40, 24) == 0.0f);
+    }
+
+    SECTION("zero sized dots are not drawn")
+    {
+        mapnik::image_rgba8 image(8, 8);
+        mapnik::dot_rasterizer(0, 2).blend(image, fill, 1.0, mapnik::src_over, {{4, 4}});
+        CHECK(std::all_of(image.begin(), image.end(), [](std::uint32_t pixel) { return pixel == 0; }));
+    }
+}
@@ -0,0 +1,204 @@
+#include "catch.hpp"
+
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/marker_sprite_cache.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+mapnik::image_rgba8 render(std::string const& file, mapnik::marker_rasterizer_enum rasterizer)
+{
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    mapnik::parameters params;
+    params["type"] = "memory";
+    auto ds = std::make_shared<mapnik::memory_datasource>(params);
+    for (int i = 0; i < 300; ++i)
+    {
+        mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i));
+        // a few distinct subpixel positions, overlapping each other
+        feature->set_geometry(mapnik::geometry::point<double>((i * 37) % 230 - 115 + (i % 4) * 0.25,
+                                                              (i * 53) % 230 - 115 + (i % 3) * 0.25));
+        ds->push(feature);
+    }
+
+    mapnik::Map m(256, 256);
+    m.set_background(mapnik::color(40, 80, 160));
+    mapnik::layer lyr("layer");
+    lyr.set_datasource(ds);
+    lyr.add_style("style");
+    m.add_layer(lyr);
+    mapnik::feature_type_style the_style;
+    mapnik::rule r;
+    mapnik::markers_symbolizer sym;
+    mapnik::put(sym, mapnik::keys::file, mapnik::parse_path(file));
+    mapnik::put(sym, mapnik::keys::width, 12.0);
+    mapnik::put(sym, mapnik::keys::fill, mapnik::color(220, 40, 40));
+    mapnik::put(sym, mapnik::keys::stroke, mapnik::color(255, 255, 255));
+    mapnik::put(sym, mapnik::keys::stroke_width, 2.0);
+    mapnik::put(sym, mapnik::keys::opacity, 0.8);
+    mapnik::put(sym, mapnik::keys::allow_overlap, true);
+    mapnik::put(sym, mapnik::keys::marker_rasterizer, rasterizer);
+    r.append(std::move(sym));
+    the_style.add_rule(std::move(r));
+    m.insert_style("style", std::move(the_style));
+    m.zoom_to_box(mapnik::box2d<double>(-128, -128, 128, 128));
+    mapnik::image_rgba8 buf(m.width(), m.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(m, buf);
+    ren.apply();
+    return buf;
+}
+
+// Mean absolute difference per channel and share of clearly different pixels.
+void compare(mapnik::image_rgba8 const& expected, mapnik::image_rgba8 const& actual)
+{
+    REQUIRE(expected.width() == actual.width());
+    REQUIRE(expected.height() == actual.height());
+    unsigned char const* a = expected.bytes();
+    unsigned char const* b = actual.bytes();
+    double sum = 0.0;
+    std::size_t painted = 0;
+    std::size_t different = 0;
+    for (std::size_t i = 0; i < expected.size(); i += 4)
+    {
+        int max_diff = 0;
+        for (std::size_t c = 0; c < 4; ++c)
+        {
+            int diff = std::abs(int(a[i + c]) - int(b[i + c]));
+            sum += diff;
+            max_diff = std::max(max_diff, diff);
+        }
+        // anything which isn't background
+        if (a[i] != 40 || a[i + 1] != 80 || a[i + 2] != 160)
+            ++painted;
+        if (max_diff > 64)
+            ++different;
+    }
+    REQUIRE(painted > 5000);
+    CHECK(sum / expected.size() < 1.0);
+    CHECK(different < painted / 100);
+}
+
+} // namespace
+
+TEST_CASE("marker_sprite_cache")
+{
+    SECTION("sprites match the full rasterizer")
+    {
+        for (std::string const file : {"shape://ellipse", "shape://arrow"})
+        {
+            mapnik::marker_sprite_cache::instance().clear();
+            mapnik::image_rgba8 full = render(file, mapnik::marker_rasterizer_enum::MARKER_RASTERIZER_FULL);
+            CHECK(mapnik::marker_sprite_cache::instance().size() == 0);
+            mapnik::image_rgba8 sprite = render(file, mapnik::marker_rasterizer_enum::MARKER_RASTERIZER_SPRITE);
+            compare(full, sprite);
+
+            // one sprite per subpixel position, reused by the next render
+            std::size_t sprites = mapnik::marker_sprite_cache::instance().size();
+            CHECK(sprites > 0);
+            CHECK(sprites <= 16);
+            mapnik::image_rgba8 again = render(file, mapnik::marker_rasterizer_enum::MARKER_RASTERIZER_SPRITE);
+            CHECK(mapnik::marker_sprite_cache::instance().size() == sprites);
+            CHECK(mapnik::compare(sprite, again) == 0);
+        }
+    }
+
+    SECTION("quantized transforms")
+    {
+        mapnik::box2d<double> bbox(-5, -5, 5, 5);
+        int x = 0;
+        int y = 0;
+        agg::trans_affine tr = agg::trans_affine_rotation(0.3);
+        tr.translate(10.6, -3.4);
+        auto k = mapnik::marker_sprite_cache::make_key(nullptr,
+                                                       mapnik::marker_sprite_style(),
+                                                       bbox,
+                                                       tr,
+                                                       1.0,
+                                                       1.0,
+                                                       mapnik::gamma_method_enum::GAMMA_POWER,
+                                                       false,
+                                                       x,
+                                                       y);
+        CHECK(x == 10);
+        CHECK(y == -4);
+        CHECK(k.dx == 2);
+        CHECK(k.dy == 2);
+        agg::trans_affine sprite_tr = mapnik::marker_sprite_cache::sprite_transform(k, bbox);
+        for (double px : {-5.0, 5.0})
+        {
+            for (double py : {-5.0, 5.0})
+            {
+                double x0 = px, y0 = py;
+                double x1 = px, y1 = py;
+                tr.transform(&x0, &y0);
+                sprite_tr.transform(&x1, &y1);
+                // half a quantization step of the linear part plus half a quarter pixel
+                CHECK(std::abs(x + x1 - x0) <= 0.0625 + 0.125 + 1e-9);
+                CHECK(std::abs(y + y1 - y0) <= 0.0625 + 0.125 + 1e-9);
+            }
+        }
+
+        // snapped markers have no subpixel offset
+        auto snapped = mapnik::marker_sprite_cache::make_key(nullptr,
+                                                             mapnik::marker_sprite_style(),
+                                                             bbox,
+                                                             tr,
+                                                             1.0,
+                                                             1.0,
+                                                             mapnik::gamma_method_enum::GAMMA_POWER,
+                                                             true,
+                                                             x,
+                                                             y);
+        CHECK(snapped.dx == 0);
+        CHECK(snapped.dy == 0);
+        CHECK(x == 11);
+        CHECK(y == -3);
+    }
+
+    SECTION("styles")
+    {
+        mapnik::box2d<double> bbox(-5, -5, 5, 5);
+        agg::trans_affine tr;
+        int x = 0;
+        int y = 0;
+        auto make = [&](mapnik::marker_sprite_style const& style) {
+            return mapnik::marker_sprite_cache::make_key(nullptr,
+                                                         style,
+                                                         bbox,
+                                                         tr,
+                                                         1.0,
+                                                         1.0,
+                                                         mapnik::gamma_method_enum::GAMMA_POWER,
+                                                         false,
+                                                         x,
+                                                         y);
+        };
+        mapnik::marker_sprite_style red;
+        red.fill = mapnik::color(255, 0, 0);
+        mapnik::marker_sprite_style blue;
+        blue.fill = mapnik::color(0, 0, 255);
+        mapnik::marker_sprite_style transparent;
+        transparent.fill_opacity = 0.0;
+        mapnik::marker_sprite_style unstroked;
+        unstroked.fill_opacity = 0.0;
+        unstroked.stroke_width = 0.0;
+        CHECK(make(red) == make(red));
+        CHECK_FALSE(make(red) == make(blue));
+        CHECK_FALSE(make(transparent) == make(unstroked));
+        CHECK_FALSE(make(red) == make(mapnik::marker_sprite_style()));
+    }
+}
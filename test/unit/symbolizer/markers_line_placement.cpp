@@ -0,0 +1,159 @@
+#include "catch.hpp"
+
+#include <mapnik/vertex_adapters.hpp>
+#include <mapnik/label_collision_detector.hpp>
+#include <mapnik/markers_placements/line.hpp>
+#include <mapnik/tolerance_iterator.hpp>
+#include <mapnik/vertex_cache.hpp>
+#include <mapnik/util/math.hpp>
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+using namespace mapnik;
+
+namespace {
+
+using va_type = mapnik::geometry::line_string_vertex_adapter<double>;
+using detector_type = mapnik::label_collision_detector4;
+using placement = std::array<double, 3>;
+
+// Checks and inserts one position after the other, as the line placement did
+// before it handed its candidates to the detector in runs.
+std::vector<placement> place_sequentially(va_type& va,
+                                          detector_type& detector,
+                                          mapnik::markers_placement_params const& params)
+{
+    std::vector<placement> result;
+    va.rewind(0);
+    vertex_cache path(va);
+    if (!path.next_subpath())
+        return result;
+    double marker_width = (params.size * params.tr).width();
+    double move = params.spacing / 2.0;
+    while (path.forward(move))
+    {
+        tolerance_iterator tolerance_offset(params.spacing * params.max_error, 0.0);
+        while (tolerance_offset.next())
+        {
+            vertex_cache::scoped_state state(path);
+            if (path.move(tolerance_offset.get()) && (path.linear_position() + marker_width / 2.0) < path.length())
+            {
+                pixel_position pos = path.current_position();
+                // DIRECTION_RIGHT_ONLY
+                double angle = util::normalize_angle(path.current_segment_angle());
+                if (std::fabs(angle) >= util::pi / 2)
+                    continue;
+                auto box = box2d<double>(params.size, params.tr * agg::trans_affine_rotation(angle).translate(pos.x, pos.y));
+                if (params.avoid_edges && !detector.extent().contains(box))
+                    continue;
+                if (!params.allow_overlap && !detector.has_placement(box))
+                    continue;
+                detector.insert(box);
+                result.push_back({{pos.x, pos.y, angle}});
+                // steps are only spacing apart after the first placement
+                move = params.spacing;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("marker placement line")
+{
+    SECTION("matches sequential placement")
+    {
+        // zig zag with segments running to the left, which DIRECTION_RIGHT_ONLY rejects
+        mapnik::geometry::line_string<double> g;
+        for (int i = 0; i < 12; ++i)
+        {
+            g.emplace_back(10.0 + i * 20.0, i % 2 == 0 ? 20.0 : 230.0);
+            g.emplace_back(i % 3 == 0 ? 5.0 + i * 20.0 : 25.0 + i * 20.0, i % 2 == 0 ? 230.0 : 20.0);
+        }
+        va_type va(g);
+
+        for (bool allow_overlap : {false, true})
+        {
+            for (bool avoid_edges : {false, true})
+            {
+                mapnik::markers_placement_params params{mapnik::box2d<double>(-6, -3, 6, 3),
+                                                        agg::trans_affine_scaling(1.5),
+                                                        15.0,
+                                                        NAN,
+                                                        0.4,
+                                                        allow_overlap,
+                                                        avoid_edges,
+                                                        direction_enum::DIRECTION_RIGHT_ONLY,
+                                                        1.0};
+
+                // obstacles along the line so that some positions need alternatives
+                detector_type expected_detector(mapnik::box2d<double>(0, 0, 256, 256));
+                detector_type detector(mapnik::box2d<double>(0, 0, 256, 256));
+                for (int i = 0; i < 40; ++i)
+                {
+                    mapnik::box2d<double> obstacle(i * 6.0, (i * 37) % 230, i * 6.0 + 4.0, (i * 37) % 230 + 4.0);
+                    expected_detector.insert(obstacle);
+                    detector.insert(obstacle);
+                }
+                std::vector<placement> expected = place_sequentially(va, expected_detector, params);
+                REQUIRE(expected.size() > 20);
+
+                va.rewind(0);
+                markers_line_placement<va_type, detector_type> line(va, detector, params);
+                std::vector<placement> actual;
+                double x, y, angle;
+                while (line.get_point(x, y, angle, false))
+                {
+                    actual.push_back({{x, y, angle}});
+                }
+                CHECK(!line.get_point(x, y, angle, false));
+                REQUIRE(actual.size() == expected.size());
+                for (std::size_t i = 0; i < actual.size(); ++i)
+                {
+                    CHECK(actual[i][0] == Approx(expected[i][0]));
+                    CHECK(actual[i][1] == Approx(expected[i][1]));
+                    CHECK(actual[i][2] == Approx(expected[i][2]));
+                }
+                CHECK(detector.size() == expected_detector.size());
+            }
+        }
+    }
+
+    SECTION("ignore placement")
+    {
+        mapnik::geometry::line_string<double> g;
+        g.emplace_back(0.0, 50.0);
+        g.emplace_back(100.0, 50.0);
+        va_type va(g);
+        detector_type detector(mapnik::box2d<double>(0, 0, 100, 100));
+        mapnik::markers_placement_params params{mapnik::box2d<double>(-5, -5, 5, 5),
+                                                agg::trans_affine(),
+                                                20.0,
+                                                NAN,
+                                                0.0,
+                                                false,
+                                                false,
+                                                direction_enum::DIRECTION_RIGHT,
+                                                1.0};
+        markers_line_placement<va_type, detector_type> line(va, detector, params);
+        std::vector<double> xs;
+        double x, y, angle;
+        while (line.get_point(x, y, angle, true))
+        {
+            xs.push_back(x);
+            CHECK(y == Approx(50.0));
+            CHECK(angle == Approx(0.0));
+        }
+        // nothing is stored with ignore_placement
+        REQUIRE(xs.size() == 5);
+        for (std::size_t i = 0; i < xs.size(); ++i)
+        {
+            CHECK(xs[i] == Approx(10.0 + i * 20.0));
+        }
+        CHECK(detector.size() == 0);
+    }
+}
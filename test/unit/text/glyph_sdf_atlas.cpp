@@ -0,0 +1,182 @@
+#include "catch.hpp"
+
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/expression.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/text/glyph_sdf_atlas.hpp>
+#include <mapnik/text/face.hpp>
+#include <mapnik/font_engine_freetype.hpp>
+#include <mapnik/text/placements/dummy.hpp>
+#include <mapnik/text/formatting/text.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+mapnik::image_rgba8 render(mapnik::geometry::geometry<double> const& geom,
+                           mapnik::label_placement_enum placement,
+                           mapnik::halo_rasterizer_enum rasterizer)
+{
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    ctx->push("name");
+    mapnik::parameters params;
+    params["type"] = "memory";
+    auto ds = std::make_shared<mapnik::memory_datasource>(params);
+    mapnik::transcoder tr("utf-8");
+    mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, 1));
+    feature->put("name", tr.transcode("Hamburg Quay 1842"));
+    feature->set_geometry_copy(geom);
+    ds->push(feature);
+
+    mapnik::Map m(256, 256);
+    REQUIRE(m.register_fonts("fonts", true));
+    m.set_background(mapnik::color(40, 80, 160));
+    mapnik::layer lyr("layer");
+    lyr.set_datasource(ds);
+    lyr.add_style("style");
+    m.add_layer(lyr);
+    mapnik::feature_type_style the_style;
+    mapnik::rule r;
+    mapnik::text_symbolizer text_sym;
+    mapnik::text_placements_ptr placements = std::make_shared<mapnik::text_placements_dummy>();
+    placements->defaults.expressions.label_placement = mapnik::enumeration_wrapper(placement);
+    placements->defaults.format_defaults.face_name = "DejaVu Sans Book";
+    placements->defaults.format_defaults.text_size = 14.0;
+    placements->defaults.format_defaults.fill = mapnik::color(0, 0, 0);
+    placements->defaults.format_defaults.halo_fill = mapnik::color(255, 255, 255);
+    placements->defaults.format_defaults.halo_radius = 2.0;
+    placements->defaults.set_format_tree(
+      std::make_shared<mapnik::formatting::text_node>(mapnik::parse_expression("[name]")));
+    mapnik::put<mapnik::text_placements_ptr>(text_sym, mapnik::keys::text_placements_, placements);
+    mapnik::put(text_sym, mapnik::keys::halo_rasterizer, rasterizer);
+    r.append(std::move(text_sym));
+    the_style.add_rule(std::move(r));
+    m.insert_style("style", std::move(the_style));
+    m.zoom_to_box(mapnik::box2d<double>(-128, -128, 128, 128));
+    mapnik::image_rgba8 buf(m.width(), m.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(m, buf);
+    ren.apply();
+    return buf;
+}
+
+// Mean absolute difference per channel and share of clearly different pixels.
+void compare(mapnik::image_rgba8 const& expected, mapnik::image_rgba8 const& actual)
+{
+    REQUIRE(expected.width() == actual.width());
+    REQUIRE(expected.height() == actual.height());
+    unsigned char const* a = expected.bytes();
+    unsigned char const* b = actual.bytes();
+    double sum = 0.0;
+    std::size_t painted = 0;
+    std::size_t different = 0;
+    for (std::size_t i = 0; i < expected.size(); i += 4)
+    {
+        int max_diff = 0;
+        for (std::size_t c = 0; c < 4; ++c)
+        {
+            int diff = std::abs(int(a[i + c]) - int(b[i + c]));
+            sum += diff;
+            max_diff = std::max(max_diff, diff);
+        }
+        // anything which isn't background
+        if (a[i] != 40 || a[i + 1] != 80 || a[i + 2] != 160)
+            ++painted;
+        if (max_diff > 64)
+            ++different;
+    }
+    REQUIRE(painted > 500);
+    CHECK(sum / expected.size() < 1.0);
+    CHECK(different < painted / 100);
+}
+
+} // namespace
+
+TEST_CASE("glyph_sdf_atlas")
+{
+    SECTION("size classes")
+    {
+        CHECK(mapnik::glyph_sdf_atlas::size_class(8.0) == Approx(32.0));
+        for (double size = 8.0; size <= 64.0; size += 0.5)
+        {
+            CHECK(mapnik::glyph_sdf_atlas::size_class(size) >= 2.0 * size - 1e-9);
+            CHECK(mapnik::glyph_sdf_atlas::size_class(size) < 2.0 * 1.4143 * size + 32.0);
+            CHECK(mapnik::glyph_sdf_atlas::max_distance(size) >= 4.0);
+        }
+    }
+
+    SECTION("fields are shared by faces of the same font file")
+    {
+        mapnik::freetype_engine::font_file_mapping_type mapping;
+        mapnik::freetype_engine::font_memory_cache_type cache;
+        REQUIRE(mapnik::freetype_engine::register_fonts("fonts", true));
+        mapnik::font_library library;
+        mapnik::face_manager_freetype fonts(library, mapping, cache);
+        mapnik::face_manager_freetype other_fonts(library, mapping, cache);
+        mapnik::face_ptr book = fonts.get_face("DejaVu Sans Book");
+        mapnik::face_ptr other_book = other_fonts.get_face("DejaVu Sans Book");
+        mapnik::face_ptr bold = fonts.get_face("DejaVu Sans Bold");
+        REQUIRE(book);
+        REQUIRE(other_book);
+        REQUIRE(bold);
+        CHECK(book != other_book);
+        CHECK(book->file_name() == other_book->file_name());
+        CHECK(book->file_name() != bold->file_name());
+
+        mapnik::glyph_sdf_atlas& atlas = mapnik::glyph_sdf_atlas::instance();
+        std::size_t capacity = atlas.capacity();
+        atlas.clear();
+        unsigned glyph = FT_Get_Char_Index(book->get_face(), 'a');
+        auto sdf = atlas.get(*book, glyph, 14.0);
+        REQUIRE(sdf);
+        CHECK(atlas.get(*other_book, glyph, 14.0) == sdf);
+        CHECK(atlas.get(*book, glyph, 40.0) != sdf);
+        CHECK(atlas.get(*bold, FT_Get_Char_Index(bold->get_face(), 'a'), 14.0) != sdf);
+        CHECK(atlas.size() == 3);
+
+        // the oldest fields are dropped first
+        atlas.set_capacity(2);
+        CHECK(atlas.size() == 2);
+        CHECK(atlas.get(*other_book, glyph, 14.0) != sdf);
+        CHECK(atlas.size() == 2);
+        atlas.set_capacity(capacity);
+        atlas.clear();
+    }
+
+    SECTION("point labels match the full halo rasterizer")
+    {
+        mapnik::geometry::point<double> pt(0, 0);
+        auto placement = mapnik::label_placement_enum::POINT_PLACEMENT;
+        mapnik::image_rgba8 full = render(pt, placement, mapnik::halo_rasterizer_enum::HALO_RASTERIZER_FULL);
+        mapnik::image_rgba8 sdf = render(pt, placement, mapnik::halo_rasterizer_enum::HALO_RASTERIZER_SDF);
+        compare(full, sdf);
+
+        // fields are generated once and reused
+        std::size_t fields = mapnik::glyph_sdf_atlas::instance().size();
+        CHECK(fields > 0);
+        render(pt, placement, mapnik::halo_rasterizer_enum::HALO_RASTERIZER_SDF);
+        CHECK(mapnik::glyph_sdf_atlas::instance().size() == fields);
+    }
+
+    SECTION("rotated line labels match the full halo rasterizer")
+    {
+        mapnik::geometry::line_string<double> line;
+        line.emplace_back(-120, -90);
+        line.emplace_back(120, 60);
+        auto placement = mapnik::label_placement_enum::LINE_PLACEMENT;
+        mapnik::image_rgba8 full = render(line, placement, mapnik::halo_rasterizer_enum::HALO_RASTERIZER_FULL);
+        mapnik::image_rgba8 sdf = render(line, placement, mapnik::halo_rasterizer_enum::HALO_RASTERIZER_SDF);
+        compare(full, sdf);
+    }
+}
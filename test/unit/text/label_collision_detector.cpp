@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include <mapnik/label_collision_detector.hpp>
+
+#include <random>
+
+TEST_CASE("label_collision_detector4")
+{
+    using detector_type = mapnik::label_collision_detector4;
+    using mapnik::box2d;
+
+    SECTION("overlap and margin")
+    {
+        detector_type detector(box2d<double>(0, 0, 256, 256));
+        CHECK(detector.has_placement(box2d<double>(10, 10, 20, 20)));
+        detector.insert(box2d<double>(10, 10, 20, 20));
+        CHECK(detector.size() == 1);
+        CHECK(!detector.has_placement(box2d<double>(15, 15, 25, 25)));
+        CHECK(detector.has_placement(box2d<double>(30, 10, 40, 20)));
+        CHECK(detector.has_placement(box2d<double>(30, 10, 40, 20), 5.0));
+        CHECK(!detector.has_placement(box2d<double>(30, 10, 40, 20), 15.0));
+        detector.clear();
+        CHECK(detector.size() == 0);
+        CHECK(detector.has_placement(box2d<double>(15, 15, 25, 25)));
+    }
+
+    SECTION("boxes outside of the extent are not stored")
+    {
+        detector_type detector(box2d<double>(0, 0, 256, 256));
+        detector.insert(box2d<double>(300, 300, 310, 310));
+        CHECK(detector.size() == 0);
+        detector.insert(box2d<double>(250, 250, 300, 300));
+        CHECK(detector.size() == 1);
+        // query entirely outside of the extent still finds the overhanging box
+        CHECK(!detector.has_placement(box2d<double>(280, 280, 290, 290)));
+    }
+
+    SECTION("repeat distance")
+    {
+        detector_type detector(box2d<double>(0, 0, 256, 256));
+        mapnik::value_unicode_string road("Main Street");
+        mapnik::value_unicode_string other("High Street");
+        detector.insert(box2d<double>(10, 10, 20, 20), road);
+        CHECK(detector.find_text(road) != detector_type::no_text);
+        CHECK(detector.find_text(other) == detector_type::no_text);
+        CHECK(detector.intern(road) == detector.find_text(road));
+        CHECK(!detector.has_placement(box2d<double>(40, 10, 50, 20), 0.0, road, 30.0));
+        CHECK(detector.has_placement(box2d<double>(40, 10, 50, 20), 0.0, other, 30.0));
+        CHECK(detector.has_placement(box2d<double>(60, 10, 70, 20), 0.0, road, 30.0));
+    }
+
+    SECTION("batch check and insert")
+    {
+        detector_type detector(box2d<double>(0, 0, 256, 256));
+        auto id = detector.intern(mapnik::value_unicode_string("label"));
+        std::vector<box2d<double>> first{{10, 10, 17, 22}, {17, 11, 24, 23}, {24, 12, 31, 24}};
+        std::vector<box2d<double>> second{{40, 10, 47, 22}, {20, 20, 27, 32}};
+        CHECK(detector.try_insert(first, 0.0, id, 0.0));
+        CHECK(detector.size() == 3);
+        CHECK(!detector.try_insert(second, 0.0, id, 0.0));
+        CHECK(detector.size() == 3);
+        second.pop_back();
+        CHECK(!detector.try_insert(second, 0.0, id, 20.0));
+        CHECK(detector.try_insert(second, 0.0, id, 5.0));
+        CHECK(detector.size() == 4);
+    }
+
+    SECTION("place a run of candidates")
+    {
+        detector_type detector(box2d<double>(0, 0, 256, 256));
+        detector.insert(box2d<double>(100, 0, 110, 10));
+        // the second box overlaps the first one, the fourth the stored box
+        std::vector<box2d<double>> run{{10, 0, 20, 10}, {15, 0, 25, 10}, {50, 0, 60, 10}, {105, 0, 115, 10}};
+        CHECK(detector.place_each(run.begin(), run.end(), false, false, true) == 1);
+        CHECK(detector.size() == 2);
+        CHECK(detector.place_each(run.begin() + 2, run.end(), false, false, true) == 1);
+        CHECK(detector.size() == 3);
+        CHECK(detector.place_each(run.begin(), run.end(), false, true, false) == 4);
+        CHECK(detector.size() == 3);
+        // boxes are only checked against the extent with avoid_edges
+        std::vector<box2d<double>> edge{{200, 200, 210, 210}, {250, 250, 260, 260}};
+        CHECK(detector.place_each(edge.begin(), edge.end(), true, false, true) == 1);
+        CHECK(detector.place_each(edge.begin() + 1, edge.end(), false, false, true) == 1);
+        CHECK(detector.size() == 5);
+    }
+
+    SECTION("matches sequential scan")
+    {
+        box2d<double> extent(-64, -64, 1088, 1088);
+        detector_type detector(extent);
+        std::vector<box2d<double>> placed;
+        std::default_random_engine engine(42);
+        std::uniform_real_distribution<double> position(-200, 1200);
+        std::uniform_real_distribution<double> size(0, 60);
+        for (int i = 0; i < 5000; ++i)
+        {
+            double x = position(engine);
+            double y = position(engine);
+            box2d<double> box(x, y, x + size(engine), y + size(engine));
+            bool expected = true;
+            for (auto const& other : placed)
+            {
+                if (other.intersects(box))
+                {
+                    expected = false;
+                    break;
+                }
+            }
+            REQUIRE(detector.has_placement(box) == expected);
+            if (expected && extent.intersects(box))
+            {
+                detector.insert(box);
+                placed.push_back(box);
+            }
+        }
+        CHECK(detector.size() == placed.size());
+    }
+}
@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/expression.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/value/types.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/text/placements/dummy.hpp>
+#include <mapnik/text/formatting/text.hpp>
+#include <mapnik/text/text_layout_pool.hpp>
+
+#include <string>
+#ifdef MAPNIK_THREADSAFE
+#include <thread>
+#endif
+
+namespace {
+
+mapnik::image_rgba8 render(mapnik::Map const& m)
+{
+    mapnik::image_rgba8 buf(m.width(), m.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(m, buf);
+    ren.apply();
+    return buf;
+}
+
+mapnik::image_rgba8 render_labels(mapnik::Map& m, mapnik::value_integer threads)
+{
+    m.get_extra_parameters()["text-layout-threads"] = threads;
+    return render(m);
+}
+
+} // namespace
+
+TEST_CASE("text_layout_pool")
+{
+    SECTION("parallel layout places the same labels as serial layout")
+    {
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        ctx->push("name");
+        ctx->push("rank");
+        mapnik::parameters params;
+        params["type"] = "memory";
+        auto ds = std::make_shared<mapnik::memory_datasource>(params);
+        mapnik::transcoder tr("utf-8");
+        for (int i = 0; i < 400; ++i)
+        {
+            mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, i));
+            feature->put("name", tr.transcode(("label " + std::to_string(i)).c_str()));
+            feature->put("rank", mapnik::value_integer(i % 7));
+            feature->set_geometry(mapnik::geometry::point<double>((i * 37) % 480 - 240, (i * 53) % 480 - 240));
+            ds->push(feature);
+        }
+
+        mapnik::Map m(256, 256);
+        REQUIRE(m.register_fonts("fonts", true));
+        mapnik::layer lyr("layer");
+        lyr.set_datasource(ds);
+        lyr.add_style("style");
+        m.add_layer(lyr);
+        mapnik::feature_type_style the_style;
+        mapnik::rule r;
+        mapnik::text_symbolizer text_sym;
+        mapnik::text_placements_ptr placements = std::make_shared<mapnik::text_placements_dummy>();
+        placements->defaults.format_defaults.face_name = "DejaVu Sans Book";
+        placements->defaults.format_defaults.text_size = 10.0;
+        placements->defaults.format_defaults.fill = mapnik::color(0, 0, 0);
+        placements->defaults.set_format_tree(
+          std::make_shared<mapnik::formatting::text_node>(mapnik::parse_expression("[name]")));
+        mapnik::put<mapnik::text_placements_ptr>(text_sym, mapnik::keys::text_placements_, placements);
+        mapnik::put(text_sym, mapnik::keys::priority, mapnik::parse_expression("[rank]"));
+        r.append(std::move(text_sym));
+        the_style.add_rule(std::move(r));
+        m.insert_style("style", std::move(the_style));
+        m.zoom_to_box(mapnik::box2d<double>(-256, -256, 256, 256));
+
+        mapnik::image_rgba8 serial = render_labels(m, 1);
+        mapnik::image_rgba8 parallel = render_labels(m, 4);
+        CHECK(!mapnik::is_solid(serial));
+        CHECK(mapnik::compare(serial, parallel) == 0);
+
+        // the threads and their fonts are kept across renders
+        auto pool = m.get_text_layout_pool(4);
+        CHECK(mapnik::compare(render_labels(m, 4), serial) == 0);
+        CHECK(m.get_text_layout_pool(4) == pool);
+        mapnik::Map copy(m);
+        CHECK(copy.get_text_layout_pool(4) != pool);
+#ifdef MAPNIK_THREADSAFE
+        CHECK(pool->num_threads() == 4);
+        // renders of the same map sharing the pool
+        mapnik::image_rgba8 other;
+        std::thread thread([&] { other = render(copy); });
+        CHECK(mapnik::compare(render(m), serial) == 0);
+        thread.join();
+        CHECK(mapnik::compare(other, serial) == 0);
+        std::thread same([&] { other = render(m); });
+        CHECK(mapnik::compare(render(m), serial) == 0);
+        same.join();
+        CHECK(mapnik::compare(other, serial) == 0);
+#endif
+    }
+}
@@ -0,0 +1,181 @@
+#include "catch.hpp"
+#include "fake_path.hpp"
+
+// mapnik
+#include <mapnik/vertex_cache.hpp>
+#include <mapnik/text/vertex_cache_store.hpp>
+
+// stl
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Staircase of 100 unit steps, alternating between x and y.
+fake_path make_stairs()
+{
+    std::vector<double> coords{0, 0};
+    double x = 0, y = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i % 2 == 0)
+            x += 1;
+        else
+            y += 1;
+        coords.push_back(x);
+        coords.push_back(y);
+    }
+    return fake_path(coords);
+}
+
+// Point at the given distance along the staircase.
+mapnik::pixel_position stairs_position(double distance)
+{
+    int steps = static_cast<int>(distance);
+    double rest = distance - steps;
+    double x = (steps + 1) / 2;
+    double y = steps / 2;
+    if (steps % 2 == 0)
+        x += rest;
+    else
+        y += rest;
+    return mapnik::pixel_position(x, y);
+}
+
+mapnik::vertex_cache_store::key make_key(std::vector<double> const& vertices)
+{
+    mapnik::vertex_cache_store::key k;
+    k.vertices = vertices;
+    k.prj_trans = nullptr;
+    k.args.fill(0.0);
+    return k;
+}
+
+std::shared_ptr<mapnik::vertex_cache> make_cache()
+{
+    fake_path path = make_stairs();
+    return std::make_shared<mapnik::vertex_cache>(path);
+}
+
+} // namespace
+
+TEST_CASE("vertex_cache")
+{
+    SECTION("long moves land on the same points as short ones")
+    {
+        fake_path path = make_stairs();
+        mapnik::vertex_cache pp(path);
+        REQUIRE(pp.next_subpath());
+        REQUIRE(pp.length() == Approx(100.0));
+
+        REQUIRE(pp.move(57.25));
+        CHECK(pp.linear_position() == Approx(57.25));
+        CHECK(pp.current_position().x == Approx(stairs_position(57.25).x));
+        CHECK(pp.current_position().y == Approx(stairs_position(57.25).y));
+
+        REQUIRE(pp.move(-40.5));
+        CHECK(pp.current_position().x == Approx(stairs_position(16.75).x));
+        CHECK(pp.current_position().y == Approx(stairs_position(16.75).y));
+
+        REQUIRE(pp.move(30.0));
+        CHECK(pp.current_position().x == Approx(stairs_position(46.75).x));
+        CHECK(pp.current_position().y == Approx(stairs_position(46.75).y));
+
+        mapnik::vertex_cache steps(path);
+        REQUIRE(steps.next_subpath());
+        for (int i = 0; i < 187; ++i)
+        {
+            REQUIRE(steps.move(0.25));
+        }
+        CHECK(steps.current_position().x == Approx(pp.current_position().x));
+        CHECK(steps.current_position().y == Approx(pp.current_position().y));
+        CHECK(steps.current_segment_angle() == Approx(pp.current_segment_angle()));
+    }
+
+    SECTION("moves stop at segment boundaries")
+    {
+        fake_path path = make_stairs();
+        mapnik::vertex_cache pp(path);
+        REQUIRE(pp.next_subpath());
+        REQUIRE(pp.move(3.0));
+        CHECK(pp.current_position().x == Approx(2.0));
+        CHECK(pp.current_position().y == Approx(1.0));
+        REQUIRE(pp.move(-3.0));
+        CHECK(pp.current_position().x == Approx(0.0));
+        CHECK(pp.current_position().y == Approx(0.0));
+    }
+
+    SECTION("moves beyond either end fail")
+    {
+        fake_path path = make_stairs();
+        mapnik::vertex_cache pp(path);
+        REQUIRE(pp.next_subpath());
+        CHECK(!pp.move(100.0));
+        pp.reset();
+        REQUIRE(pp.next_subpath());
+        REQUIRE(pp.move(50.0));
+        CHECK(!pp.move(-60.0));
+    }
+}
+
+TEST_CASE("vertex_cache_store")
+{
+    SECTION("equal keys hit")
+    {
+        mapnik::vertex_cache_store store;
+        auto cache = make_cache();
+        store.insert(make_key({2, 2, 0, 0, 10, 0}), cache);
+        CHECK(store.find(make_key({2, 2, 0, 0, 10, 0})) == cache);
+        CHECK(store.size() == 1);
+        // inserting again keeps the first path
+        store.insert(make_key({2, 2, 0, 0, 10, 0}), make_cache());
+        CHECK(store.find(make_key({2, 2, 0, 0, 10, 0})) == cache);
+        CHECK(store.size() == 1);
+    }
+
+    SECTION("keys differing in any vertex or argument miss")
+    {
+        mapnik::vertex_cache_store store;
+        auto cache = make_cache();
+        store.insert(make_key({2, 2, 0, 0, 10, 0}), cache);
+        CHECK(!store.find(make_key({2, 2, 0, 0, 10, 1})));
+        CHECK(!store.find(make_key({2, 3, 0, 0, 10, 0, 20, 0})));
+        // same vertices as a polygon ring
+        CHECK(!store.find(make_key({3, 2, 0, 0, 10, 0})));
+        auto offset = make_key({2, 2, 0, 0, 10, 0});
+        offset.args[6] = 5.0;
+        CHECK(!store.find(offset));
+        auto transformed = make_key({2, 2, 0, 0, 10, 0});
+        transformed.prj_trans = reinterpret_cast<mapnik::proj_transform const*>(&store);
+        CHECK(!store.find(transformed));
+    }
+
+    SECTION("the oldest paths are dropped when full")
+    {
+        mapnik::vertex_cache_store store;
+        std::vector<std::shared_ptr<mapnik::vertex_cache>> caches;
+        for (int i = 0; i < 1025; ++i)
+        {
+            caches.push_back(make_cache());
+            store.insert(make_key({2, 1, static_cast<double>(i), 0}), caches.back());
+        }
+        CHECK(store.size() == 1024);
+        CHECK(!store.find(make_key({2, 1, 0, 0})));
+        CHECK(store.find(make_key({2, 1, 1, 0})) == caches[1]);
+        CHECK(store.find(make_key({2, 1, 1024, 0})) == caches[1024]);
+
+        // hits do not refresh a path
+        store.insert(make_key({2, 1, 1025, 0}), make_cache());
+        CHECK(!store.find(make_key({2, 1, 1, 0})));
+        CHECK(store.find(make_key({2, 1, 2, 0})) == caches[2]);
+        CHECK(store.size() == 1024);
+    }
+
+    SECTION("a store without capacity keeps nothing")
+    {
+        mapnik::vertex_cache_store store(0);
+        store.insert(make_key({2, 2, 0, 0, 10, 0}), make_cache());
+        CHECK(store.size() == 0);
+        CHECK(!store.find(make_key({2, 2, 0, 0, 10, 0})));
+    }
+}